@@ -0,0 +1,417 @@
+//! Read-through OHLCV cache wrapping another `DataPort` (TRD Section 11.1).
+//!
+//! The web server answers many backtests over the same codes and dates that
+//! differ only in their rules. `CachedDataPort` keeps the columns it has
+//! loaded per `(exchange, code)` together with the date range they cover,
+//! and answers any request inside that range by slicing, without touching
+//! the wrapped adapter. A request reaching outside it refetches the union of
+//! the old and new ranges, so the cached range only grows. Entries are
+//! evicted least recently used first (`lru::Lru`, O(1) per eviction) once
+//! their total size passes the byte budget.
+//!
+//! Nothing here can tell when the database changes: whoever ingests new
+//! bars calls `DataPort::invalidate`.
+
+use crate::adapters::lru::Lru;
+use crate::domain::error::SamtraderError;
+use crate::domain::ohlcv::{OhlcvBar, OhlcvSeries};
+use crate::ports::data_port::DataPort;
+use chrono::NaiveDate;
+use std::mem::size_of;
+use std::sync::Mutex;
+
+/// Bytes charged per cached bar: one date plus five numeric columns.
+const BAR_BYTES: usize = size_of::<NaiveDate>() + 4 * size_of::<f64>() + size_of::<i64>();
+
+/// Fixed bytes charged per entry for the key, map slot and column headers.
+const ENTRY_OVERHEAD: usize = 256;
+
+#[derive(Debug)]
+struct Entry {
+    /// Requested range the series is complete for; it may hold fewer bars
+    /// (non-trading days, or no data at all).
+    start: NaiveDate,
+    end: NaiveDate,
+    series: OhlcvSeries,
+}
+
+#[derive(Debug)]
+struct CacheState {
+    entries: Lru<(String, String), Entry>,
+    /// Bumped by every invalidation, so a fetch that started before one
+    /// does not store what it read.
+    generation: u64,
+}
+
+impl CacheState {
+    fn lookup(
+        &mut self,
+        key: &(String, String),
+        start: NaiveDate,
+        end: NaiveDate,
+    ) -> Option<OhlcvSeries> {
+        let entry = self.entries.peek(key)?;
+        if entry.start > start || entry.end < end {
+            return None;
+        }
+        let entry = self.entries.get(key)?;
+        Some(entry.series.date_range(start, end))
+    }
+
+    /// Range to fetch so the entry for `key` ends up covering
+    /// `[start, end]`: the request widened by whatever is cached now.
+    fn fetch_range(
+        &self,
+        key: &(String, String),
+        start: NaiveDate,
+        end: NaiveDate,
+    ) -> (NaiveDate, NaiveDate) {
+        match self.entries.peek(key) {
+            Some(e) => (e.start.min(start), e.end.max(end)),
+            None => (start, end),
+        }
+    }
+
+    /// Cache `entry` as most recently used, unless it alone is over budget,
+    /// in which case any older entry for `key` is dropped instead.
+    fn insert(&mut self, key: (String, String), entry: Entry, bytes: usize, capacity: usize) {
+        if bytes > capacity {
+            self.entries.remove(&key);
+            return;
+        }
+        self.entries.insert(key, entry, bytes);
+    }
+}
+
+/// `DataPort` decorator caching fetched bar columns in a byte-bounded LRU.
+pub struct CachedDataPort<P> {
+    inner: P,
+    capacity: usize,
+    state: Mutex<CacheState>,
+}
+
+impl<P: DataPort> CachedDataPort<P> {
+    /// Wrap `inner`, holding at most `capacity_bytes` of bar data.
+    pub fn new(inner: P, capacity_bytes: usize) -> Self {
+        Self {
+            inner,
+            capacity: capacity_bytes,
+            state: Mutex::new(CacheState {
+                entries: Lru::new(capacity_bytes),
+                generation: 0,
+            }),
+        }
+    }
+
+    /// Approximate bytes of bar data currently held.
+    pub fn cached_bytes(&self) -> usize {
+        self.state.lock().unwrap().entries.bytes()
+    }
+
+    fn key(code: &str, exchange: &str) -> (String, String) {
+        (exchange.to_string(), code.to_string())
+    }
+
+    /// Store a freshly fetched `[start, end]` series unless an invalidation
+    /// happened since `generation` was read.
+    fn store(
+        &self,
+        key: (String, String),
+        start: NaiveDate,
+        end: NaiveDate,
+        series: &OhlcvSeries,
+        generation: u64,
+    ) {
+        let mut state = self.state.lock().unwrap();
+        if state.generation != generation {
+            return;
+        }
+        let entry = Entry {
+            start,
+            end,
+            series: series.clone(),
+        };
+        let bytes = ENTRY_OVERHEAD + series.len() * BAR_BYTES;
+        state.insert(key, entry, bytes, self.capacity);
+    }
+}
+
+impl<P: DataPort> DataPort for CachedDataPort<P> {
+    fn fetch_ohlcv(
+        &self,
+        code: &str,
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<Vec<OhlcvBar>, SamtraderError> {
+        self.fetch_ohlcv_series(code, exchange, start_date, end_date)
+            .map(|series| series.to_bars(code, exchange))
+    }
+
+    fn fetch_ohlcv_series(
+        &self,
+        code: &str,
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<OhlcvSeries, SamtraderError> {
+        let key = Self::key(code, exchange);
+        let (generation, (from, to)) = {
+            let mut state = self.state.lock().unwrap();
+            if let Some(hit) = state.lookup(&key, start_date, end_date) {
+                return Ok(hit);
+            }
+            (
+                state.generation,
+                state.fetch_range(&key, start_date, end_date),
+            )
+        };
+
+        let series = self.inner.fetch_ohlcv_series(code, exchange, from, to)?;
+        self.store(key, from, to, &series, generation);
+        Ok(series.date_range(start_date, end_date))
+    }
+
+    /// Serves cached codes from memory and fetches the rest with a single
+    /// `fetch_ohlcv_batch` on the wrapped port.
+    fn fetch_ohlcv_batch(
+        &self,
+        codes: &[String],
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<Vec<OhlcvSeries>, SamtraderError> {
+        let mut result = vec![OhlcvSeries::new(); codes.len()];
+        let mut missing: Vec<usize> = Vec::new();
+        let (generation, from, to) = {
+            let mut state = self.state.lock().unwrap();
+            let (mut from, mut to) = (start_date, end_date);
+            for (i, code) in codes.iter().enumerate() {
+                let key = Self::key(code, exchange);
+                match state.lookup(&key, start_date, end_date) {
+                    Some(hit) => result[i] = hit,
+                    None => {
+                        let (f, t) = state.fetch_range(&key, start_date, end_date);
+                        from = from.min(f);
+                        to = to.max(t);
+                        missing.push(i);
+                    }
+                }
+            }
+            (state.generation, from, to)
+        };
+        if missing.is_empty() {
+            return Ok(result);
+        }
+
+        let missing_codes: Vec<String> = missing.iter().map(|&i| codes[i].clone()).collect();
+        let fetched = self
+            .inner
+            .fetch_ohlcv_batch(&missing_codes, exchange, from, to)?;
+        for (&i, series) in missing.iter().zip(fetched) {
+            self.store(
+                Self::key(&codes[i], exchange),
+                from,
+                to,
+                &series,
+                generation,
+            );
+            result[i] = series.date_range(start_date, end_date);
+        }
+        Ok(result)
+    }
+
+    fn batch_is_one_query(&self) -> bool {
+        self.inner.batch_is_one_query()
+    }
+
+    fn list_symbols(&self, exchange: &str) -> Result<Vec<String>, SamtraderError> {
+        self.inner.list_symbols(exchange)
+    }
+
+    fn get_data_range(
+        &self,
+        code: &str,
+        exchange: &str,
+    ) -> Result<Option<(NaiveDate, NaiveDate, usize)>, SamtraderError> {
+        self.inner.get_data_range(code, exchange)
+    }
+
+    fn invalidate(&self, exchange: &str, code: Option<&str>) {
+        let mut state = self.state.lock().unwrap();
+        state.generation += 1;
+        state
+            .entries
+            .retain(|(e, c), _| e != exchange || code.is_some_and(|code| code != c));
+        self.inner.invalidate(exchange, code);
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use chrono::Datelike;
+    use std::sync::atomic::{AtomicUsize, Ordering};
+
+    /// Port serving one bar per day from 2024-01-01 and counting calls.
+    struct CountingPort {
+        days: u32,
+        calls: AtomicUsize,
+    }
+
+    impl CountingPort {
+        fn new(days: u32) -> Self {
+            CountingPort {
+                days,
+                calls: AtomicUsize::new(0),
+            }
+        }
+
+        fn calls(&self) -> usize {
+            self.calls.load(Ordering::SeqCst)
+        }
+    }
+
+    impl DataPort for CountingPort {
+        fn fetch_ohlcv(
+            &self,
+            _code: &str,
+            _exchange: &str,
+            start_date: NaiveDate,
+            end_date: NaiveDate,
+        ) -> Result<Vec<OhlcvBar>, SamtraderError> {
+            self.calls.fetch_add(1, Ordering::SeqCst);
+            Ok((0..self.days)
+                .map(|i| day(1) + chrono::Duration::days(i64::from(i)))
+                .filter(|d| *d >= start_date && *d <= end_date)
+                .map(|date| OhlcvBar {
+                    code: "BHP".into(),
+                    exchange: "ASX".into(),
+                    date,
+                    open: 1.0,
+                    high: 2.0,
+                    low: 0.5,
+                    close: f64::from(date.ordinal()),
+                    volume: 100,
+                })
+                .collect())
+        }
+
+        fn list_symbols(&self, _exchange: &str) -> Result<Vec<String>, SamtraderError> {
+            Ok(vec!["BHP".into()])
+        }
+
+        fn get_data_range(
+            &self,
+            _code: &str,
+            _exchange: &str,
+        ) -> Result<Option<(NaiveDate, NaiveDate, usize)>, SamtraderError> {
+            Ok(None)
+        }
+    }
+
+    fn day(n: u32) -> NaiveDate {
+        NaiveDate::from_yo_opt(2024, n).unwrap()
+    }
+
+    #[test]
+    fn sub_ranges_are_served_from_cache() {
+        let cache = CachedDataPort::new(CountingPort::new(100), 1 << 20);
+
+        let full = cache
+            .fetch_ohlcv_series("BHP", "ASX", day(1), day(60))
+            .unwrap();
+        assert_eq!(full.len(), 60);
+        let window = cache
+            .fetch_ohlcv_series("BHP", "ASX", day(10), day(20))
+            .unwrap();
+        assert_eq!(window, full.date_range(day(10), day(20)));
+        let rows = cache.fetch_ohlcv("BHP", "ASX", day(59), day(60)).unwrap();
+        assert_eq!(rows.len(), 2);
+        assert_eq!(cache.inner.calls(), 1);
+
+        // Extending past the cached range refetches the union once.
+        let wider = cache
+            .fetch_ohlcv_series("BHP", "ASX", day(30), day(90))
+            .unwrap();
+        assert_eq!(wider.len(), 61);
+        cache
+            .fetch_ohlcv_series("BHP", "ASX", day(1), day(90))
+            .unwrap();
+        assert_eq!(cache.inner.calls(), 2);
+    }
+
+    #[test]
+    fn batch_fetches_only_missing_codes() {
+        let cache = CachedDataPort::new(CountingPort::new(30), 1 << 20);
+        cache
+            .fetch_ohlcv_series("BHP", "ASX", day(1), day(30))
+            .unwrap();
+
+        let codes = vec!["BHP".to_string(), "CBA".to_string()];
+        let batch = cache
+            .fetch_ohlcv_batch(&codes, "ASX", day(5), day(10))
+            .unwrap();
+        assert_eq!(batch[0].len(), 6);
+        assert_eq!(batch[1].len(), 6);
+        // One call for the warm-up, one for CBA alone.
+        assert_eq!(cache.inner.calls(), 2);
+
+        cache
+            .fetch_ohlcv_batch(&codes, "ASX", day(5), day(10))
+            .unwrap();
+        assert_eq!(cache.inner.calls(), 2);
+    }
+
+    #[test]
+    fn evicts_least_recently_used_past_budget() {
+        let per_entry = ENTRY_OVERHEAD + 10 * BAR_BYTES;
+        let cache = CachedDataPort::new(CountingPort::new(10), 2 * per_entry);
+        for code in ["A", "B"] {
+            cache
+                .fetch_ohlcv_series(code, "ASX", day(1), day(10))
+                .unwrap();
+        }
+        cache
+            .fetch_ohlcv_series("A", "ASX", day(1), day(10))
+            .unwrap();
+        cache
+            .fetch_ohlcv_series("C", "ASX", day(1), day(10))
+            .unwrap();
+        assert_eq!(cache.inner.calls(), 3);
+        assert_eq!(cache.cached_bytes(), 2 * per_entry);
+
+        // B was least recently used and is gone; A survived.
+        cache
+            .fetch_ohlcv_series("A", "ASX", day(1), day(10))
+            .unwrap();
+        assert_eq!(cache.inner.calls(), 3);
+        cache
+            .fetch_ohlcv_series("B", "ASX", day(1), day(10))
+            .unwrap();
+        assert_eq!(cache.inner.calls(), 4);
+    }
+
+    #[test]
+    fn invalidate_drops_matching_entries() {
+        let cache = CachedDataPort::new(CountingPort::new(10), 1 << 20);
+        for code in ["BHP", "CBA"] {
+            cache
+                .fetch_ohlcv_series(code, "ASX", day(1), day(10))
+                .unwrap();
+        }
+
+        cache.invalidate("ASX", Some("BHP"));
+        cache
+            .fetch_ohlcv_series("CBA", "ASX", day(1), day(10))
+            .unwrap();
+        assert_eq!(cache.inner.calls(), 2);
+        cache
+            .fetch_ohlcv_series("BHP", "ASX", day(1), day(10))
+            .unwrap();
+        assert_eq!(cache.inner.calls(), 3);
+
+        cache.invalidate("ASX", None);
+        assert_eq!(cache.cached_bytes(), 0);
+    }
+}
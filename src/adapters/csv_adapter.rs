@@ -1,24 +1,327 @@
 //! CSV file data adapter (TRD Section 2.2).
-
+//!
+//! Files are read a record at a time into one reused `StringRecord`, so
+//! memory stays flat whatever the file size. Each `<CODE>_<EXCHANGE>.csv`
+//! gets a sidecar `<CODE>_<EXCHANGE>.csv.idx` the first time it is read: the
+//! byte offset and date of every `INDEX_STRIDE`th record, plus the row count,
+//! date bounds and whether the file is in date order. With it a range query
+//! seeks to just before `start_date` and, for a sorted file, stops at the
+//! first row past `end_date`. The sidecar records the CSV's length and mtime
+//! and is rebuilt whenever either changes.
+
+use crate::domain::codec::{ByteReader, ByteWriter};
 use crate::domain::error::SamtraderError;
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::ohlcv::{OhlcvBar, OhlcvSeries};
 use crate::ports::data_port::DataPort;
 use chrono::NaiveDate;
-use std::fs;
-use std::path::PathBuf;
+use csv::{Position, StringRecord};
+use std::fmt::Display;
+use std::fs::{self, File};
+use std::path::{Path, PathBuf};
+use std::str::FromStr;
+use std::time::UNIX_EPOCH;
+
+/// Records between consecutive sidecar index entries.
+const INDEX_STRIDE: usize = 64;
+const INDEX_MAGIC: &[u8; 4] = b"STCI";
+const INDEX_VERSION: u32 = 1;
 
 pub struct CsvAdapter {
     base_path: PathBuf,
+    use_index: bool,
 }
 
 impl CsvAdapter {
     pub fn new(base_path: PathBuf) -> Self {
-        Self { base_path }
+        Self {
+            base_path,
+            use_index: true,
+        }
+    }
+
+    /// Never read or write sidecar indexes (e.g. for a read-only directory
+    /// of files queried once). Range queries then scan each file in full.
+    pub fn without_index(mut self) -> Self {
+        self.use_index = false;
+        self
     }
 
     fn csv_path(&self, code: &str, exchange: &str) -> PathBuf {
         self.base_path.join(format!("{}_{}.csv", code, exchange))
     }
+
+    /// The sidecar index for `path`, reusing the stored one while it matches
+    /// the file and otherwise rebuilding it and (best effort) saving it.
+    fn load_index(&self, path: &Path) -> Result<CsvIndex, SamtraderError> {
+        let stamp = fs::metadata(path).ok().and_then(|m| file_stamp(&m));
+        let sidecar = index_path(path);
+        if self.use_index {
+            let stored = fs::read(&sidecar)
+                .ok()
+                .and_then(|bytes| CsvIndex::from_bytes(&bytes).ok());
+            if let Some(index) = stored.filter(|i| stamp.is_some() && i.stamp == stamp) {
+                return Ok(index);
+            }
+        }
+
+        let index = CsvIndex::build(path, stamp)?;
+        if self.use_index && stamp.is_some() {
+            // A stale or unwritable sidecar only costs a rebuild next time.
+            let mut tmp = sidecar.clone().into_os_string();
+            tmp.push(".tmp");
+            if fs::write(&tmp, index.to_bytes()).is_ok() {
+                let _ = fs::rename(&tmp, &sidecar);
+            }
+        }
+        Ok(index)
+    }
+
+    /// `(code, exchange)` of every `<CODE>_<EXCHANGE>.csv` in the directory,
+    /// sorted.
+    pub fn list_files(&self) -> Result<Vec<(String, String)>, SamtraderError> {
+        let entries = fs::read_dir(&self.base_path).map_err(|e| SamtraderError::Database {
+            reason: format!(
+                "failed to read directory {}: {}",
+                self.base_path.display(),
+                e
+            ),
+        })?;
+
+        let mut files = Vec::new();
+        for entry in entries {
+            let entry = entry.map_err(|e| SamtraderError::Database {
+                reason: format!("directory entry error: {}", e),
+            })?;
+            let name = entry.file_name();
+            let name_str = name.to_string_lossy();
+            let Some((code, exchange)) = name_str
+                .strip_suffix(".csv")
+                .and_then(|stem| stem.rsplit_once('_'))
+            else {
+                continue;
+            };
+            if !code.is_empty() && !exchange.is_empty() {
+                files.push((code.to_string(), exchange.to_string()));
+            }
+        }
+
+        files.sort();
+        Ok(files)
+    }
+
+    /// Stream one file's bars in file order, a record at a time, so a bulk
+    /// import holds one row in memory rather than the whole file.
+    pub fn read_bars(
+        &self,
+        code: &str,
+        exchange: &str,
+    ) -> Result<impl Iterator<Item = Result<OhlcvBar, SamtraderError>> + use<>, SamtraderError>
+    {
+        let rdr = open_csv(&self.csv_path(code, exchange))?;
+        let (code, exchange) = (code.to_string(), exchange.to_string());
+
+        Ok(rdr.into_records().map(move |result| {
+            let record = result.map_err(|e| SamtraderError::Database {
+                reason: format!("CSV parse error: {}", e),
+            })?;
+            let date = date_field(&record)?;
+            let (open, high, low, close, volume) = price_fields(&record)?;
+            Ok(OhlcvBar {
+                code: code.clone(),
+                exchange: exchange.clone(),
+                date,
+                open,
+                high,
+                low,
+                close,
+                volume,
+            })
+        }))
+    }
+}
+
+fn open_csv(path: &Path) -> Result<csv::Reader<File>, SamtraderError> {
+    csv::Reader::from_path(path).map_err(|e| SamtraderError::Database {
+        reason: format!("failed to read {}: {}", path.display(), e),
+    })
+}
+
+/// Read the next record into `record`; false at end of file.
+fn next_record(
+    rdr: &mut csv::Reader<File>,
+    record: &mut StringRecord,
+) -> Result<bool, SamtraderError> {
+    rdr.read_record(record)
+        .map_err(|e| SamtraderError::Database {
+            reason: format!("CSV parse error: {}", e),
+        })
+}
+
+fn index_path(path: &Path) -> PathBuf {
+    let mut name = path.as_os_str().to_owned();
+    name.push(".idx");
+    PathBuf::from(name)
+}
+
+/// Length and mtime (nanoseconds since the epoch) identifying a file's
+/// contents; `None` where the platform has no mtime.
+fn file_stamp(meta: &fs::Metadata) -> Option<(u64, u64)> {
+    let mtime = meta.modified().ok()?.duration_since(UNIX_EPOCH).ok()?;
+    Some((meta.len(), mtime.as_nanos() as u64))
+}
+
+/// Sidecar index of one CSV file.
+#[derive(Debug, Clone, PartialEq)]
+struct CsvIndex {
+    /// `file_stamp` of the CSV the index was built from.
+    stamp: Option<(u64, u64)>,
+    /// Rows are in non-decreasing date order.
+    sorted: bool,
+    count: usize,
+    /// Earliest and latest date, if any rows.
+    bounds: Option<(NaiveDate, NaiveDate)>,
+    /// Date and starting byte offset of every `INDEX_STRIDE`th record.
+    entries: Vec<(NaiveDate, u64)>,
+}
+
+impl CsvIndex {
+    /// One streaming pass over the file, parsing only the date column.
+    fn build(path: &Path, stamp: Option<(u64, u64)>) -> Result<Self, SamtraderError> {
+        let mut rdr = open_csv(path)?;
+        let mut record = StringRecord::new();
+        let mut index = CsvIndex {
+            stamp,
+            sorted: true,
+            count: 0,
+            bounds: None,
+            entries: Vec::new(),
+        };
+        let mut prev: Option<NaiveDate> = None;
+
+        while next_record(&mut rdr, &mut record)? {
+            let date = date_field(&record)?;
+            if index.count % INDEX_STRIDE == 0 {
+                let offset = record.position().map_or(0, Position::byte);
+                index.entries.push((date, offset));
+            }
+            if prev.is_some_and(|p| date < p) {
+                index.sorted = false;
+            }
+            index.bounds = Some(match index.bounds {
+                Some((lo, hi)) => (lo.min(date), hi.max(date)),
+                None => (date, date),
+            });
+            prev = Some(date);
+            index.count += 1;
+        }
+
+        Ok(index)
+    }
+
+    /// Offset to start reading from so no row dated `start` or later is
+    /// skipped, when the file is sorted and has rows.
+    fn seek_offset(&self, start: NaiveDate) -> Option<u64> {
+        if !self.sorted {
+            return None;
+        }
+        let first_at_or_after = self.entries.partition_point(|(date, _)| *date < start);
+        self.entries
+            .get(first_at_or_after.saturating_sub(1))
+            .map(|&(_, offset)| offset)
+    }
+
+    fn to_bytes(&self) -> Vec<u8> {
+        let mut w = ByteWriter::new();
+        for &b in INDEX_MAGIC {
+            w.u8(b);
+        }
+        w.u32(INDEX_VERSION);
+        let (len, mtime) = self.stamp.unwrap_or_default();
+        w.u64(len);
+        w.u64(mtime);
+        w.bool(self.sorted);
+        w.usize(self.count);
+        w.bool(self.bounds.is_some());
+        if let Some((lo, hi)) = self.bounds {
+            w.date(lo);
+            w.date(hi);
+        }
+        w.usize(self.entries.len());
+        for &(date, offset) in &self.entries {
+            w.date(date);
+            w.u64(offset);
+        }
+        w.into_bytes()
+    }
+
+    fn from_bytes(bytes: &[u8]) -> Result<Self, SamtraderError> {
+        let mut r = ByteReader::new(bytes, "csv index");
+        for &b in INDEX_MAGIC {
+            if r.u8()? != b {
+                return Err(r.error("not a csv index"));
+            }
+        }
+        let version = r.u32()?;
+        if version != INDEX_VERSION {
+            return Err(r.error(format!("unsupported version {version}")));
+        }
+        let stamp = Some((r.u64()?, r.u64()?));
+        let sorted = r.bool()?;
+        let count = r.usize()?;
+        let bounds = if r.bool()? {
+            Some((r.date()?, r.date()?))
+        } else {
+            None
+        };
+        let len = r.count(12)?;
+        let entries = (0..len)
+            .map(|_| Ok((r.date()?, r.u64()?)))
+            .collect::<Result<Vec<_>, SamtraderError>>()?;
+        r.finish()?;
+        Ok(CsvIndex {
+            stamp,
+            sorted,
+            count,
+            bounds,
+            entries,
+        })
+    }
+}
+
+fn date_field(record: &StringRecord) -> Result<NaiveDate, SamtraderError> {
+    let date_str = record.get(0).ok_or_else(|| SamtraderError::Database {
+        reason: "missing date column".into(),
+    })?;
+    NaiveDate::parse_from_str(date_str, "%Y-%m-%d").map_err(|e| SamtraderError::Database {
+        reason: format!("invalid date format: {}", e),
+    })
+}
+
+fn field<T>(record: &StringRecord, index: usize, name: &str) -> Result<T, SamtraderError>
+where
+    T: FromStr,
+    T::Err: Display,
+{
+    record
+        .get(index)
+        .ok_or_else(|| SamtraderError::Database {
+            reason: format!("missing {} column", name),
+        })?
+        .parse()
+        .map_err(|e| SamtraderError::Database {
+            reason: format!("invalid {} value: {}", name, e),
+        })
+}
+
+/// Open, high, low, close and volume of a record.
+fn price_fields(record: &StringRecord) -> Result<(f64, f64, f64, f64, i64), SamtraderError> {
+    Ok((
+        field(record, 1, "open")?,
+        field(record, 2, "high")?,
+        field(record, 3, "low")?,
+        field(record, 4, "close")?,
+        field(record, 5, "volume")?,
+    ))
 }
 
 impl DataPort for CsvAdapter {
@@ -29,96 +332,54 @@ impl DataPort for CsvAdapter {
         start_date: NaiveDate,
         end_date: NaiveDate,
     ) -> Result<Vec<OhlcvBar>, SamtraderError> {
-        let path = self.csv_path(code, exchange);
-        let content = fs::read_to_string(&path).map_err(|e| SamtraderError::Database {
-            reason: format!("failed to read {}: {}", path.display(), e),
-        })?;
-
-        let mut rdr = csv::Reader::from_reader(content.as_bytes());
-        let mut bars = Vec::new();
+        let series = self.fetch_ohlcv_series(code, exchange, start_date, end_date)?;
+        Ok(series.to_bars(code, exchange))
+    }
 
-        for result in rdr.records() {
-            let record = result.map_err(|e| SamtraderError::Database {
-                reason: format!("CSV parse error: {}", e),
+    fn fetch_ohlcv_series(
+        &self,
+        code: &str,
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<OhlcvSeries, SamtraderError> {
+        let path = self.csv_path(code, exchange);
+        let mut rdr = open_csv(&path)?;
+        let index = if self.use_index {
+            Some(self.load_index(&path)?)
+        } else {
+            None
+        };
+        let sorted = index.as_ref().is_some_and(|i| i.sorted);
+        if let Some(offset) = index.as_ref().and_then(|i| i.seek_offset(start_date)) {
+            let mut pos = Position::new();
+            pos.set_byte(offset);
+            rdr.seek(pos).map_err(|e| SamtraderError::Database {
+                reason: format!("failed to seek {}: {}", path.display(), e),
             })?;
+        }
 
-            let date_str = record.get(0).ok_or_else(|| SamtraderError::Database {
-                reason: "missing date column".into(),
-            })?;
-            let date = NaiveDate::parse_from_str(date_str, "%Y-%m-%d").map_err(|e| {
-                SamtraderError::Database {
-                    reason: format!("invalid date format: {}", e),
+        let mut series = OhlcvSeries::new();
+        let mut record = StringRecord::new();
+        while next_record(&mut rdr, &mut record)? {
+            let date = date_field(&record)?;
+            if date < start_date {
+                continue;
+            }
+            if date > end_date {
+                if sorted {
+                    break;
                 }
-            })?;
-
-            if date < start_date || date > end_date {
                 continue;
             }
-
-            let open: f64 = record
-                .get(1)
-                .ok_or_else(|| SamtraderError::Database {
-                    reason: "missing open column".into(),
-                })?
-                .parse()
-                .map_err(|e| SamtraderError::Database {
-                    reason: format!("invalid open value: {}", e),
-                })?;
-
-            let high: f64 = record
-                .get(2)
-                .ok_or_else(|| SamtraderError::Database {
-                    reason: "missing high column".into(),
-                })?
-                .parse()
-                .map_err(|e| SamtraderError::Database {
-                    reason: format!("invalid high value: {}", e),
-                })?;
-
-            let low: f64 = record
-                .get(3)
-                .ok_or_else(|| SamtraderError::Database {
-                    reason: "missing low column".into(),
-                })?
-                .parse()
-                .map_err(|e| SamtraderError::Database {
-                    reason: format!("invalid low value: {}", e),
-                })?;
-
-            let close: f64 = record
-                .get(4)
-                .ok_or_else(|| SamtraderError::Database {
-                    reason: "missing close column".into(),
-                })?
-                .parse()
-                .map_err(|e| SamtraderError::Database {
-                    reason: format!("invalid close value: {}", e),
-                })?;
-
-            let volume: i64 = record
-                .get(5)
-                .ok_or_else(|| SamtraderError::Database {
-                    reason: "missing volume column".into(),
-                })?
-                .parse()
-                .map_err(|e| SamtraderError::Database {
-                    reason: format!("invalid volume value: {}", e),
-                })?;
-
-            bars.push(OhlcvBar {
-                code: code.to_string(),
-                exchange: exchange.to_string(),
-                date,
-                open,
-                high,
-                low,
-                close,
-                volume,
-            });
+            let (open, high, low, close, volume) = price_fields(&record)?;
+            series.push(date, open, high, low, close, volume);
         }
 
-        bars.sort_by_key(|b| b.date);
-        Ok(bars)
+        if !sorted {
+            series.sort_by_date();
+        }
+        Ok(series)
     }
 
     fn list_symbols(&self, exchange: &str) -> Result<Vec<String>, SamtraderError> {
@@ -162,41 +423,8 @@ impl DataPort for CsvAdapter {
             return Ok(None);
         }
 
-        let content = fs::read_to_string(&path).map_err(|e| SamtraderError::Database {
-            reason: format!("failed to read {}: {}", path.display(), e),
-        })?;
-
-        let mut rdr = csv::Reader::from_reader(content.as_bytes());
-        let mut dates = Vec::new();
-
-        for result in rdr.records() {
-            let record = result.map_err(|e| SamtraderError::Database {
-                reason: format!("CSV parse error: {}", e),
-            })?;
-
-            let date_str = record.get(0).ok_or_else(|| SamtraderError::Database {
-                reason: "missing date column".into(),
-            })?;
-
-            let date = NaiveDate::parse_from_str(date_str, "%Y-%m-%d").map_err(|e| {
-                SamtraderError::Database {
-                    reason: format!("invalid date format: {}", e),
-                }
-            })?;
-
-            dates.push(date);
-        }
-
-        if dates.is_empty() {
-            return Ok(None);
-        }
-
-        dates.sort();
-        let min_date = *dates.first().unwrap();
-        let max_date = *dates.last().unwrap();
-        let count = dates.len();
-
-        Ok(Some((min_date, max_date, count)))
+        let index = self.load_index(&path)?;
+        Ok(index.bounds.map(|(lo, hi)| (lo, hi, index.count)))
     }
 }
 
@@ -260,6 +488,34 @@ mod tests {
         assert_eq!(bars[0].date, NaiveDate::from_ymd_opt(2024, 1, 16).unwrap());
     }
 
+    #[test]
+    fn fetch_ohlcv_series_is_sorted_columns() {
+        let dir = TempDir::new().unwrap();
+        let path = dir.path().to_path_buf();
+        fs::write(
+            path.join("BHP_ASX.csv"),
+            "date,open,high,low,close,volume\n\
+             2024-01-17,110.0,120.0,105.0,115.0,55000\n\
+             2024-01-15,100.0,110.0,90.0,105.0,50000\n",
+        )
+        .unwrap();
+        let adapter = CsvAdapter::new(path);
+
+        let start = NaiveDate::from_ymd_opt(2024, 1, 1).unwrap();
+        let end = NaiveDate::from_ymd_opt(2024, 1, 31).unwrap();
+        let series = adapter
+            .fetch_ohlcv_series("BHP", "ASX", start, end)
+            .unwrap();
+
+        assert_eq!(series.len(), 2);
+        assert_eq!(
+            series.date[0],
+            NaiveDate::from_ymd_opt(2024, 1, 15).unwrap()
+        );
+        assert_eq!(series.close, vec![105.0, 115.0]);
+        assert_eq!(series.volume, vec![50000, 55000]);
+    }
+
     #[test]
     fn fetch_ohlcv_returns_empty_for_missing_file() {
         let (_dir, path) = setup_test_data();
@@ -306,6 +562,127 @@ mod tests {
         assert!(range.is_none());
     }
 
+    #[test]
+    fn list_files_and_read_bars_stream_rows() {
+        let (_dir, path) = setup_test_data();
+        fs::write(path.join("notes.txt"), "not data").unwrap();
+        let adapter = CsvAdapter::new(path);
+
+        assert_eq!(
+            adapter.list_files().unwrap(),
+            vec![
+                ("AAPL".to_string(), "NYSE".to_string()),
+                ("BHP".to_string(), "ASX".to_string()),
+                ("CBA".to_string(), "ASX".to_string()),
+            ]
+        );
+
+        let bars: Vec<OhlcvBar> = adapter
+            .read_bars("BHP", "ASX")
+            .unwrap()
+            .collect::<Result<_, _>>()
+            .unwrap();
+        let start = NaiveDate::from_ymd_opt(2024, 1, 1).unwrap();
+        let end = NaiveDate::from_ymd_opt(2024, 12, 31).unwrap();
+        assert_eq!(bars.len(), 3);
+        assert_eq!(bars[2].code, "BHP");
+        assert_eq!(
+            OhlcvSeries::from(bars),
+            adapter
+                .fetch_ohlcv_series("BHP", "ASX", start, end)
+                .unwrap()
+        );
+        assert_eq!(adapter.read_bars("CBA", "ASX").unwrap().count(), 0);
+        assert!(adapter.read_bars("XYZ", "ASX").is_err());
+    }
+
+    fn write_daily_csv(path: &Path, start: NaiveDate, days: usize) {
+        let mut content = String::from("date,open,high,low,close,volume\n");
+        for i in 0..days {
+            let date = start + chrono::Duration::days(i as i64);
+            content.push_str(&format!(
+                "{},{}.0,{}.5,{}.0,{}.25,{}\n",
+                date, i, i, i, i, i
+            ));
+        }
+        fs::write(path, content).unwrap();
+    }
+
+    #[test]
+    fn indexed_range_reads_match_full_scan() {
+        let dir = TempDir::new().unwrap();
+        let start = NaiveDate::from_ymd_opt(2020, 1, 1).unwrap();
+        write_daily_csv(&dir.path().join("BHP_ASX.csv"), start, 500);
+        let indexed = CsvAdapter::new(dir.path().to_path_buf());
+        let scanned = CsvAdapter::new(dir.path().to_path_buf()).without_index();
+
+        let d = |days: i64| start + chrono::Duration::days(days);
+        for (from, to) in [
+            (0, 499),
+            (130, 140),
+            (64, 64),
+            (63, 200),
+            (-10, 3),
+            (490, 900),
+            (600, 700),
+        ] {
+            let expected = scanned
+                .fetch_ohlcv_series("BHP", "ASX", d(from), d(to))
+                .unwrap();
+            let got = indexed
+                .fetch_ohlcv_series("BHP", "ASX", d(from), d(to))
+                .unwrap();
+            assert_eq!(got, expected, "range {from}..={to}");
+        }
+        let window = indexed
+            .fetch_ohlcv_series("BHP", "ASX", d(130), d(140))
+            .unwrap();
+        assert_eq!(window.len(), 11);
+        assert_eq!(window.volume[0], 130);
+
+        assert!(dir.path().join("BHP_ASX.csv.idx").exists());
+        assert_eq!(
+            indexed.get_data_range("BHP", "ASX").unwrap(),
+            Some((d(0), d(499), 500))
+        );
+    }
+
+    #[test]
+    fn stale_or_corrupt_sidecar_is_rebuilt() {
+        let dir = TempDir::new().unwrap();
+        let csv = dir.path().join("BHP_ASX.csv");
+        let start = NaiveDate::from_ymd_opt(2020, 1, 1).unwrap();
+        write_daily_csv(&csv, start, 100);
+        let adapter = CsvAdapter::new(dir.path().to_path_buf());
+        assert_eq!(
+            adapter.get_data_range("BHP", "ASX").unwrap().unwrap().2,
+            100
+        );
+
+        write_daily_csv(&csv, start, 150);
+        let end = start + chrono::Duration::days(149);
+        assert_eq!(
+            adapter.get_data_range("BHP", "ASX").unwrap(),
+            Some((start, end, 150))
+        );
+
+        fs::write(dir.path().join("BHP_ASX.csv.idx"), b"garbage").unwrap();
+        let series = adapter.fetch_ohlcv_series("BHP", "ASX", end, end).unwrap();
+        assert_eq!(series.volume, vec![149]);
+    }
+
+    #[test]
+    fn without_index_writes_no_sidecar() {
+        let (dir, path) = setup_test_data();
+        let adapter = CsvAdapter::new(path).without_index();
+
+        let start = NaiveDate::from_ymd_opt(2024, 1, 16).unwrap();
+        let bars = adapter.fetch_ohlcv("BHP", "ASX", start, start).unwrap();
+        assert_eq!(bars.len(), 1);
+        assert_eq!(adapter.get_data_range("BHP", "ASX").unwrap().unwrap().2, 3);
+        assert!(!dir.path().join("BHP_ASX.csv.idx").exists());
+    }
+
     #[test]
     fn get_data_range_returns_none_for_empty_csv() {
         let (_dir, path) = setup_test_data();
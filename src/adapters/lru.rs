@@ -0,0 +1,218 @@
+//! Byte-bounded least-recently-used map shared by the adapter caches.
+//!
+//! Entries live in a slab; a map from key to slab index plus a recency list
+//! threaded through the slab make lookup, touch, insert and eviction O(1).
+//! Each entry is charged the byte size its caller gives it, and inserting
+//! evicts from the least recently used end until the total is back under
+//! capacity.
+
+use std::borrow::Borrow;
+use std::collections::HashMap;
+use std::hash::Hash;
+
+/// Marks the ends of the recency list.
+const NIL: usize = usize::MAX;
+
+#[derive(Debug)]
+struct Slot<K, V> {
+    key: K,
+    value: V,
+    bytes: usize,
+    prev: usize,
+    next: usize,
+}
+
+/// LRU over a slab of slots; `head` is the most recently used.
+#[derive(Debug)]
+pub struct Lru<K, V> {
+    index: HashMap<K, usize>,
+    slots: Vec<Option<Slot<K, V>>>,
+    free: Vec<usize>,
+    head: usize,
+    tail: usize,
+    bytes: usize,
+    capacity: usize,
+}
+
+impl<K: Eq + Hash + Clone, V> Lru<K, V> {
+    pub fn new(capacity: usize) -> Self {
+        Lru {
+            index: HashMap::new(),
+            slots: Vec::new(),
+            free: Vec::new(),
+            head: NIL,
+            tail: NIL,
+            bytes: 0,
+            capacity,
+        }
+    }
+
+    /// Bytes charged for the entries currently held.
+    pub fn bytes(&self) -> usize {
+        self.bytes
+    }
+
+    fn slot(&mut self, i: usize) -> &mut Slot<K, V> {
+        self.slots[i].as_mut().expect("linked slot is live")
+    }
+
+    fn unlink(&mut self, i: usize) {
+        let (prev, next) = {
+            let slot = self.slot(i);
+            (slot.prev, slot.next)
+        };
+        match prev {
+            NIL => self.head = next,
+            p => self.slot(p).next = next,
+        }
+        match next {
+            NIL => self.tail = prev,
+            n => self.slot(n).prev = prev,
+        }
+    }
+
+    fn push_front(&mut self, i: usize) {
+        let head = self.head;
+        let slot = self.slot(i);
+        slot.prev = NIL;
+        slot.next = head;
+        match head {
+            NIL => self.tail = i,
+            h => self.slot(h).prev = i,
+        }
+        self.head = i;
+    }
+
+    fn remove_slot(&mut self, i: usize) -> Slot<K, V> {
+        self.unlink(i);
+        let slot = self.slots[i].take().expect("linked slot is live");
+        self.bytes -= slot.bytes;
+        self.index.remove(&slot.key);
+        self.free.push(i);
+        slot
+    }
+
+    /// The value for `key`, without counting as a use.
+    pub fn peek<Q>(&self, key: &Q) -> Option<&V>
+    where
+        K: Borrow<Q>,
+        Q: Eq + Hash + ?Sized,
+    {
+        let i = *self.index.get(key)?;
+        self.slots[i].as_ref().map(|slot| &slot.value)
+    }
+
+    /// The value for `key`, marked most recently used.
+    pub fn get<Q>(&mut self, key: &Q) -> Option<&V>
+    where
+        K: Borrow<Q>,
+        Q: Eq + Hash + ?Sized,
+    {
+        let i = *self.index.get(key)?;
+        self.unlink(i);
+        self.push_front(i);
+        Some(&self.slot(i).value)
+    }
+
+    pub fn remove<Q>(&mut self, key: &Q) -> Option<V>
+    where
+        K: Borrow<Q>,
+        Q: Eq + Hash + ?Sized,
+    {
+        let i = *self.index.get(key)?;
+        Some(self.remove_slot(i).value)
+    }
+
+    /// Insert as most recently used, replacing any entry under `key`, then
+    /// evict from the tail until back under capacity. The new entry itself
+    /// is always kept.
+    pub fn insert(&mut self, key: K, value: V, bytes: usize) {
+        if let Some(&i) = self.index.get(&key) {
+            self.remove_slot(i);
+        }
+        let slot = Slot {
+            key: key.clone(),
+            value,
+            bytes,
+            prev: NIL,
+            next: NIL,
+        };
+        let i = match self.free.pop() {
+            Some(i) => {
+                self.slots[i] = Some(slot);
+                i
+            }
+            None => {
+                self.slots.push(Some(slot));
+                self.slots.len() - 1
+            }
+        };
+        self.index.insert(key, i);
+        self.push_front(i);
+        self.bytes += bytes;
+
+        while self.bytes > self.capacity && self.tail != i {
+            self.remove_slot(self.tail);
+        }
+    }
+
+    /// Drop every entry `keep` rejects. O(n); for bulk invalidation only.
+    pub fn retain(&mut self, mut keep: impl FnMut(&K, &V) -> bool) {
+        for i in 0..self.slots.len() {
+            if let Some(slot) = &self.slots[i]
+                && !keep(&slot.key, &slot.value)
+            {
+                self.remove_slot(i);
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn evicts_least_recently_used_by_bytes() {
+        let mut lru = Lru::new(30);
+        for key in ["a", "b", "c"] {
+            lru.insert(key.to_string(), key, 10);
+        }
+        assert_eq!(lru.bytes(), 30);
+
+        // Touch "a" so "b" is now the least recently used; peeking at "b"
+        // does not save it.
+        assert_eq!(lru.get("a"), Some(&"a"));
+        assert_eq!(lru.peek("b"), Some(&"b"));
+        lru.insert("d".to_string(), "d", 10);
+        assert!(lru.peek("b").is_none());
+        assert!(lru.peek("a").is_some() && lru.peek("c").is_some());
+
+        // An entry larger than the whole budget evicts everything else but
+        // is itself kept.
+        lru.insert("big".to_string(), "big", 50);
+        assert_eq!(lru.bytes(), 50);
+        assert!(lru.peek("a").is_none() && lru.peek("d").is_none());
+    }
+
+    #[test]
+    fn reinsert_remove_and_retain_keep_bytes_exact() {
+        let mut lru = Lru::new(usize::MAX);
+        lru.insert("a".to_string(), 1, 10);
+        lru.insert("a".to_string(), 2, 12);
+        lru.insert("b".to_string(), 3, 5);
+        assert_eq!(lru.bytes(), 17);
+        assert_eq!(lru.peek("a"), Some(&2));
+
+        assert_eq!(lru.remove("b"), Some(3));
+        assert_eq!(lru.remove("b"), None);
+        assert_eq!(lru.bytes(), 12);
+
+        // Freed slots are reused and stay linked correctly.
+        lru.insert("c".to_string(), 4, 1);
+        lru.retain(|key, _| key != "a");
+        assert_eq!(lru.bytes(), 1);
+        assert!(lru.peek("a").is_none());
+        assert_eq!(lru.get("c"), Some(&4));
+    }
+}
@@ -0,0 +1,577 @@
+//! Memory-mapped columnar bar cache (TRD Section 3.2, 11.1).
+//!
+//! `export_bar_cache` snapshots a universe from any `DataPort` into a single
+//! binary file; `MmapAdapter` maps that file read-only and answers range
+//! queries straight from the mapped columns: dates are binary-searched and
+//! the matching slice of each column is copied into an `OhlcvSeries`, with
+//! no text parsing and no per-row strings. The mapping is shared through
+//! the page cache, so concurrent processes (sweep workers, the web server)
+//! pay for the file once.
+//!
+//! File layout (all integers little-endian):
+//!
+//! ```text
+//! page 0     header: MAGIC, VERSION u32, PAGE_SIZE u32, entry count u64,
+//!            directory offset u64, directory length u64; zero-padded
+//! page k..   one block per code, each starting on a page boundary:
+//!              date   i32 x n   (days from the common era)
+//!              pad to 8 bytes
+//!              open, high, low, close   f64 x n each
+//!              volume i64 x n
+//! last       directory: per code: code, exchange (length-prefixed UTF-8),
+//!            bar count u64, block offset u64
+//! ```
+//!
+//! Bars within a block are in ascending date order. The writer builds the
+//! file under a temporary name and renames it into place, so a running
+//! reader keeps its consistent (old) mapping.
+
+use crate::domain::codec::{ByteReader, ByteWriter};
+use crate::domain::error::SamtraderError;
+use crate::domain::ohlcv::{OhlcvBar, OhlcvSeries};
+use crate::ports::config_port::ConfigPort;
+use crate::ports::data_port::DataPort;
+use chrono::{Datelike, NaiveDate};
+use memmap2::Mmap;
+use std::collections::{BTreeMap, HashMap};
+use std::fs::{self, File};
+use std::io::{BufWriter, Seek, SeekFrom, Write};
+use std::path::{Path, PathBuf};
+
+const MAGIC: &[u8; 8] = b"SAMBARS\0";
+const VERSION: u32 = 1;
+const PAGE_SIZE: u64 = 4096;
+const HEADER_LEN: usize = 8 + 4 + 4 + 8 + 8 + 8;
+
+fn align_up(n: u64, to: u64) -> u64 {
+    n.div_ceil(to) * to
+}
+
+/// Byte offsets of one code's columns relative to its block.
+#[derive(Debug, Clone, Copy)]
+struct Layout {
+    len: usize,
+}
+
+impl Layout {
+    /// Start of the f64 column `k` (0 = open .. 3 = close), or 4 for volume.
+    fn column(&self, k: usize) -> usize {
+        align_up(4 * self.len as u64, 8) as usize + k * 8 * self.len
+    }
+
+    fn size(&self) -> usize {
+        self.column(5)
+    }
+}
+
+/// One code's block in the mapped file.
+#[derive(Debug, Clone)]
+struct Entry {
+    offset: usize,
+    layout: Layout,
+}
+
+/// Incrementally writes a bar cache file, one code at a time.
+pub struct BarCacheWriter {
+    path: PathBuf,
+    tmp_path: PathBuf,
+    out: BufWriter<File>,
+    offset: u64,
+    directory: ByteWriter,
+    entries: u64,
+}
+
+impl BarCacheWriter {
+    pub fn create(path: &Path) -> Result<Self, SamtraderError> {
+        let mut tmp = path.as_os_str().to_owned();
+        tmp.push(".tmp");
+        let tmp_path = PathBuf::from(tmp);
+        let mut out = BufWriter::new(File::create(&tmp_path)?);
+        // Header is filled in by `finish`; reserve its page now.
+        out.write_all(&[0u8; PAGE_SIZE as usize])?;
+        Ok(BarCacheWriter {
+            path: path.to_path_buf(),
+            tmp_path,
+            out,
+            offset: PAGE_SIZE,
+            directory: ByteWriter::new(),
+            entries: 0,
+        })
+    }
+
+    /// Append one code's bars (ascending by date).
+    pub fn add(
+        &mut self,
+        code: &str,
+        exchange: &str,
+        bars: &OhlcvSeries,
+    ) -> Result<(), SamtraderError> {
+        debug_assert!(bars.date.windows(2).all(|w| w[0] <= w[1]));
+        let layout = Layout { len: bars.len() };
+
+        for date in &bars.date {
+            self.out.write_all(&date.num_days_from_ce().to_le_bytes())?;
+        }
+        let pad = layout.column(0) - 4 * bars.len();
+        self.out.write_all(&[0u8; 8][..pad])?;
+        for column in [&bars.open, &bars.high, &bars.low, &bars.close] {
+            for v in column {
+                self.out.write_all(&v.to_le_bytes())?;
+            }
+        }
+        for v in &bars.volume {
+            self.out.write_all(&v.to_le_bytes())?;
+        }
+
+        self.directory.str(code);
+        self.directory.str(exchange);
+        self.directory.usize(bars.len());
+        self.directory.u64(self.offset);
+        self.entries += 1;
+
+        let end = self.offset + layout.size() as u64;
+        let next = align_up(end, PAGE_SIZE);
+        self.out.write_all(&vec![0u8; (next - end) as usize])?;
+        self.offset = next;
+        Ok(())
+    }
+
+    /// Write the directory and header and move the file into place.
+    pub fn finish(mut self) -> Result<(), SamtraderError> {
+        let directory = std::mem::take(&mut self.directory).into_bytes();
+        self.out.write_all(&directory)?;
+
+        let mut header = ByteWriter::new();
+        for &b in MAGIC {
+            header.u8(b);
+        }
+        header.u32(VERSION);
+        header.u32(PAGE_SIZE as u32);
+        header.u64(self.entries);
+        header.u64(self.offset);
+        header.usize(directory.len());
+        self.out.seek(SeekFrom::Start(0))?;
+        self.out.write_all(&header.into_bytes())?;
+
+        let file = self.out.into_inner().map_err(|e| e.into_error())?;
+        file.sync_all()?;
+        fs::rename(&self.tmp_path, &self.path)?;
+        Ok(())
+    }
+}
+
+/// Snapshot every bar of `codes` on `exchange` from `source` into a cache
+/// file at `path`. Returns the number of bars written.
+pub fn export_bar_cache(
+    source: &dyn DataPort,
+    codes: &[String],
+    exchange: &str,
+    path: &Path,
+) -> Result<usize, SamtraderError> {
+    let mut writer = BarCacheWriter::create(path)?;
+    let mut total = 0;
+    for code in codes {
+        let bars = match source.get_data_range(code, exchange)? {
+            Some((first, last, _)) => source.fetch_ohlcv_series(code, exchange, first, last)?,
+            None => OhlcvSeries::new(),
+        };
+        total += bars.len();
+        writer.add(code, exchange, &bars)?;
+    }
+    writer.finish()?;
+    Ok(total)
+}
+
+/// Read-only `DataPort` over a mapped bar cache file.
+pub struct MmapAdapter {
+    map: Mmap,
+    entries: HashMap<(String, String), Entry>,
+    /// Codes per exchange, sorted, for `list_symbols`.
+    symbols: BTreeMap<String, Vec<String>>,
+}
+
+impl MmapAdapter {
+    /// Open the cache named by `[mmap] path`.
+    pub fn from_config(config: &dyn ConfigPort) -> Result<Self, SamtraderError> {
+        let path =
+            config
+                .get_string("mmap", "path")
+                .ok_or_else(|| SamtraderError::ConfigMissing {
+                    section: "mmap".into(),
+                    key: "path".into(),
+                })?;
+        Self::open(Path::new(&path))
+    }
+
+    pub fn open(path: &Path) -> Result<Self, SamtraderError> {
+        let file = File::open(path)?;
+        // SAFETY: the file is only ever replaced by rename, never modified
+        // in place, so the mapped bytes stay fixed for the mapping's life.
+        let map = unsafe { Mmap::map(&file)? };
+        let (entries, symbols) = read_directory(&map)?;
+        Ok(MmapAdapter {
+            map,
+            entries,
+            symbols,
+        })
+    }
+
+    fn entry(&self, code: &str, exchange: &str) -> Option<&Entry> {
+        self.entries.get(&(code.to_string(), exchange.to_string()))
+    }
+
+    fn block(&self, entry: &Entry) -> &[u8] {
+        &self.map[entry.offset..entry.offset + entry.layout.size()]
+    }
+
+    /// Day number of bar `i` in `block`.
+    fn day(block: &[u8], i: usize) -> i32 {
+        i32::from_le_bytes(block[4 * i..4 * i + 4].try_into().unwrap())
+    }
+
+    /// Bars `start..end` of `entry`'s block as a series.
+    fn slice(&self, entry: &Entry, start: usize, end: usize) -> OhlcvSeries {
+        let block = self.block(entry);
+        let layout = entry.layout;
+        let f64s = |k: usize| -> Vec<f64> {
+            let base = layout.column(k);
+            block[base + 8 * start..base + 8 * end]
+                .chunks_exact(8)
+                .map(|b| f64::from_le_bytes(b.try_into().unwrap()))
+                .collect()
+        };
+        let volume_base = layout.column(4);
+        OhlcvSeries {
+            date: (start..end)
+                .map(|i| {
+                    NaiveDate::from_num_days_from_ce_opt(Self::day(block, i))
+                        .expect("validated on open")
+                })
+                .collect(),
+            open: f64s(0),
+            high: f64s(1),
+            low: f64s(2),
+            close: f64s(3),
+            volume: block[volume_base + 8 * start..volume_base + 8 * end]
+                .chunks_exact(8)
+                .map(|b| i64::from_le_bytes(b.try_into().unwrap()))
+                .collect(),
+        }
+    }
+
+    /// Index range of bars dated within `[start_date, end_date]`.
+    fn range(&self, entry: &Entry, start_date: NaiveDate, end_date: NaiveDate) -> (usize, usize) {
+        let block = self.block(entry);
+        let (lo, hi) = (start_date.num_days_from_ce(), end_date.num_days_from_ce());
+        let first = partition_point(entry.layout.len, |i| Self::day(block, i) < lo);
+        let end = partition_point(entry.layout.len, |i| Self::day(block, i) <= hi);
+        (first, end.max(first))
+    }
+}
+
+/// First index in `0..len` for which `pred` is false (`pred` must be
+/// true on a prefix).
+fn partition_point(len: usize, pred: impl Fn(usize) -> bool) -> usize {
+    let (mut lo, mut hi) = (0, len);
+    while lo < hi {
+        let mid = lo + (hi - lo) / 2;
+        if pred(mid) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    lo
+}
+
+type Directory = (
+    HashMap<(String, String), Entry>,
+    BTreeMap<String, Vec<String>>,
+);
+
+/// Validate the header and directory and check every block lies inside the
+/// file with dates in range, so lookups need no further checks.
+fn read_directory(bytes: &[u8]) -> Result<Directory, SamtraderError> {
+    let header = bytes.get(..HEADER_LEN).unwrap_or(bytes);
+    let mut r = ByteReader::new(header, "bar cache");
+    for &b in MAGIC {
+        if r.u8()? != b {
+            return Err(r.error("not a bar cache file"));
+        }
+    }
+    let version = r.u32()?;
+    if version != VERSION {
+        return Err(r.error(format!("unsupported version {version}")));
+    }
+    let page_size = r.u32()?;
+    if u64::from(page_size) != PAGE_SIZE {
+        return Err(r.error(format!("unsupported page size {page_size}")));
+    }
+    let count = r.u64()?;
+    let dir_offset = r.usize()?;
+    let dir_len = r.usize()?;
+    let dir_bytes = dir_offset
+        .checked_add(dir_len)
+        .and_then(|end| bytes.get(dir_offset..end))
+        .ok_or_else(|| r.error("directory out of bounds"))?;
+
+    let mut r = ByteReader::new(dir_bytes, "bar cache");
+    let mut entries = HashMap::new();
+    let mut symbols: BTreeMap<String, Vec<String>> = BTreeMap::new();
+    for _ in 0..count {
+        let code = r.string()?;
+        let exchange = r.string()?;
+        let len = r.usize()?;
+        let offset = r.usize()?;
+        let layout = Layout { len };
+        let in_bounds = len <= bytes.len() / 44
+            && offset % PAGE_SIZE as usize == 0
+            && offset
+                .checked_add(layout.size())
+                .is_some_and(|end| end <= dir_offset);
+        if !in_bounds {
+            return Err(r.error(format!("block of {code}.{exchange} out of bounds")));
+        }
+        let block = &bytes[offset..offset + layout.size()];
+        for i in 0..len {
+            let day = MmapAdapter::day(block, i);
+            let valid = NaiveDate::from_num_days_from_ce_opt(day).is_some()
+                && (i == 0 || MmapAdapter::day(block, i - 1) <= day);
+            if !valid {
+                return Err(r.error(format!("bad date at bar {i} of {code}.{exchange}")));
+            }
+        }
+        symbols
+            .entry(exchange.clone())
+            .or_default()
+            .push(code.clone());
+        entries.insert((code, exchange), Entry { offset, layout });
+    }
+    r.finish()?;
+    for codes in symbols.values_mut() {
+        codes.sort();
+    }
+    Ok((entries, symbols))
+}
+
+impl DataPort for MmapAdapter {
+    fn fetch_ohlcv(
+        &self,
+        code: &str,
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<Vec<OhlcvBar>, SamtraderError> {
+        self.fetch_ohlcv_series(code, exchange, start_date, end_date)
+            .map(|series| series.to_bars(code, exchange))
+    }
+
+    fn fetch_ohlcv_series(
+        &self,
+        code: &str,
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<OhlcvSeries, SamtraderError> {
+        Ok(match self.entry(code, exchange) {
+            Some(entry) => {
+                let (start, end) = self.range(entry, start_date, end_date);
+                self.slice(entry, start, end)
+            }
+            None => OhlcvSeries::new(),
+        })
+    }
+
+    fn list_symbols(&self, exchange: &str) -> Result<Vec<String>, SamtraderError> {
+        Ok(self.symbols.get(exchange).cloned().unwrap_or_default())
+    }
+
+    fn get_data_range(
+        &self,
+        code: &str,
+        exchange: &str,
+    ) -> Result<Option<(NaiveDate, NaiveDate, usize)>, SamtraderError> {
+        let Some(entry) = self.entry(code, exchange).filter(|e| e.layout.len > 0) else {
+            return Ok(None);
+        };
+        let block = self.block(entry);
+        let date = |i| NaiveDate::from_num_days_from_ce_opt(Self::day(block, i)).unwrap();
+        let len = entry.layout.len;
+        Ok(Some((date(0), date(len - 1), len)))
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn series(n: usize, start: &str, base: f64) -> OhlcvSeries {
+        let start = NaiveDate::parse_from_str(start, "%Y-%m-%d").unwrap();
+        let mut s = OhlcvSeries::new();
+        for i in 0..n {
+            let close = base + i as f64 * 0.5;
+            s.push(
+                start + chrono::Duration::days(i as i64),
+                close - 0.25,
+                close + 1.0,
+                close - 1.0,
+                close,
+                1000 + i as i64,
+            );
+        }
+        s
+    }
+
+    fn write_cache(dir: &Path, codes: &[(&str, &str, OhlcvSeries)]) -> PathBuf {
+        let path = dir.join("bars.cache");
+        let mut writer = BarCacheWriter::create(&path).unwrap();
+        for (code, exchange, bars) in codes {
+            writer.add(code, exchange, bars).unwrap();
+        }
+        writer.finish().unwrap();
+        path
+    }
+
+    fn d(s: &str) -> NaiveDate {
+        NaiveDate::parse_from_str(s, "%Y-%m-%d").unwrap()
+    }
+
+    #[test]
+    fn round_trips_series_and_ranges() {
+        let dir = tempfile::TempDir::new().unwrap();
+        let bhp = series(700, "2020-01-01", 40.0);
+        let cba = series(3, "2021-06-01", 90.0);
+        let path = write_cache(
+            dir.path(),
+            &[("BHP", "ASX", bhp.clone()), ("CBA", "ASX", cba.clone())],
+        );
+
+        let cache = MmapAdapter::open(&path).unwrap();
+        let all = cache
+            .fetch_ohlcv_series("BHP", "ASX", NaiveDate::MIN, NaiveDate::MAX)
+            .unwrap();
+        assert_eq!(all, bhp);
+
+        let window = cache
+            .fetch_ohlcv_series("BHP", "ASX", d("2020-03-01"), d("2020-03-10"))
+            .unwrap();
+        assert_eq!(window.len(), 10);
+        assert_eq!(window.date[0], d("2020-03-01"));
+        assert_eq!(window.close, bhp.close[60..70]);
+
+        let rows = cache
+            .fetch_ohlcv("CBA", "ASX", d("2021-06-02"), d("2030-01-01"))
+            .unwrap();
+        assert_eq!(rows.len(), 2);
+        assert_eq!(rows[0].code, "CBA");
+        assert_eq!(rows[0].date, d("2021-06-02"));
+        assert_eq!(rows[1].close, cba.close[2]);
+    }
+
+    #[test]
+    fn unknown_codes_and_empty_ranges() {
+        let dir = tempfile::TempDir::new().unwrap();
+        let path = write_cache(
+            dir.path(),
+            &[
+                ("BHP", "ASX", series(10, "2020-01-01", 40.0)),
+                ("EMPTY", "ASX", OhlcvSeries::new()),
+            ],
+        );
+        let cache = MmapAdapter::open(&path).unwrap();
+
+        assert!(
+            cache
+                .fetch_ohlcv_series("XYZ", "ASX", NaiveDate::MIN, NaiveDate::MAX)
+                .unwrap()
+                .is_empty()
+        );
+        assert!(
+            cache
+                .fetch_ohlcv_series("BHP", "NYSE", NaiveDate::MIN, NaiveDate::MAX)
+                .unwrap()
+                .is_empty()
+        );
+        assert!(
+            cache
+                .fetch_ohlcv_series("BHP", "ASX", d("2021-01-01"), d("2020-01-01"))
+                .unwrap()
+                .is_empty()
+        );
+        assert_eq!(cache.get_data_range("EMPTY", "ASX").unwrap(), None);
+        assert_eq!(
+            cache.get_data_range("BHP", "ASX").unwrap(),
+            Some((d("2020-01-01"), d("2020-01-10"), 10))
+        );
+        assert_eq!(cache.list_symbols("ASX").unwrap(), ["BHP", "EMPTY"]);
+        assert!(cache.list_symbols("NYSE").unwrap().is_empty());
+    }
+
+    #[test]
+    fn export_from_another_port() {
+        struct Source(OhlcvSeries);
+        impl DataPort for Source {
+            fn fetch_ohlcv(
+                &self,
+                code: &str,
+                exchange: &str,
+                _start: NaiveDate,
+                _end: NaiveDate,
+            ) -> Result<Vec<OhlcvBar>, SamtraderError> {
+                Ok(self.0.to_bars(code, exchange))
+            }
+            fn list_symbols(&self, _exchange: &str) -> Result<Vec<String>, SamtraderError> {
+                Ok(Vec::new())
+            }
+            fn get_data_range(
+                &self,
+                _code: &str,
+                _exchange: &str,
+            ) -> Result<Option<(NaiveDate, NaiveDate, usize)>, SamtraderError> {
+                let last = self.0.len() - 1;
+                Ok(Some((self.0.date[0], self.0.date[last], self.0.len())))
+            }
+        }
+
+        let dir = tempfile::TempDir::new().unwrap();
+        let path = dir.path().join("universe.cache");
+        let bars = series(25, "2022-01-03", 10.0);
+        let codes = vec!["BHP".to_string(), "RIO".to_string()];
+
+        let written = export_bar_cache(&Source(bars.clone()), &codes, "ASX", &path).unwrap();
+
+        assert_eq!(written, 50);
+        let cache = MmapAdapter::open(&path).unwrap();
+        let batch = cache
+            .fetch_ohlcv_batch(&codes, "ASX", NaiveDate::MIN, NaiveDate::MAX)
+            .unwrap();
+        assert_eq!(batch, vec![bars.clone(), bars]);
+    }
+
+    #[test]
+    fn rejects_corrupt_files() {
+        let dir = tempfile::TempDir::new().unwrap();
+        let path = write_cache(
+            dir.path(),
+            &[("BHP", "ASX", series(10, "2020-01-01", 40.0))],
+        );
+        let bytes = fs::read(&path).unwrap();
+
+        let bad = dir.path().join("bad.cache");
+        fs::write(&bad, b"not a cache").unwrap();
+        assert!(matches!(
+            MmapAdapter::open(&bad),
+            Err(SamtraderError::Decode { .. })
+        ));
+
+        fs::write(&bad, &bytes[..bytes.len() - 3]).unwrap();
+        assert!(MmapAdapter::open(&bad).is_err());
+
+        // Swap two dates so the column is no longer sorted.
+        let mut unsorted = bytes.clone();
+        let page = PAGE_SIZE as usize;
+        unsorted.copy_within(page..page + 4, page + 8);
+        fs::write(&bad, &unsorted).unwrap();
+        assert!(MmapAdapter::open(&bad).is_err());
+    }
+}
@@ -1,9 +1,12 @@
 //! Concrete adapter implementations for ports (TRD Section 2.2).
 
+pub mod cached_data_port;
 pub mod csv_adapter;
 pub mod file_config_adapter;
 #[cfg(any(feature = "web-sqlite", feature = "web-postgres"))]
 pub mod html_report_adapter;
+pub mod lru;
+pub mod mmap_adapter;
 #[cfg(feature = "postgres")]
 pub mod postgres_adapter;
 #[cfg(feature = "sqlite")]
@@ -1,14 +1,18 @@
 //! PostgreSQL data adapter (TRD Section 2.2).
 
 use crate::domain::error::SamtraderError;
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::ohlcv::{OhlcvBar, OhlcvSeries};
 use crate::ports::config_port::ConfigPort;
 use crate::ports::data_port::DataPort;
 use chrono::{DateTime, NaiveDate, NaiveTime, Utc};
-use postgres::types::ToSql;
+use postgres::binary_copy::BinaryCopyInWriter;
+use postgres::fallible_iterator::FallibleIterator;
+use postgres::types::{ToSql, Type};
 use postgres::NoTls;
 use r2d2::Pool;
 use r2d2_postgres::PostgresConnectionManager;
+use std::borrow::Borrow;
+use std::collections::HashMap;
 use std::time::Duration;
 
 pub struct PostgresAdapter {
@@ -112,74 +116,110 @@ impl PostgresAdapter {
         Ok(())
     }
 
+    /// Upsert `bars` in a single transaction.
     pub fn insert_bars(&self, bars: &[OhlcvBar]) -> Result<(), SamtraderError> {
         if bars.is_empty() {
             return Ok(());
         }
+        self.copy_bars(bars.iter().map(Ok), bars.len()).map(|_| ())
+    }
 
-        let mut conn = self.get_conn()?;
-        let mut tx = conn
-            .transaction()
-            .map_err(|e| SamtraderError::DatabaseQuery {
-                reason: e.to_string(),
-            })?;
-
-        let mut param_idx = 1;
-        let mut value_rows: Vec<String> = Vec::new();
-        let mut dts: Vec<DateTime<Utc>> = Vec::with_capacity(bars.len());
-        let mut params: Vec<&(dyn ToSql + Sync)> = Vec::new();
-
-        for bar in bars {
-            let dt: DateTime<Utc> = bar.date.and_hms_opt(0, 0, 0).unwrap().and_utc();
-            dts.push(dt);
-        }
+    /// Bulk upsert a stream of bars, `batch_size` at a time.
+    ///
+    /// Each batch is streamed with `COPY ... FROM STDIN (FORMAT binary)` into
+    /// a session-local staging table and merged into `public.ohlcv` with one
+    /// `INSERT ... ON CONFLICT`, then committed on its own; memory stays at
+    /// one row regardless of the input size. A duplicate key within a batch
+    /// keeps the bar that came last. If the stream or a batch fails, the
+    /// batches before it remain committed, and since the merge is an upsert
+    /// rerunning the import is safe. Returns the number of rows merged.
+    pub fn copy_bars<I, B>(&self, bars: I, batch_size: usize) -> Result<u64, SamtraderError>
+    where
+        I: IntoIterator<Item = Result<B, SamtraderError>>,
+        B: Borrow<OhlcvBar>,
+    {
+        let query_err = |e: postgres::Error| SamtraderError::DatabaseQuery {
+            reason: e.to_string(),
+        };
+        let types = [
+            Type::INT8,
+            Type::TEXT,
+            Type::TEXT,
+            Type::TIMESTAMPTZ,
+            Type::FLOAT8,
+            Type::FLOAT8,
+            Type::FLOAT8,
+            Type::FLOAT8,
+            Type::INT8,
+        ];
 
-        for (i, bar) in bars.iter().enumerate() {
-            value_rows.push(format!(
-                "(${},${},${},${},${},${},${},${})",
-                param_idx,
-                param_idx + 1,
-                param_idx + 2,
-                param_idx + 3,
-                param_idx + 4,
-                param_idx + 5,
-                param_idx + 6,
-                param_idx + 7
-            ));
-            param_idx += 8;
-
-            params.push(&bar.code);
-            params.push(&bar.exchange);
-            params.push(&dts[i]);
-            params.push(&bar.open);
-            params.push(&bar.high);
-            params.push(&bar.low);
-            params.push(&bar.close);
-            params.push(&bar.volume);
+        let mut conn = self.get_conn()?;
+        conn.batch_execute(
+            "CREATE TEMPORARY TABLE IF NOT EXISTS ohlcv_stage (
+                seq BIGINT NOT NULL,
+                code TEXT NOT NULL,
+                exchange TEXT NOT NULL,
+                date TIMESTAMP WITH TIME ZONE NOT NULL,
+                open DOUBLE PRECISION NOT NULL,
+                high DOUBLE PRECISION NOT NULL,
+                low DOUBLE PRECISION NOT NULL,
+                close DOUBLE PRECISION NOT NULL,
+                volume BIGINT NOT NULL
+            ) ON COMMIT DELETE ROWS",
+        )
+        .map_err(query_err)?;
+
+        let mut bars = bars.into_iter().peekable();
+        let mut merged = 0;
+        while bars.peek().is_some() {
+            let mut tx = conn.transaction().map_err(query_err)?;
+            let sink = tx
+                .copy_in(
+                    "COPY ohlcv_stage (seq, code, exchange, date, open, high, low, close, volume) \
+                     FROM STDIN (FORMAT binary)",
+                )
+                .map_err(query_err)?;
+            let mut writer = BinaryCopyInWriter::new(sink, &types);
+            for (seq, bar) in bars.by_ref().take(batch_size.max(1)).enumerate() {
+                let owned = bar?;
+                let bar = owned.borrow();
+                let date: DateTime<Utc> = bar.date.and_time(NaiveTime::MIN).and_utc();
+                writer
+                    .write(&[
+                        &(seq as i64),
+                        &bar.code,
+                        &bar.exchange,
+                        &date,
+                        &bar.open,
+                        &bar.high,
+                        &bar.low,
+                        &bar.close,
+                        &bar.volume,
+                    ])
+                    .map_err(query_err)?;
+            }
+            writer.finish().map_err(query_err)?;
+
+            merged += tx
+                .execute(
+                    "INSERT INTO public.ohlcv (code, exchange, date, open, high, low, close, volume) \
+                     SELECT DISTINCT ON (code, exchange, date) \
+                            code, exchange, date, open, high, low, close, volume \
+                     FROM ohlcv_stage \
+                     ORDER BY code, exchange, date, seq DESC \
+                     ON CONFLICT (code, exchange, date) DO UPDATE SET \
+                     open = EXCLUDED.open, \
+                     high = EXCLUDED.high, \
+                     low = EXCLUDED.low, \
+                     close = EXCLUDED.close, \
+                     volume = EXCLUDED.volume",
+                    &[],
+                )
+                .map_err(query_err)?;
+            tx.commit().map_err(query_err)?;
         }
 
-        let query = format!(
-            "INSERT INTO public.ohlcv (code, exchange, date, open, high, low, close, volume) \
-             VALUES {} \
-             ON CONFLICT (code, exchange, date) DO UPDATE SET \
-             open = EXCLUDED.open, \
-             high = EXCLUDED.high, \
-             low = EXCLUDED.low, \
-             close = EXCLUDED.close, \
-             volume = EXCLUDED.volume",
-            value_rows.join(",")
-        );
-
-        tx.execute(&query, &params[..])
-            .map_err(|e| SamtraderError::DatabaseQuery {
-                reason: e.to_string(),
-            })?;
-
-        tx.commit().map_err(|e| SamtraderError::DatabaseQuery {
-            reason: e.to_string(),
-        })?;
-
-        Ok(())
+        Ok(merged)
     }
 }
 
@@ -231,6 +271,107 @@ impl DataPort for PostgresAdapter {
         Ok(bars)
     }
 
+    fn fetch_ohlcv_series(
+        &self,
+        code: &str,
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<OhlcvSeries, SamtraderError> {
+        let mut conn = self.get_conn()?;
+
+        let start_dt: DateTime<Utc> = start_date.and_time(NaiveTime::MIN).and_utc();
+        let end_dt: DateTime<Utc> = end_date.and_hms_opt(23, 59, 59).unwrap().and_utc();
+
+        let query = "SELECT date, \
+                            open::double precision, high::double precision, \
+                            low::double precision, close::double precision, \
+                            volume::bigint \
+                     FROM public.ohlcv \
+                     WHERE code = $1 AND exchange = $2 AND date >= $3 AND date <= $4 \
+                     ORDER BY date ASC";
+
+        let params: &[&(dyn ToSql + Sync)] = &[&code, &exchange, &start_dt, &end_dt];
+        let rows = conn
+            .query(query, params)
+            .map_err(|e| SamtraderError::DatabaseQuery {
+                reason: e.to_string(),
+            })?;
+
+        let mut series = OhlcvSeries::with_capacity(rows.len());
+        for row in &rows {
+            let dt: DateTime<Utc> = row.get(0);
+            series.push(
+                dt.naive_utc().date(),
+                row.get(1),
+                row.get(2),
+                row.get(3),
+                row.get(4),
+                row.get(5),
+            );
+        }
+
+        Ok(series)
+    }
+
+    fn fetch_ohlcv_batch(
+        &self,
+        codes: &[String],
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<Vec<OhlcvSeries>, SamtraderError> {
+        let mut conn = self.get_conn()?;
+
+        let start_dt: DateTime<Utc> = start_date.and_time(NaiveTime::MIN).and_utc();
+        let end_dt: DateTime<Utc> = end_date.and_hms_opt(23, 59, 59).unwrap().and_utc();
+
+        let query = "SELECT code, date, \
+                            open::double precision, high::double precision, \
+                            low::double precision, close::double precision, \
+                            volume::bigint \
+                     FROM public.ohlcv \
+                     WHERE code = ANY($1) AND exchange = $2 AND date >= $3 AND date <= $4 \
+                     ORDER BY date ASC";
+
+        let mut slot_of: HashMap<&str, usize> = HashMap::with_capacity(codes.len());
+        for (i, code) in codes.iter().enumerate() {
+            slot_of.entry(code.as_str()).or_insert(i);
+        }
+        let mut series = vec![OhlcvSeries::new(); codes.len()];
+
+        let params: &[&(dyn ToSql + Sync)] = &[&codes, &exchange, &start_dt, &end_dt];
+        let mut rows = conn
+            .query_raw(query, params.iter().copied())
+            .map_err(|e| SamtraderError::DatabaseQuery {
+                reason: e.to_string(),
+            })?;
+
+        while let Some(row) = rows.next().map_err(|e| SamtraderError::DatabaseQuery {
+            reason: e.to_string(),
+        })? {
+            let code: &str = row.get(0);
+            let Some(&slot) = slot_of.get(code) else {
+                continue;
+            };
+            let dt: DateTime<Utc> = row.get(1);
+            series[slot].push(
+                dt.naive_utc().date(),
+                row.get(2),
+                row.get(3),
+                row.get(4),
+                row.get(5),
+                row.get(6),
+            );
+        }
+
+        Ok(series)
+    }
+
+    fn batch_is_one_query(&self) -> bool {
+        true
+    }
+
     fn list_symbols(&self, exchange: &str) -> Result<Vec<String>, SamtraderError> {
         let mut conn = self.get_conn()?;
 
@@ -477,6 +618,49 @@ mod tests {
         assert_eq!(fetched[1].close, 101.5);
     }
 
+    #[test]
+    #[ignore]
+    fn postgres_fetch_ohlcv_batch_groups_by_code() {
+        let adapter = get_test_adapter().expect("Set SAMTRADER_PG_TEST_CONN to run this test");
+        adapter.initialize_schema().unwrap();
+
+        let mut conn = adapter.get_conn().unwrap();
+        conn.execute("DELETE FROM public.ohlcv", &[]).unwrap();
+        drop(conn);
+
+        let bars: Vec<OhlcvBar> = ["BHP", "CBA"]
+            .iter()
+            .flat_map(|code| {
+                (1..=2).map(move |d| OhlcvBar {
+                    code: code.to_string(),
+                    exchange: "ASX".to_string(),
+                    date: NaiveDate::from_ymd_opt(2024, 1, d).unwrap(),
+                    open: 100.0,
+                    high: 101.0,
+                    low: 99.0,
+                    close: 100.0 + d as f64,
+                    volume: 1000,
+                })
+            })
+            .collect();
+        adapter.insert_bars(&bars).unwrap();
+
+        let codes = vec!["CBA".to_string(), "XYZ".to_string(), "BHP".to_string()];
+        let batch = adapter
+            .fetch_ohlcv_batch(
+                &codes,
+                "ASX",
+                NaiveDate::from_ymd_opt(2024, 1, 1).unwrap(),
+                NaiveDate::from_ymd_opt(2024, 1, 2).unwrap(),
+            )
+            .unwrap();
+
+        assert_eq!(batch.len(), 3);
+        assert_eq!(batch[0].close, vec![101.0, 102.0]);
+        assert!(batch[1].is_empty());
+        assert_eq!(batch[2].close, vec![101.0, 102.0]);
+    }
+
     #[test]
     #[ignore]
     fn postgres_insert_bars_upsert() {
@@ -527,6 +711,51 @@ mod tests {
         assert_eq!(fetched[0].volume, 2000);
     }
 
+    #[test]
+    #[ignore]
+    fn postgres_copy_bars_batches_and_keeps_last_duplicate() {
+        let adapter = get_test_adapter().expect("Set SAMTRADER_PG_TEST_CONN to run this test");
+        adapter.initialize_schema().unwrap();
+
+        let mut conn = adapter.get_conn().unwrap();
+        conn.execute("DELETE FROM public.ohlcv", &[]).unwrap();
+        drop(conn);
+
+        let bar = |d: u32, close: f64| OhlcvBar {
+            code: "BHP".to_string(),
+            exchange: "ASX".to_string(),
+            date: NaiveDate::from_ymd_opt(2024, 1, d).unwrap(),
+            open: 100.0,
+            high: 101.0,
+            low: 99.0,
+            close,
+            volume: 1000,
+        };
+        let bars = vec![bar(1, 1.0), bar(2, 2.0), bar(3, 3.0), bar(3, 3.5), bar(4, 4.0)];
+
+        let merged = adapter
+            .copy_bars(bars.into_iter().map(Ok), 2)
+            .unwrap();
+        assert_eq!(merged, 4);
+
+        let fetched = adapter
+            .fetch_ohlcv_series(
+                "BHP",
+                "ASX",
+                NaiveDate::from_ymd_opt(2024, 1, 1).unwrap(),
+                NaiveDate::from_ymd_opt(2024, 1, 4).unwrap(),
+            )
+            .unwrap();
+        assert_eq!(fetched.close, vec![1.0, 2.0, 3.5, 4.0]);
+
+        let failing = vec![Ok(bar(5, 5.0)), Err(SamtraderError::Database {
+            reason: "bad row".into(),
+        })];
+        assert!(adapter.copy_bars(failing, 10).is_err());
+        let range = adapter.get_data_range("BHP", "ASX").unwrap().unwrap();
+        assert_eq!(range.1, NaiveDate::from_ymd_opt(2024, 1, 4).unwrap());
+    }
+
     #[test]
     fn postgres_insert_bars_empty() {
         let adapter = get_test_adapter();
@@ -1,19 +1,87 @@
 //! SQLite data adapter (TRD Section 3.2).
+//!
+//! Schema version 2 (`PRAGMA user_version`) stores each bar in a
+//! `WITHOUT ROWID` table clustered on `(exchange, code, date)`, with `date`
+//! as an integer day number (days from the common era, as in
+//! `chrono::Datelike::num_days_from_ce`). A range scan for one code is then
+//! a walk over adjacent leaf pages of the primary key, and rows decode
+//! without parsing date text. `initialize_schema` creates this layout or
+//! upgrades the original TEXT-date table in place.
 
 use crate::domain::error::SamtraderError;
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::ohlcv::{OhlcvBar, OhlcvSeries};
 use crate::ports::config_port::ConfigPort;
 use crate::ports::data_port::DataPort;
-use chrono::NaiveDate;
+use chrono::{Datelike, NaiveDate};
 use r2d2::Pool;
 use r2d2_sqlite::SqliteConnectionManager;
-use rusqlite::params;
+use rusqlite::{Connection, ToSql, params};
+use std::collections::HashMap;
+
+/// Codes bound per `IN (...)` query; keeps well under SQLite's
+/// bound-parameter limit (999 on older builds).
+const BATCH_CODES: usize = 500;
+
+/// Current on-disk layout, stored in `PRAGMA user_version`. Version 0 with
+/// an `ohlcv` table is the original TEXT-date layout.
+pub const SCHEMA_VERSION: i64 = 2;
+
+const CREATE_OHLCV: &str = "CREATE TABLE IF NOT EXISTS ohlcv (
+        exchange TEXT NOT NULL,
+        code TEXT NOT NULL,
+        date INTEGER NOT NULL,
+        open REAL NOT NULL,
+        high REAL NOT NULL,
+        low REAL NOT NULL,
+        close REAL NOT NULL,
+        volume INTEGER NOT NULL,
+        PRIMARY KEY (exchange, code, date)
+    ) WITHOUT ROWID;";
+
+/// `julianday('0001-01-01') - 1`: converts a version 0 TEXT date to a day
+/// number during migration.
+const JULIAN_DAY_OFFSET: f64 = 1_721_424.5;
+
+/// What `initialize_schema` did to the database.
+#[derive(Debug, Clone, Copy, PartialEq, Eq)]
+pub enum SchemaChange {
+    UpToDate,
+    Created,
+    /// Rewrote the version 0 table; `rows` bars were carried over.
+    Migrated {
+        rows: usize,
+    },
+}
+
+fn to_query_err(e: rusqlite::Error) -> SamtraderError {
+    SamtraderError::DatabaseQuery {
+        reason: e.to_string(),
+    }
+}
+
+fn to_day(date: NaiveDate) -> i32 {
+    date.num_days_from_ce()
+}
+
+fn from_day(day: i32) -> rusqlite::Result<NaiveDate> {
+    NaiveDate::from_num_days_from_ce_opt(day)
+        .ok_or(rusqlite::Error::IntegralValueOutOfRange(0, i64::from(day)))
+}
+
+fn schema_version(conn: &Connection) -> Result<i64, SamtraderError> {
+    conn.query_row("PRAGMA user_version", [], |row| row.get(0))
+        .map_err(to_query_err)
+}
 
 pub struct SqliteAdapter {
     pool: Pool<SqliteConnectionManager>,
 }
 
 impl SqliteAdapter {
+    /// Read-only pool for the backtest and web read paths. Connections map
+    /// up to `[sqlite] mmap_size` bytes of the file and keep a
+    /// `[sqlite] cache_size` KiB page cache; `query_only` guards against
+    /// accidental writes. Fails unless the file is at `SCHEMA_VERSION`.
     pub fn from_config(config: &dyn ConfigPort) -> Result<Self, SamtraderError> {
         let db_path =
             config
@@ -24,14 +92,19 @@ impl SqliteAdapter {
                 })?;
 
         let pool_size = config.get_int("sqlite", "pool_size", 4) as u32;
-
-        let manager = SqliteConnectionManager::file(&db_path).with_init(|conn| {
-            conn.execute_batch(
-                "PRAGMA journal_mode=WAL;\
-                     PRAGMA busy_timeout=5000;\
-                     PRAGMA synchronous=NORMAL;",
-            )
-        });
+        let mmap_size = config.get_int("sqlite", "mmap_size", 256 * 1024 * 1024);
+        let cache_kib = config.get_int("sqlite", "cache_size", 64 * 1024);
+
+        let pragmas = format!(
+            "PRAGMA journal_mode=WAL;\
+                 PRAGMA busy_timeout=5000;\
+                 PRAGMA synchronous=NORMAL;\
+                 PRAGMA mmap_size={mmap_size};\
+                 PRAGMA cache_size=-{cache_kib};\
+                 PRAGMA query_only=ON;"
+        );
+        let manager = SqliteConnectionManager::file(&db_path)
+            .with_init(move |conn| conn.execute_batch(&pragmas));
         let pool =
             Pool::builder()
                 .max_size(pool_size)
@@ -40,7 +113,18 @@ impl SqliteAdapter {
                     reason: e.to_string(),
                 })?;
 
-        Ok(Self { pool })
+        let adapter = Self { pool };
+        let version = adapter.schema_version()?;
+        if version != SCHEMA_VERSION {
+            return Err(SamtraderError::Database {
+                reason: format!(
+                    "{db_path} has schema version {version}, expected {SCHEMA_VERSION}; \
+                     run `samtrader migrate --sqlite {db_path}`"
+                ),
+            });
+        }
+
+        Ok(adapter)
     }
 
     pub fn from_path(db_path: &str) -> Result<Self, SamtraderError> {
@@ -73,74 +157,112 @@ impl SqliteAdapter {
         Ok(Self { pool })
     }
 
-    pub fn initialize_schema(&self) -> Result<(), SamtraderError> {
-        let conn = self
-            .pool
+    fn conn(&self) -> Result<r2d2::PooledConnection<SqliteConnectionManager>, SamtraderError> {
+        self.pool
             .get()
             .map_err(|e: r2d2::Error| SamtraderError::Database {
                 reason: e.to_string(),
-            })?;
-
-        conn.execute_batch(
-            "CREATE TABLE IF NOT EXISTS ohlcv (
-                code TEXT NOT NULL,
-                exchange TEXT NOT NULL,
-                date TEXT NOT NULL,
-                open REAL NOT NULL,
-                high REAL NOT NULL,
-                low REAL NOT NULL,
-                close REAL NOT NULL,
-                volume INTEGER NOT NULL,
-                PRIMARY KEY (code, exchange, date)
-            );
-            CREATE INDEX IF NOT EXISTS idx_ohlcv_code_exchange ON ohlcv(code, exchange);
-            CREATE INDEX IF NOT EXISTS idx_ohlcv_date ON ohlcv(date);",
-        )
-        .map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-            reason: e.to_string(),
-        })?;
+            })
+    }
 
-        Ok(())
+    pub fn schema_version(&self) -> Result<i64, SamtraderError> {
+        schema_version(&self.conn()?)
     }
 
-    pub fn insert_bars(&self, bars: &[OhlcvBar]) -> Result<(), SamtraderError> {
-        let mut conn = self
-            .pool
-            .get()
-            .map_err(|e: r2d2::Error| SamtraderError::Database {
-                reason: e.to_string(),
-            })?;
+    /// Bring the database to `SCHEMA_VERSION`: create the table in an empty
+    /// database, or rewrite a version 0 table (TEXT dates, rowid table with
+    /// two secondary indexes) in one transaction and `VACUUM` so the new
+    /// clustered pages are laid out contiguously.
+    pub fn initialize_schema(&self) -> Result<SchemaChange, SamtraderError> {
+        let mut conn = self.conn()?;
 
-        let tx =
-            conn.transaction()
-                .map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                    reason: e.to_string(),
-                })?;
+        let version = schema_version(&conn)?;
+        if version == SCHEMA_VERSION {
+            return Ok(SchemaChange::UpToDate);
+        }
+        if version > SCHEMA_VERSION {
+            return Err(SamtraderError::Database {
+                reason: format!(
+                    "schema version {version} is newer than supported version {SCHEMA_VERSION}"
+                ),
+            });
+        }
 
-        for bar in bars {
-            tx.execute(
-                "INSERT OR REPLACE INTO ohlcv (code, exchange, date, open, high, low, close, volume)
-                 VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8)",
-                params![
-                    bar.code,
+        let legacy: bool = conn
+            .query_row(
+                "SELECT EXISTS (SELECT 1 FROM sqlite_master WHERE type = 'table' AND name = 'ohlcv')",
+                [],
+                |row| row.get(0),
+            )
+            .map_err(to_query_err)?;
+
+        let tx = conn.transaction().map_err(to_query_err)?;
+        if legacy {
+            tx.execute_batch(
+                "DROP INDEX IF EXISTS idx_ohlcv_code_exchange;
+                 DROP INDEX IF EXISTS idx_ohlcv_date;
+                 ALTER TABLE ohlcv RENAME TO ohlcv_v0;",
+            )
+            .map_err(to_query_err)?;
+        }
+        tx.execute_batch(CREATE_OHLCV).map_err(to_query_err)?;
+        let rows = if legacy {
+            // Rows whose date does not parse fail the NOT NULL constraint and
+            // roll the whole migration back.
+            let rows = tx
+                .execute(
+                    "INSERT INTO ohlcv (exchange, code, date, open, high, low, close, volume)
+                     SELECT exchange, code, CAST(julianday(date) - ?1 AS INTEGER),
+                            open, high, low, close, volume
+                     FROM ohlcv_v0",
+                    params![JULIAN_DAY_OFFSET],
+                )
+                .map_err(to_query_err)?;
+            tx.execute_batch("DROP TABLE ohlcv_v0;")
+                .map_err(to_query_err)?;
+            Some(rows)
+        } else {
+            None
+        };
+        tx.pragma_update(None, "user_version", SCHEMA_VERSION)
+            .map_err(to_query_err)?;
+        tx.commit().map_err(to_query_err)?;
+
+        Ok(match rows {
+            Some(rows) => {
+                conn.execute_batch("VACUUM;").map_err(to_query_err)?;
+                SchemaChange::Migrated { rows }
+            }
+            None => SchemaChange::Created,
+        })
+    }
+
+    pub fn insert_bars(&self, bars: &[OhlcvBar]) -> Result<(), SamtraderError> {
+        let mut conn = self.conn()?;
+
+        let tx = conn.transaction().map_err(to_query_err)?;
+        {
+            let mut stmt = tx
+                .prepare_cached(
+                    "INSERT OR REPLACE INTO ohlcv (exchange, code, date, open, high, low, close, volume)
+                     VALUES (?1, ?2, ?3, ?4, ?5, ?6, ?7, ?8)",
+                )
+                .map_err(to_query_err)?;
+            for bar in bars {
+                stmt.execute(params![
                     bar.exchange,
-                    bar.date.format("%Y-%m-%d").to_string(),
+                    bar.code,
+                    to_day(bar.date),
                     bar.open,
                     bar.high,
                     bar.low,
                     bar.close,
                     bar.volume
-                ],
-            )
-            .map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                reason: e.to_string(),
-            })?;
+                ])
+                .map_err(to_query_err)?;
+            }
         }
-
-        tx.commit()
-            .map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                reason: e.to_string(),
-            })?;
+        tx.commit().map_err(to_query_err)?;
 
         Ok(())
     }
@@ -154,96 +276,162 @@ impl DataPort for SqliteAdapter {
         start_date: NaiveDate,
         end_date: NaiveDate,
     ) -> Result<Vec<OhlcvBar>, SamtraderError> {
-        let conn = self
-            .pool
-            .get()
-            .map_err(|e: r2d2::Error| SamtraderError::Database {
-                reason: e.to_string(),
-            })?;
+        let conn = self.conn()?;
+
+        let mut stmt = conn
+            .prepare_cached(
+                "SELECT date, open, high, low, close, volume
+                 FROM ohlcv
+                 WHERE exchange = ?1 AND code = ?2 AND date >= ?3 AND date <= ?4
+                 ORDER BY date ASC",
+            )
+            .map_err(to_query_err)?;
 
-        let start_str = start_date.format("%Y-%m-%d").to_string();
-        let end_str = end_date.format("%Y-%m-%d").to_string();
+        let rows = stmt
+            .query_map(
+                params![exchange, code, to_day(start_date), to_day(end_date)],
+                |row| {
+                    Ok(OhlcvBar {
+                        code: code.to_string(),
+                        exchange: exchange.to_string(),
+                        date: from_day(row.get(0)?)?,
+                        open: row.get(1)?,
+                        high: row.get(2)?,
+                        low: row.get(3)?,
+                        close: row.get(4)?,
+                        volume: row.get(5)?,
+                    })
+                },
+            )
+            .map_err(to_query_err)?;
 
-        let query = "SELECT code, exchange, date, open, high, low, close, volume
-                     FROM ohlcv
-                     WHERE code = ?1 AND exchange = ?2 AND date >= ?3 AND date <= ?4
-                     ORDER BY date ASC";
+        rows.collect::<rusqlite::Result<Vec<_>>>()
+            .map_err(to_query_err)
+    }
 
-        let mut stmt =
-            conn.prepare(query)
-                .map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                    reason: e.to_string(),
-                })?;
+    fn fetch_ohlcv_series(
+        &self,
+        code: &str,
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<OhlcvSeries, SamtraderError> {
+        let conn = self.conn()?;
+
+        let mut stmt = conn
+            .prepare_cached(
+                "SELECT date, open, high, low, close, volume
+                 FROM ohlcv
+                 WHERE exchange = ?1 AND code = ?2 AND date >= ?3 AND date <= ?4
+                 ORDER BY date ASC",
+            )
+            .map_err(to_query_err)?;
+
+        let mut rows = stmt
+            .query(params![
+                exchange,
+                code,
+                to_day(start_date),
+                to_day(end_date)
+            ])
+            .map_err(to_query_err)?;
+
+        let mut series = OhlcvSeries::new();
+        while let Some(row) = rows.next().map_err(to_query_err)? {
+            series.push(
+                row.get(0).and_then(from_day).map_err(to_query_err)?,
+                row.get(1).map_err(to_query_err)?,
+                row.get(2).map_err(to_query_err)?,
+                row.get(3).map_err(to_query_err)?,
+                row.get(4).map_err(to_query_err)?,
+                row.get(5).map_err(to_query_err)?,
+            );
+        }
 
-        let rows = stmt
-            .query_map(params![code, exchange, start_str, end_str], |row| {
-                let date_str: String = row.get(2)?;
-                let date = NaiveDate::parse_from_str(&date_str, "%Y-%m-%d").map_err(|e| {
-                    rusqlite::Error::FromSqlConversionFailure(
-                        date_str.len(),
-                        rusqlite::types::Type::Text,
-                        Box::new(e),
-                    )
-                })?;
-                Ok(OhlcvBar {
-                    code: row.get(0)?,
-                    exchange: row.get(1)?,
-                    date,
-                    open: row.get(3)?,
-                    high: row.get(4)?,
-                    low: row.get(5)?,
-                    close: row.get(6)?,
-                    volume: row.get(7)?,
-                })
-            })
-            .map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                reason: e.to_string(),
-            })?;
+        Ok(series)
+    }
 
-        let mut bars = Vec::new();
-        for row in rows {
-            bars.push(
-                row.map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                    reason: e.to_string(),
-                })?,
+    fn fetch_ohlcv_batch(
+        &self,
+        codes: &[String],
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<Vec<OhlcvSeries>, SamtraderError> {
+        let conn = self.conn()?;
+
+        let (start_day, end_day) = (to_day(start_date), to_day(end_date));
+
+        let mut slot_of: HashMap<&str, usize> = HashMap::with_capacity(codes.len());
+        for (i, code) in codes.iter().enumerate() {
+            slot_of.entry(code.as_str()).or_insert(i);
+        }
+        let mut series = vec![OhlcvSeries::new(); codes.len()];
+
+        for chunk in codes.chunks(BATCH_CODES) {
+            let placeholders = (0..chunk.len())
+                .map(|i| format!("?{}", i + 4))
+                .collect::<Vec<_>>()
+                .join(", ");
+            // Ordered by the primary key, so each code's rows come off one
+            // contiguous key range already in date order.
+            let query = format!(
+                "SELECT code, date, open, high, low, close, volume
+                 FROM ohlcv
+                 WHERE exchange = ?1 AND code IN ({}) AND date >= ?2 AND date <= ?3
+                 ORDER BY code, date",
+                placeholders
             );
+
+            let mut stmt = conn.prepare_cached(&query).map_err(to_query_err)?;
+            let bound: Vec<&dyn ToSql> = [&exchange as &dyn ToSql, &start_day, &end_day]
+                .into_iter()
+                .chain(chunk.iter().map(|c| c as &dyn ToSql))
+                .collect();
+            let mut rows = stmt.query(bound.as_slice()).map_err(to_query_err)?;
+
+            while let Some(row) = rows.next().map_err(to_query_err)? {
+                let code = row
+                    .get_ref(0)
+                    .map_err(to_query_err)?
+                    .as_str()
+                    .map_err(|e| SamtraderError::DatabaseQuery {
+                        reason: e.to_string(),
+                    })?;
+                let Some(&slot) = slot_of.get(code) else {
+                    continue;
+                };
+                series[slot].push(
+                    row.get(1).and_then(from_day).map_err(to_query_err)?,
+                    row.get(2).map_err(to_query_err)?,
+                    row.get(3).map_err(to_query_err)?,
+                    row.get(4).map_err(to_query_err)?,
+                    row.get(5).map_err(to_query_err)?,
+                    row.get(6).map_err(to_query_err)?,
+                );
+            }
         }
 
-        Ok(bars)
+        Ok(series)
     }
 
-    fn list_symbols(&self, exchange: &str) -> Result<Vec<String>, SamtraderError> {
-        let conn = self
-            .pool
-            .get()
-            .map_err(|e: r2d2::Error| SamtraderError::Database {
-                reason: e.to_string(),
-            })?;
+    fn batch_is_one_query(&self) -> bool {
+        true
+    }
 
-        let query = "SELECT DISTINCT code FROM ohlcv WHERE exchange = ?1 ORDER BY code";
+    fn list_symbols(&self, exchange: &str) -> Result<Vec<String>, SamtraderError> {
+        let conn = self.conn()?;
 
-        let mut stmt =
-            conn.prepare(query)
-                .map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                    reason: e.to_string(),
-                })?;
+        let mut stmt = conn
+            .prepare_cached("SELECT DISTINCT code FROM ohlcv WHERE exchange = ?1 ORDER BY code")
+            .map_err(to_query_err)?;
 
         let rows = stmt
             .query_map(params![exchange], |row| row.get(0))
-            .map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                reason: e.to_string(),
-            })?;
+            .map_err(to_query_err)?;
 
-        let mut symbols = Vec::new();
-        for row in rows {
-            symbols.push(
-                row.map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                    reason: e.to_string(),
-                })?,
-            );
-        }
-
-        Ok(symbols)
+        rows.collect::<rusqlite::Result<Vec<String>>>()
+            .map_err(to_query_err)
     }
 
     fn get_data_range(
@@ -251,38 +439,26 @@ impl DataPort for SqliteAdapter {
         code: &str,
         exchange: &str,
     ) -> Result<Option<(NaiveDate, NaiveDate, usize)>, SamtraderError> {
-        let conn = self
-            .pool
-            .get()
-            .map_err(|e: r2d2::Error| SamtraderError::Database {
-                reason: e.to_string(),
-            })?;
+        let conn = self.conn()?;
 
-        let query =
-            "SELECT MIN(date), MAX(date), COUNT(*) FROM ohlcv WHERE code = ?1 AND exchange = ?2";
+        let mut stmt = conn
+            .prepare_cached(
+                "SELECT MIN(date), MAX(date), COUNT(*) FROM ohlcv WHERE exchange = ?1 AND code = ?2",
+            )
+            .map_err(to_query_err)?;
 
-        let result: (Option<String>, Option<String>, i64) = conn
-            .query_row(query, params![code, exchange], |row| {
+        let result: (Option<i32>, Option<i32>, i64) = stmt
+            .query_row(params![exchange, code], |row| {
                 Ok((row.get(0)?, row.get(1)?, row.get(2)?))
             })
-            .map_err(|e: rusqlite::Error| SamtraderError::DatabaseQuery {
-                reason: e.to_string(),
-            })?;
+            .map_err(to_query_err)?;
 
         match result {
-            (Some(min_str), Some(max_str), count) if count > 0 => {
-                let min = NaiveDate::parse_from_str(&min_str, "%Y-%m-%d").map_err(
-                    |e: chrono::ParseError| SamtraderError::Database {
-                        reason: e.to_string(),
-                    },
-                )?;
-                let max = NaiveDate::parse_from_str(&max_str, "%Y-%m-%d").map_err(
-                    |e: chrono::ParseError| SamtraderError::Database {
-                        reason: e.to_string(),
-                    },
-                )?;
-                Ok(Some((min, max, count as usize)))
-            }
+            (Some(min), Some(max), count) if count > 0 => Ok(Some((
+                from_day(min).map_err(to_query_err)?,
+                from_day(max).map_err(to_query_err)?,
+                count as usize,
+            ))),
             _ => Ok(None),
         }
     }
@@ -353,6 +529,151 @@ mod tests {
         adapter.initialize_schema().unwrap();
     }
 
+    #[test]
+    fn initialize_schema_is_idempotent() {
+        let adapter = SqliteAdapter::in_memory().unwrap();
+        assert_eq!(adapter.initialize_schema().unwrap(), SchemaChange::Created);
+        assert_eq!(adapter.initialize_schema().unwrap(), SchemaChange::UpToDate);
+        assert_eq!(adapter.schema_version().unwrap(), SCHEMA_VERSION);
+    }
+
+    #[test]
+    fn migrates_text_date_schema() {
+        let adapter = SqliteAdapter::in_memory().unwrap();
+        adapter
+            .conn()
+            .unwrap()
+            .execute_batch(
+                "CREATE TABLE ohlcv (
+                    code TEXT NOT NULL,
+                    exchange TEXT NOT NULL,
+                    date TEXT NOT NULL,
+                    open REAL NOT NULL,
+                    high REAL NOT NULL,
+                    low REAL NOT NULL,
+                    close REAL NOT NULL,
+                    volume INTEGER NOT NULL,
+                    PRIMARY KEY (code, exchange, date)
+                );
+                CREATE INDEX idx_ohlcv_code_exchange ON ohlcv(code, exchange);
+                CREATE INDEX idx_ohlcv_date ON ohlcv(date);
+                INSERT INTO ohlcv VALUES ('BHP', 'ASX', '2024-01-02', 1, 2, 0.5, 1.5, 10);
+                INSERT INTO ohlcv VALUES ('BHP', 'ASX', '0001-01-01', 1, 2, 0.5, 1.0, 20);
+                INSERT INTO ohlcv VALUES ('CBA', 'ASX', '2024-02-29', 3, 4, 2.5, 3.5, 30);",
+            )
+            .unwrap();
+
+        assert_eq!(
+            adapter.initialize_schema().unwrap(),
+            SchemaChange::Migrated { rows: 3 }
+        );
+
+        let series = adapter
+            .fetch_ohlcv_series("BHP", "ASX", NaiveDate::MIN, NaiveDate::MAX)
+            .unwrap();
+        assert_eq!(
+            series.date,
+            vec![
+                NaiveDate::from_ymd_opt(1, 1, 1).unwrap(),
+                NaiveDate::from_ymd_opt(2024, 1, 2).unwrap(),
+            ]
+        );
+        assert_eq!(series.volume, vec![20, 10]);
+        assert_eq!(
+            adapter.get_data_range("CBA", "ASX").unwrap(),
+            Some((
+                NaiveDate::from_ymd_opt(2024, 2, 29).unwrap(),
+                NaiveDate::from_ymd_opt(2024, 2, 29).unwrap(),
+                1
+            ))
+        );
+
+        let indexes: i64 = adapter
+            .conn()
+            .unwrap()
+            .query_row(
+                "SELECT COUNT(*) FROM sqlite_master WHERE type = 'index' AND sql IS NOT NULL",
+                [],
+                |row| row.get(0),
+            )
+            .unwrap();
+        assert_eq!(indexes, 0);
+    }
+
+    #[test]
+    fn migration_rolls_back_on_bad_dates() {
+        let adapter = SqliteAdapter::in_memory().unwrap();
+        adapter
+            .conn()
+            .unwrap()
+            .execute_batch(
+                "CREATE TABLE ohlcv (code TEXT, exchange TEXT, date TEXT, open REAL,
+                    high REAL, low REAL, close REAL, volume INTEGER);
+                INSERT INTO ohlcv VALUES ('BHP', 'ASX', 'yesterday', 1, 2, 0.5, 1.5, 10);",
+            )
+            .unwrap();
+
+        assert!(adapter.initialize_schema().is_err());
+        assert_eq!(adapter.schema_version().unwrap(), 0);
+        let count: i64 = adapter
+            .conn()
+            .unwrap()
+            .query_row("SELECT COUNT(*) FROM ohlcv", [], |row| row.get(0))
+            .unwrap();
+        assert_eq!(count, 1);
+    }
+
+    #[test]
+    fn from_config_requires_current_schema() {
+        struct PathConfig(String);
+
+        impl ConfigPort for PathConfig {
+            fn get_string(&self, section: &str, key: &str) -> Option<String> {
+                (section == "sqlite" && key == "path").then(|| self.0.clone())
+            }
+            fn get_int(&self, _section: &str, _key: &str, default: i64) -> i64 {
+                default
+            }
+            fn get_double(&self, _section: &str, _key: &str, default: f64) -> f64 {
+                default
+            }
+            fn get_bool(&self, _section: &str, _key: &str, default: bool) -> bool {
+                default
+            }
+        }
+
+        let dir = tempfile::TempDir::new().unwrap();
+        let path = dir.path().join("samtrader.db").display().to_string();
+        let config = PathConfig(path.clone());
+
+        match SqliteAdapter::from_config(&config) {
+            Err(SamtraderError::Database { reason }) => assert!(reason.contains("migrate")),
+            Err(other) => panic!("expected Database error, got: {other}"),
+            Ok(_) => panic!("expected error, got Ok"),
+        }
+
+        SqliteAdapter::from_path(&path)
+            .unwrap()
+            .initialize_schema()
+            .unwrap();
+        let reader = SqliteAdapter::from_config(&config).unwrap();
+        assert!(reader.list_symbols("ASX").unwrap().is_empty());
+        assert!(
+            reader
+                .insert_bars(&[OhlcvBar {
+                    code: "BHP".to_string(),
+                    exchange: "ASX".to_string(),
+                    date: NaiveDate::from_ymd_opt(2024, 1, 1).unwrap(),
+                    open: 1.0,
+                    high: 1.0,
+                    low: 1.0,
+                    close: 1.0,
+                    volume: 1,
+                }])
+                .is_err()
+        );
+    }
+
     #[test]
     fn sqlite_fetch_ohlcv_returns_bars() {
         let adapter = SqliteAdapter::in_memory().unwrap();
@@ -397,6 +718,81 @@ mod tests {
         assert_eq!(fetched[1].close, 101.5);
     }
 
+    #[test]
+    fn sqlite_fetch_ohlcv_series_matches_rows() {
+        let adapter = SqliteAdapter::in_memory().unwrap();
+        adapter.initialize_schema().unwrap();
+
+        let bars: Vec<OhlcvBar> = (1..=3)
+            .map(|d| OhlcvBar {
+                code: "BHP".to_string(),
+                exchange: "ASX".to_string(),
+                date: NaiveDate::from_ymd_opt(2024, 1, d).unwrap(),
+                open: 100.0 + d as f64,
+                high: 101.0 + d as f64,
+                low: 99.0 + d as f64,
+                close: 100.5 + d as f64,
+                volume: 1000 * d as i64,
+            })
+            .collect();
+        adapter.insert_bars(&bars).unwrap();
+
+        let start = NaiveDate::from_ymd_opt(2024, 1, 1).unwrap();
+        let end = NaiveDate::from_ymd_opt(2024, 1, 3).unwrap();
+        let rows = adapter.fetch_ohlcv("BHP", "ASX", start, end).unwrap();
+        let series = adapter
+            .fetch_ohlcv_series("BHP", "ASX", start, end)
+            .unwrap();
+
+        assert_eq!(series, OhlcvSeries::from(rows));
+        assert_eq!(series.close, vec![101.5, 102.5, 103.5]);
+    }
+
+    #[test]
+    fn sqlite_fetch_ohlcv_batch_groups_by_code() {
+        let adapter = SqliteAdapter::in_memory().unwrap();
+        adapter.initialize_schema().unwrap();
+
+        let bars: Vec<OhlcvBar> = ["BHP", "CBA"]
+            .iter()
+            .flat_map(|code| {
+                (1..=3).map(move |d| OhlcvBar {
+                    code: code.to_string(),
+                    exchange: "ASX".to_string(),
+                    date: NaiveDate::from_ymd_opt(2024, 1, d).unwrap(),
+                    open: 100.0,
+                    high: 101.0,
+                    low: 99.0,
+                    close: if *code == "BHP" {
+                        d as f64
+                    } else {
+                        10.0 * d as f64
+                    },
+                    volume: 1000,
+                })
+            })
+            .collect();
+        adapter.insert_bars(&bars).unwrap();
+
+        let start = NaiveDate::from_ymd_opt(2024, 1, 1).unwrap();
+        let end = NaiveDate::from_ymd_opt(2024, 1, 3).unwrap();
+        let codes = vec!["CBA".to_string(), "XYZ".to_string(), "BHP".to_string()];
+        let batch = adapter
+            .fetch_ohlcv_batch(&codes, "ASX", start, end)
+            .unwrap();
+
+        assert_eq!(batch.len(), 3);
+        assert_eq!(batch[0].close, vec![10.0, 20.0, 30.0]);
+        assert!(batch[1].is_empty());
+        assert_eq!(batch[2].close, vec![1.0, 2.0, 3.0]);
+        assert_eq!(
+            batch[2],
+            adapter
+                .fetch_ohlcv_series("BHP", "ASX", start, end)
+                .unwrap()
+        );
+    }
+
     #[test]
     fn sqlite_list_symbols() {
         let adapter = SqliteAdapter::in_memory().unwrap();
@@ -1,7 +1,9 @@
 //! SVG chart rendering for reports (TRD Section 3.9).
 //!
 //! Generates inline SVG strings for equity curve and drawdown charts,
-//! suitable for embedding in Typst via `#image.decode(...)`.
+//! suitable for embedding in Typst via `#image.decode(...)`. Long curves are
+//! reduced with largest-triangle-three-buckets to at most one vertex per
+//! pixel of plot width, so the SVG size no longer grows with the backtest.
 
 use crate::domain::portfolio::EquityPoint;
 
@@ -11,6 +13,8 @@ const MARGIN_LEFT: f64 = 60.0;
 const MARGIN_RIGHT: f64 = 20.0;
 const MARGIN_TOP: f64 = 30.0;
 const MARGIN_BOTTOM: f64 = 40.0;
+/// Most path vertices drawn: one per pixel of plot width.
+const MAX_VERTICES: usize = (CHART_WIDTH - MARGIN_LEFT - MARGIN_RIGHT) as usize;
 
 fn fmt_currency(value: f64) -> String {
     if value >= 0.0 {
@@ -47,11 +51,12 @@ pub fn generate_equity_svg(equity_curve: &[EquityPoint]) -> String {
     let y_scale =
         |v: f64| -> f64 { MARGIN_TOP + plot_height - ((v - min_equity) / range) * plot_height };
 
+    let values: Vec<f64> = equity_curve.iter().map(|p| p.equity).collect();
     let mut path_data = String::new();
-    for (i, point) in equity_curve.iter().enumerate() {
+    for (n, i) in lttb_indices(&values, MAX_VERTICES).into_iter().enumerate() {
         let x = x_scale(i);
-        let y = y_scale(point.equity);
-        if i == 0 {
+        let y = y_scale(values[i]);
+        if n == 0 {
             path_data.push_str(&format!("M {x:.1} {y:.1}"));
         } else {
             path_data.push_str(&format!(" L {x:.1} {y:.1}"));
@@ -145,9 +150,13 @@ pub fn generate_drawdown_svg(equity_curve: &[EquityPoint]) -> String {
     let y_scale = |dd: f64| -> f64 { MARGIN_TOP + (dd / max_dd) * plot_height };
 
     let mut path_data = format!("M {:.1} {:.1}", x_scale(0), y_scale(0.0));
-    for (i, &dd) in drawdowns.iter().enumerate() {
+    for i in lttb_indices(&drawdowns, MAX_VERTICES) {
         if i > 0 {
-            path_data.push_str(&format!(" L {:.1} {:.1}", x_scale(i), y_scale(dd)));
+            path_data.push_str(&format!(
+                " L {:.1} {:.1}",
+                x_scale(i),
+                y_scale(drawdowns[i])
+            ));
         }
     }
     path_data.push_str(&format!(
@@ -223,6 +232,49 @@ pub fn generate_drawdown_svg(equity_curve: &[EquityPoint]) -> String {
     svg
 }
 
+/// Indices of the points kept when reducing `values` (plotted against their
+/// index) to `threshold` points with largest-triangle-three-buckets.
+///
+/// The first and last points are always kept. Each bucket in between
+/// contributes the point forming the largest triangle with the previously
+/// kept point and the mean of the next bucket, which favours peaks and
+/// troughs over points on a straight run. Returns every index when `values`
+/// already fits or `threshold` is below 3.
+pub fn lttb_indices(values: &[f64], threshold: usize) -> Vec<usize> {
+    let n = values.len();
+    if threshold >= n || threshold < 3 {
+        return (0..n).collect();
+    }
+
+    let bucket = (n - 2) as f64 / (threshold - 2) as f64;
+    let bucket_start = |b: usize| (b as f64 * bucket) as usize + 1;
+
+    let mut kept = Vec::with_capacity(threshold);
+    kept.push(0);
+    let mut a = 0;
+    for b in 0..threshold - 2 {
+        let next = bucket_start(b + 1)..bucket_start(b + 2).min(n);
+        let next_len = next.len() as f64;
+        let avg_x = next.clone().sum::<usize>() as f64 / next_len;
+        let avg_y = values[next].iter().sum::<f64>() / next_len;
+
+        let (ax, ay) = (a as f64, values[a]);
+        let mut best = bucket_start(b);
+        let mut best_area = -1.0;
+        for j in bucket_start(b)..bucket_start(b + 1) {
+            let area = ((ax - avg_x) * (values[j] - ay) - (ax - j as f64) * (avg_y - ay)).abs();
+            if area > best_area {
+                best_area = area;
+                best = j;
+            }
+        }
+        kept.push(best);
+        a = best;
+    }
+    kept.push(n - 1);
+    kept
+}
+
 pub fn compute_drawdown_series(equity_curve: &[EquityPoint]) -> Vec<f64> {
     let mut drawdowns = Vec::with_capacity(equity_curve.len());
     let mut peak = equity_curve[0].equity;
@@ -321,6 +373,58 @@ mod tests {
         assert!(svg.contains("fill=\"rgba(239,68,68,0.3)\""));
     }
 
+    fn daily_curve(values: &[f64]) -> Vec<EquityPoint> {
+        let start = NaiveDate::from_ymd_opt(2000, 1, 1).unwrap();
+        values
+            .iter()
+            .enumerate()
+            .map(|(i, &equity)| EquityPoint {
+                date: start + chrono::Duration::days(i as i64),
+                equity,
+            })
+            .collect()
+    }
+
+    #[test]
+    fn lttb_keeps_short_series_whole() {
+        assert_eq!(lttb_indices(&[1.0, 2.0, 3.0], 10), vec![0, 1, 2]);
+        assert_eq!(lttb_indices(&[1.0, 2.0, 3.0, 4.0], 2), vec![0, 1, 2, 3]);
+        assert!(lttb_indices(&[], 10).is_empty());
+    }
+
+    #[test]
+    fn lttb_caps_points_and_keeps_extremes() {
+        let mut values: Vec<f64> = (0..10_000).map(|i| 100.0 + (i % 7) as f64 * 0.01).collect();
+        values[3_333] = 500.0;
+        values[6_666] = 10.0;
+
+        let kept = lttb_indices(&values, 100);
+        assert_eq!(kept.len(), 100);
+        assert_eq!(kept[0], 0);
+        assert_eq!(kept[99], 9_999);
+        assert!(kept.windows(2).all(|w| w[0] < w[1]));
+        assert!(kept.contains(&3_333), "peak dropped");
+        assert!(kept.contains(&6_666), "trough dropped");
+    }
+
+    #[test]
+    fn long_curves_are_drawn_with_bounded_vertices() {
+        let values: Vec<f64> = (0..20 * 252)
+            .map(|i| 100_000.0 + (i as f64 * 0.05).sin() * 5_000.0 + i as f64)
+            .collect();
+        let curve = daily_curve(&values);
+
+        let equity = generate_equity_svg(&curve);
+        assert_eq!(equity.matches(" L ").count(), MAX_VERTICES - 1);
+        // Labels still come from the full curve.
+        let max = values.iter().cloned().fold(f64::NEG_INFINITY, f64::max);
+        assert!(equity.contains(&fmt_currency(max)));
+
+        let drawdown = generate_drawdown_svg(&curve);
+        // Downsampled vertices plus the two closing the area.
+        assert_eq!(drawdown.matches(" L ").count(), MAX_VERTICES - 1 + 2);
+    }
+
     #[test]
     fn drawdown_series_zero_drawdown() {
         let curve = vec![
@@ -4,6 +4,13 @@
 
 use argon2::{Argon2, PasswordHash, PasswordVerifier};
 use axum_login::{AuthUser, AuthnBackend, UserId};
+use std::sync::Arc;
+use tokio::sync::Semaphore;
+
+/// Argon2 verifications allowed to run at once. Each one takes tens of
+/// milliseconds of CPU and ~19 MiB of memory, so a burst of login attempts
+/// must not fan out across the whole blocking pool.
+const MAX_CONCURRENT_VERIFICATIONS: usize = 2;
 
 /// Authenticated user. Since this is single-user, the username is the ID.
 #[derive(Debug, Clone, serde::Serialize, serde::Deserialize)]
@@ -37,6 +44,7 @@ pub struct Credentials {
 pub struct Backend {
     username: String,
     password_hash: String,
+    verify_permits: Arc<Semaphore>,
 }
 
 impl Backend {
@@ -44,6 +52,7 @@ impl Backend {
         Self {
             username,
             password_hash,
+            verify_permits: Arc::new(Semaphore::new(MAX_CONCURRENT_VERIFICATIONS)),
         }
     }
 
@@ -68,16 +77,24 @@ impl AuthnBackend for Backend {
             return Ok(None);
         }
 
-        let parsed_hash = match PasswordHash::new(&self.password_hash) {
-            Ok(h) => h,
-            Err(_) => return Ok(None),
+        // Verification is deliberately slow; run it on the blocking pool so
+        // it never stalls a Tokio worker serving other requests.
+        let Ok(_permit) = self.verify_permits.acquire().await else {
+            return Ok(None);
         };
+        let password_hash = self.password_hash.clone();
+        let verified = tokio::task::spawn_blocking(move || {
+            let Ok(parsed_hash) = PasswordHash::new(&password_hash) else {
+                return false;
+            };
+            Argon2::default()
+                .verify_password(creds.password.as_bytes(), &parsed_hash)
+                .is_ok()
+        })
+        .await
+        .unwrap_or(false);
 
-        let argon2 = Argon2::default();
-        if argon2
-            .verify_password(creds.password.as_bytes(), &parsed_hash)
-            .is_ok()
-        {
+        if verified {
             Ok(Some(self.make_user()))
         } else {
             Ok(None)
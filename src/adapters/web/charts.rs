@@ -0,0 +1,112 @@
+//! Rendered report charts, memoized per report.
+//!
+//! A report's equity and drawdown SVGs depend only on its equity curve, so
+//! each is rendered once, gzip-compressed once and served from memory after
+//! that. The ETag is a hash of the SVG, which lets browsers revalidate with
+//! `If-None-Match` instead of downloading the chart again.
+
+use std::io::Write;
+
+use flate2::Compression;
+use flate2::write::GzEncoder;
+
+/// An SVG chart ready to serve, with its gzip encoding and ETag.
+#[derive(Debug, Clone, PartialEq)]
+pub struct RenderedChart {
+    pub svg: String,
+    pub gzip: Vec<u8>,
+    pub etag: String,
+}
+
+impl RenderedChart {
+    pub fn new(svg: String) -> Self {
+        let mut encoder = GzEncoder::new(Vec::new(), Compression::default());
+        let gzip = encoder
+            .write_all(svg.as_bytes())
+            .and_then(|()| encoder.finish())
+            .expect("gzip into a Vec cannot fail");
+        let etag = format!("\"{:016x}\"", fnv1a_64(svg.as_bytes()));
+        RenderedChart { svg, gzip, etag }
+    }
+
+    /// Whether an `If-None-Match` header value names this chart's ETag.
+    /// Weak validators match too, as RFC 9110 requires for this header.
+    pub fn matches(&self, if_none_match: &str) -> bool {
+        if_none_match
+            .split(',')
+            .map(str::trim)
+            .any(|tag| tag == "*" || tag.strip_prefix("W/").unwrap_or(tag) == self.etag)
+    }
+}
+
+/// Whether an `Accept-Encoding` header value allows a gzip response. An
+/// explicit `gzip` entry decides; `*` only applies when gzip is not named.
+pub fn accepts_gzip(accept_encoding: &str) -> bool {
+    let mut wildcard = None;
+    for coding in accept_encoding.split(',') {
+        let mut parts = coding.split(';').map(str::trim);
+        let name = parts.next().unwrap_or("");
+        let refused = parts.any(|p| {
+            p.strip_prefix("q=")
+                .and_then(|q| q.parse::<f64>().ok())
+                .is_some_and(|q| q == 0.0)
+        });
+        if name.eq_ignore_ascii_case("gzip") {
+            return !refused;
+        }
+        if name == "*" {
+            wildcard = Some(!refused);
+        }
+    }
+    wildcard.unwrap_or(false)
+}
+
+fn fnv1a_64(bytes: &[u8]) -> u64 {
+    bytes.iter().fold(0xcbf2_9ce4_8422_2325, |hash, &b| {
+        (hash ^ b as u64).wrapping_mul(0x0000_0100_0000_01b3)
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use flate2::read::GzDecoder;
+    use std::io::Read;
+
+    #[test]
+    fn gzip_round_trips_and_etag_tracks_content() {
+        let chart = RenderedChart::new("<svg>".repeat(200));
+        let mut plain = String::new();
+        GzDecoder::new(chart.gzip.as_slice())
+            .read_to_string(&mut plain)
+            .unwrap();
+        assert_eq!(plain, chart.svg);
+        assert!(chart.gzip.len() < chart.svg.len());
+
+        assert_eq!(chart.etag, RenderedChart::new(chart.svg.clone()).etag);
+        assert_ne!(chart.etag, RenderedChart::new("<svg/>".into()).etag);
+    }
+
+    #[test]
+    fn if_none_match_accepts_lists_weak_tags_and_wildcard() {
+        let chart = RenderedChart::new("<svg/>".into());
+        assert!(chart.matches(&chart.etag));
+        assert!(chart.matches(&format!("\"other\", W/{}", chart.etag)));
+        assert!(chart.matches("*"));
+        assert!(!chart.matches("\"other\""));
+    }
+
+    #[test]
+    fn accept_encoding_respects_zero_quality() {
+        assert!(accepts_gzip("gzip, deflate, br"));
+        assert!(accepts_gzip("br;q=1.0, GZIP;q=0.5"));
+        assert!(accepts_gzip("*"));
+        assert!(!accepts_gzip("gzip;q=0"));
+        assert!(!accepts_gzip("*, gzip;q=0"));
+        assert!(!accepts_gzip("gzip;q=0, *"));
+        assert!(!accepts_gzip("*;q=0"));
+        assert!(accepts_gzip("*;q=0, gzip"));
+        assert!(!accepts_gzip("deflate, br"));
+        assert!(!accepts_gzip(""));
+    }
+}
@@ -2,32 +2,27 @@
 
 use axum::{
     extract::{Path, State},
-    http::{HeaderMap, header},
+    http::{HeaderMap, StatusCode, header},
     response::{IntoResponse, Redirect, Response},
     Form,
 };
 use std::sync::Arc;
 
-use crate::domain::backtest::{run_backtest as run_backtest_engine, BacktestConfig};
-use crate::domain::code_data::{build_unified_timeline, CodeData};
-use crate::domain::indicator_helpers::compute_indicators;
+use crate::domain::backtest::{run_backtest_with_progress, BacktestConfig};
+use crate::domain::code_data::build_unified_timeline;
+use crate::domain::loader::{compute_code_indicators, fetch_code_data};
 use crate::domain::metrics::{CodeResult, Metrics};
 use crate::domain::rule::extract_indicators;
 use crate::domain::strategy::Strategy;
-use crate::domain::universe::{validate_universe, SkipReason};
+use crate::domain::universe::{validate_fetched, SkipReason};
 
-use super::{AppState, WebError, auth};
+use super::charts::{accepts_gzip, RenderedChart};
+use super::jobs::{JobProgress, JobStatus};
+use super::{is_htmx_request, AppState, CachedBacktest, WebError, auth};
 use super::templates::{render_page, render_page_with_nav, LoginTemplate};
 
 type AuthSession = axum_login::AuthSession<auth::Backend>;
 
-fn generate_report_id() -> String {
-    use rand::Rng;
-    let mut rng = rand::thread_rng();
-    let id: u64 = rng.r#gen();
-    format!("{:016x}", id)
-}
-
 pub async fn dashboard(
     State(_state): State<Arc<AppState>>,
     headers: HeaderMap,
@@ -87,6 +82,28 @@ pub async fn logout(mut auth_session: AuthSession) -> Result<Response, WebError>
     Ok(Redirect::to("/login").into_response())
 }
 
+#[derive(Debug, serde::Deserialize)]
+pub struct InvalidateFormData {
+    pub exchange: String,
+    #[serde(default)]
+    pub code: Option<String>,
+}
+
+/// Drop cached bars for one code (or a whole exchange) after new data has
+/// been ingested, so the next backtest reads it from the database.
+pub async fn invalidate_data(
+    State(state): State<Arc<AppState>>,
+    Form(form): Form<InvalidateFormData>,
+) -> Result<Response, WebError> {
+    let code = form.code.as_deref().map(str::trim).filter(|c| !c.is_empty());
+    state.data_port.invalidate(form.exchange.trim(), code);
+    let cache = Arc::clone(&state.backtest_cache);
+    tokio::task::spawn_blocking(move || cache.bump_data_epoch())
+        .await
+        .map_err(|e| WebError::internal(e.to_string()))??;
+    Ok(StatusCode::NO_CONTENT.into_response())
+}
+
 pub async fn backtest_form(
     State(state): State<Arc<AppState>>,
     headers: HeaderMap,
@@ -168,50 +185,181 @@ pub async fn run_backtest(
         slippage_pct: 0.0,
         allow_shorting: false,
         risk_free_rate: 0.05,
+        workers: 0,
+    };
+
+    let (data_port, range_codes) = (Arc::clone(&state.data_port), codes.clone());
+    let ranges = tokio::task::spawn_blocking(move || {
+        data_ranges(&*data_port, &range_codes, "ASX")
+    })
+    .await
+    .map_err(|e| err(WebError::internal(e.to_string())))?;
+    let job_id = backtest_key(
+        &codes,
+        &strategy,
+        &bt_config,
+        &ranges,
+        state.backtest_cache.data_epoch(),
+    );
+    if find_report(&state, &job_id).await.map_err(err)?.is_some() {
+        return Ok(redirect_to_report(&job_id, &headers));
+    }
+
+    // Identical in-flight requests share the job keyed by `job_id`.
+    let job_state = Arc::clone(&state);
+    let report_id = job_id.clone();
+    state
+        .jobs
+        .submit(job_id.clone(), move |progress| {
+            execute_backtest(&job_state, report_id, &codes, &strategy, &bt_config, progress)
+        })
+        .map_err(|_| {
+            err(WebError::new(
+                StatusCode::SERVICE_UNAVAILABLE,
+                "Too many backtests are queued; try again shortly",
+            ))
+        })?;
+
+    let template = super::templates::JobStatusTemplate {
+        job_id: &job_id,
+        percent: None,
+    };
+    let page = render_page(&template, "Backtest Queued - Samtrader", &headers)?;
+    Ok((StatusCode::ACCEPTED, page).into_response())
+}
+
+/// `DataPort::get_data_range` of each code, in `codes` order. A code whose
+/// range cannot be read counts as having no data, as validation would skip
+/// it either way.
+fn data_ranges(
+    data_port: &dyn crate::ports::data_port::DataPort,
+    codes: &[String],
+    exchange: &str,
+) -> Vec<Option<(chrono::NaiveDate, chrono::NaiveDate, usize)>> {
+    codes
+        .iter()
+        .map(|code| data_port.get_data_range(code, exchange).ok().flatten())
+        .collect()
+}
+
+/// Content key of a web backtest request, used as its job and report ID.
+///
+/// Covers everything that determines the result: the strategy's rules (in
+/// their normalized `Display` form) and parameters, the codes in submission
+/// order (which fixes `SymbolId` order), the config fields the engine and
+/// metrics read, and the data the run would read. The data is identified by
+/// each code's `data_ranges` entry (first and last date and bar count), so
+/// bars added by any writer (`import`, a loader, another process) change the
+/// key, and by the cache's data epoch, which `/data/invalidate` bumps for
+/// bars restated in place. Display names and `workers` are left out. Hashed
+/// with 128-bit FNV-1a, which unlike `DefaultHasher` is stable across
+/// builds.
+pub fn backtest_key(
+    codes: &[String],
+    strategy: &Strategy,
+    config: &BacktestConfig,
+    data_ranges: &[Option<(chrono::NaiveDate, chrono::NaiveDate, usize)>],
+    data_epoch: u64,
+) -> String {
+    let optional = |rule: &Option<crate::domain::rule::Rule>| {
+        rule.as_ref().map_or_else(|| "-".to_string(), |r| r.to_string())
     };
+    let data = data_ranges
+        .iter()
+        .map(|range| match range {
+            Some((first, last, bars)) => format!("{first}/{last}/{bars}"),
+            None => "-".to_string(),
+        })
+        .collect::<Vec<_>>()
+        .join(",");
+    let canonical = format!(
+        "entry={}|exit={}|entry_short={}|exit_short={}|size={:?}|stop={:?}|take={:?}|max={}\
+         |codes={}|start={}|end={}|capital={:?}|commission={:?}|commission_pct={:?}\
+         |slippage={:?}|shorting={}|risk_free={:?}|data={}|epoch={}",
+        strategy.entry_long,
+        strategy.exit_long,
+        optional(&strategy.entry_short),
+        optional(&strategy.exit_short),
+        strategy.position_size,
+        strategy.stop_loss_pct,
+        strategy.take_profit_pct,
+        strategy.max_positions,
+        codes.join(","),
+        config.start_date,
+        config.end_date,
+        config.initial_capital,
+        config.commission_per_trade,
+        config.commission_pct,
+        config.slippage_pct,
+        config.allow_shorting,
+        config.risk_free_rate,
+        data,
+        data_epoch,
+    );
+    const OFFSET: u128 = 0x6c62_272e_07bb_0142_62b8_2175_6295_c58d;
+    const PRIME: u128 = 0x0000_0000_0100_0000_0000_0000_0000_013b;
+    let hash = canonical
+        .bytes()
+        .fold(OFFSET, |hash, b| (hash ^ b as u128).wrapping_mul(PRIME));
+    format!("{hash:032x}")
+}
+
+/// Send the browser to a finished report: `HX-Redirect` for HTMX requests,
+/// otherwise a 303.
+fn redirect_to_report(report_id: &str, headers: &HeaderMap) -> Response {
+    let location = format!("/report/{report_id}");
+    if is_htmx_request(headers) {
+        ([("HX-Redirect", location)], StatusCode::OK).into_response()
+    } else {
+        Redirect::to(&location).into_response()
+    }
+}
 
-    let validation = validate_universe(
+/// Run a submitted backtest on a job worker: load the universe, run the
+/// engine and cache the report under `report_id`, returning it.
+fn execute_backtest(
+    state: &AppState,
+    report_id: String,
+    codes: &[String],
+    strategy: &Strategy,
+    bt_config: &BacktestConfig,
+    progress: &JobProgress,
+) -> Result<String, WebError> {
+    let fetched = fetch_code_data(
         &*state.data_port,
-        codes.clone(),
+        codes,
         "ASX",
-        start_date,
-        end_date,
-    ).map_err(|e| err(WebError::bad_request(e.to_string())))?;
+        bt_config.start_date,
+        bt_config.end_date,
+        bt_config.workers,
+    )?;
+    let validation = validate_fetched(codes.to_vec(), fetched, "ASX")
+        .map_err(|e| WebError::bad_request(e.to_string()))?;
 
-    let valid_codes = &validation.universe.codes;
     let indicator_types = extract_indicators(&strategy.entry_long)
         .into_iter()
         .chain(extract_indicators(&strategy.exit_long))
         .collect::<Vec<_>>();
 
-    let mut code_data_vec: Vec<CodeData> = Vec::with_capacity(valid_codes.len());
-
-    for code in valid_codes {
-        let ohlcv = state.data_port.fetch_ohlcv(
-            code,
-            "ASX",
-            start_date,
-            end_date,
-        ).map_err(|e| err(WebError::internal(e.to_string())))?;
-
-        let indicators = compute_indicators(&ohlcv, &indicator_types);
-        let mut cd = CodeData::new(code.to_string(), "ASX".to_string(), ohlcv);
-        cd.indicators = indicators;
-        code_data_vec.push(cd);
-    }
+    let mut code_data_vec = validation.code_data;
+    compute_code_indicators(&mut code_data_vec, &indicator_types, bt_config.workers);
 
     if code_data_vec.is_empty() {
-        return Err(err(WebError::bad_request("No valid codes with data")));
+        return Err(WebError::bad_request("No valid codes with data"));
     }
 
     let timeline = build_unified_timeline(&code_data_vec);
-    let result = run_backtest_engine(&code_data_vec, &timeline, &strategy, &bt_config);
+    let result = run_backtest_with_progress(
+        &code_data_vec,
+        &timeline,
+        strategy,
+        bt_config,
+        &mut |done, total| progress.set(done, total),
+    );
     let metrics = Metrics::compute(&result.portfolio, bt_config.risk_free_rate);
     let code_results = CodeResult::compute_per_code(&result.portfolio.closed_trades);
 
-    let report_id = generate_report_id();
-
-    let skipped_owned: Vec<(String, String)> = validation.skipped
+    let skipped: Vec<(String, String)> = validation.skipped
         .iter()
         .map(|s| (s.code.clone(), match &s.reason {
             SkipReason::NoData => "No data available".to_string(),
@@ -219,50 +367,72 @@ pub async fn run_backtest(
         }))
         .collect();
 
-    {
-        let mut cache = state.backtest_cache.write().unwrap();
-        cache.insert(report_id.clone(), super::CachedBacktest {
-            equity_curve: result.portfolio.equity_curve.clone(),
-            strategy: strategy.clone(),
-            metrics: metrics.clone(),
-            code_results: code_results.clone(),
-            trades: result.portfolio.closed_trades.clone(),
-            skipped: skipped_owned.clone(),
-            start_date,
-            end_date,
-            initial_capital,
-            created_at: std::time::Instant::now(),
-        });
+    let report = CachedBacktest::new(
+        strategy,
+        bt_config,
+        metrics,
+        code_results,
+        &result.portfolio,
+        skipped,
+    );
+    // The report is cached in memory either way; a failed write only means
+    // it will not outlive this process.
+    if let Err(e) = state.backtest_cache.insert(report_id.clone(), report) {
+        eprintln!("warning: failed to persist report {report_id}: {e}");
     }
 
-    let monthly_returns = super::templates::compute_monthly_returns(
-        &result.portfolio.equity_curve,
-    );
+    Ok(report_id)
+}
 
-    let skipped: Vec<super::templates::SkippedCode> = skipped_owned
-        .iter()
-        .map(|(code, reason)| super::templates::SkippedCode {
-            code: code.as_str(),
-            reason: reason.as_str(),
-        })
-        .collect();
+/// A finished report from memory or, if it was evicted or predates a
+/// restart, from the result store (read on the blocking pool).
+async fn find_report(
+    state: &AppState,
+    id: &str,
+) -> Result<Option<Arc<CachedBacktest>>, WebError> {
+    if let Some(report) = state.backtest_cache.get(id) {
+        return Ok(Some(report));
+    }
+    let cache = Arc::clone(&state.backtest_cache);
+    let id = id.to_string();
+    let report = tokio::task::spawn_blocking(move || cache.load(&id))
+        .await
+        .map_err(|e| WebError::internal(e.to_string()))??;
+    Ok(report)
+}
 
-    let template = super::templates::ReportTemplate {
-        report_id: &report_id,
-        strategy: &strategy,
-        metrics: &metrics,
-        code_results: if code_results.is_empty() { None } else { Some(&code_results) },
-        equity_svg: None,
-        drawdown_svg: None,
-        trades: &result.portfolio.closed_trades,
-        skipped: &skipped,
-        start_date,
-        end_date,
-        initial_capital,
-        monthly_returns: &monthly_returns,
+async fn load_report(state: &AppState, id: &str) -> Result<Arc<CachedBacktest>, WebError> {
+    find_report(state, id)
+        .await?
+        .ok_or_else(|| WebError::not_found("Report not found"))
+}
+
+/// Poll target for a submitted backtest. Renders progress while the job is
+/// queued or running and redirects to the report once it is done.
+pub async fn job_status(
+    State(state): State<Arc<AppState>>,
+    Path(id): Path<String>,
+    headers: HeaderMap,
+) -> Result<Response, WebError> {
+    let status = state
+        .jobs
+        .status(&id)
+        .ok_or_else(|| WebError::not_found("Job not found").with_headers(headers.clone()))?;
+
+    let percent = match status {
+        JobStatus::Queued => None,
+        JobStatus::Running { percent } => Some(percent),
+        JobStatus::Done { report_id } => return Ok(redirect_to_report(&report_id, &headers)),
+        JobStatus::Failed { status, message } => {
+            return Err(WebError::new(status, message).with_headers(headers));
+        }
     };
 
-    render_page(&template, "Report - Samtrader", &headers)
+    let template = super::templates::JobStatusTemplate {
+        job_id: &id,
+        percent,
+    };
+    render_page(&template, "Backtest Running - Samtrader", &headers)
 }
 
 pub async fn view_report(
@@ -270,11 +440,11 @@ pub async fn view_report(
     Path(id): Path<String>,
     headers: HeaderMap,
 ) -> Result<Response, WebError> {
-    let cache = state.backtest_cache.read().unwrap();
-    let cached = cache.get(&id)
-        .ok_or_else(|| WebError::not_found("Report not found"))?;
+    let cached = load_report(&state, &id).await?;
+    let equity_curve = cached.equity_curve();
+    let trades = cached.trades();
 
-    let monthly_returns = super::templates::compute_monthly_returns(&cached.equity_curve);
+    let monthly_returns = super::templates::compute_monthly_returns(&equity_curve);
     let skipped: Vec<super::templates::SkippedCode> = cached.skipped
         .iter()
         .map(|(code, reason)| super::templates::SkippedCode {
@@ -290,7 +460,7 @@ pub async fn view_report(
         code_results: if cached.code_results.is_empty() { None } else { Some(&cached.code_results) },
         equity_svg: None,
         drawdown_svg: None,
-        trades: &cached.trades,
+        trades: &trades,
         skipped: &skipped,
         start_date: cached.start_date,
         end_date: cached.end_date,
@@ -304,31 +474,51 @@ pub async fn view_report(
 pub async fn equity_chart_svg(
     State(state): State<Arc<AppState>>,
     Path(id): Path<String>,
+    headers: HeaderMap,
 ) -> Result<Response, WebError> {
-    let cache = state.backtest_cache.read().unwrap();
-    let cached = cache.get(&id).ok_or_else(|| WebError::not_found("Report not found"))?;
-    
-    let svg = crate::adapters::typst_report::chart_svg::generate_equity_svg(&cached.equity_curve);
-    
-    Ok((
-        [(header::CONTENT_TYPE, "image/svg+xml")],
-        svg,
-    ).into_response())
+    let cached = load_report(&state, &id).await?;
+    Ok(chart_response(cached.equity_chart(), &headers))
 }
 
 pub async fn drawdown_chart_svg(
     State(state): State<Arc<AppState>>,
     Path(id): Path<String>,
+    headers: HeaderMap,
 ) -> Result<Response, WebError> {
-    let cache = state.backtest_cache.read().unwrap();
-    let cached = cache.get(&id).ok_or_else(|| WebError::not_found("Report not found"))?;
-    
-    let svg = crate::adapters::typst_report::chart_svg::generate_drawdown_svg(&cached.equity_curve);
-    
-    Ok((
+    let cached = load_report(&state, &id).await?;
+    Ok(chart_response(cached.drawdown_chart(), &headers))
+}
+
+/// Serve a memoized chart: 304 when the client already has this ETag,
+/// otherwise the SVG, gzip-encoded when the client accepts it. `no-cache`
+/// makes browsers revalidate, which costs only the 304.
+fn chart_response(chart: &RenderedChart, headers: &HeaderMap) -> Response {
+    let header_str =
+        |name: header::HeaderName| headers.get(name).and_then(|v| v.to_str().ok());
+    let cache_headers = [
+        (header::ETAG, chart.etag.clone()),
+        (header::CACHE_CONTROL, "private, no-cache".to_string()),
+        (header::VARY, "Accept-Encoding".to_string()),
+    ];
+
+    if header_str(header::IF_NONE_MATCH).is_some_and(|tags| chart.matches(tags)) {
+        return (StatusCode::NOT_MODIFIED, cache_headers).into_response();
+    }
+    if header_str(header::ACCEPT_ENCODING).is_some_and(accepts_gzip) {
+        return (
+            cache_headers,
+            [
+                (header::CONTENT_TYPE, "image/svg+xml"),
+                (header::CONTENT_ENCODING, "gzip"),
+            ],
+            chart.gzip.clone(),
+        ).into_response();
+    }
+    (
+        cache_headers,
         [(header::CONTENT_TYPE, "image/svg+xml")],
-        svg,
-    ).into_response())
+        chart.svg.clone(),
+    ).into_response()
 }
 
 pub async fn not_found(headers: HeaderMap) -> WebError {
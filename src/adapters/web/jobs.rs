@@ -0,0 +1,329 @@
+//! Bounded job pool for web backtests.
+//!
+//! Backtests are CPU-bound and synchronous, so handlers hand them to a fixed
+//! set of worker threads instead of running them on a Tokio worker. At most
+//! `queue_depth` jobs wait for a free worker; further submissions are refused
+//! so the server answers with 503 rather than queueing without bound. Each
+//! job's status is kept for `JOB_RETENTION` after it finishes so the status
+//! endpoint can be polled.
+
+use axum::http::StatusCode;
+use std::collections::HashMap;
+use std::panic::{AssertUnwindSafe, catch_unwind};
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::mpsc::{self, Receiver, SyncSender, TrySendError};
+use std::sync::{Arc, Mutex};
+use std::thread;
+use std::time::{Duration, Instant};
+
+use super::WebError;
+use crate::ports::config_port::ConfigPort;
+
+/// How long a finished job's status stays pollable.
+const JOB_RETENTION: Duration = Duration::from_secs(15 * 60);
+
+type Task = Box<dyn FnOnce() + Send>;
+
+/// Dates processed so far by a running job, updated from the worker thread
+/// without taking the pool lock.
+#[derive(Debug, Default)]
+pub struct JobProgress {
+    done: AtomicUsize,
+    total: AtomicUsize,
+}
+
+impl JobProgress {
+    pub fn set(&self, done: usize, total: usize) {
+        self.total.store(total, Ordering::Relaxed);
+        self.done.store(done, Ordering::Relaxed);
+    }
+
+    /// Percent complete, 0 until the total is known.
+    pub fn percent(&self) -> u8 {
+        let total = self.total.load(Ordering::Relaxed);
+        if total == 0 {
+            return 0;
+        }
+        let done = self.done.load(Ordering::Relaxed).min(total);
+        (done * 100 / total) as u8
+    }
+}
+
+/// Snapshot of a job as seen by the status endpoint.
+#[derive(Debug, Clone, PartialEq)]
+pub enum JobStatus {
+    Queued,
+    Running { percent: u8 },
+    Done { report_id: String },
+    Failed { status: StatusCode, message: String },
+}
+
+enum JobState {
+    Queued,
+    Running,
+    Done(String),
+    Failed(StatusCode, String),
+}
+
+struct JobEntry {
+    state: JobState,
+    progress: Arc<JobProgress>,
+    finished_at: Option<Instant>,
+}
+
+struct PoolInner {
+    sender: SyncSender<Task>,
+    jobs: Mutex<HashMap<String, JobEntry>>,
+}
+
+impl PoolInner {
+    fn set_state(&self, id: &str, state: JobState) {
+        let mut jobs = self.jobs.lock().unwrap();
+        if let Some(entry) = jobs.get_mut(id) {
+            if matches!(state, JobState::Done(_) | JobState::Failed(..)) {
+                entry.finished_at = Some(Instant::now());
+            }
+            entry.state = state;
+        }
+    }
+}
+
+/// Returned by `JobPool::submit` when the queue is already full.
+#[derive(Debug)]
+pub struct QueueFull;
+
+/// Handle to the worker threads; cheap to clone.
+#[derive(Clone)]
+pub struct JobPool {
+    inner: Arc<PoolInner>,
+}
+
+impl JobPool {
+    /// Start `workers` threads (at least one) behind a queue of `queue_depth`
+    /// waiting jobs. Workers exit once every handle has been dropped.
+    pub fn new(workers: usize, queue_depth: usize) -> Self {
+        let (sender, receiver) = mpsc::sync_channel::<Task>(queue_depth);
+        let receiver = Arc::new(Mutex::new(receiver));
+        for n in 0..workers.max(1) {
+            let receiver = Arc::clone(&receiver);
+            thread::Builder::new()
+                .name(format!("samtrader-job-{n}"))
+                .spawn(move || worker_loop(&receiver))
+                .expect("failed to spawn job worker");
+        }
+        Self {
+            inner: Arc::new(PoolInner {
+                sender,
+                jobs: Mutex::new(HashMap::new()),
+            }),
+        }
+    }
+
+    /// Pool sized by `[web] job_workers` (default 2) and `[web] job_queue`
+    /// (default 16).
+    pub fn from_config(config: &dyn ConfigPort) -> Self {
+        let workers = config.get_int("web", "job_workers", 2).max(1) as usize;
+        let queue_depth = config.get_int("web", "job_queue", 16).max(0) as usize;
+        Self::new(workers, queue_depth)
+    }
+
+    /// Queue `work` under `id`. The closure runs on a worker thread and
+    /// returns the report ID of the finished backtest.
+    ///
+    /// IDs are content keys, so a job already queued or running under `id`
+    /// is computing the same result: `work` is dropped and the caller polls
+    /// that job instead. A finished job under `id` is replaced.
+    pub fn submit<F>(&self, id: String, work: F) -> Result<(), QueueFull>
+    where
+        F: FnOnce(&JobProgress) -> Result<String, WebError> + Send + 'static,
+    {
+        let progress = Arc::new(JobProgress::default());
+        {
+            let mut jobs = self.inner.jobs.lock().unwrap();
+            jobs.retain(|_, e| e.finished_at.is_none_or(|t| t.elapsed() < JOB_RETENTION));
+            if jobs.get(&id).is_some_and(|e| e.finished_at.is_none()) {
+                return Ok(());
+            }
+            jobs.insert(
+                id.clone(),
+                JobEntry {
+                    state: JobState::Queued,
+                    progress: Arc::clone(&progress),
+                    finished_at: None,
+                },
+            );
+        }
+
+        let inner = Arc::clone(&self.inner);
+        let job_id = id.clone();
+        let task: Task = Box::new(move || {
+            inner.set_state(&job_id, JobState::Running);
+            let outcome = catch_unwind(AssertUnwindSafe(|| work(&progress)));
+            let state = match outcome {
+                Ok(Ok(report_id)) => JobState::Done(report_id),
+                Ok(Err(e)) => JobState::Failed(e.status, e.message),
+                Err(_) => JobState::Failed(
+                    StatusCode::INTERNAL_SERVER_ERROR,
+                    "Backtest job panicked".to_string(),
+                ),
+            };
+            inner.set_state(&job_id, state);
+        });
+
+        match self.inner.sender.try_send(task) {
+            Ok(()) => Ok(()),
+            Err(TrySendError::Full(_) | TrySendError::Disconnected(_)) => {
+                self.inner.jobs.lock().unwrap().remove(&id);
+                Err(QueueFull)
+            }
+        }
+    }
+
+    /// Current status of job `id`, or `None` if it is unknown or expired.
+    pub fn status(&self, id: &str) -> Option<JobStatus> {
+        let jobs = self.inner.jobs.lock().unwrap();
+        let entry = jobs.get(id)?;
+        Some(match &entry.state {
+            JobState::Queued => JobStatus::Queued,
+            JobState::Running => JobStatus::Running {
+                percent: entry.progress.percent(),
+            },
+            JobState::Done(report_id) => JobStatus::Done {
+                report_id: report_id.clone(),
+            },
+            JobState::Failed(status, message) => JobStatus::Failed {
+                status: *status,
+                message: message.clone(),
+            },
+        })
+    }
+}
+
+fn worker_loop(receiver: &Mutex<Receiver<Task>>) {
+    loop {
+        let task = receiver.lock().unwrap().recv();
+        match task {
+            Ok(task) => task(),
+            Err(_) => return,
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use std::sync::mpsc::channel;
+
+    fn wait_for(pool: &JobPool, id: &str) -> JobStatus {
+        let deadline = Instant::now() + Duration::from_secs(5);
+        loop {
+            match pool.status(id) {
+                Some(JobStatus::Queued | JobStatus::Running { .. })
+                    if Instant::now() < deadline =>
+                {
+                    thread::sleep(Duration::from_millis(5));
+                }
+                Some(status) => return status,
+                None => panic!("job {id} vanished"),
+            }
+        }
+    }
+
+    #[test]
+    fn job_runs_to_done() {
+        let pool = JobPool::new(1, 4);
+        pool.submit("a".into(), |progress| {
+            progress.set(3, 4);
+            assert_eq!(progress.percent(), 75);
+            Ok("report-a".into())
+        })
+        .unwrap();
+        assert_eq!(
+            wait_for(&pool, "a"),
+            JobStatus::Done {
+                report_id: "report-a".into()
+            }
+        );
+        assert_eq!(pool.status("missing"), None);
+    }
+
+    #[test]
+    fn errors_and_panics_become_failed() {
+        let pool = JobPool::new(1, 4);
+        pool.submit("bad".into(), |_| Err(WebError::bad_request("no data")))
+            .unwrap();
+        pool.submit("boom".into(), |_| panic!("engine bug"))
+            .unwrap();
+        assert_eq!(
+            wait_for(&pool, "bad"),
+            JobStatus::Failed {
+                status: StatusCode::BAD_REQUEST,
+                message: "no data".into()
+            }
+        );
+        assert!(matches!(
+            wait_for(&pool, "boom"),
+            JobStatus::Failed {
+                status: StatusCode::INTERNAL_SERVER_ERROR,
+                ..
+            }
+        ));
+    }
+
+    #[test]
+    fn identical_ids_share_one_computation() {
+        let pool = JobPool::new(1, 4);
+        let runs = Arc::new(AtomicUsize::new(0));
+        let (release, gate) = channel::<()>();
+        let counted = Arc::clone(&runs);
+        pool.submit("key".into(), move |_| {
+            counted.fetch_add(1, Ordering::SeqCst);
+            gate.recv().unwrap();
+            Ok("key".into())
+        })
+        .unwrap();
+        let counted = Arc::clone(&runs);
+        pool.submit("key".into(), move |_| {
+            counted.fetch_add(1, Ordering::SeqCst);
+            Ok("key".into())
+        })
+        .unwrap();
+
+        release.send(()).unwrap();
+        assert!(matches!(wait_for(&pool, "key"), JobStatus::Done { .. }));
+        assert_eq!(runs.load(Ordering::SeqCst), 1);
+
+        // Once finished, the same ID runs again.
+        let counted = Arc::clone(&runs);
+        pool.submit("key".into(), move |_| {
+            counted.fetch_add(1, Ordering::SeqCst);
+            Ok("key".into())
+        })
+        .unwrap();
+        wait_for(&pool, "key");
+        assert_eq!(runs.load(Ordering::SeqCst), 2);
+    }
+
+    #[test]
+    fn full_queue_rejects_submissions() {
+        let pool = JobPool::new(1, 1);
+        let (release, gate) = channel::<()>();
+        let (started, running) = channel::<()>();
+        pool.submit("busy".into(), move |_| {
+            started.send(()).unwrap();
+            gate.recv().unwrap();
+            Ok("busy".into())
+        })
+        .unwrap();
+        running.recv().unwrap();
+
+        pool.submit("waiting".into(), |_| Ok("waiting".into()))
+            .unwrap();
+        assert_eq!(pool.status("waiting"), Some(JobStatus::Queued));
+        assert!(pool.submit("rejected".into(), |_| Ok("x".into())).is_err());
+        assert_eq!(pool.status("rejected"), None);
+
+        release.send(()).unwrap();
+        assert!(matches!(wait_for(&pool, "waiting"), JobStatus::Done { .. }));
+    }
+}
@@ -4,12 +4,17 @@
 //! and viewing reports through a browser.
 
 pub mod auth;
+pub mod charts;
 mod error;
 mod handlers;
+pub mod jobs;
+pub mod report_cache;
 pub mod templates;
 
 pub use error::WebError;
 pub use handlers::*;
+pub use jobs::JobPool;
+pub use report_cache::{CachedBacktest, ReportCache, StrategySummary};
 pub use templates::*;
 
 use axum::{
@@ -18,80 +23,30 @@ use axum::{
 };
 use axum_login::{login_required, AuthManagerLayerBuilder};
 use axum_login::tower_sessions::{Expiry, SessionManagerLayer, cookie::Key};
-use std::collections::HashMap;
-use std::sync::{Arc, RwLock};
+use std::sync::Arc;
 use tower_http::services::ServeDir;
 #[cfg(feature = "web-sqlite")]
 use tower_sessions_rusqlite_store::RusqliteStore;
 
 use crate::ports::data_port::DataPort;
 use crate::ports::config_port::ConfigPort;
-use crate::domain::metrics::{CodeResult, Metrics};
-use crate::domain::portfolio::EquityPoint;
-use crate::domain::position::ClosedTrade;
-use crate::domain::strategy::Strategy;
-use chrono::NaiveDate;
-
-const BACKTEST_CACHE_MAX: usize = 32;
-
-pub struct CachedBacktest {
-    pub equity_curve: Vec<EquityPoint>,
-    pub strategy: Strategy,
-    pub metrics: Metrics,
-    pub code_results: Vec<CodeResult>,
-    pub trades: Vec<ClosedTrade>,
-    pub skipped: Vec<(String, String)>,
-    pub start_date: NaiveDate,
-    pub end_date: NaiveDate,
-    pub initial_capital: f64,
-    pub created_at: std::time::Instant,
-}
-
-pub struct BacktestCacheInner {
-    entries: HashMap<String, CachedBacktest>,
-}
 
-impl Default for BacktestCacheInner {
-    fn default() -> Self {
-        Self::new()
-    }
-}
-
-impl BacktestCacheInner {
-    pub fn new() -> Self {
-        Self { entries: HashMap::new() }
-    }
-
-    pub fn get(&self, key: &str) -> Option<&CachedBacktest> {
-        self.entries.get(key)
-    }
-
-    pub fn insert(&mut self, key: String, value: CachedBacktest) {
-        if self.entries.len() >= BACKTEST_CACHE_MAX {
-            // Evict oldest entry
-            if let Some(oldest_key) = self
-                .entries
-                .iter()
-                .min_by_key(|(_, v)| v.created_at)
-                .map(|(k, _)| k.clone())
-            {
-                self.entries.remove(&oldest_key);
-            }
-        }
-        self.entries.insert(key, value);
-    }
-}
+/// Memory budget of `new_backtest_cache`.
+const DEFAULT_REPORT_CACHE_BYTES: usize = 64 * 1024 * 1024;
 
-pub type BacktestCache = Arc<RwLock<BacktestCacheInner>>;
+pub type BacktestCache = Arc<ReportCache>;
 
+/// Memory-only report cache; the server builds a persistent one with
+/// `ReportCache::from_config`.
 pub fn new_backtest_cache() -> BacktestCache {
-    Arc::new(RwLock::new(BacktestCacheInner::new()))
+    Arc::new(ReportCache::new(DEFAULT_REPORT_CACHE_BYTES))
 }
 
 pub struct AppState {
     pub data_port: Arc<dyn DataPort + Send + Sync>,
     pub config: Arc<dyn ConfigPort + Send + Sync>,
     pub backtest_cache: BacktestCache,
+    pub jobs: JobPool,
 }
 
 /// Shared route definitions used by both production and test routers.
@@ -101,6 +56,7 @@ fn app_routes() -> Router<Arc<AppState>> {
         .route("/htmx.js", get(handlers::htmx_js))
         .route("/backtest", get(handlers::backtest_form))
         .route("/backtest/run", post(handlers::run_backtest))
+        .route("/backtest/job/{id}", get(handlers::job_status))
         .route("/report/{id}", get(handlers::view_report))
         .route(
             "/report/{id}/equity-chart",
@@ -110,6 +66,7 @@ fn app_routes() -> Router<Arc<AppState>> {
             "/report/{id}/drawdown-chart",
             get(handlers::drawdown_chart_svg),
         )
+        .route("/data/invalidate", post(handlers::invalidate_data))
         .route("/logout", post(handlers::logout))
 }
 
@@ -0,0 +1,846 @@
+//! Byte-bounded LRU of finished web reports with SQLite persistence.
+//!
+//! Reports are held in compact form: the equity curve as parallel date and
+//! value columns, and trades with their code and exchange interned into a
+//! per-report symbol table. The in-memory LRU is bounded by the measured
+//! size of those columns rather than by a report count, using the shared
+//! O(1) slab LRU in `adapters::lru`.
+//!
+//! With a `ReportStore` every report is also written to a
+//! `backtest_reports` table. An evicted report is read back on demand, so
+//! `/report/{id}` links survive restarts and deploys.
+
+use std::collections::HashMap;
+use std::mem::size_of;
+use std::sync::atomic::{AtomicU64, Ordering};
+use std::sync::{Arc, Mutex, OnceLock};
+
+use chrono::NaiveDate;
+
+use crate::adapters::lru::Lru;
+use crate::adapters::typst_report::chart_svg::{generate_drawdown_svg, generate_equity_svg};
+use crate::domain::backtest::BacktestConfig;
+use crate::domain::codec::{ByteReader, ByteWriter};
+use crate::domain::error::SamtraderError;
+use crate::domain::metrics::{CodeResult, Metrics};
+use crate::domain::portfolio::{EquityPoint, Portfolio};
+use crate::domain::position::ClosedTrade;
+use crate::domain::strategy::Strategy;
+use crate::ports::config_port::ConfigPort;
+
+use super::charts::RenderedChart;
+
+/// Format version of a stored report, bumped on layout changes.
+const REPORT_VERSION: u8 = 1;
+
+/// Strategy as shown on the report page. Rules are kept in their rendered
+/// form, since a finished report never evaluates them again.
+#[derive(Debug, Clone, PartialEq)]
+pub struct StrategySummary {
+    pub name: String,
+    pub description: String,
+    pub entry_long: String,
+    pub exit_long: String,
+    pub entry_short: Option<String>,
+    pub exit_short: Option<String>,
+    pub position_size: f64,
+    pub stop_loss_pct: f64,
+    pub take_profit_pct: f64,
+    pub max_positions: usize,
+}
+
+impl From<&Strategy> for StrategySummary {
+    fn from(strategy: &Strategy) -> Self {
+        StrategySummary {
+            name: strategy.name.clone(),
+            description: strategy.description.clone(),
+            entry_long: strategy.entry_long.to_string(),
+            exit_long: strategy.exit_long.to_string(),
+            entry_short: strategy.entry_short.as_ref().map(|r| r.to_string()),
+            exit_short: strategy.exit_short.as_ref().map(|r| r.to_string()),
+            position_size: strategy.position_size,
+            stop_loss_pct: strategy.stop_loss_pct,
+            take_profit_pct: strategy.take_profit_pct,
+            max_positions: strategy.max_positions,
+        }
+    }
+}
+
+/// `ClosedTrade` with its code and exchange replaced by an index into
+/// `CachedBacktest::symbols`.
+#[derive(Debug, Clone, Copy, PartialEq)]
+struct CompactTrade {
+    symbol: u32,
+    quantity: i64,
+    entry_price: f64,
+    exit_price: f64,
+    entry_date: NaiveDate,
+    exit_date: NaiveDate,
+    pnl: f64,
+}
+
+/// A finished web backtest in compact form.
+#[derive(Debug, Clone, PartialEq)]
+pub struct CachedBacktest {
+    pub strategy: StrategySummary,
+    pub metrics: Metrics,
+    pub code_results: Vec<CodeResult>,
+    pub skipped: Vec<(String, String)>,
+    pub start_date: NaiveDate,
+    pub end_date: NaiveDate,
+    pub initial_capital: f64,
+    equity_dates: Vec<NaiveDate>,
+    equity_values: Vec<f64>,
+    /// `(code, exchange)` of each traded symbol, in first-trade order.
+    symbols: Vec<(String, String)>,
+    trades: Vec<CompactTrade>,
+    /// Rendered on first request; not persisted.
+    equity_chart: OnceLock<RenderedChart>,
+    drawdown_chart: OnceLock<RenderedChart>,
+}
+
+/// Allowance in `byte_size` for the two memoized charts. Downsampling caps
+/// their vertex count, so this is fixed rather than measured at insert time.
+const CHART_BYTES_ESTIMATE: usize = 2 * 32 * 1024;
+
+impl CachedBacktest {
+    pub fn new(
+        strategy: &Strategy,
+        config: &BacktestConfig,
+        metrics: Metrics,
+        code_results: Vec<CodeResult>,
+        portfolio: &Portfolio,
+        skipped: Vec<(String, String)>,
+    ) -> Self {
+        let mut symbols: Vec<(String, String)> = Vec::new();
+        let mut interned: HashMap<(&str, &str), u32> = HashMap::new();
+        let trades = portfolio
+            .closed_trades
+            .iter()
+            .map(|t| {
+                let symbol = *interned
+                    .entry((t.code.as_str(), t.exchange.as_str()))
+                    .or_insert_with(|| {
+                        symbols.push((t.code.clone(), t.exchange.clone()));
+                        (symbols.len() - 1) as u32
+                    });
+                CompactTrade {
+                    symbol,
+                    quantity: t.quantity,
+                    entry_price: t.entry_price,
+                    exit_price: t.exit_price,
+                    entry_date: t.entry_date,
+                    exit_date: t.exit_date,
+                    pnl: t.pnl,
+                }
+            })
+            .collect();
+
+        CachedBacktest {
+            strategy: StrategySummary::from(strategy),
+            metrics,
+            code_results,
+            skipped,
+            start_date: config.start_date,
+            end_date: config.end_date,
+            initial_capital: config.initial_capital,
+            equity_dates: portfolio.equity_curve.iter().map(|p| p.date).collect(),
+            equity_values: portfolio.equity_curve.iter().map(|p| p.equity).collect(),
+            symbols,
+            trades,
+            equity_chart: OnceLock::new(),
+            drawdown_chart: OnceLock::new(),
+        }
+    }
+
+    pub fn equity_chart(&self) -> &RenderedChart {
+        self.equity_chart
+            .get_or_init(|| RenderedChart::new(generate_equity_svg(&self.equity_curve())))
+    }
+
+    pub fn drawdown_chart(&self) -> &RenderedChart {
+        self.drawdown_chart
+            .get_or_init(|| RenderedChart::new(generate_drawdown_svg(&self.equity_curve())))
+    }
+
+    pub fn equity_curve(&self) -> Vec<EquityPoint> {
+        self.equity_dates
+            .iter()
+            .zip(&self.equity_values)
+            .map(|(&date, &equity)| EquityPoint { date, equity })
+            .collect()
+    }
+
+    pub fn trades(&self) -> Vec<ClosedTrade> {
+        self.trades
+            .iter()
+            .map(|t| {
+                let (code, exchange) = &self.symbols[t.symbol as usize];
+                ClosedTrade {
+                    code: code.clone(),
+                    exchange: exchange.clone(),
+                    quantity: t.quantity,
+                    entry_price: t.entry_price,
+                    exit_price: t.exit_price,
+                    entry_date: t.entry_date,
+                    exit_date: t.exit_date,
+                    pnl: t.pnl,
+                }
+            })
+            .collect()
+    }
+
+    /// Approximate heap plus inline footprint, used to bound the LRU.
+    pub fn byte_size(&self) -> usize {
+        let strings = |pairs: &[(String, String)]| -> usize {
+            pairs
+                .iter()
+                .map(|(a, b)| size_of::<(String, String)>() + a.len() + b.len())
+                .sum()
+        };
+        let s = &self.strategy;
+        size_of::<Self>()
+            + s.name.len()
+            + s.description.len()
+            + s.entry_long.len()
+            + s.exit_long.len()
+            + s.entry_short.as_ref().map_or(0, String::len)
+            + s.exit_short.as_ref().map_or(0, String::len)
+            + self
+                .code_results
+                .iter()
+                .map(|r| size_of::<CodeResult>() + r.code.len() + r.exchange.len())
+                .sum::<usize>()
+            + strings(&self.skipped)
+            + self.equity_dates.len() * size_of::<NaiveDate>()
+            + self.equity_values.len() * size_of::<f64>()
+            + strings(&self.symbols)
+            + self.trades.len() * size_of::<CompactTrade>()
+            + CHART_BYTES_ESTIMATE
+    }
+
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut w = ByteWriter::new();
+        w.u8(REPORT_VERSION);
+
+        let s = &self.strategy;
+        w.str(&s.name);
+        w.str(&s.description);
+        w.str(&s.entry_long);
+        w.str(&s.exit_long);
+        for rule in [&s.entry_short, &s.exit_short] {
+            w.bool(rule.is_some());
+            if let Some(rule) = rule {
+                w.str(rule);
+            }
+        }
+        w.f64(s.position_size);
+        w.f64(s.stop_loss_pct);
+        w.f64(s.take_profit_pct);
+        w.usize(s.max_positions);
+
+        encode_metrics(&mut w, &self.metrics);
+        w.usize(self.code_results.len());
+        for r in &self.code_results {
+            w.str(&r.code);
+            w.str(&r.exchange);
+            w.usize(r.total_trades);
+            w.usize(r.winning_trades);
+            w.usize(r.losing_trades);
+            w.f64(r.total_pnl);
+            w.f64(r.win_rate);
+            w.f64(r.largest_win);
+            w.f64(r.largest_loss);
+        }
+        for pairs in [&self.skipped, &self.symbols] {
+            w.usize(pairs.len());
+            for (a, b) in pairs {
+                w.str(a);
+                w.str(b);
+            }
+        }
+
+        w.date(self.start_date);
+        w.date(self.end_date);
+        w.f64(self.initial_capital);
+
+        w.usize(self.equity_dates.len());
+        for &date in &self.equity_dates {
+            w.date(date);
+        }
+        w.f64s(self.equity_values.iter());
+
+        w.usize(self.trades.len());
+        for t in &self.trades {
+            w.u32(t.symbol);
+            w.i64(t.quantity);
+            w.f64(t.entry_price);
+            w.f64(t.exit_price);
+            w.date(t.entry_date);
+            w.date(t.exit_date);
+            w.f64(t.pnl);
+        }
+        w.into_bytes()
+    }
+
+    pub fn from_bytes(bytes: &[u8]) -> Result<Self, SamtraderError> {
+        let mut r = ByteReader::new(bytes, "stored report");
+        let version = r.u8()?;
+        if version != REPORT_VERSION {
+            return Err(r.error(format!("unsupported version {version}")));
+        }
+
+        let name = r.string()?;
+        let description = r.string()?;
+        let entry_long = r.string()?;
+        let exit_long = r.string()?;
+        let entry_short = if r.bool()? { Some(r.string()?) } else { None };
+        let exit_short = if r.bool()? { Some(r.string()?) } else { None };
+        let strategy = StrategySummary {
+            name,
+            description,
+            entry_long,
+            exit_long,
+            entry_short,
+            exit_short,
+            position_size: r.f64()?,
+            stop_loss_pct: r.f64()?,
+            take_profit_pct: r.f64()?,
+            max_positions: r.usize()?,
+        };
+
+        let metrics = decode_metrics(&mut r)?;
+        let code_results = (0..r.count(72)?)
+            .map(|_| {
+                Ok(CodeResult {
+                    code: r.string()?,
+                    exchange: r.string()?,
+                    total_trades: r.usize()?,
+                    winning_trades: r.usize()?,
+                    losing_trades: r.usize()?,
+                    total_pnl: r.f64()?,
+                    win_rate: r.f64()?,
+                    largest_win: r.f64()?,
+                    largest_loss: r.f64()?,
+                })
+            })
+            .collect::<Result<_, SamtraderError>>()?;
+        let mut pairs = || -> Result<Vec<(String, String)>, SamtraderError> {
+            (0..r.count(16)?)
+                .map(|_| Ok((r.string()?, r.string()?)))
+                .collect()
+        };
+        let skipped = pairs()?;
+        let symbols = pairs()?;
+
+        let start_date = r.date()?;
+        let end_date = r.date()?;
+        let initial_capital = r.f64()?;
+
+        let equity_dates = (0..r.count(4)?)
+            .map(|_| r.date())
+            .collect::<Result<Vec<_>, _>>()?;
+        let equity_values = r.f64s()?;
+        if equity_values.len() != equity_dates.len() {
+            return Err(r.error("equity columns differ in length"));
+        }
+
+        let trades = (0..r.count(44)?)
+            .map(|_| {
+                let trade = CompactTrade {
+                    symbol: r.u32()?,
+                    quantity: r.i64()?,
+                    entry_price: r.f64()?,
+                    exit_price: r.f64()?,
+                    entry_date: r.date()?,
+                    exit_date: r.date()?,
+                    pnl: r.f64()?,
+                };
+                if trade.symbol as usize >= symbols.len() {
+                    return Err(r.error(format!("trade symbol {} out of range", trade.symbol)));
+                }
+                Ok(trade)
+            })
+            .collect::<Result<_, SamtraderError>>()?;
+        r.finish()?;
+
+        Ok(CachedBacktest {
+            strategy,
+            metrics,
+            code_results,
+            skipped,
+            start_date,
+            end_date,
+            initial_capital,
+            equity_dates,
+            equity_values,
+            symbols,
+            trades,
+            equity_chart: OnceLock::new(),
+            drawdown_chart: OnceLock::new(),
+        })
+    }
+}
+
+fn encode_metrics(w: &mut ByteWriter, m: &Metrics) {
+    for v in [
+        m.total_return,
+        m.annualized_return,
+        m.sharpe_ratio,
+        m.sortino_ratio,
+        m.max_drawdown,
+        m.max_drawdown_duration,
+    ] {
+        w.f64(v);
+    }
+    for n in [
+        m.total_trades,
+        m.winning_trades,
+        m.losing_trades,
+        m.break_even_trades,
+    ] {
+        w.usize(n);
+    }
+    for v in [
+        m.win_rate,
+        m.profit_factor,
+        m.average_win,
+        m.average_loss,
+        m.largest_win,
+        m.largest_loss,
+        m.average_trade_duration,
+    ] {
+        w.f64(v);
+    }
+}
+
+fn decode_metrics(r: &mut ByteReader) -> Result<Metrics, SamtraderError> {
+    Ok(Metrics {
+        total_return: r.f64()?,
+        annualized_return: r.f64()?,
+        sharpe_ratio: r.f64()?,
+        sortino_ratio: r.f64()?,
+        max_drawdown: r.f64()?,
+        max_drawdown_duration: r.f64()?,
+        total_trades: r.usize()?,
+        winning_trades: r.usize()?,
+        losing_trades: r.usize()?,
+        break_even_trades: r.usize()?,
+        win_rate: r.f64()?,
+        profit_factor: r.f64()?,
+        average_win: r.f64()?,
+        average_loss: r.f64()?,
+        largest_win: r.f64()?,
+        largest_loss: r.f64()?,
+        average_trade_duration: r.f64()?,
+    })
+}
+
+/// Finished reports keyed by report ID, in memory and optionally on disk.
+///
+/// Web report IDs are content keys (see `handlers::backtest_key`), so a hit
+/// is a finished run of the same request. The lock guards only O(1) map and
+/// list updates; disk reads and writes happen outside it, and async callers
+/// run `load` on the blocking pool.
+pub struct ReportCache {
+    lru: Mutex<Lru<String, Arc<CachedBacktest>>>,
+    /// Bumped whenever market data is invalidated. Part of every content key
+    /// so results computed from older bars are not reused.
+    data_epoch: AtomicU64,
+    #[cfg(feature = "sqlite")]
+    store: Option<ReportStore>,
+}
+
+impl ReportCache {
+    /// Memory-only cache holding up to `capacity_bytes` of reports.
+    pub fn new(capacity_bytes: usize) -> Self {
+        ReportCache {
+            lru: Mutex::new(Lru::new(capacity_bytes)),
+            data_epoch: AtomicU64::new(0),
+            #[cfg(feature = "sqlite")]
+            store: None,
+        }
+    }
+
+    /// Cache that writes every report through to `store` and reads evicted
+    /// ones back from it.
+    #[cfg(feature = "sqlite")]
+    pub fn with_store(capacity_bytes: usize, store: ReportStore) -> Result<Self, SamtraderError> {
+        let epoch = store.data_epoch()?;
+        Ok(ReportCache {
+            lru: Mutex::new(Lru::new(capacity_bytes)),
+            data_epoch: AtomicU64::new(epoch),
+            store: Some(store),
+        })
+    }
+
+    /// Cache sized by `[web] report_cache_mb` (default 64), persisted to
+    /// `[web] report_store` or, failing that, `[database] sqlite_path`.
+    /// Stored reports older than `[web] report_retention_days` (default 90)
+    /// are dropped on startup.
+    pub fn from_config(config: &dyn ConfigPort) -> Result<Self, SamtraderError> {
+        let capacity = config.get_int("web", "report_cache_mb", 64).max(1) as usize * 1024 * 1024;
+
+        #[cfg(feature = "sqlite")]
+        {
+            let path = config
+                .get_string("web", "report_store")
+                .or_else(|| config.get_string("database", "sqlite_path"));
+            if let Some(path) = path {
+                let store = ReportStore::open(&path)?;
+                let days = config.get_int("web", "report_retention_days", 90);
+                if days > 0 {
+                    store.prune_older_than(days * 86_400)?;
+                }
+                return Self::with_store(capacity, store);
+            }
+        }
+        Ok(Self::new(capacity))
+    }
+
+    /// In-memory lookup; never touches the disk.
+    pub fn get(&self, id: &str) -> Option<Arc<CachedBacktest>> {
+        self.lru.lock().unwrap().get(id).cloned()
+    }
+
+    /// Look `id` up in memory, then in the store, caching a stored report
+    /// again on the way out. Blocking.
+    pub fn load(&self, id: &str) -> Result<Option<Arc<CachedBacktest>>, SamtraderError> {
+        if let Some(report) = self.get(id) {
+            return Ok(Some(report));
+        }
+        #[cfg(feature = "sqlite")]
+        if let Some(store) = &self.store
+            && let Some(bytes) = store.load(id)?
+        {
+            let report = Arc::new(CachedBacktest::from_bytes(&bytes)?);
+            let bytes = report.byte_size() + id.len();
+            self.lru
+                .lock()
+                .unwrap()
+                .insert(id.to_string(), Arc::clone(&report), bytes);
+            return Ok(Some(report));
+        }
+        Ok(None)
+    }
+
+    /// Cache `report` under `id` and write it through to the store. The
+    /// report stays cached in memory even if the write fails. Blocking.
+    pub fn insert(&self, id: String, report: CachedBacktest) -> Result<(), SamtraderError> {
+        #[cfg(feature = "sqlite")]
+        let bytes = self.store.as_ref().map(|_| report.to_bytes());
+        let size = report.byte_size() + id.len();
+        self.lru
+            .lock()
+            .unwrap()
+            .insert(id.clone(), Arc::new(report), size);
+        #[cfg(feature = "sqlite")]
+        if let (Some(store), Some(bytes)) = (&self.store, bytes) {
+            store.save(&id, &bytes)?;
+        }
+        Ok(())
+    }
+
+    /// Bytes of reports currently held in memory.
+    pub fn cached_bytes(&self) -> usize {
+        self.lru.lock().unwrap().bytes()
+    }
+
+    pub fn data_epoch(&self) -> u64 {
+        self.data_epoch.load(Ordering::SeqCst)
+    }
+
+    /// Stop reusing results for requests made from now on. Existing
+    /// reports stay viewable under their IDs. Blocking.
+    pub fn bump_data_epoch(&self) -> Result<(), SamtraderError> {
+        let epoch = self.data_epoch.fetch_add(1, Ordering::SeqCst) + 1;
+        #[cfg(feature = "sqlite")]
+        if let Some(store) = &self.store {
+            store.set_data_epoch(epoch)?;
+        }
+        #[cfg(not(feature = "sqlite"))]
+        let _ = epoch;
+        Ok(())
+    }
+}
+
+#[cfg(feature = "sqlite")]
+pub use store::ReportStore;
+
+#[cfg(feature = "sqlite")]
+mod store {
+    use rusqlite::{Connection, OptionalExtension, params};
+    use std::sync::Mutex;
+    use std::time::{SystemTime, UNIX_EPOCH};
+
+    use crate::domain::error::SamtraderError;
+
+    const CREATE_TABLES: &str = "CREATE TABLE IF NOT EXISTS backtest_reports (
+            id TEXT PRIMARY KEY,
+            created_at INTEGER NOT NULL,
+            report BLOB NOT NULL
+        );
+        CREATE TABLE IF NOT EXISTS backtest_report_meta (
+            key TEXT PRIMARY KEY,
+            value INTEGER NOT NULL
+        ) WITHOUT ROWID;";
+
+    fn to_query_err(e: rusqlite::Error) -> SamtraderError {
+        SamtraderError::DatabaseQuery {
+            reason: e.to_string(),
+        }
+    }
+
+    fn now() -> i64 {
+        SystemTime::now()
+            .duration_since(UNIX_EPOCH)
+            .map_or(0, |d| d.as_secs() as i64)
+    }
+
+    /// Encoded reports in a SQLite file. Uses its own writable connection,
+    /// separate from the read-only `SqliteAdapter` pool.
+    pub struct ReportStore {
+        conn: Mutex<Connection>,
+    }
+
+    impl ReportStore {
+        pub fn open(path: &str) -> Result<Self, SamtraderError> {
+            let conn = Connection::open(path).map_err(|e| SamtraderError::Database {
+                reason: format!("{path}: {e}"),
+            })?;
+            conn.busy_timeout(std::time::Duration::from_secs(5))
+                .map_err(to_query_err)?;
+            conn.execute_batch(CREATE_TABLES).map_err(to_query_err)?;
+            Ok(ReportStore {
+                conn: Mutex::new(conn),
+            })
+        }
+
+        /// Delete reports stored more than `age_secs` ago; returns how many.
+        pub fn prune_older_than(&self, age_secs: i64) -> Result<usize, SamtraderError> {
+            self.conn
+                .lock()
+                .unwrap()
+                .execute(
+                    "DELETE FROM backtest_reports WHERE created_at < ?1",
+                    params![now() - age_secs],
+                )
+                .map_err(to_query_err)
+        }
+
+        pub(super) fn load(&self, id: &str) -> Result<Option<Vec<u8>>, SamtraderError> {
+            self.conn
+                .lock()
+                .unwrap()
+                .prepare_cached("SELECT report FROM backtest_reports WHERE id = ?1")
+                .and_then(|mut stmt| stmt.query_row(params![id], |row| row.get(0)).optional())
+                .map_err(to_query_err)
+        }
+
+        pub(super) fn save(&self, id: &str, report: &[u8]) -> Result<(), SamtraderError> {
+            self.conn
+                .lock()
+                .unwrap()
+                .prepare_cached(
+                    "INSERT OR REPLACE INTO backtest_reports (id, created_at, report)
+                     VALUES (?1, ?2, ?3)",
+                )
+                .and_then(|mut stmt| stmt.execute(params![id, now(), report]))
+                .map(|_| ())
+                .map_err(to_query_err)
+        }
+
+        pub(super) fn data_epoch(&self) -> Result<u64, SamtraderError> {
+            let epoch: Option<i64> = self
+                .conn
+                .lock()
+                .unwrap()
+                .query_row(
+                    "SELECT value FROM backtest_report_meta WHERE key = 'data_epoch'",
+                    [],
+                    |row| row.get(0),
+                )
+                .optional()
+                .map_err(to_query_err)?;
+            Ok(epoch.unwrap_or(0) as u64)
+        }
+
+        pub(super) fn set_data_epoch(&self, epoch: u64) -> Result<(), SamtraderError> {
+            self.conn
+                .lock()
+                .unwrap()
+                .execute(
+                    "INSERT OR REPLACE INTO backtest_report_meta (key, value)
+                     VALUES ('data_epoch', ?1)",
+                    params![epoch as i64],
+                )
+                .map(|_| ())
+                .map_err(to_query_err)
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::domain::rule::{Operand, Rule};
+
+    fn date(day: u32) -> NaiveDate {
+        NaiveDate::from_ymd_opt(2024, 1, day).unwrap()
+    }
+
+    fn trade(code: &str, day: u32, pnl: f64) -> ClosedTrade {
+        ClosedTrade {
+            code: code.to_string(),
+            exchange: "ASX".to_string(),
+            quantity: 10,
+            entry_price: 100.0,
+            exit_price: 100.0 + pnl / 10.0,
+            entry_date: date(day),
+            exit_date: date(day + 1),
+            pnl,
+        }
+    }
+
+    fn report(points: usize) -> CachedBacktest {
+        let strategy = Strategy {
+            name: "Web Backtest".to_string(),
+            description: "Submitted via web form".to_string(),
+            entry_long: Rule::Above {
+                left: Operand::Close,
+                right: Operand::Constant(100.0),
+            },
+            exit_long: Rule::Below {
+                left: Operand::Close,
+                right: Operand::Constant(100.0),
+            },
+            entry_short: None,
+            exit_short: None,
+            position_size: 0.25,
+            stop_loss_pct: 0.0,
+            take_profit_pct: 0.0,
+            max_positions: 2,
+        };
+        let config = BacktestConfig {
+            start_date: date(1),
+            end_date: date(31),
+            initial_capital: 100_000.0,
+            commission_per_trade: 0.0,
+            commission_pct: 0.0,
+            slippage_pct: 0.0,
+            allow_shorting: false,
+            risk_free_rate: 0.05,
+            workers: 0,
+        };
+        let mut portfolio = Portfolio::new(100_000.0);
+        portfolio.closed_trades = vec![
+            trade("BHP", 2, 50.0),
+            trade("CBA", 3, -20.0),
+            trade("BHP", 5, 10.0),
+        ];
+        portfolio.equity_curve = (0..points)
+            .map(|i| EquityPoint {
+                date: date(1) + chrono::Days::new(i as u64),
+                equity: 100_000.0 + i as f64,
+            })
+            .collect();
+        let metrics = Metrics::compute(&portfolio, config.risk_free_rate);
+        let code_results = CodeResult::compute_per_code(&portfolio.closed_trades);
+        CachedBacktest::new(
+            &strategy,
+            &config,
+            metrics,
+            code_results,
+            &portfolio,
+            vec![("XYZ".to_string(), "No data available".to_string())],
+        )
+    }
+
+    #[test]
+    fn compact_report_interns_codes_and_restores_rows() {
+        let cached = report(3);
+        assert_eq!(cached.symbols.len(), 2);
+        assert_eq!(cached.trades().len(), 3);
+        assert_eq!(cached.trades()[2].code, "BHP");
+        assert_eq!(cached.equity_curve()[2].equity, 100_002.0);
+        assert_eq!(cached.strategy.entry_long, "close above 100");
+    }
+
+    #[test]
+    fn charts_render_once_per_report() {
+        let cached = report(2_000);
+        let equity = cached.equity_chart();
+        assert_eq!(equity.svg, generate_equity_svg(&cached.equity_curve()));
+        assert!(std::ptr::eq(equity, cached.equity_chart()));
+        assert_ne!(cached.drawdown_chart().etag, equity.etag);
+    }
+
+    #[test]
+    fn report_round_trips_through_bytes() {
+        let cached = report(40);
+        let bytes = cached.to_bytes();
+        assert_eq!(CachedBacktest::from_bytes(&bytes).unwrap(), cached);
+
+        assert!(CachedBacktest::from_bytes(&bytes[..bytes.len() - 1]).is_err());
+        let mut future = bytes.clone();
+        future[0] = REPORT_VERSION + 1;
+        assert!(CachedBacktest::from_bytes(&future).is_err());
+    }
+
+    #[test]
+    fn lru_evicts_least_recently_used_by_bytes() {
+        let entry = report(10).byte_size() + 1;
+        let cache = ReportCache::new(entry * 3);
+        for id in ["a", "b", "c"] {
+            cache.insert(id.to_string(), report(10)).unwrap();
+        }
+        assert_eq!(cache.cached_bytes(), entry * 3);
+
+        // Touch "a" so "b" is now the least recently used.
+        assert!(cache.get("a").is_some());
+        cache.insert("d".to_string(), report(10)).unwrap();
+        assert!(cache.get("b").is_none());
+        assert!(cache.get("a").is_some());
+        assert!(cache.get("c").is_some());
+        assert!(cache.get("d").is_some());
+
+        // A report larger than the whole budget evicts everything else but
+        // is itself kept.
+        cache.insert("big".to_string(), report(50_000)).unwrap();
+        assert!(cache.get("big").is_some());
+        assert!(cache.get("a").is_none() && cache.get("d").is_none());
+        assert_eq!(cache.cached_bytes(), report(50_000).byte_size() + 3);
+    }
+
+    #[test]
+    fn reinsert_replaces_without_leaking_bytes() {
+        let cache = ReportCache::new(usize::MAX);
+        cache.insert("a".to_string(), report(10)).unwrap();
+        let once = cache.cached_bytes();
+        cache.insert("a".to_string(), report(10)).unwrap();
+        assert_eq!(cache.cached_bytes(), once);
+        assert!(cache.load("missing").unwrap().is_none());
+    }
+
+    #[cfg(feature = "sqlite")]
+    #[test]
+    fn stored_reports_and_epoch_survive_reopen() {
+        let dir = tempfile::TempDir::new().unwrap();
+        let path = dir.path().join("reports.db").display().to_string();
+
+        let cache = ReportCache::with_store(1, ReportStore::open(&path).unwrap()).unwrap();
+        cache.insert("a".to_string(), report(10)).unwrap();
+        cache.insert("b".to_string(), report(10)).unwrap();
+        // Capacity of one byte keeps only the newest report in memory...
+        assert!(cache.get("a").is_none());
+        // ...but the evicted one is read back from disk.
+        assert_eq!(*cache.load("a").unwrap().unwrap(), report(10));
+        cache.bump_data_epoch().unwrap();
+        drop(cache);
+
+        let reopened = ReportCache::with_store(1 << 20, ReportStore::open(&path).unwrap()).unwrap();
+        assert_eq!(reopened.data_epoch(), 1);
+        assert_eq!(*reopened.load("b").unwrap().unwrap(), report(10));
+        assert!(reopened.load("missing").unwrap().is_none());
+    }
+}
@@ -12,8 +12,8 @@ use std::collections::BTreeMap;
 use crate::domain::metrics::{CodeResult, Metrics};
 use crate::domain::portfolio::EquityPoint;
 use crate::domain::position::ClosedTrade;
-use crate::domain::strategy::Strategy;
 
+use super::report_cache::StrategySummary;
 use super::{is_htmx_request, WebError};
 
 /// Base page wrapper. Renders the full HTML page around pre-rendered content.
@@ -84,7 +84,7 @@ pub struct BacktestFormTemplate<'a> {
 #[template(path = "report.html")]
 pub struct ReportTemplate<'a> {
     pub report_id: &'a str,
-    pub strategy: &'a Strategy,
+    pub strategy: &'a StrategySummary,
     pub metrics: &'a Metrics,
     pub code_results: Option<&'a [CodeResult]>,
     pub equity_svg: Option<&'a str>,
@@ -102,6 +102,16 @@ pub struct SkippedCode<'a> {
     pub reason: &'a str,
 }
 
+/// Progress of a queued or running backtest job; polls itself until the
+/// job finishes.
+#[derive(Template)]
+#[template(path = "job_status.html")]
+pub struct JobStatusTemplate<'a> {
+    pub job_id: &'a str,
+    /// Percent of the timeline processed, or `None` while still queued.
+    pub percent: Option<u8>,
+}
+
 #[derive(Template)]
 #[template(path = "error.html")]
 pub struct ErrorTemplate<'a> {
@@ -1,25 +1,30 @@
 //! CLI definition and dispatch (TRD §13.1-13.2).
 
 use chrono::NaiveDate;
-use clap::{Parser, Subcommand};
+use clap::{Parser, Subcommand, ValueEnum};
 use std::fs;
 use std::path::{Path, PathBuf};
 use std::process::ExitCode;
 
 use crate::adapters::file_config_adapter::FileConfigAdapter;
+use crate::adapters::mmap_adapter::MmapAdapter;
 use crate::adapters::typst_report;
 use crate::adapters::typst_report::default_template;
-use crate::domain::backtest::{self as backtest_engine, BacktestConfig};
-use crate::domain::code_data::{build_unified_timeline, CodeData};
+use crate::domain::backtest::{
+    self as backtest_engine, BacktestConfig, BacktestResult, BacktestState,
+};
+use crate::domain::checkpoint::{BacktestCheckpoint, checkpoint_path};
+use crate::domain::code_data::{CodeData, build_unified_timeline};
 use crate::domain::config_validation::{validate_backtest_config, validate_strategy_config};
 use crate::domain::error::SamtraderError;
 use crate::domain::indicator::IndicatorType;
-use crate::domain::indicator_helpers::compute_indicators;
+use crate::domain::loader::{compute_code_indicators, fetch_code_data};
 use crate::domain::metrics::{CodeResult, Metrics};
 use crate::domain::rule::extract_indicators;
 use crate::domain::rule_parser;
 use crate::domain::strategy::Strategy;
-use crate::domain::universe::{parse_codes, validate_universe};
+use crate::domain::sweep::{self, GridPoint, ParamGrid, PointConfig, SweepPoint};
+use crate::domain::universe::{parse_codes, validate_fetched};
 use crate::ports::config_port::ConfigPort;
 
 #[derive(Parser, Debug)]
@@ -45,6 +50,29 @@ pub enum Command {
         exchange: Option<String>,
         #[arg(long)]
         dry_run: bool,
+        /// Continue from the checkpoint next to the report (<output>.ckpt)
+        /// over newly appended dates, then save a new checkpoint
+        #[arg(long)]
+        resume: bool,
+    },
+    /// Run a strategy parameter grid over one loaded universe
+    ///
+    /// Grid parameters come from the [sweep] section; each point substitutes
+    /// its values for ${name} placeholders in the strategy keys. One metrics
+    /// row per point is streamed to --output (stdout by default).
+    Sweep {
+        #[arg(short, long)]
+        config: PathBuf,
+        #[arg(short, long)]
+        strategy: Option<PathBuf>,
+        #[arg(short, long)]
+        output: Option<PathBuf>,
+        #[arg(long, value_enum, default_value_t = SweepFormat::Csv)]
+        format: SweepFormat,
+        #[arg(long)]
+        code: Option<String>,
+        #[arg(long)]
+        exchange: Option<String>,
     },
     /// List available symbols on an exchange
     ListSymbols {
@@ -70,7 +98,8 @@ pub enum Command {
     /// Initialize database schema
     ///
     /// Creates the OHLCV table and indexes. Use --sqlite for SQLite databases
-    /// or --postgres for PostgreSQL databases.
+    /// or --postgres for PostgreSQL databases. An existing SQLite database
+    /// in an older layout is upgraded in place.
     ///
     /// Note: --postgres initializes the schema but does not import samtrader.sql.
     Migrate {
@@ -79,6 +108,36 @@ pub enum Command {
         #[arg(long)]
         postgres: Option<String>,
     },
+    /// Bulk-load a directory of CSV files into PostgreSQL
+    ///
+    /// Reads every <CODE>_<EXCHANGE>.csv in --dir (only --exchange's files
+    /// when given) and upserts the bars through binary COPY, committing every
+    /// --batch-size rows ([postgres] copy_batch_size, default 100000).
+    Import {
+        #[arg(short, long)]
+        config: PathBuf,
+        #[arg(long)]
+        dir: PathBuf,
+        #[arg(long)]
+        exchange: Option<String>,
+        #[arg(long)]
+        batch_size: Option<usize>,
+    },
+    /// Export a universe to a memory-mapped bar cache
+    ///
+    /// Snapshots every bar of the configured codes (all symbols on the
+    /// exchange when none are configured) into --output. Point [mmap] path
+    /// at the file to have backtest and sweep read from it.
+    ExportCache {
+        #[arg(short, long)]
+        config: PathBuf,
+        #[arg(short, long)]
+        output: PathBuf,
+        #[arg(long)]
+        code: Option<String>,
+        #[arg(long)]
+        exchange: Option<String>,
+    },
     /// Start the web server
     Serve {
         #[arg(short, long)]
@@ -88,6 +147,15 @@ pub enum Command {
     HashPassword,
 }
 
+/// Row format for `sweep` output.
+#[derive(ValueEnum, Debug, Clone, Copy, PartialEq, Eq)]
+pub enum SweepFormat {
+    /// Header line plus one comma-separated row per grid point
+    Csv,
+    /// One JSON object per line
+    Json,
+}
+
 pub fn run(cli: Cli) -> ExitCode {
     match cli.command {
         Command::Backtest {
@@ -97,6 +165,7 @@ pub fn run(cli: Cli) -> ExitCode {
             code,
             exchange,
             dry_run,
+            resume,
         } => {
             if dry_run {
                 run_dry_run(&config)
@@ -107,9 +176,25 @@ pub fn run(cli: Cli) -> ExitCode {
                     output.as_ref(),
                     code.as_deref(),
                     exchange.as_deref(),
+                    resume,
                 )
             }
         }
+        Command::Sweep {
+            config,
+            strategy,
+            output,
+            format,
+            code,
+            exchange,
+        } => run_sweep(
+            &config,
+            strategy.as_ref(),
+            output.as_ref(),
+            format,
+            code.as_deref(),
+            exchange.as_deref(),
+        ),
         Command::ListSymbols { exchange, config } => run_list_symbols(&exchange, config.as_ref()),
         Command::Validate { strategy } => run_validate(&strategy),
         Command::Info {
@@ -118,6 +203,18 @@ pub fn run(cli: Cli) -> ExitCode {
             config,
         } => run_info(code.as_deref(), exchange.as_deref(), config.as_ref()),
         Command::Migrate { sqlite, postgres } => run_migrate(sqlite.as_ref(), postgres.as_deref()),
+        Command::Import {
+            config,
+            dir,
+            exchange,
+            batch_size,
+        } => run_import(&config, &dir, exchange.as_deref(), batch_size),
+        Command::ExportCache {
+            config,
+            output,
+            code,
+            exchange,
+        } => run_export_cache(&config, &output, code.as_deref(), exchange.as_deref()),
         Command::Serve { config } => run_serve(&config),
         Command::HashPassword => run_hash_password(),
     }
@@ -140,6 +237,7 @@ fn run_backtest(
     output_path: Option<&PathBuf>,
     code_override: Option<&str>,
     exchange_override: Option<&str>,
+    resume: bool,
 ) -> ExitCode {
     // Stage 1: Load config
     eprintln!("Loading config from {}", config_path.display());
@@ -213,7 +311,29 @@ fn run_backtest(
     // Read template path before entering feature-gated block
     let template_path = adapter.get_string("report", "template_path");
 
-    // Stages 6-11: Data port dependent pipeline
+    // Stages 6-11: Data port dependent pipeline. An exported bar cache
+    // takes precedence over the database.
+    if adapter.get_string("mmap", "path").is_some() {
+        let data_port = match MmapAdapter::from_config(&adapter) {
+            Ok(a) => a,
+            Err(e) => {
+                eprintln!("error: {e}");
+                return (&e).into();
+            }
+        };
+
+        return run_backtest_pipeline(
+            &data_port,
+            &strategy,
+            &bt_config,
+            &codes,
+            &exchange,
+            output_path,
+            template_path.as_deref(),
+            resume,
+        );
+    }
+
     #[cfg(feature = "sqlite")]
     {
         use crate::adapters::sqlite_adapter::SqliteAdapter;
@@ -234,12 +354,13 @@ fn run_backtest(
             &exchange,
             output_path,
             template_path.as_deref(),
+            resume,
         )
     }
 
     #[cfg(not(feature = "sqlite"))]
     {
-        let _ = (&strategy, &bt_config, &codes, &exchange, output_path, template_path);
+        let _ = (&strategy, &bt_config, &codes, &exchange, output_path, template_path, resume);
         eprintln!("error: sqlite feature is required for backtest");
         ExitCode::from(1)
     }
@@ -285,6 +406,7 @@ pub fn build_backtest_config(adapter: &dyn ConfigPort) -> Result<BacktestConfig,
         slippage_pct: adapter.get_double("backtest", "slippage_pct", 0.0),
         allow_shorting: adapter.get_bool("backtest", "allow_shorting", false),
         risk_free_rate: adapter.get_double("backtest", "risk_free_rate", 0.05),
+        workers: adapter.get_int("backtest", "workers", 0).max(0) as usize,
     })
 }
 
@@ -372,71 +494,90 @@ pub fn build_strategy(adapter: &dyn ConfigPort) -> Result<Strategy, ExitCode> {
     })
 }
 
-pub fn collect_all_indicators(strategy: &Strategy) -> Vec<IndicatorType> {
-    let mut indicators = extract_indicators(&strategy.entry_long);
-    indicators.extend(extract_indicators(&strategy.exit_long));
-    if let Some(ref rule) = strategy.entry_short {
-        indicators.extend(extract_indicators(rule));
+/// Advance the checkpoint at `path` over the bars appended since it was
+/// written, fetching only those (plus each code's last bar, to check it is
+/// unchanged). `None` when the checkpoint is missing or was made from
+/// different inputs; a full replay then follows.
+fn resume_from_checkpoint(
+    data_port: &dyn crate::ports::data_port::DataPort,
+    path: &Path,
+    strategy: &Strategy,
+    bt_config: &BacktestConfig,
+    codes: &[String],
+    exchange: &str,
+) -> Option<BacktestCheckpoint> {
+    if !path.exists() {
+        eprintln!("No checkpoint at {}; running full history", path.display());
+        return None;
     }
-    if let Some(ref rule) = strategy.exit_short {
-        indicators.extend(extract_indicators(rule));
+    let resumed = BacktestCheckpoint::load(path).and_then(|checkpoint| {
+        checkpoint.check(codes, exchange, strategy, bt_config)?;
+        checkpoint.check_skipped(data_port, exchange, bt_config)?;
+        let fetched = checkpoint.fetch(data_port, exchange, bt_config)?;
+        if let Some(date) = checkpoint.state.last_date {
+            let bars: usize = fetched.iter().map(CodeData::bar_count).sum();
+            eprintln!(
+                "Resuming from checkpoint at {date}: {} codes, {bars} bars fetched",
+                fetched.len()
+            );
+        }
+        checkpoint.resume(&fetched, strategy, bt_config)
+    });
+    match resumed {
+        Ok(checkpoint) => Some(checkpoint),
+        Err(e) => {
+            eprintln!("warning: {e}; running full history");
+            None
+        }
     }
-    indicators.into_iter().collect()
 }
 
-pub fn run_backtest_pipeline(
+fn save_checkpoint(checkpoint: &BacktestCheckpoint, path: &Path) {
+    match checkpoint.save(path) {
+        Ok(()) => eprintln!("Checkpoint written to: {}", path.display()),
+        Err(e) => eprintln!("warning: failed to write checkpoint: {e}"),
+    }
+}
+
+pub fn collect_all_indicators(strategy: &Strategy) -> Vec<IndicatorType> {
+    strategy.indicator_types()
+}
+
+/// Stages 6-8 over the whole history: fetch and validate the universe,
+/// compute indicators and run the event loop from the first date.
+fn run_full_history(
     data_port: &dyn crate::ports::data_port::DataPort,
     strategy: &Strategy,
     bt_config: &BacktestConfig,
     codes: &[String],
     exchange: &str,
-    output_path: Option<&PathBuf>,
-    template_path: Option<&str>,
-) -> ExitCode {
-    // Stage 6: Validate universe
-    let validation = match validate_universe(
+) -> Result<(Vec<CodeData>, BacktestState), ExitCode> {
+    // Stage 6: Fetch OHLCV data and validate universe
+    let validation = fetch_code_data(
         data_port,
-        codes.to_vec(),
+        codes,
         exchange,
         bt_config.start_date,
         bt_config.end_date,
-    ) {
+        bt_config.workers,
+    )
+    .and_then(|fetched| validate_fetched(codes.to_vec(), fetched, exchange));
+    let validation = match validation {
         Ok(v) => v,
         Err(e) => {
             eprintln!("error: {e}");
-            return (&e).into();
+            return Err((&e).into());
         }
     };
 
-    let valid_codes = &validation.universe.codes;
-
-    // Stage 7: Fetch OHLCV data and compute indicators
+    // Stage 7: Compute indicators on the bars loaded during validation
     let indicator_types = collect_all_indicators(strategy);
-    let mut code_data_vec: Vec<CodeData> = Vec::with_capacity(valid_codes.len());
-
-    for code in valid_codes {
-        let ohlcv = match data_port.fetch_ohlcv(
-            code,
-            exchange,
-            bt_config.start_date,
-            bt_config.end_date,
-        ) {
-            Ok(bars) => bars,
-            Err(e) => {
-                eprintln!("warning: skipping {} ({})", code, e);
-                continue;
-            }
-        };
-
-        let indicators = compute_indicators(&ohlcv, &indicator_types);
-        let mut cd = CodeData::new(code.clone(), exchange.to_string(), ohlcv);
-        cd.indicators = indicators;
-        code_data_vec.push(cd);
-    }
+    let mut code_data_vec = validation.code_data;
+    compute_code_indicators(&mut code_data_vec, &indicator_types, bt_config.workers);
 
     if code_data_vec.is_empty() {
         eprintln!("error: no valid codes with data to backtest");
-        return ExitCode::from(5);
+        return Err(ExitCode::from(5));
     }
 
     // Stage 8: Build timeline and run backtest
@@ -450,7 +591,65 @@ pub fn run_backtest_pipeline(
     );
     eprintln!("  Processing: {} dates", timeline.len());
 
-    let result = backtest_engine::run_backtest(&code_data_vec, &timeline, strategy, bt_config);
+    let state = backtest_engine::resume_backtest(
+        &code_data_vec,
+        &timeline,
+        strategy,
+        bt_config,
+        BacktestState::new(bt_config.initial_capital, code_data_vec.len()),
+    );
+    Ok((code_data_vec, state))
+}
+
+pub fn run_backtest_pipeline(
+    data_port: &dyn crate::ports::data_port::DataPort,
+    strategy: &Strategy,
+    bt_config: &BacktestConfig,
+    codes: &[String],
+    exchange: &str,
+    output_path: Option<&PathBuf>,
+    template_path: Option<&str>,
+    resume: bool,
+) -> ExitCode {
+    let output = output_path
+        .cloned()
+        .unwrap_or_else(|| PathBuf::from("report.typ"));
+    let checkpoint_file = checkpoint_path(&output);
+
+    // Stages 6-8 from the checkpoint when resuming, over the new bars only
+    let resumed = if resume {
+        resume_from_checkpoint(data_port, &checkpoint_file, strategy, bt_config, codes, exchange)
+    } else {
+        None
+    };
+    let state = match resumed {
+        Some(checkpoint) => {
+            save_checkpoint(&checkpoint, &checkpoint_file);
+            checkpoint.state
+        }
+        None => {
+            let (code_data_vec, state) =
+                match run_full_history(data_port, strategy, bt_config, codes, exchange) {
+                    Ok(run) => run,
+                    Err(code) => return code,
+                };
+            if resume {
+                let checkpoint = BacktestCheckpoint::capture(
+                    codes,
+                    exchange,
+                    &code_data_vec,
+                    strategy,
+                    bt_config,
+                    &state,
+                );
+                save_checkpoint(&checkpoint, &checkpoint_file);
+            }
+            state
+        }
+    };
+    let result = BacktestResult {
+        portfolio: state.portfolio,
+    };
 
     // Stage 9: Compute metrics
     let metrics = Metrics::compute(&result.portfolio, bt_config.risk_free_rate);
@@ -483,10 +682,6 @@ pub fn run_backtest_pipeline(
     }
 
     // Stage 11: Generate report
-    let output = output_path
-        .cloned()
-        .unwrap_or_else(|| PathBuf::from("report.typ"));
-
     let template_content: String;
     let template: &str = match template_path {
         Some(path) => {
@@ -530,6 +725,247 @@ pub fn run_backtest_pipeline(
     }
 }
 
+fn run_sweep(
+    config_path: &PathBuf,
+    strategy_path: Option<&PathBuf>,
+    output_path: Option<&PathBuf>,
+    format: SweepFormat,
+    code_override: Option<&str>,
+    exchange_override: Option<&str>,
+) -> ExitCode {
+    eprintln!("Loading config from {}", config_path.display());
+    let adapter = match load_config(config_path) {
+        Ok(a) => a,
+        Err(code) => return code,
+    };
+
+    if let Err(e) = validate_backtest_config(&adapter) {
+        eprintln!("error: {e}");
+        return (&e).into();
+    }
+
+    // The strategy template and its [sweep] grid live in the same file.
+    let strategy_adapter = match strategy_path {
+        Some(strat_path) => {
+            eprintln!("Loading strategy from {}", strat_path.display());
+            match load_config(strat_path) {
+                Ok(a) => Some(a),
+                Err(code) => return code,
+            }
+        }
+        None => None,
+    };
+    let strategy_config: &dyn ConfigPort = match &strategy_adapter {
+        Some(a) => a,
+        None => &adapter,
+    };
+
+    let grid = match ParamGrid::from_config(strategy_config) {
+        Ok(g) => g,
+        Err(e) => {
+            eprintln!("error: {e}");
+            return (&e).into();
+        }
+    };
+    let points = match build_sweep_points(strategy_config, &grid) {
+        Ok(p) => p,
+        Err(code) => return code,
+    };
+
+    let bt_config = match build_backtest_config(&adapter) {
+        Ok(c) => c,
+        Err(e) => {
+            eprintln!("error: {e}");
+            return (&e).into();
+        }
+    };
+
+    let codes = resolve_codes(code_override, &adapter);
+    if codes.is_empty() {
+        eprintln!("error: no codes configured");
+        return ExitCode::from(2);
+    }
+
+    let exchange = match exchange_override {
+        Some(e) => e.to_string(),
+        None => match adapter.get_string("backtest", "exchange") {
+            Some(e) => e,
+            None => {
+                eprintln!("error: exchange is required");
+                return ExitCode::from(2);
+            }
+        },
+    };
+
+    if adapter.get_string("mmap", "path").is_some() {
+        let data_port = match MmapAdapter::from_config(&adapter) {
+            Ok(a) => a,
+            Err(e) => {
+                eprintln!("error: {e}");
+                return (&e).into();
+            }
+        };
+
+        return run_sweep_pipeline(
+            &data_port,
+            &grid,
+            &points,
+            &bt_config,
+            &codes,
+            &exchange,
+            output_path,
+            format,
+        );
+    }
+
+    #[cfg(feature = "sqlite")]
+    {
+        use crate::adapters::sqlite_adapter::SqliteAdapter;
+
+        let data_port = match SqliteAdapter::from_config(&adapter) {
+            Ok(a) => a,
+            Err(e) => {
+                eprintln!("error: {e}");
+                return (&e).into();
+            }
+        };
+
+        run_sweep_pipeline(
+            &data_port,
+            &grid,
+            &points,
+            &bt_config,
+            &codes,
+            &exchange,
+            output_path,
+            format,
+        )
+    }
+
+    #[cfg(not(feature = "sqlite"))]
+    {
+        let _ = (&points, &bt_config, &codes, &exchange, output_path, format);
+        eprintln!("error: sqlite feature is required for sweep");
+        ExitCode::from(1)
+    }
+}
+
+/// Validate and build the strategy for every grid point up front, so a bad
+/// template fails before any data is loaded.
+pub fn build_sweep_points(
+    strategy_config: &dyn ConfigPort,
+    grid: &ParamGrid,
+) -> Result<Vec<SweepPoint>, ExitCode> {
+    grid.points()
+        .into_iter()
+        .map(|params: GridPoint| {
+            let view = PointConfig::new(strategy_config, &params);
+            if let Err(e) = validate_strategy_config(&view) {
+                eprintln!("error: {e}");
+                return Err((&e).into());
+            }
+            let strategy = build_strategy(&view)?;
+            Ok(SweepPoint { params, strategy })
+        })
+        .collect()
+}
+
+#[allow(clippy::too_many_arguments)]
+pub fn run_sweep_pipeline(
+    data_port: &dyn crate::ports::data_port::DataPort,
+    grid: &ParamGrid,
+    points: &[SweepPoint],
+    bt_config: &BacktestConfig,
+    codes: &[String],
+    exchange: &str,
+    output_path: Option<&PathBuf>,
+    format: SweepFormat,
+) -> ExitCode {
+    use std::io::{BufWriter, Write};
+
+    let validation = fetch_code_data(
+        data_port,
+        codes,
+        exchange,
+        bt_config.start_date,
+        bt_config.end_date,
+        bt_config.workers,
+    )
+    .and_then(|fetched| validate_fetched(codes.to_vec(), fetched, exchange));
+    let validation = match validation {
+        Ok(v) => v,
+        Err(e) => {
+            eprintln!("error: {e}");
+            return (&e).into();
+        }
+    };
+
+    // Indicators are computed lazily by the sweep's shared store, once per
+    // distinct (code, indicator) across all points.
+    let code_data_vec = validation.code_data;
+
+    if code_data_vec.is_empty() {
+        eprintln!("error: no valid codes with data to backtest");
+        return ExitCode::from(5);
+    }
+
+    let timeline = build_unified_timeline(&code_data_vec);
+
+    let mut out: Box<dyn Write> = match output_path {
+        Some(path) => match fs::File::create(path) {
+            Ok(f) => Box::new(BufWriter::new(f)),
+            Err(e) => {
+                eprintln!("error: failed to create {}: {e}", path.display());
+                return ExitCode::from(1);
+            }
+        },
+        None => Box::new(std::io::stdout().lock()),
+    };
+
+    eprintln!(
+        "Running sweep: {} points, {} codes, {} dates",
+        points.len(),
+        code_data_vec.len(),
+        timeline.len(),
+    );
+
+    let mut write_result = match format {
+        SweepFormat::Csv => writeln!(out, "{}", sweep::csv_header(grid)),
+        SweepFormat::Json => Ok(()),
+    };
+    sweep::run_sweep(
+        &code_data_vec,
+        &timeline,
+        points,
+        bt_config,
+        bt_config.workers,
+        |index, metrics| {
+            if write_result.is_err() {
+                return;
+            }
+            let params = &points[index].params;
+            let row = match format {
+                SweepFormat::Csv => sweep::csv_row(index, params, &metrics),
+                SweepFormat::Json => sweep::json_row(index, params, &metrics),
+            };
+            write_result = writeln!(out, "{row}").and_then(|()| out.flush());
+        },
+    );
+
+    match write_result {
+        Ok(()) => {
+            if let Some(path) = output_path {
+                eprintln!("Sweep results written to: {}", path.display());
+            }
+            ExitCode::SUCCESS
+        }
+        Err(e) => {
+            eprintln!("error: failed to write sweep results: {e}");
+            ExitCode::from(1)
+        }
+    }
+}
+
 pub fn run_dry_run(config_path: &PathBuf) -> ExitCode {
     eprintln!("Loading config from {}", config_path.display());
     let adapter = match load_config(config_path) {
@@ -813,6 +1249,158 @@ fn run_info(code: Option<&str>, exchange: Option<&str>, config_path: Option<&Pat
     }
 }
 
+fn run_import(
+    config_path: &PathBuf,
+    dir: &Path,
+    exchange: Option<&str>,
+    batch_size: Option<usize>,
+) -> ExitCode {
+    use crate::adapters::csv_adapter::CsvAdapter;
+
+    let config = match load_config(config_path) {
+        Ok(c) => c,
+        Err(code) => return code,
+    };
+    let batch_size = batch_size
+        .unwrap_or_else(|| config.get_int("postgres", "copy_batch_size", 100_000).max(1) as usize);
+
+    let csv = CsvAdapter::new(dir.to_path_buf());
+    let files: Vec<(String, String)> = match csv.list_files() {
+        Ok(files) => files
+            .into_iter()
+            .filter(|(_, e)| exchange.is_none_or(|x| x == e))
+            .collect(),
+        Err(e) => {
+            eprintln!("error: {e}");
+            return (&e).into();
+        }
+    };
+    if files.is_empty() {
+        eprintln!("error: no CSV files found in {}", dir.display());
+        return ExitCode::from(1);
+    }
+
+    #[cfg(feature = "postgres")]
+    {
+        use crate::adapters::postgres_adapter::PostgresAdapter;
+        use crate::domain::ohlcv::OhlcvBar;
+
+        let adapter = match PostgresAdapter::from_config(&config) {
+            Ok(a) => a,
+            Err(e) => {
+                eprintln!("error: {e}");
+                return (&e).into();
+            }
+        };
+
+        eprintln!(
+            "Importing {} files from {} in batches of {}",
+            files.len(),
+            dir.display(),
+            batch_size
+        );
+        type Rows = Box<dyn Iterator<Item = Result<OhlcvBar, SamtraderError>>>;
+        let bars = files.iter().flat_map(|(code, exchange)| -> Rows {
+            match csv.read_bars(code, exchange) {
+                Ok(rows) => Box::new(rows),
+                Err(e) => Box::new(std::iter::once(Err(e))),
+            }
+        });
+        match adapter.copy_bars(bars, batch_size) {
+            Ok(rows) => {
+                eprintln!("Imported {} bars", rows);
+                ExitCode::SUCCESS
+            }
+            Err(e) => {
+                eprintln!("error: {e}");
+                (&e).into()
+            }
+        }
+    }
+
+    #[cfg(not(feature = "postgres"))]
+    {
+        let _ = (csv, files, batch_size);
+        eprintln!("error: postgres feature is required for import");
+        ExitCode::from(1)
+    }
+}
+
+fn run_export_cache(
+    config_path: &PathBuf,
+    output_path: &Path,
+    code: Option<&str>,
+    exchange: Option<&str>,
+) -> ExitCode {
+    let config = match load_config(config_path) {
+        Ok(c) => c,
+        Err(code) => return code,
+    };
+
+    let codes = resolve_codes(code, &config);
+    let exchange = match exchange {
+        Some(e) => e.to_string(),
+        None => match config.get_string("backtest", "exchange") {
+            Some(e) => e,
+            None => {
+                eprintln!("error: exchange is required (use --exchange or set in config)");
+                return ExitCode::from(1);
+            }
+        },
+    };
+
+    #[cfg(feature = "sqlite")]
+    {
+        use crate::adapters::mmap_adapter::export_bar_cache;
+        use crate::adapters::sqlite_adapter::SqliteAdapter;
+        use crate::ports::data_port::DataPort;
+
+        let adapter = match SqliteAdapter::from_config(&config) {
+            Ok(a) => a,
+            Err(e) => {
+                eprintln!("error: {e}");
+                return (&e).into();
+            }
+        };
+
+        let codes = if codes.is_empty() {
+            match adapter.list_symbols(&exchange) {
+                Ok(s) => s,
+                Err(e) => {
+                    eprintln!("error: {e}");
+                    return (&e).into();
+                }
+            }
+        } else {
+            codes
+        };
+
+        eprintln!(
+            "Exporting {} codes on {} to {}",
+            codes.len(),
+            exchange,
+            output_path.display()
+        );
+        match export_bar_cache(&adapter, &codes, &exchange, output_path) {
+            Ok(bars) => {
+                eprintln!("Wrote {} bars", bars);
+                ExitCode::SUCCESS
+            }
+            Err(e) => {
+                eprintln!("error: {e}");
+                (&e).into()
+            }
+        }
+    }
+
+    #[cfg(not(feature = "sqlite"))]
+    {
+        let _ = (output_path, codes, exchange);
+        eprintln!("error: sqlite feature is required for export-cache");
+        ExitCode::from(1)
+    }
+}
+
 pub fn resolve_codes(code_override: Option<&str>, config: &dyn ConfigPort) -> Vec<String> {
     if let Some(c) = code_override {
         return vec![c.to_uppercase()];
@@ -854,9 +1442,9 @@ fn run_migrate(sqlite_path: Option<&PathBuf>, postgres_conn: Option<&str>) -> Ex
 fn run_migrate_sqlite(sqlite_path: &Path) -> ExitCode {
     #[cfg(feature = "sqlite")]
     {
-        use crate::adapters::sqlite_adapter::SqliteAdapter;
+        use crate::adapters::sqlite_adapter::{SCHEMA_VERSION, SchemaChange, SqliteAdapter};
 
-        eprintln!("Creating schema at {}", sqlite_path.display());
+        eprintln!("Initializing schema at {}", sqlite_path.display());
 
         let adapter = match SqliteAdapter::from_path(&sqlite_path.display().to_string()) {
             Ok(a) => a,
@@ -866,12 +1454,19 @@ fn run_migrate_sqlite(sqlite_path: &Path) -> ExitCode {
             }
         };
 
-        if let Err(e) = adapter.initialize_schema() {
-            eprintln!("error: {e}");
-            return (&e).into();
+        match adapter.initialize_schema() {
+            Ok(SchemaChange::Created) => eprintln!("Schema created successfully"),
+            Ok(SchemaChange::UpToDate) => {
+                eprintln!("Schema is already at version {SCHEMA_VERSION}")
+            }
+            Ok(SchemaChange::Migrated { rows }) => {
+                eprintln!("Migrated {rows} bars to schema version {SCHEMA_VERSION}")
+            }
+            Err(e) => {
+                eprintln!("error: {e}");
+                return (&e).into();
+            }
         }
-
-        eprintln!("Schema created successfully");
         ExitCode::SUCCESS
     }
 
@@ -931,7 +1526,7 @@ fn run_serve(config_path: &PathBuf) -> ExitCode {
         };
 
         let data_port = match PostgresAdapter::from_config(&config) {
-            Ok(a) => Arc::new(a) as Arc<dyn crate::ports::data_port::DataPort + Send + Sync>,
+            Ok(a) => web_data_port(a, &config),
             Err(e) => {
                 eprintln!("error: failed to connect to PostgreSQL: {e}");
                 return ExitCode::from(1);
@@ -946,10 +1541,19 @@ fn run_serve(config_path: &PathBuf) -> ExitCode {
 
         eprintln!("Starting web server on {} (PostgreSQL)", addr);
 
+        let jobs = crate::adapters::web::JobPool::from_config(&config);
+        let backtest_cache = match crate::adapters::web::ReportCache::from_config(&config) {
+            Ok(cache) => Arc::new(cache),
+            Err(e) => {
+                eprintln!("error: failed to open report store: {e}");
+                return ExitCode::from(1);
+            }
+        };
         let state = crate::adapters::web::AppState {
             data_port,
             config: Arc::new(config),
-            backtest_cache: crate::adapters::web::new_backtest_cache(),
+            backtest_cache,
+            jobs,
         };
 
         let rt = match tokio::runtime::Runtime::new() {
@@ -992,7 +1596,7 @@ fn run_serve(config_path: &PathBuf) -> ExitCode {
         };
 
         let data_port = match SqliteAdapter::from_config(&config) {
-            Ok(a) => Arc::new(a) as Arc<dyn crate::ports::data_port::DataPort + Send + Sync>,
+            Ok(a) => web_data_port(a, &config),
             Err(e) => {
                 eprintln!("error: failed to connect to SQLite: {e}");
                 return ExitCode::from(1);
@@ -1007,10 +1611,19 @@ fn run_serve(config_path: &PathBuf) -> ExitCode {
 
         eprintln!("Starting web server on {} (SQLite)", addr);
 
+        let jobs = crate::adapters::web::JobPool::from_config(&config);
+        let backtest_cache = match crate::adapters::web::ReportCache::from_config(&config) {
+            Ok(cache) => Arc::new(cache),
+            Err(e) => {
+                eprintln!("error: failed to open report store: {e}");
+                return ExitCode::from(1);
+            }
+        };
         let state = crate::adapters::web::AppState {
             data_port,
             config: Arc::new(config),
-            backtest_cache: crate::adapters::web::new_backtest_cache(),
+            backtest_cache,
+            jobs,
         };
 
         let rt = match tokio::runtime::Runtime::new() {
@@ -1047,6 +1660,22 @@ fn run_serve(config_path: &PathBuf) -> ExitCode {
     }
 }
 
+/// Put the web server's data port behind the `[web] data_cache_mb` OHLCV
+/// cache (256 MiB by default; 0 disables it).
+#[cfg(any(feature = "web-sqlite", feature = "web-postgres"))]
+fn web_data_port<P: crate::ports::data_port::DataPort + 'static>(
+    port: P,
+    config: &dyn ConfigPort,
+) -> std::sync::Arc<dyn crate::ports::data_port::DataPort + Send + Sync> {
+    use crate::adapters::cached_data_port::CachedDataPort;
+    use std::sync::Arc;
+
+    match config.get_int("web", "data_cache_mb", 256) {
+        mb if mb > 0 => Arc::new(CachedDataPort::new(port, mb as usize * 1024 * 1024)),
+        _ => Arc::new(port),
+    }
+}
+
 fn run_hash_password() -> ExitCode {
     #[cfg(feature = "web")]
     {
@@ -1,16 +1,20 @@
 //! Backtest engine and event loop (TRD Section 3.4, 8.3).
 //!
 //! BacktestConfig (TRD Section 3.7) defines backtest parameters.
-//! run_backtest executes the unified backtest loop.
+//! run_backtest executes the unified backtest loop. resume_backtest continues
+//! it from a saved `BacktestState` (see `domain::checkpoint`) over dates
+//! after the last one processed.
 
 use chrono::NaiveDate;
-use std::collections::HashMap;
 
-use super::code_data::CodeData;
+use super::code_data::{CodeData, Timeline};
 use super::execution::{self, EntryResult, ExecutionConfig, ExecutionParams};
+use super::indicator_helpers::IndicatorCache;
 use super::portfolio::Portfolio;
-use super::rule_eval;
+use super::rule_compile::CompiledRule;
+use super::signal::SignalBits;
 use super::strategy::Strategy;
+use super::symbol::SymbolId;
 
 #[derive(Debug, Clone)]
 pub struct BacktestConfig {
@@ -22,6 +26,8 @@ pub struct BacktestConfig {
     pub slippage_pct: f64,
     pub allow_shorting: bool,
     pub risk_free_rate: f64,
+    /// Worker threads for per-code loading; 0 uses every available core.
+    pub workers: usize,
 }
 
 #[derive(Debug, Clone)]
@@ -45,14 +51,169 @@ pub struct CodeResult {
     pub result: BacktestResult,
 }
 
+/// Everything the event loop carries from one date to the next besides the
+/// bars themselves. Persisted by `BacktestCheckpoint`.
+#[derive(Debug, Clone, PartialEq)]
+pub struct BacktestState {
+    pub portfolio: Portfolio,
+    /// Entry commission of each open position, indexed by `SymbolId`.
+    pub entry_commissions: Vec<f64>,
+    /// Last timeline date processed; a resumed loop starts after it.
+    pub last_date: Option<NaiveDate>,
+}
+
+impl BacktestState {
+    /// State before the first date of a run over `code_count` codes.
+    pub fn new(initial_capital: f64, code_count: usize) -> Self {
+        BacktestState {
+            portfolio: Portfolio::new(initial_capital),
+            entry_commissions: vec![0.0; code_count],
+            last_date: None,
+        }
+    }
+}
+
+/// Run the unified event loop. `timeline` must have been aligned to this same
+/// `code_data` slice (see `build_unified_timeline` / `Timeline::new`).
 pub fn run_backtest(
     code_data: &[CodeData],
-    timeline: &[NaiveDate],
+    timeline: &Timeline,
+    strategy: &Strategy,
+    config: &BacktestConfig,
+) -> BacktestResult {
+    let indicators: Vec<&IndicatorCache> = code_data.iter().map(|cd| &cd.indicators).collect();
+    run_backtest_with_indicators(code_data, &indicators, timeline, strategy, config)
+}
+
+/// `run_backtest` reading each code's indicators from `indicators[c]`
+/// instead of `CodeData::indicators`, so concurrent runs can share one
+/// universe while each supplies its own (e.g. `IndicatorStore`) series.
+pub fn run_backtest_with_indicators(
+    code_data: &[CodeData],
+    indicators: &[&IndicatorCache],
+    timeline: &Timeline,
     strategy: &Strategy,
     config: &BacktestConfig,
 ) -> BacktestResult {
-    let mut portfolio = Portfolio::new(config.initial_capital);
-    let mut entry_commissions: HashMap<String, f64> = HashMap::new();
+    let state = BacktestState::new(config.initial_capital, code_data.len());
+    let state =
+        resume_backtest_with_indicators(code_data, indicators, timeline, strategy, config, state);
+    BacktestResult {
+        portfolio: state.portfolio,
+    }
+}
+
+/// Continue the event loop from `state` over the timeline dates after
+/// `state.last_date`, returning the state after the last date.
+///
+/// Signals at a bar depend only on bars up to it, so resuming a state saved
+/// at date D over a history extended past D gives exactly the result of a
+/// full run over the extended history.
+pub fn resume_backtest(
+    code_data: &[CodeData],
+    timeline: &Timeline,
+    strategy: &Strategy,
+    config: &BacktestConfig,
+    state: BacktestState,
+) -> BacktestState {
+    let indicators: Vec<&IndicatorCache> = code_data.iter().map(|cd| &cd.indicators).collect();
+    resume_backtest_with_indicators(code_data, &indicators, timeline, strategy, config, state)
+}
+
+/// `resume_backtest` with per-code indicators, as `run_backtest_with_indicators`.
+pub fn resume_backtest_with_indicators(
+    code_data: &[CodeData],
+    indicators: &[&IndicatorCache],
+    timeline: &Timeline,
+    strategy: &Strategy,
+    config: &BacktestConfig,
+    state: BacktestState,
+) -> BacktestState {
+    resume_backtest_with_progress(
+        code_data,
+        indicators,
+        timeline,
+        strategy,
+        config,
+        state,
+        &mut |_, _| {},
+    )
+}
+
+/// `run_backtest` calling `progress(dates_processed, total_dates)` after
+/// each timeline date, e.g. to report how far a queued web job has got.
+pub fn run_backtest_with_progress(
+    code_data: &[CodeData],
+    timeline: &Timeline,
+    strategy: &Strategy,
+    config: &BacktestConfig,
+    progress: &mut dyn FnMut(usize, usize),
+) -> BacktestResult {
+    let indicators: Vec<&IndicatorCache> = code_data.iter().map(|cd| &cd.indicators).collect();
+    let state = BacktestState::new(config.initial_capital, code_data.len());
+    let state = resume_backtest_with_progress(
+        code_data,
+        &indicators,
+        timeline,
+        strategy,
+        config,
+        state,
+        progress,
+    );
+    BacktestResult {
+        portfolio: state.portfolio,
+    }
+}
+
+/// `resume_backtest_with_indicators` reporting progress as
+/// `run_backtest_with_progress` does.
+pub fn resume_backtest_with_progress(
+    code_data: &[CodeData],
+    indicators: &[&IndicatorCache],
+    timeline: &Timeline,
+    strategy: &Strategy,
+    config: &BacktestConfig,
+    state: BacktestState,
+    progress: &mut dyn FnMut(usize, usize),
+) -> BacktestState {
+    debug_assert_eq!(indicators.len(), code_data.len());
+    // Entry/exit decisions for every bar of every code, evaluated a whole
+    // series at a time before the loop starts.
+    let signals: Vec<(SignalBits, SignalBits)> = code_data
+        .iter()
+        .zip(indicators)
+        .map(|(cd, indicators)| {
+            let entry = CompiledRule::compile(&strategy.entry_long, &cd.ohlcv, indicators);
+            let exit = CompiledRule::compile(&strategy.exit_long, &cd.ohlcv, indicators);
+            (entry.signals(), exit.signals())
+        })
+        .collect();
+    resume_backtest_with_signals(
+        code_data, &signals, timeline, strategy, config, state, progress,
+    )
+}
+
+/// The event loop behind every variant above, taking the entry and exit
+/// decision for bar `i` of `code_data[c]` from bit `i` of `signals[c]`.
+/// Bits of bars on or before `state.last_date` are never read, so a
+/// checkpoint resume only has to evaluate the rules on the new bars.
+pub fn resume_backtest_with_signals(
+    code_data: &[CodeData],
+    signals: &[(SignalBits, SignalBits)],
+    timeline: &Timeline,
+    strategy: &Strategy,
+    config: &BacktestConfig,
+    state: BacktestState,
+    progress: &mut dyn FnMut(usize, usize),
+) -> BacktestState {
+    let BacktestState {
+        mut portfolio,
+        // Per-code buffers indexed by SymbolId (the code's slice position),
+        // reused for the whole run.
+        mut entry_commissions,
+        mut last_date,
+    } = state;
+    let mut prices: Vec<Option<f64>> = vec![None; code_data.len()];
 
     let exec_config = ExecutionConfig {
         commission_per_trade: config.commission_per_trade,
@@ -67,70 +228,85 @@ pub fn run_backtest(
         take_profit_pct: strategy.take_profit_pct,
     };
 
-    for &date in timeline {
-        let mut price_map: HashMap<String, f64> = HashMap::new();
-        for cd in code_data {
-            if let Some(bar) = cd.get_bar(date) {
-                price_map.insert(cd.code.clone(), bar.close);
-            }
+    debug_assert_eq!(timeline.code_count(), code_data.len());
+    debug_assert_eq!(signals.len(), code_data.len());
+    assert_eq!(
+        entry_commissions.len(),
+        code_data.len(),
+        "state is for another universe"
+    );
+
+    let dates = timeline.dates();
+    let first = last_date.map_or(0, |last| dates.partition_point(|&d| d <= last));
+
+    for (t, &date) in dates.iter().enumerate().skip(first) {
+        for (c, cd) in code_data.iter().enumerate() {
+            prices[c] = timeline.bar_index(c, t).map(|i| cd.ohlcv.close[i]);
         }
 
         execution::check_triggers(
             &mut portfolio,
-            &price_map,
+            &prices,
             date,
             &entry_commissions,
             &exec_config,
         );
 
-        for cd in code_data {
-            let bar_index = match cd.get_bar_index(date) {
+        for (c, cd) in code_data.iter().enumerate() {
+            let bar_index = match timeline.bar_index(c, t) {
                 Some(idx) => idx,
                 None => continue,
             };
+            let symbol = SymbolId::from_index(c);
+            let (entry_bits, exit_bits) = &signals[c];
 
-            let bar = &cd.ohlcv[bar_index];
+            let close = cd.ohlcv.close[bar_index];
 
-            if portfolio.has_position(&cd.code)
-                && rule_eval::evaluate(&strategy.exit_long, &cd.ohlcv, &cd.indicators, bar_index)
-            {
-                let entry_commission = entry_commissions.remove(&cd.code).unwrap_or(0.0);
+            if portfolio.has_position(symbol) && exit_bits.get(bar_index) {
+                let entry_commission = std::mem::take(&mut entry_commissions[c]);
                 execution::exit_position(
                     &mut portfolio,
-                    &cd.code,
-                    bar.close,
+                    symbol,
+                    close,
                     date,
                     entry_commission,
                     &exec_config,
                 );
             }
 
-            if !portfolio.has_position(&cd.code) {
+            if !portfolio.has_position(symbol) {
                 if portfolio.position_count() >= strategy.max_positions {
                     continue;
                 }
-                if rule_eval::evaluate(&strategy.entry_long, &cd.ohlcv, &cd.indicators, bar_index) {
+                if entry_bits.get(bar_index) {
                     let result = execution::enter_long(
                         &mut portfolio,
+                        symbol,
                         &cd.code,
                         &cd.exchange,
-                        bar.close,
+                        close,
                         date,
                         &exec_params,
                         &exec_config,
                     );
                     if let EntryResult::Entered { commission, .. } = result {
-                        entry_commissions.insert(cd.code.clone(), commission);
+                        entry_commissions[c] = commission;
                     }
                 }
             }
         }
 
-        let equity = portfolio.total_equity(&price_map);
+        let equity = portfolio.total_equity(&prices);
         portfolio.record_equity(date, equity);
+        last_date = Some(date);
+        progress(t + 1, dates.len());
     }
 
-    BacktestResult { portfolio }
+    BacktestState {
+        portfolio,
+        entry_commissions,
+        last_date,
+    }
 }
 
 #[cfg(test)]
@@ -150,6 +326,7 @@ mod tests {
             slippage_pct: 0.0,
             allow_shorting: false,
             risk_free_rate: 0.05,
+            workers: 1,
         }
     }
 
@@ -281,11 +458,14 @@ mod tests {
         ];
         let code_data = make_code_data("BHP", bars);
         // Pass a subset of the timeline — caller controls date range
-        let timeline: Vec<NaiveDate> = vec![
-            NaiveDate::from_ymd_opt(2024, 1, 2).unwrap(),
-            NaiveDate::from_ymd_opt(2024, 1, 3).unwrap(),
-            NaiveDate::from_ymd_opt(2024, 1, 4).unwrap(),
-        ];
+        let timeline = Timeline::new(
+            &[code_data.clone()],
+            vec![
+                NaiveDate::from_ymd_opt(2024, 1, 2).unwrap(),
+                NaiveDate::from_ymd_opt(2024, 1, 3).unwrap(),
+                NaiveDate::from_ymd_opt(2024, 1, 4).unwrap(),
+            ],
+        );
         let strategy = make_simple_strategy();
         let config = sample_config();
 
@@ -302,6 +482,32 @@ mod tests {
         );
     }
 
+    #[test]
+    fn run_backtest_with_progress_reports_each_date() {
+        let bars = vec![
+            make_bar("BHP", "2024-01-01", 90.0),
+            make_bar("BHP", "2024-01-02", 110.0),
+            make_bar("BHP", "2024-01-03", 90.0),
+        ];
+        let code_data = make_code_data("BHP", bars);
+        let timeline = build_unified_timeline(&[code_data.clone()]);
+        let strategy = make_simple_strategy();
+        let config = sample_config();
+
+        let mut seen = Vec::new();
+        let result = run_backtest_with_progress(
+            &[code_data.clone()],
+            &timeline,
+            &strategy,
+            &config,
+            &mut |done, total| seen.push((done, total)),
+        );
+
+        assert_eq!(seen, vec![(1, 3), (2, 3), (3, 3)]);
+        let plain = run_backtest(&[code_data], &timeline, &strategy, &config);
+        assert_eq!(result.portfolio, plain.portfolio);
+    }
+
     #[test]
     fn run_backtest_max_positions_enforced() {
         let bhp_bars = vec![
@@ -384,7 +590,7 @@ mod tests {
     fn run_backtest_empty_timeline() {
         let bars: Vec<OhlcvBar> = vec![];
         let code_data = make_code_data("BHP", bars);
-        let timeline: Vec<NaiveDate> = vec![];
+        let timeline = Timeline::new(&[code_data.clone()], vec![]);
         let strategy = make_simple_strategy();
         let config = sample_config();
 
@@ -0,0 +1,940 @@
+//! Persisted backtest checkpoints for incremental re-runs (TRD Section 8.3).
+//!
+//! A nightly refresh of a long-history backtest differs from yesterday's run
+//! only by the newly appended bars. `BacktestCheckpoint` saves everything
+//! needed to continue from the last date processed without the history
+//! before it:
+//!
+//! - the event loop's `BacktestState` (portfolio, entry commissions, last
+//!   date);
+//! - per code, its last bar, an `IndicatorState` for every indicator the
+//!   strategy reads (positioned just before that bar) and the entry and
+//!   exit rules' `StepperState` (after it).
+//!
+//! `BacktestCheckpoint::resume` takes each code's bars from its own
+//! `fetch_starts` date on, pushes them through the indicator states and rule
+//! steppers, and runs the event loop over the new dates only, so a refresh
+//! costs O(new bars) whatever the length of the history. The last bar is fetched again
+//! because `CROSS_*` and the first new indicator values look back at it.
+//!
+//! The result is identical to a full replay provided the inputs that shaped
+//! the saved state are unchanged, which the checkpoint verifies as far as it
+//! can without the history:
+//!
+//! - a fingerprint of the requested codes, the strategy's rules and
+//!   parameters and the config fields the loop reads (`workers` and
+//!   `risk_free_rate` may change freely, and `end_date` may move forward
+//!   but not before the checkpoint);
+//! - each code's last bar, which must come back unchanged, with no bar
+//!   inserted between it and the checkpoint date. Rewrites further back are
+//!   not detected; replay in full after restating older history;
+//! - the codes universe validation left out of the run, none of which may
+//!   have gained enough bars since to be validated in.
+
+use std::collections::BTreeMap;
+use std::fs;
+use std::path::{Path, PathBuf};
+use std::sync::Arc;
+
+use chrono::NaiveDate;
+
+use super::backtest::{self, BacktestConfig, BacktestState};
+use super::code_data::{CodeData, build_unified_timeline};
+use super::codec::{ByteReader, ByteWriter};
+use super::error::SamtraderError;
+use super::indicator::{IndicatorColumns, IndicatorSeries};
+use super::indicator_helpers::IndicatorCache;
+use super::indicator_stream::IndicatorState;
+use super::loader::fetch_code_data;
+use super::ohlcv::OhlcvSeries;
+use super::portfolio::{EquityPoint, Portfolio};
+use super::position::{ClosedTrade, Position};
+use super::rule::Rule;
+use super::rule_compile::{CompiledRule, StepperState};
+use super::signal::SignalBits;
+use super::strategy::Strategy;
+use super::symbol::SymbolId;
+use super::universe::MIN_OHLCV_BARS;
+use crate::ports::data_port::DataPort;
+
+/// Leading bytes of every checkpoint file.
+const MAGIC: &[u8; 4] = b"STCK";
+const VERSION: u8 = 3;
+
+/// A saved `BacktestState` plus each code's signal carry.
+#[derive(Debug, Clone)]
+pub struct BacktestCheckpoint {
+    pub fingerprint: u64,
+    /// Codes the event loop ran over, in `SymbolId` order.
+    pub codes: Vec<String>,
+    /// Signal carry of each code, in `codes` order.
+    pub carries: Vec<CodeCarry>,
+    /// Requested codes that universe validation left out, in request order.
+    pub skipped: Vec<String>,
+    pub state: BacktestState,
+}
+
+/// Where signal evaluation of one code stopped.
+#[derive(Debug, Clone)]
+pub struct CodeCarry {
+    /// The code's last bar on or before the checkpoint date, if any.
+    pub tail: OhlcvSeries,
+    /// One state per indicator the strategy reads, positioned just before
+    /// `tail`.
+    pub indicators: Vec<IndicatorState>,
+    /// Entry and exit rule carry after `tail`.
+    pub entry: StepperState,
+    pub exit: StepperState,
+}
+
+/// Checkpoint file written next to a report: `report.typ` ->
+/// `report.typ.ckpt`.
+pub fn checkpoint_path(output: &Path) -> PathBuf {
+    let mut name = output.as_os_str().to_owned();
+    name.push(".ckpt");
+    PathBuf::from(name)
+}
+
+/// Stable hash of everything that shapes the event loop's state: the codes
+/// requested, the rules in their canonical text form and the numeric
+/// parameters, but not the strategy's name or description.
+pub fn fingerprint(
+    codes: &[String],
+    exchange: &str,
+    strategy: &Strategy,
+    config: &BacktestConfig,
+) -> u64 {
+    let optional = |rule: &Option<Rule>| {
+        rule.as_ref()
+            .map_or_else(|| "-".to_string(), |r| r.to_string())
+    };
+    let key = format!(
+        "codes={}|exchange={exchange}|entry={}|exit={}|entry_short={}|exit_short={}\
+         |size={:?}|stop={:?}|take={:?}|max={}|start={}|capital={:?}|commission={:?}\
+         |commission_pct={:?}|slippage={:?}|shorting={}",
+        codes.join(","),
+        strategy.entry_long,
+        strategy.exit_long,
+        optional(&strategy.entry_short),
+        optional(&strategy.exit_short),
+        strategy.position_size,
+        strategy.stop_loss_pct,
+        strategy.take_profit_pct,
+        strategy.max_positions,
+        config.start_date,
+        config.initial_capital,
+        config.commission_per_trade,
+        config.commission_pct,
+        config.slippage_pct,
+        config.allow_shorting,
+    );
+    // FNV-1a: unlike `DefaultHasher`, stable across builds.
+    key.bytes().fold(0xcbf2_9ce4_8422_2325, |hash, b| {
+        (hash ^ b as u64).wrapping_mul(0x0100_0000_01b3)
+    })
+}
+
+fn stale(reason: impl Into<String>) -> SamtraderError {
+    SamtraderError::Decode {
+        what: "backtest checkpoint".to_string(),
+        reason: reason.into(),
+    }
+}
+
+impl BacktestCheckpoint {
+    /// Snapshot `state` of a full run of `strategy` over `code_data`, the
+    /// codes validated out of `codes` on `exchange`.
+    pub fn capture(
+        codes: &[String],
+        exchange: &str,
+        code_data: &[CodeData],
+        strategy: &Strategy,
+        config: &BacktestConfig,
+        state: &BacktestState,
+    ) -> Self {
+        BacktestCheckpoint {
+            fingerprint: fingerprint(codes, exchange, strategy, config),
+            codes: code_data.iter().map(|cd| cd.code.clone()).collect(),
+            carries: code_data
+                .iter()
+                .map(|cd| CodeCarry::capture(cd, strategy, state.last_date))
+                .collect(),
+            skipped: codes
+                .iter()
+                .filter(|&code| code_data.iter().all(|cd| &cd.code != code))
+                .cloned()
+                .collect(),
+            state: state.clone(),
+        }
+    }
+
+    /// Whether this checkpoint can be resumed with these inputs; otherwise
+    /// the reason it cannot.
+    pub fn check(
+        &self,
+        codes: &[String],
+        exchange: &str,
+        strategy: &Strategy,
+        config: &BacktestConfig,
+    ) -> Result<(), SamtraderError> {
+        if self.fingerprint != fingerprint(codes, exchange, strategy, config) {
+            return Err(stale("codes, strategy or backtest config changed"));
+        }
+        if let Some(last) = self.state.last_date.filter(|&d| d > config.end_date) {
+            return Err(stale(format!("saved through {last}, after end date")));
+        }
+        Ok(())
+    }
+
+    /// Whether every code skipped at capture would still be skipped by
+    /// universe validation over `config`'s dates; otherwise a full run would
+    /// include it and the checkpoint cannot stand in for one.
+    ///
+    /// `get_data_range` rules out most codes without reading bars; only a
+    /// code with enough bars overall has those in range fetched and counted.
+    /// A code whose data cannot be read stays skipped, as it would in a full
+    /// run.
+    pub fn check_skipped(
+        &self,
+        data_port: &dyn DataPort,
+        exchange: &str,
+        config: &BacktestConfig,
+    ) -> Result<(), SamtraderError> {
+        for code in &self.skipped {
+            let total = match data_port.get_data_range(code, exchange) {
+                Ok(Some((_, _, bars))) => bars,
+                Ok(None) | Err(_) => continue,
+            };
+            if total < MIN_OHLCV_BARS {
+                continue;
+            }
+            let in_range = data_port
+                .fetch_ohlcv_series(code, exchange, config.start_date, config.end_date)
+                .map_or(0, |series| series.len());
+            if in_range >= MIN_OHLCV_BARS {
+                return Err(stale(format!(
+                    "skipped code {code} now has {in_range} bars"
+                )));
+            }
+        }
+        Ok(())
+    }
+
+    /// First date `resume` needs bars from for each code, in `codes` order:
+    /// the code's last bar, or the day after the checkpoint date for a code
+    /// without one.
+    pub fn fetch_starts(&self, config: &BacktestConfig) -> Vec<NaiveDate> {
+        let after_last = self
+            .state
+            .last_date
+            .and_then(|d| d.succ_opt())
+            .unwrap_or(config.start_date);
+        self.carries
+            .iter()
+            .map(|carry| carry.tail.date.first().copied().unwrap_or(after_last))
+            .collect()
+    }
+
+    /// Fetch what `resume` reads: each code's bars from its `fetch_starts`
+    /// date through `config.end_date`. Codes sharing a start date (normally
+    /// every code that traded on the checkpoint date) are fetched together,
+    /// so a delisted code's old last bar does not widen the others' range.
+    pub fn fetch(
+        &self,
+        data_port: &dyn DataPort,
+        exchange: &str,
+        config: &BacktestConfig,
+    ) -> Result<Vec<CodeData>, SamtraderError> {
+        let mut groups: BTreeMap<NaiveDate, Vec<usize>> = BTreeMap::new();
+        for (i, start) in self.fetch_starts(config).into_iter().enumerate() {
+            groups.entry(start).or_default().push(i);
+        }
+        let mut fetched: Vec<Option<CodeData>> = vec![None; self.codes.len()];
+        for (start, slots) in groups {
+            let codes: Vec<String> = slots.iter().map(|&i| self.codes[i].clone()).collect();
+            let results = fetch_code_data(
+                data_port,
+                &codes,
+                exchange,
+                start,
+                config.end_date,
+                config.workers,
+            )?;
+            for (i, result) in slots.into_iter().zip(results) {
+                fetched[i] = Some(result?);
+            }
+        }
+        Ok(fetched.into_iter().flatten().collect())
+    }
+
+    /// Continue over `fetched`, one `CodeData` per code of `codes` in the
+    /// same order holding its bars from its `fetch_starts` date on (see
+    /// `fetch`); `check` must have passed. Returns the checkpoint after the last new date, whose
+    /// portfolio equals that of a full run over the extended history.
+    pub fn resume(
+        self,
+        fetched: &[CodeData],
+        strategy: &Strategy,
+        config: &BacktestConfig,
+    ) -> Result<Self, SamtraderError> {
+        let codes: Vec<&str> = fetched.iter().map(|cd| cd.code.as_str()).collect();
+        if self.codes != codes {
+            return Err(stale("universe changed"));
+        }
+        let last_date = self.state.last_date;
+        let mut code_data = Vec::with_capacity(fetched.len());
+        let mut signals = Vec::with_capacity(fetched.len());
+        let mut carries = Vec::with_capacity(fetched.len());
+        for (carry, cd) in self.carries.iter().zip(fetched) {
+            let (ohlcv, bits, carry) = carry
+                .advance(&cd.ohlcv, last_date, strategy)
+                .map_err(|reason| stale(format!("{}: {reason}", cd.code)))?;
+            code_data.push(CodeData::new(cd.code.clone(), cd.exchange.clone(), ohlcv));
+            signals.push(bits);
+            carries.push(carry);
+        }
+
+        let timeline = build_unified_timeline(&code_data);
+        let state = backtest::resume_backtest_with_signals(
+            &code_data,
+            &signals,
+            &timeline,
+            strategy,
+            config,
+            self.state,
+            &mut |_, _| {},
+        );
+        Ok(BacktestCheckpoint {
+            fingerprint: self.fingerprint,
+            codes: self.codes,
+            carries,
+            skipped: self.skipped,
+            state,
+        })
+    }
+
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut w = ByteWriter::new();
+        for &b in MAGIC {
+            w.u8(b);
+        }
+        w.u8(VERSION);
+        w.u64(self.fingerprint);
+        w.usize(self.codes.len());
+        for (code, carry) in self.codes.iter().zip(&self.carries) {
+            w.str(code);
+            encode_carry(&mut w, carry);
+        }
+        w.usize(self.skipped.len());
+        for code in &self.skipped {
+            w.str(code);
+        }
+        encode_state(&mut w, &self.state);
+        w.into_bytes()
+    }
+
+    pub fn from_bytes(bytes: &[u8]) -> Result<Self, SamtraderError> {
+        let mut r = ByteReader::new(bytes, "backtest checkpoint");
+        for &b in MAGIC {
+            if r.u8()? != b {
+                return Err(r.error("not a checkpoint file"));
+            }
+        }
+        let version = r.u8()?;
+        if version != VERSION {
+            return Err(r.error(format!("unsupported version {version}")));
+        }
+        let fingerprint = r.u64()?;
+        let code_count = r.count(33)?;
+        let mut codes = Vec::with_capacity(code_count);
+        let mut carries = Vec::with_capacity(code_count);
+        for _ in 0..code_count {
+            codes.push(r.string()?);
+            carries.push(decode_carry(&mut r)?);
+        }
+        let skipped = (0..r.count(8)?)
+            .map(|_| r.string())
+            .collect::<Result<_, _>>()?;
+        let state = decode_state(&mut r, code_count)?;
+        if state.entry_commissions.len() != code_count {
+            return Err(r.error("entry commissions do not match codes"));
+        }
+        let after_last = |&date: &NaiveDate| state.last_date.is_none_or(|last| date > last);
+        if carries.iter().any(|c| c.tail.date.iter().any(after_last)) {
+            return Err(r.error("a code's last bar is after the checkpoint date"));
+        }
+        r.finish()?;
+        Ok(BacktestCheckpoint {
+            fingerprint,
+            codes,
+            carries,
+            skipped,
+            state,
+        })
+    }
+
+    pub fn save(&self, path: &Path) -> Result<(), SamtraderError> {
+        // Write then rename so an interrupted run never leaves a torn file.
+        let mut tmp = path.as_os_str().to_owned();
+        tmp.push(".tmp");
+        let tmp = PathBuf::from(tmp);
+        fs::write(&tmp, self.to_bytes())?;
+        fs::rename(&tmp, path)?;
+        Ok(())
+    }
+
+    pub fn load(path: &Path) -> Result<Self, SamtraderError> {
+        Self::from_bytes(&fs::read(path)?)
+    }
+}
+
+impl CodeCarry {
+    /// Carry before a code's first bar.
+    fn fresh(strategy: &Strategy) -> Self {
+        let (empty, no_indicators) = (OhlcvSeries::new(), IndicatorCache::new());
+        let initial = |rule: &Rule| {
+            CompiledRule::compile(rule, &empty, &no_indicators)
+                .stepper()
+                .state()
+        };
+        let mut indicators: Vec<IndicatorState> = strategy
+            .indicator_types()
+            .iter()
+            .filter_map(IndicatorState::new)
+            .collect();
+        // A stable order, so equal checkpoints encode to equal bytes.
+        indicators.sort_by_cached_key(|state| state.indicator_type().to_string());
+        CodeCarry {
+            tail: OhlcvSeries::new(),
+            indicators,
+            entry: initial(&strategy.entry_long),
+            exit: initial(&strategy.exit_long),
+        }
+    }
+
+    /// Carry after the bars of `cd` dated on or before `last_date`.
+    fn capture(cd: &CodeData, strategy: &Strategy, last_date: Option<NaiveDate>) -> Self {
+        let bars = last_date.map_or(0, |d| cd.ohlcv.date.partition_point(|&bar| bar <= d));
+        let (_, _, carry) = Self::fresh(strategy)
+            .advance(&cd.ohlcv.slice(0, bars), None, strategy)
+            .expect("a fresh carry extends over any history");
+        carry
+    }
+
+    /// Extend this carry over `bars`, the code's bars from its
+    /// `BacktestCheckpoint::fetch_starts` date on. Returns the bars the event
+    /// loop needs (`tail` followed by those after `last_date`), their entry
+    /// and exit signals, and the carry after them.
+    fn advance(
+        &self,
+        bars: &OhlcvSeries,
+        last_date: Option<NaiveDate>,
+        strategy: &Strategy,
+    ) -> Result<(OhlcvSeries, (SignalBits, SignalBits), CodeCarry), String> {
+        let mut expected = strategy.indicator_types();
+        expected.retain(|t| IndicatorState::new(t).is_some());
+        if self.indicators.len() != expected.len()
+            || !self
+                .indicators
+                .iter()
+                .all(|state| expected.contains(state.indicator_type()))
+        {
+            return Err("indicators do not match strategy".into());
+        }
+
+        let new_from = last_date.map_or(0, |d| bars.date.partition_point(|&bar| bar <= d));
+        let from = match self.tail.date.first() {
+            Some(&tail) => bars.date.partition_point(|&bar| bar < tail).min(new_from),
+            None => 0,
+        };
+        if bars.slice(from, new_from) != self.tail {
+            return Err("history before the checkpoint date changed".into());
+        }
+
+        let ohlcv = bars.slice(from, bars.len());
+        let (indicators, carried) = stream_indicators(&self.indicators, &ohlcv);
+        let start = self.tail.len();
+        let (entry_bits, entry) = step_rule(
+            &strategy.entry_long,
+            &ohlcv,
+            &indicators,
+            start,
+            &self.entry,
+        )?;
+        let (exit_bits, exit) =
+            step_rule(&strategy.exit_long, &ohlcv, &indicators, start, &self.exit)?;
+        let carry = CodeCarry {
+            tail: ohlcv.slice(ohlcv.len().saturating_sub(1), ohlcv.len()),
+            indicators: carried,
+            entry,
+            exit,
+        };
+        Ok((ohlcv, (entry_bits, exit_bits), carry))
+    }
+}
+
+/// Push every bar of `ohlcv` through `states`, which are positioned just
+/// before its first bar. Returns the indicator series over `ohlcv` (warmups
+/// counted from its first bar) and the states just before its last bar.
+fn stream_indicators(
+    states: &[IndicatorState],
+    ohlcv: &OhlcvSeries,
+) -> (IndicatorCache, Vec<IndicatorState>) {
+    let last = ohlcv.len().saturating_sub(1);
+    let mut cache = IndicatorCache::new();
+    let mut carried = Vec::with_capacity(states.len());
+    for state in states {
+        let mut state = state.clone();
+        let indicator_type = state.indicator_type().clone();
+        let mut series = IndicatorSeries::new(
+            indicator_type.clone(),
+            state.warmup().saturating_sub(state.bars_seen()),
+            IndicatorColumns::empty_for(&indicator_type),
+        );
+        for i in 0..last {
+            series.columns.push(&state.push_at(ohlcv, i));
+        }
+        carried.push(state.clone());
+        for i in last..ohlcv.len() {
+            series.columns.push(&state.push_at(ohlcv, i));
+        }
+        cache.insert(indicator_type, Arc::new(series));
+    }
+    (cache, carried)
+}
+
+/// Step `rule` over bars `start..` of `ohlcv` from `state`, its carry after
+/// bar `start - 1`. Returns the signals (bars before `start` clear) and the
+/// carry after the last bar.
+fn step_rule(
+    rule: &Rule,
+    ohlcv: &OhlcvSeries,
+    indicators: &IndicatorCache,
+    start: usize,
+    state: &StepperState,
+) -> Result<(SignalBits, StepperState), String> {
+    let compiled = CompiledRule::compile(rule, ohlcv, indicators);
+    let mut stepper = compiled
+        .resume(start, state.clone())
+        .ok_or("rule state does not match strategy")?;
+    let mut bits = SignalBits::new(ohlcv.len());
+    for i in start..ohlcv.len() {
+        bits.set(i, stepper.step() == Some(true));
+    }
+    Ok((bits, stepper.state()))
+}
+
+fn encode_carry(w: &mut ByteWriter, carry: &CodeCarry) {
+    let tail = &carry.tail;
+    w.bool(!tail.is_empty());
+    if !tail.is_empty() {
+        w.date(tail.date[0]);
+        w.f64(tail.open[0]);
+        w.f64(tail.high[0]);
+        w.f64(tail.low[0]);
+        w.f64(tail.close[0]);
+        w.i64(tail.volume[0]);
+    }
+    w.usize(carry.indicators.len());
+    for state in &carry.indicators {
+        w.bytes(&state.to_bytes());
+    }
+    carry.entry.encode(w);
+    carry.exit.encode(w);
+}
+
+fn decode_carry(r: &mut ByteReader) -> Result<CodeCarry, SamtraderError> {
+    let mut tail = OhlcvSeries::new();
+    if r.bool()? {
+        tail.push(r.date()?, r.f64()?, r.f64()?, r.f64()?, r.f64()?, r.i64()?);
+    }
+    let indicators = (0..r.count(8)?)
+        .map(|_| IndicatorState::from_bytes(r.bytes()?))
+        .collect::<Result<_, _>>()?;
+    Ok(CodeCarry {
+        tail,
+        indicators,
+        entry: StepperState::decode(r)?,
+        exit: StepperState::decode(r)?,
+    })
+}
+
+fn encode_state(w: &mut ByteWriter, state: &BacktestState) {
+    let p = &state.portfolio;
+    w.f64(p.cash);
+    w.f64(p.initial_capital);
+
+    w.usize(p.positions.len());
+    for pos in p.positions.values() {
+        w.u32(pos.symbol.0);
+        w.str(&pos.code);
+        w.str(&pos.exchange);
+        w.i64(pos.quantity);
+        w.f64(pos.entry_price);
+        w.date(pos.entry_date);
+        w.f64(pos.stop_loss);
+        w.f64(pos.take_profit);
+    }
+
+    w.usize(p.closed_trades.len());
+    for t in &p.closed_trades {
+        w.str(&t.code);
+        w.str(&t.exchange);
+        w.i64(t.quantity);
+        w.f64(t.entry_price);
+        w.f64(t.exit_price);
+        w.date(t.entry_date);
+        w.date(t.exit_date);
+        w.f64(t.pnl);
+    }
+
+    w.usize(p.equity_curve.len());
+    for point in &p.equity_curve {
+        w.date(point.date);
+        w.f64(point.equity);
+    }
+
+    w.f64s(state.entry_commissions.iter());
+    w.bool(state.last_date.is_some());
+    if let Some(date) = state.last_date {
+        w.date(date);
+    }
+}
+
+fn decode_state(r: &mut ByteReader, code_count: usize) -> Result<BacktestState, SamtraderError> {
+    let mut portfolio = Portfolio::new(0.0);
+    portfolio.cash = r.f64()?;
+    portfolio.initial_capital = r.f64()?;
+
+    for _ in 0..r.count(48)? {
+        let symbol = SymbolId(r.u32()?);
+        if symbol.index() >= code_count {
+            return Err(r.error(format!("position symbol {} out of range", symbol.0)));
+        }
+        portfolio.add_position(Position {
+            symbol,
+            code: r.string()?,
+            exchange: r.string()?,
+            quantity: r.i64()?,
+            entry_price: r.f64()?,
+            entry_date: r.date()?,
+            stop_loss: r.f64()?,
+            take_profit: r.f64()?,
+        });
+    }
+
+    for _ in 0..r.count(56)? {
+        portfolio.record_trade(ClosedTrade {
+            code: r.string()?,
+            exchange: r.string()?,
+            quantity: r.i64()?,
+            entry_price: r.f64()?,
+            exit_price: r.f64()?,
+            entry_date: r.date()?,
+            exit_date: r.date()?,
+            pnl: r.f64()?,
+        });
+    }
+
+    let points = r.count(12)?;
+    portfolio.equity_curve = (0..points)
+        .map(|_| {
+            Ok(EquityPoint {
+                date: r.date()?,
+                equity: r.f64()?,
+            })
+        })
+        .collect::<Result<_, SamtraderError>>()?;
+
+    let entry_commissions = r.f64s()?;
+    let last_date = if r.bool()? { Some(r.date()?) } else { None };
+
+    Ok(BacktestState {
+        portfolio,
+        entry_commissions,
+        last_date,
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::domain::backtest::{resume_backtest, run_backtest};
+    use crate::domain::indicator_helpers::compute_indicators;
+    use crate::domain::ohlcv::OhlcvBar;
+    use crate::domain::rule_parser::parse;
+
+    fn config() -> BacktestConfig {
+        BacktestConfig {
+            start_date: NaiveDate::from_ymd_opt(2020, 1, 1).unwrap(),
+            end_date: NaiveDate::from_ymd_opt(2024, 12, 31).unwrap(),
+            initial_capital: 100_000.0,
+            commission_per_trade: 9.95,
+            commission_pct: 0.1,
+            slippage_pct: 0.05,
+            allow_shorting: false,
+            risk_free_rate: 0.05,
+            workers: 1,
+        }
+    }
+
+    /// Indicators with warmups, a cross and both temporal operators, so the
+    /// resumed run depends on every kind of carried state.
+    fn strategy() -> Strategy {
+        Strategy {
+            name: "Swing".into(),
+            description: String::new(),
+            entry_long: parse("AND(CROSS_ABOVE(close, SMA(5)), ANY_OF(ABOVE(RSI(7), 45), 3))")
+                .unwrap(),
+            exit_long: parse(
+                "OR(CONSECUTIVE(BELOW(close, EMA(4)), 2), ABOVE(close, BOLLINGER_UPPER(10, 2)))",
+            )
+            .unwrap(),
+            entry_short: None,
+            exit_short: None,
+            position_size: 0.3,
+            stop_loss_pct: 4.0,
+            take_profit_pct: 0.0,
+            max_positions: 2,
+        }
+    }
+
+    fn codes() -> Vec<String> {
+        vec!["BHP".into(), "CBA".into()]
+    }
+
+    /// `n` daily bars oscillating around 100 so trades open and close.
+    fn code_data(code: &str, n: usize, phase: f64) -> CodeData {
+        let start = NaiveDate::from_ymd_opt(2024, 1, 1).unwrap();
+        let bars: Vec<OhlcvBar> = (0..n)
+            .map(|i| {
+                let close = 100.0 + 6.0 * (i as f64 * 0.4 + phase).sin() + (i % 3) as f64;
+                OhlcvBar {
+                    code: code.into(),
+                    exchange: "ASX".into(),
+                    date: start + chrono::Duration::days(i as i64),
+                    open: close,
+                    high: close + 1.0,
+                    low: close - 1.0,
+                    close,
+                    volume: 1000,
+                }
+            })
+            .collect();
+        let mut cd = CodeData::new(code.into(), "ASX".into(), bars);
+        cd.indicators = compute_indicators(&cd.ohlcv, &strategy().indicator_types());
+        cd
+    }
+
+    fn universe(n: usize) -> Vec<CodeData> {
+        vec![code_data("BHP", n, 0.0), code_data("CBA", n, 1.3)]
+    }
+
+    /// What `BacktestCheckpoint::fetch` returns: each code's bars from its
+    /// own start on.
+    fn fetch_from(data: &[CodeData], starts: &[NaiveDate]) -> Vec<CodeData> {
+        data.iter()
+            .zip(starts)
+            .map(|(cd, &start)| {
+                let bars = cd.ohlcv.date_range(start, config().end_date);
+                CodeData::new(cd.code.clone(), cd.exchange.clone(), bars)
+            })
+            .collect()
+    }
+
+    fn full_run(data: &[CodeData]) -> BacktestCheckpoint {
+        let (strategy, config) = (strategy(), config());
+        let state = resume_backtest(
+            data,
+            &build_unified_timeline(data),
+            &strategy,
+            &config,
+            BacktestState::new(config.initial_capital, data.len()),
+        );
+        BacktestCheckpoint::capture(&codes(), "ASX", data, &strategy, &config, &state)
+    }
+
+    #[test]
+    fn resumed_run_matches_full_replay() {
+        let (strategy, config) = (strategy(), config());
+
+        // Yesterday: 60 days of history, checkpoint saved through bytes.
+        let bytes = full_run(&universe(60)).to_bytes();
+
+        // Today: 25 new days; only they and each code's last bar are read.
+        let mut checkpoint = BacktestCheckpoint::from_bytes(&bytes).unwrap();
+        for n in [85, 86, 120] {
+            let after = universe(n);
+            checkpoint
+                .check(&codes(), "ASX", &strategy, &config)
+                .unwrap();
+            let fetched = fetch_from(&after, &checkpoint.fetch_starts(&config));
+            let new_bars = n - checkpoint.state.portfolio.equity_curve.len();
+            assert!(fetched.iter().all(|cd| cd.bar_count() == new_bars + 1));
+            checkpoint = checkpoint.resume(&fetched, &strategy, &config).unwrap();
+
+            let full = run_backtest(&after, &build_unified_timeline(&after), &strategy, &config);
+            assert!(!full.portfolio.closed_trades.is_empty());
+            assert_eq!(checkpoint.state.portfolio, full.portfolio, "after {n} days");
+            assert_eq!(checkpoint.to_bytes(), full_run(&after).to_bytes());
+        }
+    }
+
+    #[test]
+    fn delisted_code_is_fetched_from_its_own_last_bar() {
+        let (strategy, config) = (strategy(), config());
+        // CBA stops trading after 40 days; BHP carries on.
+        let at = |n| vec![code_data("BHP", n, 0.0), code_data("CBA", 40, 1.3)];
+        let checkpoint = full_run(&at(60));
+
+        let starts = checkpoint.fetch_starts(&config);
+        assert_eq!(
+            starts,
+            vec![at(60)[0].ohlcv.date[59], at(60)[1].ohlcv.date[39]]
+        );
+
+        let after = at(85);
+        let fetched = fetch_from(&after, &starts);
+        assert_eq!(fetched[0].bar_count(), 26);
+        assert_eq!(fetched[1].bar_count(), 1);
+        let resumed = checkpoint.resume(&fetched, &strategy, &config).unwrap();
+        assert_eq!(resumed.to_bytes(), full_run(&after).to_bytes());
+    }
+
+    #[test]
+    fn skipped_codes_are_recorded() {
+        let (strategy, config) = (strategy(), config());
+        let requested = vec!["BHP".into(), "NEW".into(), "CBA".into()];
+        let data = universe(40);
+        let state = resume_backtest(
+            &data,
+            &build_unified_timeline(&data),
+            &strategy,
+            &config,
+            BacktestState::new(config.initial_capital, data.len()),
+        );
+        let checkpoint =
+            BacktestCheckpoint::capture(&requested, "ASX", &data, &strategy, &config, &state);
+
+        let loaded = BacktestCheckpoint::from_bytes(&checkpoint.to_bytes()).unwrap();
+        assert_eq!(loaded.codes, codes());
+        assert_eq!(loaded.skipped, vec!["NEW".to_string()]);
+    }
+
+    #[test]
+    fn stale_checkpoints_are_rejected() {
+        let (strategy, config) = (strategy(), config());
+        let checkpoint = full_run(&universe(40));
+        let check = |codes: &[String], strategy: &Strategy, config: &BacktestConfig| {
+            checkpoint.check(codes, "ASX", strategy, config)
+        };
+        assert!(check(&codes(), &strategy, &config).is_ok());
+
+        let mut changed = strategy.clone();
+        changed.position_size = 0.5;
+        assert!(check(&codes(), &changed, &config).is_err());
+        assert!(check(&codes()[..1], &strategy, &config).is_err());
+        assert!(
+            checkpoint
+                .check(&codes(), "NZX", &strategy, &config)
+                .is_err()
+        );
+
+        let mut renamed = strategy.clone();
+        renamed.name = "Renamed".into();
+        renamed.description = "Same rules".into();
+        assert!(check(&codes(), &renamed, &config).is_ok());
+
+        let mut later = config.clone();
+        later.end_date = NaiveDate::from_ymd_opt(2025, 6, 30).unwrap();
+        assert!(check(&codes(), &strategy, &later).is_ok());
+
+        let mut earlier = config.clone();
+        earlier.end_date = NaiveDate::from_ymd_opt(2024, 1, 20).unwrap();
+        assert!(check(&codes(), &strategy, &earlier).is_err());
+    }
+
+    #[test]
+    fn changed_history_is_rejected_on_resume() {
+        let (strategy, config) = (strategy(), config());
+        let checkpoint = full_run(&universe(40));
+        let starts = checkpoint.fetch_starts(&config);
+        let resume = |fetched: &[CodeData]| {
+            checkpoint
+                .clone()
+                .resume(fetched, &strategy, &config)
+                .is_ok()
+        };
+        assert!(resume(&fetch_from(&universe(50), &starts)));
+
+        // The last bar before the checkpoint was restated.
+        let mut restated = fetch_from(&universe(50), &starts);
+        restated[1].ohlcv.close[0] += 0.5;
+        assert!(!resume(&restated));
+
+        // A bar back-filled between the last bar and the checkpoint date.
+        let mut gappy = universe(50);
+        let last = checkpoint.state.last_date.unwrap();
+        let kept: Vec<usize> = (0..50)
+            .filter(|&i| gappy[0].ohlcv.date[i] != last)
+            .collect();
+        let mut bhp = OhlcvSeries::new();
+        for &i in &kept {
+            bhp.push_bar(&gappy[0].ohlcv.bar(i, "BHP", "ASX"));
+        }
+        gappy[0] = CodeData::new("BHP".into(), "ASX".into(), bhp);
+        let short = full_run(&[gappy[0].clone(), universe(40)[1].clone()]);
+        let backfilled = fetch_from(&universe(50), &short.fetch_starts(&config));
+        assert!(short.resume(&backfilled, &strategy, &config).is_err());
+
+        // Codes out of order.
+        let mut swapped = fetch_from(&universe(50), &starts);
+        swapped.swap(0, 1);
+        assert!(!resume(&swapped));
+    }
+
+    #[test]
+    fn corrupt_files_are_rejected() {
+        let checkpoint = full_run(&universe(30));
+        let bytes = checkpoint.to_bytes();
+
+        assert_eq!(
+            BacktestCheckpoint::from_bytes(&bytes).unwrap().to_bytes(),
+            bytes
+        );
+        assert!(BacktestCheckpoint::from_bytes(&bytes[..bytes.len() - 1]).is_err());
+        assert!(BacktestCheckpoint::from_bytes(b"nope").is_err());
+
+        // A position on a code the checkpoint does not list.
+        let mut stray = checkpoint.clone();
+        stray.state.portfolio.add_position(Position {
+            symbol: SymbolId(2),
+            code: "WES".into(),
+            exchange: "ASX".into(),
+            quantity: 10,
+            entry_price: 100.0,
+            entry_date: NaiveDate::from_ymd_opt(2024, 1, 2).unwrap(),
+            stop_loss: 0.0,
+            take_profit: 0.0,
+        });
+        assert!(BacktestCheckpoint::from_bytes(&stray.to_bytes()).is_err());
+
+        // A code's last bar after the checkpoint date.
+        let mut ahead = checkpoint;
+        ahead.state.last_date = NaiveDate::from_ymd_opt(2024, 1, 5);
+        assert!(BacktestCheckpoint::from_bytes(&ahead.to_bytes()).is_err());
+    }
+
+    #[test]
+    fn save_and_load_next_to_report() {
+        let dir = tempfile::TempDir::new().unwrap();
+        let path = checkpoint_path(&dir.path().join("report.typ"));
+        assert!(path.ends_with("report.typ.ckpt"));
+
+        let checkpoint = full_run(&universe(5));
+        checkpoint.save(&path).unwrap();
+
+        let loaded = BacktestCheckpoint::load(&path).unwrap();
+        assert_eq!(loaded.to_bytes(), checkpoint.to_bytes());
+    }
+}
@@ -1,7 +1,7 @@
 //! CodeData struct and unified timeline (TRD Section 8.1/8.2).
 
-use crate::domain::indicator::{IndicatorSeries, IndicatorType};
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::indicator_helpers::IndicatorCache;
+use crate::domain::ohlcv::OhlcvSeries;
 use chrono::NaiveDate;
 use std::collections::{BTreeSet, HashMap};
 
@@ -9,23 +9,25 @@ use std::collections::{BTreeSet, HashMap};
 pub struct CodeData {
     pub code: String,
     pub exchange: String,
-    pub ohlcv: Vec<OhlcvBar>,
-    pub indicators: HashMap<IndicatorType, IndicatorSeries>,
+    pub ohlcv: OhlcvSeries,
+    pub indicators: IndicatorCache,
     pub date_index: HashMap<NaiveDate, usize>,
 }
 
 impl CodeData {
-    pub fn new(code: String, exchange: String, ohlcv: Vec<OhlcvBar>) -> Self {
+    pub fn new(code: String, exchange: String, ohlcv: impl Into<OhlcvSeries>) -> Self {
+        let ohlcv = ohlcv.into();
         let date_index = ohlcv
+            .date
             .iter()
             .enumerate()
-            .map(|(i, bar)| (bar.date, i))
+            .map(|(i, &date)| (date, i))
             .collect();
         Self {
             code,
             exchange,
             ohlcv,
-            indicators: HashMap::new(),
+            indicators: IndicatorCache::new(),
             date_index,
         }
     }
@@ -34,8 +36,8 @@ impl CodeData {
         self.ohlcv.len()
     }
 
-    pub fn get_bar(&self, date: NaiveDate) -> Option<&OhlcvBar> {
-        self.date_index.get(&date).map(|&i| &self.ohlcv[i])
+    pub fn get_close(&self, date: NaiveDate) -> Option<f64> {
+        self.date_index.get(&date).map(|&i| self.ohlcv.close[i])
     }
 
     pub fn get_bar_index(&self, date: NaiveDate) -> Option<usize> {
@@ -43,17 +45,93 @@ impl CodeData {
     }
 }
 
-pub fn build_unified_timeline(codes: &[CodeData]) -> Vec<NaiveDate> {
+/// Unified multi-code timeline (TRD Section 8.2) with every code's bars
+/// aligned to it.
+///
+/// `bar_index(c, t)` answers "which bar of `code_data[c]` falls on
+/// `dates[t]`" with plain integer indexing, so the event loop never hashes a
+/// date. The alignment is tied to the `code_data` slice (and its order) the
+/// timeline was built from.
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct Timeline {
+    dates: Vec<NaiveDate>,
+    alignment: Vec<Vec<Option<u32>>>,
+}
+
+impl Timeline {
+    /// Align `codes` to an explicit, ascending list of dates.
+    pub fn new(codes: &[CodeData], dates: Vec<NaiveDate>) -> Self {
+        let alignment = codes.iter().map(|cd| align_code(cd, &dates)).collect();
+        Self { dates, alignment }
+    }
+
+    pub fn dates(&self) -> &[NaiveDate] {
+        &self.dates
+    }
+
+    pub fn len(&self) -> usize {
+        self.dates.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.dates.is_empty()
+    }
+
+    /// Number of codes aligned to this timeline.
+    pub fn code_count(&self) -> usize {
+        self.alignment.len()
+    }
+
+    /// Bar index of code `code_pos` on timeline position `t`, if it traded.
+    pub fn bar_index(&self, code_pos: usize, t: usize) -> Option<usize> {
+        self.alignment[code_pos][t].map(|i| i as usize)
+    }
+}
+
+impl std::ops::Index<usize> for Timeline {
+    type Output = NaiveDate;
+
+    fn index(&self, t: usize) -> &NaiveDate {
+        &self.dates[t]
+    }
+}
+
+/// Map each timeline date to the code's bar index. Bars from the data
+/// adapters are date-ordered, so this is a single merge walk; unordered
+/// series fall back to the per-date hash index.
+fn align_code(cd: &CodeData, dates: &[NaiveDate]) -> Vec<Option<u32>> {
+    let bar_dates = &cd.ohlcv.date;
+    if !bar_dates.windows(2).all(|w| w[0] < w[1]) {
+        return dates
+            .iter()
+            .map(|d| cd.get_bar_index(*d).map(|i| i as u32))
+            .collect();
+    }
+
+    let mut cursor = 0;
+    dates
+        .iter()
+        .map(|&date| {
+            while cursor < bar_dates.len() && bar_dates[cursor] < date {
+                cursor += 1;
+            }
+            (cursor < bar_dates.len() && bar_dates[cursor] == date).then_some(cursor as u32)
+        })
+        .collect()
+}
+
+pub fn build_unified_timeline(codes: &[CodeData]) -> Timeline {
     let unique_dates: BTreeSet<NaiveDate> = codes
         .iter()
-        .flat_map(|cd| cd.ohlcv.iter().map(|bar| bar.date))
+        .flat_map(|cd| cd.ohlcv.date.iter().copied())
         .collect();
-    unique_dates.into_iter().collect()
+    Timeline::new(codes, unique_dates.into_iter().collect())
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::ohlcv::OhlcvBar;
 
     fn make_bar(code: &str, date: &str, close: f64) -> OhlcvBar {
         OhlcvBar {
@@ -96,19 +174,19 @@ mod tests {
     }
 
     #[test]
-    fn code_data_get_bar() {
+    fn code_data_get_close() {
         let bars = vec![
             make_bar("BHP", "2024-01-01", 100.0),
             make_bar("BHP", "2024-01-02", 101.0),
         ];
         let cd = CodeData::new("BHP".into(), "ASX".into(), bars);
 
-        let bar = cd.get_bar(NaiveDate::from_ymd_opt(2024, 1, 2).unwrap());
-        assert!(bar.is_some());
-        assert!((bar.unwrap().close - 101.0).abs() < f64::EPSILON);
+        let close = cd.get_close(NaiveDate::from_ymd_opt(2024, 1, 2).unwrap());
+        assert!(close.is_some());
+        assert!((close.unwrap() - 101.0).abs() < f64::EPSILON);
 
         assert!(
-            cd.get_bar(NaiveDate::from_ymd_opt(2024, 1, 5).unwrap())
+            cd.get_close(NaiveDate::from_ymd_opt(2024, 1, 5).unwrap())
                 .is_none()
         );
     }
@@ -164,4 +242,58 @@ mod tests {
         assert_eq!(timeline[0], NaiveDate::from_ymd_opt(2024, 1, 1).unwrap());
         assert_eq!(timeline[1], NaiveDate::from_ymd_opt(2024, 1, 3).unwrap());
     }
+
+    #[test]
+    fn unified_timeline_aligns_bar_indices() {
+        let bhp = CodeData::new(
+            "BHP".into(),
+            "ASX".into(),
+            vec![
+                make_bar("BHP", "2024-01-02", 100.0),
+                make_bar("BHP", "2024-01-05", 101.0),
+            ],
+        );
+        let rio = CodeData::new(
+            "RIO".into(),
+            "ASX".into(),
+            vec![
+                make_bar("RIO", "2024-01-03", 51.0),
+                make_bar("RIO", "2024-01-01", 50.0),
+            ],
+        );
+
+        let timeline = build_unified_timeline(&[bhp, rio]);
+
+        assert_eq!(timeline.code_count(), 2);
+        let bhp_bars: Vec<_> = (0..timeline.len())
+            .map(|t| timeline.bar_index(0, t))
+            .collect();
+        let rio_bars: Vec<_> = (0..timeline.len())
+            .map(|t| timeline.bar_index(1, t))
+            .collect();
+        assert_eq!(bhp_bars, vec![None, Some(0), None, Some(1)]);
+        assert_eq!(rio_bars, vec![Some(1), None, Some(0), None]);
+    }
+
+    #[test]
+    fn timeline_new_aligns_explicit_dates() {
+        let bhp = CodeData::new(
+            "BHP".into(),
+            "ASX".into(),
+            vec![
+                make_bar("BHP", "2024-01-01", 100.0),
+                make_bar("BHP", "2024-01-02", 101.0),
+                make_bar("BHP", "2024-01-03", 102.0),
+            ],
+        );
+        let dates = vec![
+            NaiveDate::from_ymd_opt(2024, 1, 2).unwrap(),
+            NaiveDate::from_ymd_opt(2024, 1, 4).unwrap(),
+        ];
+
+        let timeline = Timeline::new(&[bhp], dates);
+
+        assert_eq!(timeline.bar_index(0, 0), Some(1));
+        assert_eq!(timeline.bar_index(0, 1), None);
+    }
 }
@@ -0,0 +1,247 @@
+//! Compact binary encoding for persisted domain state.
+//!
+//! Streaming indicator states are saved between runs and must come back
+//! bit-for-bit, so floats are stored as their raw IEEE-754 bits rather than
+//! as text. All integers are little-endian; `usize` is widened to `u64`.
+//! Variable-length sequences are prefixed with their length; dates are
+//! stored as days from the common era.
+
+use crate::domain::error::SamtraderError;
+use chrono::{Datelike, NaiveDate};
+
+/// Append-only byte buffer.
+#[derive(Debug, Default)]
+pub struct ByteWriter {
+    buf: Vec<u8>,
+}
+
+impl ByteWriter {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn u8(&mut self, v: u8) {
+        self.buf.push(v);
+    }
+
+    pub fn u32(&mut self, v: u32) {
+        self.buf.extend_from_slice(&v.to_le_bytes());
+    }
+
+    pub fn u64(&mut self, v: u64) {
+        self.buf.extend_from_slice(&v.to_le_bytes());
+    }
+
+    pub fn i64(&mut self, v: i64) {
+        self.buf.extend_from_slice(&v.to_le_bytes());
+    }
+
+    pub fn usize(&mut self, v: usize) {
+        self.u64(v as u64);
+    }
+
+    pub fn bool(&mut self, v: bool) {
+        self.u8(v as u8);
+    }
+
+    pub fn f64(&mut self, v: f64) {
+        self.u64(v.to_bits());
+    }
+
+    /// Length-prefixed UTF-8 string.
+    pub fn str(&mut self, v: &str) {
+        self.usize(v.len());
+        self.buf.extend_from_slice(v.as_bytes());
+    }
+
+    /// Length-prefixed byte string, e.g. a nested encoding.
+    pub fn bytes(&mut self, v: &[u8]) {
+        self.usize(v.len());
+        self.buf.extend_from_slice(v);
+    }
+
+    pub fn date(&mut self, v: NaiveDate) {
+        let days = v.num_days_from_ce();
+        self.buf.extend_from_slice(&days.to_le_bytes());
+    }
+
+    /// Length-prefixed run of floats.
+    pub fn f64s<'a>(&mut self, values: impl ExactSizeIterator<Item = &'a f64>) {
+        self.usize(values.len());
+        for &v in values {
+            self.f64(v);
+        }
+    }
+
+    pub fn into_bytes(self) -> Vec<u8> {
+        self.buf
+    }
+}
+
+/// Cursor over bytes written by `ByteWriter`. Every read fails with
+/// `SamtraderError::Decode` instead of panicking on short or bad input.
+#[derive(Debug)]
+pub struct ByteReader<'a> {
+    bytes: &'a [u8],
+    pos: usize,
+    what: &'static str,
+}
+
+impl<'a> ByteReader<'a> {
+    /// `what` names the payload in error messages ("indicator state").
+    pub fn new(bytes: &'a [u8], what: &'static str) -> Self {
+        ByteReader {
+            bytes,
+            pos: 0,
+            what,
+        }
+    }
+
+    /// A `Decode` error for this payload.
+    pub fn error(&self, reason: impl Into<String>) -> SamtraderError {
+        SamtraderError::Decode {
+            what: self.what.to_string(),
+            reason: reason.into(),
+        }
+    }
+
+    fn take<const N: usize>(&mut self) -> Result<[u8; N], SamtraderError> {
+        let end = self.pos + N;
+        let chunk = self
+            .bytes
+            .get(self.pos..end)
+            .ok_or_else(|| self.error(format!("truncated at byte {}", self.pos)))?;
+        self.pos = end;
+        Ok(chunk.try_into().expect("chunk has length N"))
+    }
+
+    pub fn u8(&mut self) -> Result<u8, SamtraderError> {
+        Ok(self.take::<1>()?[0])
+    }
+
+    pub fn u32(&mut self) -> Result<u32, SamtraderError> {
+        Ok(u32::from_le_bytes(self.take()?))
+    }
+
+    pub fn u64(&mut self) -> Result<u64, SamtraderError> {
+        Ok(u64::from_le_bytes(self.take()?))
+    }
+
+    pub fn i64(&mut self) -> Result<i64, SamtraderError> {
+        Ok(i64::from_le_bytes(self.take()?))
+    }
+
+    pub fn usize(&mut self) -> Result<usize, SamtraderError> {
+        let v = self.u64()?;
+        usize::try_from(v).map_err(|_| self.error(format!("length {v} out of range")))
+    }
+
+    pub fn bool(&mut self) -> Result<bool, SamtraderError> {
+        match self.u8()? {
+            0 => Ok(false),
+            1 => Ok(true),
+            b => Err(self.error(format!("invalid bool byte {b}"))),
+        }
+    }
+
+    pub fn f64(&mut self) -> Result<f64, SamtraderError> {
+        Ok(f64::from_bits(self.u64()?))
+    }
+
+    pub fn string(&mut self) -> Result<String, SamtraderError> {
+        let bytes = self.bytes()?;
+        String::from_utf8(bytes.to_vec()).map_err(|_| self.error("string is not UTF-8"))
+    }
+
+    /// A byte string written by `ByteWriter::bytes`, borrowed from the input.
+    pub fn bytes(&mut self) -> Result<&'a [u8], SamtraderError> {
+        let len = self.usize()?;
+        let bytes = self
+            .bytes
+            .get(self.pos..self.pos.saturating_add(len))
+            .ok_or_else(|| self.error(format!("truncated at byte {}", self.pos)))?;
+        self.pos += len;
+        Ok(bytes)
+    }
+
+    pub fn date(&mut self) -> Result<NaiveDate, SamtraderError> {
+        let days = i32::from_le_bytes(self.take()?);
+        NaiveDate::from_num_days_from_ce_opt(days)
+            .ok_or_else(|| self.error(format!("day {days} out of range")))
+    }
+
+    /// A length prefix for a sequence whose elements take at least
+    /// `min_size` bytes each, rejected up front if the input cannot hold it.
+    pub fn count(&mut self, min_size: usize) -> Result<usize, SamtraderError> {
+        let len = self.usize()?;
+        if len > (self.bytes.len() - self.pos) / min_size.max(1) {
+            return Err(self.error(format!("length {len} exceeds remaining input")));
+        }
+        Ok(len)
+    }
+
+    pub fn f64s(&mut self) -> Result<Vec<f64>, SamtraderError> {
+        let len = self.count(8)?;
+        (0..len).map(|_| self.f64()).collect()
+    }
+
+    /// Succeeds only if every byte was consumed.
+    pub fn finish(self) -> Result<(), SamtraderError> {
+        if self.pos == self.bytes.len() {
+            Ok(())
+        } else {
+            Err(self.error(format!("{} trailing bytes", self.bytes.len() - self.pos)))
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn round_trips_values_bit_exact() {
+        let mut w = ByteWriter::new();
+        w.u8(7);
+        w.usize(123_456);
+        w.bool(true);
+        w.f64(-0.0);
+        w.i64(-42);
+        w.str("BHP.AX");
+        w.bytes(&[1, 2, 3]);
+        w.date(NaiveDate::from_ymd_opt(2024, 2, 29).unwrap());
+        w.f64s([0.1, f64::MAX, f64::MIN_POSITIVE].iter());
+        let bytes = w.into_bytes();
+
+        let mut r = ByteReader::new(&bytes, "test");
+        assert_eq!(r.u8().unwrap(), 7);
+        assert_eq!(r.usize().unwrap(), 123_456);
+        assert!(r.bool().unwrap());
+        assert_eq!(r.f64().unwrap().to_bits(), (-0.0f64).to_bits());
+        assert_eq!(r.i64().unwrap(), -42);
+        assert_eq!(r.string().unwrap(), "BHP.AX");
+        assert_eq!(r.bytes().unwrap(), [1, 2, 3]);
+        assert_eq!(
+            r.date().unwrap(),
+            NaiveDate::from_ymd_opt(2024, 2, 29).unwrap()
+        );
+        assert_eq!(r.f64s().unwrap(), [0.1, f64::MAX, f64::MIN_POSITIVE]);
+        r.finish().unwrap();
+    }
+
+    #[test]
+    fn short_and_trailing_input_are_errors() {
+        let mut r = ByteReader::new(&[1, 2, 3], "test");
+        assert!(matches!(r.u64(), Err(SamtraderError::Decode { .. })));
+
+        let mut r = ByteReader::new(&[0, 0], "test");
+        r.u8().unwrap();
+        assert!(r.finish().is_err());
+
+        // A huge length prefix is rejected without allocating.
+        let mut w = ByteWriter::new();
+        w.u64(u64::MAX / 16);
+        let bytes = w.into_bytes();
+        assert!(ByteReader::new(&bytes, "test").f64s().is_err());
+    }
+}
@@ -12,6 +12,7 @@ pub fn validate_backtest_config(config: &dyn ConfigPort) -> Result<(), Samtrader
     validate_commission(config)?;
     validate_slippage(config)?;
     validate_risk_free_rate(config)?;
+    validate_workers(config)?;
     validate_dates(config)?;
     validate_exchange(config)?;
     validate_codes(config)?;
@@ -93,6 +94,18 @@ fn validate_risk_free_rate(config: &dyn ConfigPort) -> Result<(), SamtraderError
     Ok(())
 }
 
+fn validate_workers(config: &dyn ConfigPort) -> Result<(), SamtraderError> {
+    let value = config.get_int("backtest", "workers", 0);
+    if value < 0 {
+        return Err(SamtraderError::ConfigInvalid {
+            section: "backtest".to_string(),
+            key: "workers".to_string(),
+            reason: "workers must be non-negative (0 = all cores)".to_string(),
+        });
+    }
+    Ok(())
+}
+
 fn validate_dates(config: &dyn ConfigPort) -> Result<(), SamtraderError> {
     let start_str = config.get_string("backtest", "start_date");
     let end_str = config.get_string("backtest", "end_date");
@@ -334,6 +347,13 @@ code = CBA
         );
     }
 
+    #[test]
+    fn workers_negative_fails() {
+        let config = make_backtest_config("[backtest]\ninitial_capital = 100\nworkers = -2\nstart_date = 2020-01-01\nend_date = 2024-12-31\nexchange = ASX\ncode = CBA\n");
+        let err = validate_backtest_config(&config).unwrap_err();
+        assert!(matches!(err, SamtraderError::ConfigInvalid { key, .. } if key == "workers"));
+    }
+
     #[test]
     fn invalid_start_date_format_fails() {
         let config = make_backtest_config("[backtest]\ninitial_capital = 100\nstart_date = 2020/01/01\nend_date = 2024-12-31\nexchange = ASX\ncode = CBA\n");
@@ -62,12 +62,15 @@ pub enum SamtraderError {
 
     #[error(transparent)]
     Io(#[from] std::io::Error),
+
+    #[error("invalid {what} data: {reason}")]
+    Decode { what: String, reason: String },
 }
 
 impl From<&SamtraderError> for std::process::ExitCode {
     fn from(err: &SamtraderError) -> Self {
         let code: u8 = match err {
-            SamtraderError::Io(_) => 1,
+            SamtraderError::Io(_) | SamtraderError::Decode { .. } => 1,
             SamtraderError::ConfigParse { .. }
             | SamtraderError::ConfigMissing { .. }
             | SamtraderError::ConfigInvalid { .. } => 2,
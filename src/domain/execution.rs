@@ -4,10 +4,10 @@
 //! and stop-loss/take-profit trigger checking.
 
 use chrono::NaiveDate;
-use std::collections::HashMap;
 
 use super::portfolio::Portfolio;
 use super::position::{ClosedTrade, Position};
+use super::symbol::SymbolId;
 
 /// Configuration for backtest execution parameters.
 #[derive(Debug, Clone, PartialEq)]
@@ -101,6 +101,7 @@ pub enum EntryResult {
 /// 8. Add position to portfolio
 pub fn enter_long(
     portfolio: &mut Portfolio,
+    symbol: SymbolId,
     code: &str,
     exchange: &str,
     market_price: f64,
@@ -140,6 +141,7 @@ pub fn enter_long(
     };
 
     let position = Position {
+        symbol,
         code: code.to_string(),
         exchange: exchange.to_string(),
         quantity,
@@ -170,6 +172,7 @@ pub fn enter_long(
 /// 6. Add position with negative quantity
 pub fn enter_short(
     portfolio: &mut Portfolio,
+    symbol: SymbolId,
     code: &str,
     exchange: &str,
     market_price: f64,
@@ -213,6 +216,7 @@ pub fn enter_short(
     };
 
     let position = Position {
+        symbol,
         code: code.to_string(),
         exchange: exchange.to_string(),
         quantity: -quantity,
@@ -255,13 +259,13 @@ pub struct ExitResult {
 /// 7. Remove position from portfolio
 pub fn exit_position(
     portfolio: &mut Portfolio,
-    code: &str,
+    symbol: SymbolId,
     market_price: f64,
     exit_date: NaiveDate,
     entry_commission: f64,
     config: &ExecutionConfig,
 ) -> Option<ExitResult> {
-    let position = portfolio.remove_position(code)?;
+    let position = portfolio.remove_position(symbol)?;
 
     let exit_price = if position.is_long() {
         apply_slippage_long_exit(market_price, config.slippage_pct)
@@ -312,36 +316,41 @@ pub fn exit_position(
 /// Check stop-loss and take-profit triggers.
 ///
 /// Two-pass approach per TRD §9.3:
-/// 1. First collect all triggered codes
+/// 1. First collect all triggered symbols
 /// 2. Then exit each triggered position
 ///
+/// `prices` and `entry_commissions` are indexed by `SymbolId`; a `None`
+/// price means the code has no bar today and cannot trigger.
+///
 /// Returns the number of positions exited.
 pub fn check_triggers(
     portfolio: &mut Portfolio,
-    price_map: &HashMap<String, f64>,
+    prices: &[Option<f64>],
     date: NaiveDate,
-    entry_commissions: &HashMap<String, f64>,
+    entry_commissions: &[f64],
     config: &ExecutionConfig,
 ) -> usize {
-    let triggered_codes: Vec<String> = portfolio
+    let triggered: Vec<(SymbolId, f64)> = portfolio
         .positions
         .values()
         .filter_map(|pos| {
-            let price = price_map.get(&pos.code)?;
-            if pos.should_stop_loss(*price) || pos.should_take_profit(*price) {
-                Some(pos.code.clone())
+            let price = prices.get(pos.symbol.index()).copied().flatten()?;
+            if pos.should_stop_loss(price) || pos.should_take_profit(price) {
+                Some((pos.symbol, price))
             } else {
                 None
             }
         })
         .collect();
 
-    let count = triggered_codes.len();
+    let count = triggered.len();
 
-    for code in triggered_codes {
-        let price = price_map.get(&code).copied().unwrap_or(0.0);
-        let entry_commission = entry_commissions.get(&code).copied().unwrap_or(0.0);
-        exit_position(portfolio, &code, price, date, entry_commission, config);
+    for (symbol, price) in triggered {
+        let entry_commission = entry_commissions
+            .get(symbol.index())
+            .copied()
+            .unwrap_or(0.0);
+        exit_position(portfolio, symbol, price, date, entry_commission, config);
     }
 
     count
@@ -351,6 +360,10 @@ pub fn check_triggers(
 mod tests {
     use super::*;
 
+    const BHP: SymbolId = SymbolId(0);
+    const CBA: SymbolId = SymbolId(1);
+    const XYZ: SymbolId = SymbolId(2);
+
     fn make_portfolio(cash: f64) -> Portfolio {
         Portfolio::new(cash)
     }
@@ -447,6 +460,7 @@ mod tests {
 
         let result = enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -470,8 +484,8 @@ mod tests {
                 let expected_commission = 10.0 + (cost * 0.1 / 100.0);
                 assert!((commission - expected_commission).abs() < f64::EPSILON);
 
-                assert!(portfolio.has_position("BHP"));
-                let pos = portfolio.get_position("BHP").unwrap();
+                assert!(portfolio.has_position(BHP));
+                let pos = portfolio.get_position(BHP).unwrap();
                 assert!(pos.is_long());
                 assert!((pos.entry_price - expected_price).abs() < f64::EPSILON);
                 assert!(pos.stop_loss > 0.0);
@@ -489,6 +503,7 @@ mod tests {
 
         let result = enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -498,7 +513,7 @@ mod tests {
         );
 
         assert!(matches!(result, EntryResult::InsufficientCapital));
-        assert!(!portfolio.has_position("BHP"));
+        assert!(!portfolio.has_position(BHP));
     }
 
     #[test]
@@ -513,6 +528,7 @@ mod tests {
 
         enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -521,7 +537,7 @@ mod tests {
             &config,
         );
 
-        let pos = portfolio.get_position("BHP").unwrap();
+        let pos = portfolio.get_position(BHP).unwrap();
         assert!((pos.stop_loss - 0.0).abs() < f64::EPSILON);
         assert!((pos.take_profit - 0.0).abs() < f64::EPSILON);
     }
@@ -534,6 +550,7 @@ mod tests {
 
         let result = enter_short(
             &mut portfolio,
+            CBA,
             "CBA",
             "ASX",
             100.0,
@@ -557,8 +574,8 @@ mod tests {
                 let expected_cash = 100000.0 - cost - commission;
                 assert!((portfolio.cash - expected_cash).abs() < f64::EPSILON);
 
-                assert!(portfolio.has_position("CBA"));
-                let pos = portfolio.get_position("CBA").unwrap();
+                assert!(portfolio.has_position(CBA));
+                let pos = portfolio.get_position(CBA).unwrap();
                 assert!(pos.is_short());
                 assert!(pos.stop_loss > execution_price);
                 assert!(pos.take_profit < execution_price);
@@ -576,6 +593,7 @@ mod tests {
 
         let result = enter_short(
             &mut portfolio,
+            CBA,
             "CBA",
             "ASX",
             100.0,
@@ -585,7 +603,7 @@ mod tests {
         );
 
         assert!(matches!(result, EntryResult::InsufficientCapital));
-        assert!(!portfolio.has_position("CBA"));
+        assert!(!portfolio.has_position(CBA));
     }
 
     #[test]
@@ -596,6 +614,7 @@ mod tests {
 
         let entry_result = enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -612,7 +631,7 @@ mod tests {
 
         let exit_result = exit_position(
             &mut portfolio,
-            "BHP",
+            BHP,
             110.0,
             date(),
             entry_commission,
@@ -625,7 +644,7 @@ mod tests {
         let exit_price = 110.0 * 0.9995;
         assert!((exit.exit_price - exit_price).abs() < f64::EPSILON);
 
-        assert!(!portfolio.has_position("BHP"));
+        assert!(!portfolio.has_position(BHP));
         assert_eq!(portfolio.closed_trades.len(), 1);
 
         let trade = &portfolio.closed_trades[0];
@@ -641,6 +660,7 @@ mod tests {
 
         let entry_result = enter_short(
             &mut portfolio,
+            CBA,
             "CBA",
             "ASX",
             100.0,
@@ -659,7 +679,7 @@ mod tests {
 
         let exit_result = exit_position(
             &mut portfolio,
-            "CBA",
+            CBA,
             90.0,
             date(),
             entry_commission,
@@ -672,7 +692,7 @@ mod tests {
         let exit_price = 90.0 * 1.0005;
         assert!((exit.exit_price - exit_price).abs() < f64::EPSILON);
 
-        assert!(!portfolio.has_position("CBA"));
+        assert!(!portfolio.has_position(CBA));
         assert_eq!(portfolio.closed_trades.len(), 1);
 
         let trade = &portfolio.closed_trades[0];
@@ -690,7 +710,7 @@ mod tests {
         let mut portfolio = make_portfolio(100000.0);
         let config = make_config();
 
-        let result = exit_position(&mut portfolio, "XYZ", 100.0, date(), 0.0, &config);
+        let result = exit_position(&mut portfolio, XYZ, 100.0, date(), 0.0, &config);
         assert!(result.is_none());
     }
 
@@ -702,6 +722,7 @@ mod tests {
 
         let entry_result = enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -714,25 +735,25 @@ mod tests {
             _ => panic!("Expected entry"),
         };
 
-        let pos = portfolio.get_position("BHP").unwrap();
+        let pos = portfolio.get_position(BHP).unwrap();
         let stop_loss_price = pos.stop_loss;
 
-        let mut entry_commissions = HashMap::new();
-        entry_commissions.insert("BHP".to_string(), entry_commission);
+        let mut entry_commissions = vec![0.0; 3];
+        entry_commissions[BHP.index()] = entry_commission;
 
-        let mut price_map = HashMap::new();
-        price_map.insert("BHP".to_string(), stop_loss_price - 1.0);
+        let mut prices = vec![None; 3];
+        prices[BHP.index()] = Some(stop_loss_price - 1.0);
 
         let exited = check_triggers(
             &mut portfolio,
-            &price_map,
+            &prices,
             date(),
             &entry_commissions,
             &config,
         );
 
         assert_eq!(exited, 1);
-        assert!(!portfolio.has_position("BHP"));
+        assert!(!portfolio.has_position(BHP));
         assert_eq!(portfolio.closed_trades.len(), 1);
     }
 
@@ -744,6 +765,7 @@ mod tests {
 
         let entry_result = enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -756,25 +778,25 @@ mod tests {
             _ => panic!("Expected entry"),
         };
 
-        let pos = portfolio.get_position("BHP").unwrap();
+        let pos = portfolio.get_position(BHP).unwrap();
         let take_profit_price = pos.take_profit;
 
-        let mut entry_commissions = HashMap::new();
-        entry_commissions.insert("BHP".to_string(), entry_commission);
+        let mut entry_commissions = vec![0.0; 3];
+        entry_commissions[BHP.index()] = entry_commission;
 
-        let mut price_map = HashMap::new();
-        price_map.insert("BHP".to_string(), take_profit_price + 1.0);
+        let mut prices = vec![None; 3];
+        prices[BHP.index()] = Some(take_profit_price + 1.0);
 
         let exited = check_triggers(
             &mut portfolio,
-            &price_map,
+            &prices,
             date(),
             &entry_commissions,
             &config,
         );
 
         assert_eq!(exited, 1);
-        assert!(!portfolio.has_position("BHP"));
+        assert!(!portfolio.has_position(BHP));
         assert_eq!(portfolio.closed_trades.len(), 1);
     }
 
@@ -786,6 +808,7 @@ mod tests {
 
         enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -794,21 +817,21 @@ mod tests {
             &config,
         );
 
-        let mut price_map = HashMap::new();
-        price_map.insert("BHP".to_string(), 100.0);
+        let mut prices = vec![None; 3];
+        prices[BHP.index()] = Some(100.0);
 
-        let entry_commissions = HashMap::new();
+        let entry_commissions = vec![0.0; 3];
 
         let exited = check_triggers(
             &mut portfolio,
-            &price_map,
+            &prices,
             date(),
             &entry_commissions,
             &config,
         );
 
         assert_eq!(exited, 0);
-        assert!(portfolio.has_position("BHP"));
+        assert!(portfolio.has_position(BHP));
         assert_eq!(portfolio.closed_trades.len(), 0);
     }
 
@@ -824,6 +847,7 @@ mod tests {
 
         let entry1 = enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -833,6 +857,7 @@ mod tests {
         );
         let entry2 = enter_long(
             &mut portfolio,
+            CBA,
             "CBA",
             "ASX",
             100.0,
@@ -841,32 +866,32 @@ mod tests {
             &config,
         );
 
-        let mut entry_commissions = HashMap::new();
+        let mut entry_commissions = vec![0.0; 3];
         if let EntryResult::Entered { commission, .. } = entry1 {
-            entry_commissions.insert("BHP".to_string(), commission);
+            entry_commissions[BHP.index()] = commission;
         }
         if let EntryResult::Entered { commission, .. } = entry2 {
-            entry_commissions.insert("CBA".to_string(), commission);
+            entry_commissions[CBA.index()] = commission;
         }
 
-        let pos_bhp = portfolio.get_position("BHP").unwrap();
+        let pos_bhp = portfolio.get_position(BHP).unwrap();
         let stop_loss_bhp = pos_bhp.stop_loss;
 
-        let mut price_map = HashMap::new();
-        price_map.insert("BHP".to_string(), stop_loss_bhp - 1.0);
-        price_map.insert("CBA".to_string(), 100.0);
+        let mut prices = vec![None; 3];
+        prices[BHP.index()] = Some(stop_loss_bhp - 1.0);
+        prices[CBA.index()] = Some(100.0);
 
         let exited = check_triggers(
             &mut portfolio,
-            &price_map,
+            &prices,
             date(),
             &entry_commissions,
             &config,
         );
 
         assert_eq!(exited, 1);
-        assert!(!portfolio.has_position("BHP"));
-        assert!(portfolio.has_position("CBA"));
+        assert!(!portfolio.has_position(BHP));
+        assert!(portfolio.has_position(CBA));
     }
 
     #[test]
@@ -886,6 +911,7 @@ mod tests {
 
         let entry_result = enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -907,16 +933,16 @@ mod tests {
         };
 
         assert!(
-            portfolio.has_position("BHP"),
+            portfolio.has_position(BHP),
             "Position should have been entered"
         );
 
-        let pos = portfolio.get_position("BHP").unwrap();
+        let pos = portfolio.get_position(BHP).unwrap();
         let qty = pos.quantity;
 
         let result = exit_position(
             &mut portfolio,
-            "BHP",
+            BHP,
             110.0,
             date(),
             entry_commission,
@@ -943,6 +969,7 @@ mod tests {
 
         let entry_result = enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             100.0,
@@ -959,7 +986,7 @@ mod tests {
 
         let exit_result = exit_position(
             &mut portfolio,
-            "BHP",
+            BHP,
             90.0, // price dropped
             date(),
             entry_commission,
@@ -990,6 +1017,7 @@ mod tests {
 
         let entry_result = enter_short(
             &mut portfolio,
+            CBA,
             "CBA",
             "ASX",
             100.0,
@@ -1004,7 +1032,7 @@ mod tests {
 
         let exit_result = exit_position(
             &mut portfolio,
-            "CBA",
+            CBA,
             110.0, // price went up — bad for short
             date(),
             entry_commission,
@@ -1046,6 +1074,7 @@ mod tests {
         // 100 / 10 = 10 shares, cost = 100, commission = 50, total = 150 > 100
         let result = enter_long(
             &mut portfolio,
+            BHP,
             "BHP",
             "ASX",
             10.0,
@@ -1055,7 +1084,7 @@ mod tests {
         );
 
         assert!(matches!(result, EntryResult::InsufficientCapital));
-        assert!(!portfolio.has_position("BHP"));
+        assert!(!portfolio.has_position(BHP));
         assert!((portfolio.cash - 100.0).abs() < f64::EPSILON, "Cash should be unchanged");
     }
 
@@ -1067,6 +1096,7 @@ mod tests {
 
         let entry_result = enter_short(
             &mut portfolio,
+            CBA,
             "CBA",
             "ASX",
             100.0,
@@ -1079,25 +1109,25 @@ mod tests {
             _ => panic!("Expected entry"),
         };
 
-        let pos = portfolio.get_position("CBA").unwrap();
+        let pos = portfolio.get_position(CBA).unwrap();
         let stop_loss_price = pos.stop_loss; // above entry for short
 
-        let mut entry_commissions = HashMap::new();
-        entry_commissions.insert("CBA".to_string(), entry_commission);
+        let mut entry_commissions = vec![0.0; 3];
+        entry_commissions[CBA.index()] = entry_commission;
 
-        let mut price_map = HashMap::new();
-        price_map.insert("CBA".to_string(), stop_loss_price + 1.0); // above stop loss
+        let mut prices = vec![None; 3];
+        prices[CBA.index()] = Some(stop_loss_price + 1.0); // above stop loss
 
         let exited = check_triggers(
             &mut portfolio,
-            &price_map,
+            &prices,
             date(),
             &entry_commissions,
             &config,
         );
 
         assert_eq!(exited, 1);
-        assert!(!portfolio.has_position("CBA"));
+        assert!(!portfolio.has_position(CBA));
         assert_eq!(portfolio.closed_trades.len(), 1);
         // Short stopped out at a loss
         assert!(portfolio.closed_trades[0].pnl < 0.0);
@@ -1111,6 +1141,7 @@ mod tests {
 
         let entry_result = enter_short(
             &mut portfolio,
+            CBA,
             "CBA",
             "ASX",
             100.0,
@@ -1123,25 +1154,25 @@ mod tests {
             _ => panic!("Expected entry"),
         };
 
-        let pos = portfolio.get_position("CBA").unwrap();
+        let pos = portfolio.get_position(CBA).unwrap();
         let take_profit_price = pos.take_profit; // below entry for short
 
-        let mut entry_commissions = HashMap::new();
-        entry_commissions.insert("CBA".to_string(), entry_commission);
+        let mut entry_commissions = vec![0.0; 3];
+        entry_commissions[CBA.index()] = entry_commission;
 
-        let mut price_map = HashMap::new();
-        price_map.insert("CBA".to_string(), take_profit_price - 1.0); // below take profit
+        let mut prices = vec![None; 3];
+        prices[CBA.index()] = Some(take_profit_price - 1.0); // below take profit
 
         let exited = check_triggers(
             &mut portfolio,
-            &price_map,
+            &prices,
             date(),
             &entry_commissions,
             &config,
         );
 
         assert_eq!(exited, 1);
-        assert!(!portfolio.has_position("CBA"));
+        assert!(!portfolio.has_position(CBA));
         assert_eq!(portfolio.closed_trades.len(), 1);
     }
 
@@ -1164,6 +1195,7 @@ mod tests {
 
         enter_short(
             &mut portfolio,
+            CBA,
             "CBA",
             "ASX",
             100.0,
@@ -1172,7 +1204,7 @@ mod tests {
             &config,
         );
 
-        exit_position(&mut portfolio, "CBA", 100.0, date(), 0.0, &config);
+        exit_position(&mut portfolio, CBA, 100.0, date(), 0.0, &config);
 
         assert!(
             (portfolio.cash - 100000.0).abs() < f64::EPSILON,
@@ -10,72 +10,78 @@
 //! Default parameters: period=20, multiplier=2.0
 //! Warmup: first (period-1) bars are invalid.
 
-use crate::domain::indicator::{IndicatorPoint, IndicatorSeries, IndicatorType, IndicatorValue};
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::indicator::{IndicatorColumns, IndicatorSeries, IndicatorType};
+use crate::domain::ohlcv::OhlcvSeries;
+
+/// Mean and population standard deviation of the `period` values ending at
+/// index `i` (`i + 1 >= period`). Two-pass, so a flat window has exactly
+/// zero deviation whatever came before it.
+pub fn window_moments(values: &[f64], period: usize, i: usize) -> (f64, f64) {
+    let window = &values[i + 1 - period..=i];
+    let mean: f64 = window.iter().sum::<f64>() / period as f64;
+    let variance: f64 = window
+        .iter()
+        .map(|&value| {
+            let diff = value - mean;
+            diff * diff
+        })
+        .sum::<f64>()
+        / period as f64;
+    (mean, variance.sqrt())
+}
 
 pub fn calculate_bollinger(
-    bars: &[OhlcvBar],
+    bars: &OhlcvSeries,
     period: usize,
     stddev_mult_x100: u32,
 ) -> IndicatorSeries {
-    let mut values = Vec::with_capacity(bars.len());
+    let mut upper_col = Vec::with_capacity(bars.len());
+    let mut middle_col = Vec::with_capacity(bars.len());
+    let mut lower_col = Vec::with_capacity(bars.len());
     let warmup = period.saturating_sub(1);
     let mult = stddev_mult_x100 as f64 / 100.0;
 
     for i in 0..bars.len() {
-        let date = bars[i].date;
         let valid = i >= warmup;
 
         let (upper, middle, lower) = if valid {
-            let start = i + 1 - period;
-            let window = &bars[start..=i];
-
-            let middle_val: f64 = window.iter().map(|b| b.close).sum::<f64>() / period as f64;
-
-            let variance: f64 = window
-                .iter()
-                .map(|b| {
-                    let diff = b.close - middle_val;
-                    diff * diff
-                })
-                .sum::<f64>()
-                / period as f64;
-
-            let stddev = variance.sqrt();
-            let upper = middle_val + mult * stddev;
-            let lower = middle_val - mult * stddev;
-
-            (upper, middle_val, lower)
+            let (middle_val, stddev) = window_moments(&bars.close, period, i);
+            (
+                middle_val + mult * stddev,
+                middle_val,
+                middle_val - mult * stddev,
+            )
         } else {
             (0.0, 0.0, 0.0)
         };
 
-        values.push(IndicatorPoint {
-            date,
-            valid,
-            value: IndicatorValue::Bollinger {
-                upper,
-                middle,
-                lower,
-            },
-        });
+        upper_col.push(upper);
+        middle_col.push(middle);
+        lower_col.push(lower);
     }
 
-    IndicatorSeries {
-        indicator_type: IndicatorType::Bollinger {
+    IndicatorSeries::new(
+        IndicatorType::Bollinger {
             period,
             stddev_mult_x100,
         },
-        values,
-    }
+        warmup,
+        IndicatorColumns::Bollinger {
+            upper: upper_col,
+            middle: middle_col,
+            lower: lower_col,
+        },
+    )
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
+    use crate::domain::ohlcv::OhlcvBar;
     use chrono::NaiveDate;
 
-    fn make_bars(prices: &[f64]) -> Vec<OhlcvBar> {
+    fn make_bars(prices: &[f64]) -> OhlcvSeries {
         prices
             .iter()
             .enumerate()
@@ -97,11 +103,11 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0, 40.0, 50.0]);
         let series = calculate_bollinger(&bars, 3, 200);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
-        assert!(series.values[3].valid);
-        assert!(series.values[4].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
+        assert!(series.is_valid(3));
+        assert!(series.is_valid(4));
     }
 
     #[test]
@@ -109,12 +115,12 @@ mod tests {
         let bars = make_bars(&[100.0, 100.0, 100.0, 100.0, 100.0]);
         let series = calculate_bollinger(&bars, 3, 200);
 
-        assert!(series.values[2].valid);
+        assert!(series.is_valid(2));
         if let IndicatorValue::Bollinger {
             upper,
             middle,
             lower,
-        } = series.values[2].value
+        } = series.value_at(2)
         {
             assert!((middle - 100.0).abs() < f64::EPSILON);
             assert!((upper - 100.0).abs() < f64::EPSILON);
@@ -129,12 +135,12 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0]);
         let series = calculate_bollinger(&bars, 3, 200);
 
-        assert!(series.values[2].valid);
+        assert!(series.is_valid(2));
         if let IndicatorValue::Bollinger {
             upper,
             middle,
             lower,
-        } = series.values[2].value
+        } = series.value_at(2)
         {
             let expected_middle: f64 = (10.0 + 20.0 + 30.0) / 3.0;
             let variance: f64 = ((10.0 - expected_middle).powi(2)
@@ -162,7 +168,7 @@ mod tests {
             upper,
             middle,
             lower,
-        } = series.values[2].value
+        } = series.value_at(2)
         {
             let expected_middle: f64 = 20.0;
             let variance: f64 = ((10.0_f64 - 20.0_f64).powi(2)
@@ -204,7 +210,7 @@ mod tests {
             upper,
             middle,
             lower,
-        } = series.values[2].value
+        } = series.value_at(2)
         {
             let upper_dist = upper - middle;
             let lower_dist = middle - lower;
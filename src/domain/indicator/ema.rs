@@ -3,60 +3,57 @@
 //! k = 2/(n+1), seed with first SMA, then EMA[i] = C[i]*k + EMA[i-1]*(1-k).
 //! Warmup: first (n-1) bars are invalid.
 
-use crate::domain::indicator::{IndicatorPoint, IndicatorSeries, IndicatorType, IndicatorValue};
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::indicator::{IndicatorColumns, IndicatorSeries, IndicatorType};
+use crate::domain::ohlcv::OhlcvSeries;
 
-pub fn calculate_ema(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
+pub fn calculate_ema(bars: &OhlcvSeries, period: usize) -> IndicatorSeries {
     if period == 0 || bars.is_empty() {
-        return IndicatorSeries {
-            indicator_type: IndicatorType::Ema(period),
-            values: Vec::new(),
-        };
+        return IndicatorSeries::new(
+            IndicatorType::Ema(period),
+            0,
+            IndicatorColumns::Simple(Vec::new()),
+        );
     }
 
-    let mut values = Vec::with_capacity(bars.len());
+    IndicatorSeries::new(
+        IndicatorType::Ema(period),
+        period - 1,
+        IndicatorColumns::Simple(ema_values(&bars.close, period)),
+    )
+}
+
+/// Raw EMA column of `values` (`period` > 0), 0.0 during warmup.
+pub fn ema_values(values: &[f64], period: usize) -> Vec<f64> {
+    let mut out = Vec::with_capacity(values.len());
     let k = 2.0 / (period as f64 + 1.0);
     let mut ema = 0.0;
     let mut sum = 0.0;
 
-    for (i, bar) in bars.iter().enumerate() {
+    for (i, &value) in values.iter().enumerate() {
         if i < period - 1 {
-            sum += bar.close;
-            values.push(IndicatorPoint {
-                date: bar.date,
-                valid: false,
-                value: IndicatorValue::Simple(0.0),
-            });
+            sum += value;
+            out.push(0.0);
         } else if i == period - 1 {
-            sum += bar.close;
+            sum += value;
             ema = sum / period as f64;
-            values.push(IndicatorPoint {
-                date: bar.date,
-                valid: true,
-                value: IndicatorValue::Simple(ema),
-            });
+            out.push(ema);
         } else {
-            ema = bar.close * k + ema * (1.0 - k);
-            values.push(IndicatorPoint {
-                date: bar.date,
-                valid: true,
-                value: IndicatorValue::Simple(ema),
-            });
+            ema = value * k + ema * (1.0 - k);
+            out.push(ema);
         }
     }
 
-    IndicatorSeries {
-        indicator_type: IndicatorType::Ema(period),
-        values,
-    }
+    out
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
+    use crate::domain::ohlcv::OhlcvBar;
     use chrono::NaiveDate;
 
-    fn make_bars(prices: &[f64]) -> Vec<OhlcvBar> {
+    fn make_bars(prices: &[f64]) -> OhlcvSeries {
         prices
             .iter()
             .enumerate()
@@ -78,11 +75,11 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0, 40.0, 50.0]);
         let series = calculate_ema(&bars, 3);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
-        assert!(series.values[3].valid);
-        assert!(series.values[4].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
+        assert!(series.is_valid(3));
+        assert!(series.is_valid(4));
     }
 
     #[test]
@@ -90,14 +87,14 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0]);
         let series = calculate_ema(&bars, 1);
 
-        assert!(series.values[0].valid);
-        assert!(series.values[1].valid);
-        assert!(series.values[2].valid);
+        assert!(series.is_valid(0));
+        assert!(series.is_valid(1));
+        assert!(series.is_valid(2));
 
-        if let IndicatorValue::Simple(v) = series.values[0].value {
+        if let IndicatorValue::Simple(v) = series.value_at(0) {
             assert!((v - 10.0).abs() < f64::EPSILON);
         }
-        if let IndicatorValue::Simple(v) = series.values[1].value {
+        if let IndicatorValue::Simple(v) = series.value_at(1) {
             assert!((v - 20.0).abs() < f64::EPSILON);
         }
     }
@@ -107,10 +104,10 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0]);
         let series = calculate_ema(&bars, 3);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
 
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             let expected_sma = (10.0 + 20.0 + 30.0) / 3.0;
             assert!((v - expected_sma).abs() < f64::EPSILON);
         } else {
@@ -126,17 +123,17 @@ mod tests {
         let k = 2.0 / 4.0;
         let sma = (10.0 + 20.0 + 30.0) / 3.0;
 
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             assert!((v - sma).abs() < f64::EPSILON);
         }
 
         let ema_3 = 40.0 * k + sma * (1.0 - k);
-        if let IndicatorValue::Simple(v) = series.values[3].value {
+        if let IndicatorValue::Simple(v) = series.value_at(3) {
             assert!((v - ema_3).abs() < f64::EPSILON);
         }
 
         let ema_4 = 50.0 * k + ema_3 * (1.0 - k);
-        if let IndicatorValue::Simple(v) = series.values[4].value {
+        if let IndicatorValue::Simple(v) = series.value_at(4) {
             assert!((v - ema_4).abs() < f64::EPSILON);
         }
     }
@@ -147,7 +144,7 @@ mod tests {
         let series = calculate_ema(&bars, 3);
 
         for i in 2..5 {
-            if let IndicatorValue::Simple(v) = series.values[i].value {
+            if let IndicatorValue::Simple(v) = series.value_at(i) {
                 assert!((v - 100.0).abs() < f64::EPSILON);
             }
         }
@@ -163,16 +160,16 @@ mod tests {
 
     #[test]
     fn ema_empty_bars() {
-        let bars: Vec<OhlcvBar> = vec![];
+        let bars = OhlcvSeries::new();
         let series = calculate_ema(&bars, 3);
-        assert!(series.values.is_empty());
+        assert!(series.is_empty());
     }
 
     #[test]
     fn ema_period_0() {
         let bars = make_bars(&[10.0, 20.0]);
         let series = calculate_ema(&bars, 0);
-        assert!(series.values.is_empty());
+        assert!(series.is_empty());
     }
 
     #[test]
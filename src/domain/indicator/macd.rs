@@ -7,56 +7,68 @@
 //! Default parameters: fast=12, slow=26, signal=9
 //! Warmup: max(fast, slow) - 1 + signal - 1 bars (i.e., slow - 1 + signal - 1 for defaults)
 
-use crate::domain::indicator::{
-    calculate_ema, IndicatorPoint, IndicatorSeries, IndicatorType, IndicatorValue,
-};
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::indicator::{ema_values, IndicatorColumns, IndicatorSeries, IndicatorType};
+use crate::domain::ohlcv::OhlcvSeries;
 
 pub const DEFAULT_FAST: usize = 12;
 pub const DEFAULT_SLOW: usize = 26;
 pub const DEFAULT_SIGNAL: usize = 9;
 
 pub fn calculate_macd(
-    bars: &[OhlcvBar],
+    bars: &OhlcvSeries,
     fast: usize,
     slow: usize,
     signal_period: usize,
 ) -> IndicatorSeries {
     if bars.is_empty() || fast == 0 || slow == 0 || signal_period == 0 {
-        return IndicatorSeries {
-            indicator_type: IndicatorType::Macd {
+        return IndicatorSeries::new(
+            IndicatorType::Macd {
                 fast,
                 slow,
                 signal: signal_period,
             },
-            values: Vec::new(),
-        };
+            0,
+            IndicatorColumns::Macd {
+                line: Vec::new(),
+                signal: Vec::new(),
+                histogram: Vec::new(),
+            },
+        );
     }
 
-    let ema_fast = ema_raw_values(bars, fast);
-    let ema_slow = ema_raw_values(bars, slow);
+    let ema_fast = ema_values(&bars.close, fast);
+    let ema_slow = ema_values(&bars.close, slow);
+    macd_from_emas(fast, slow, signal_period, &ema_fast, &ema_slow)
+}
 
-    let mut macd_line: Vec<f64> = Vec::with_capacity(bars.len());
-    for i in 0..bars.len() {
-        macd_line.push(ema_fast[i] - ema_slow[i]);
-    }
+/// MACD assembled from precomputed fast and slow EMA columns of equal,
+/// non-zero length (all periods non-zero).
+pub fn macd_from_emas(
+    fast: usize,
+    slow: usize,
+    signal_period: usize,
+    ema_fast: &[f64],
+    ema_slow: &[f64],
+) -> IndicatorSeries {
+    let len = ema_fast.len();
+    let macd_line: Vec<f64> = ema_fast.iter().zip(ema_slow).map(|(f, s)| f - s).collect();
 
     let k = 2.0 / (signal_period as f64 + 1.0);
-    let mut signal_line: Vec<f64> = vec![0.0; bars.len()];
+    let mut signal_line: Vec<f64> = vec![0.0; len];
     let macd_warmup = slow - 1;
 
-    if bars.len() > macd_warmup {
+    if len > macd_warmup {
         let mut sum = 0.0;
-        let signal_seed_end = (macd_warmup + signal_period).min(bars.len());
+        let signal_seed_end = (macd_warmup + signal_period).min(len);
         for value in macd_line.iter().take(signal_seed_end).skip(macd_warmup) {
             sum += value;
         }
 
-        if macd_warmup + signal_period <= bars.len() {
+        if macd_warmup + signal_period <= len {
             let mut signal_ema = sum / signal_period as f64;
             signal_line[macd_warmup + signal_period - 1] = signal_ema;
 
-            for i in (macd_warmup + signal_period)..bars.len() {
+            for i in (macd_warmup + signal_period)..len {
                 signal_ema = macd_line[i] * k + signal_ema * (1.0 - k);
                 signal_line[i] = signal_ema;
             }
@@ -65,57 +77,39 @@ pub fn calculate_macd(
 
     let signal_warmup = slow - 1 + signal_period - 1;
 
-    let mut values = Vec::with_capacity(bars.len());
-    for (i, bar) in bars.iter().enumerate() {
-        let valid = i >= signal_warmup;
-        let macd = macd_line[i];
-        let signal = signal_line[i];
-        let histogram = macd - signal;
-
-        values.push(IndicatorPoint {
-            date: bar.date,
-            valid,
-            value: IndicatorValue::Macd {
-                line: macd,
-                signal,
-                histogram,
-            },
-        });
-    }
+    let histogram: Vec<f64> = macd_line
+        .iter()
+        .zip(&signal_line)
+        .map(|(macd, signal)| macd - signal)
+        .collect();
 
-    IndicatorSeries {
-        indicator_type: IndicatorType::Macd {
+    IndicatorSeries::new(
+        IndicatorType::Macd {
             fast,
             slow,
             signal: signal_period,
         },
-        values,
-    }
+        signal_warmup,
+        IndicatorColumns::Macd {
+            line: macd_line,
+            signal: signal_line,
+            histogram,
+        },
+    )
 }
 
-pub fn calculate_macd_default(bars: &[OhlcvBar]) -> IndicatorSeries {
+pub fn calculate_macd_default(bars: &OhlcvSeries) -> IndicatorSeries {
     calculate_macd(bars, DEFAULT_FAST, DEFAULT_SLOW, DEFAULT_SIGNAL)
 }
 
-/// Extract raw f64 values from the EMA module, using 0.0 for warmup bars.
-fn ema_raw_values(bars: &[OhlcvBar], period: usize) -> Vec<f64> {
-    let series = calculate_ema(bars, period);
-    series
-        .values
-        .iter()
-        .map(|p| match p.value {
-            IndicatorValue::Simple(v) => v,
-            _ => 0.0,
-        })
-        .collect()
-}
-
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
+    use crate::domain::ohlcv::OhlcvBar;
     use chrono::NaiveDate;
 
-    fn make_bars(prices: &[f64]) -> Vec<OhlcvBar> {
+    fn make_bars(prices: &[f64]) -> OhlcvSeries {
         prices
             .iter()
             .enumerate()
@@ -134,7 +128,7 @@ mod tests {
 
     #[test]
     fn macd_warmup_default() {
-        let bars: Vec<OhlcvBar> = (0..40)
+        let bars: OhlcvSeries = (0..40)
             .map(|i| {
                 let month = i / 28 + 1;
                 let day = i % 28 + 1;
@@ -155,10 +149,10 @@ mod tests {
 
         let warmup = DEFAULT_SLOW - 1 + DEFAULT_SIGNAL - 1;
         for i in 0..warmup {
-            assert!(!series.values[i].valid, "Index {} should not be valid", i);
+            assert!(!series.is_valid(i), "Index {} should not be valid", i);
         }
         assert!(
-            series.values[warmup].valid,
+            series.is_valid(warmup),
             "Index {} should be valid",
             warmup
         );
@@ -166,7 +160,7 @@ mod tests {
 
     #[test]
     fn macd_histogram_equals_line_minus_signal() {
-        let bars: Vec<OhlcvBar> = (0..40)
+        let bars: OhlcvSeries = (0..40)
             .map(|i| {
                 let month = i / 28 + 1;
                 let day = i % 28 + 1;
@@ -185,13 +179,13 @@ mod tests {
 
         let series = calculate_macd_default(&bars);
 
-        for point in &series.values {
-            if point.valid {
+        for i in 0..series.len() {
+            if series.is_valid(i) {
                 if let IndicatorValue::Macd {
                     line,
                     signal,
                     histogram,
-                } = point.value
+                } = series.value_at(i)
                 {
                     assert!((histogram - (line - signal)).abs() < f64::EPSILON);
                 }
@@ -216,9 +210,9 @@ mod tests {
 
     #[test]
     fn macd_empty_bars() {
-        let bars: Vec<OhlcvBar> = vec![];
+        let bars = OhlcvSeries::new();
         let series = calculate_macd_default(&bars);
-        assert!(series.values.is_empty());
+        assert!(series.is_empty());
     }
 
     #[test]
@@ -226,13 +220,13 @@ mod tests {
         let bars = make_bars(&[100.0, 101.0, 102.0]);
 
         let series = calculate_macd(&bars, 0, 26, 9);
-        assert!(series.values.is_empty());
+        assert!(series.is_empty());
 
         let series = calculate_macd(&bars, 12, 0, 9);
-        assert!(series.values.is_empty());
+        assert!(series.is_empty());
 
         let series = calculate_macd(&bars, 12, 26, 0);
-        assert!(series.values.is_empty());
+        assert!(series.is_empty());
     }
 
     #[test]
@@ -240,11 +234,11 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0, 40.0, 50.0, 60.0, 70.0, 80.0, 90.0, 100.0]);
         let series = calculate_macd(&bars, 3, 5, 2);
 
-        let ema_fast = ema_raw_values(&bars, 3);
-        let ema_slow = ema_raw_values(&bars, 5);
+        let ema_fast = ema_values(&bars.close, 3);
+        let ema_slow = ema_values(&bars.close, 5);
 
-        for (i, point) in series.values.iter().enumerate() {
-            if let IndicatorValue::Macd { line, .. } = point.value {
+        for i in 0..series.len() {
+            if let IndicatorValue::Macd { line, .. } = series.value_at(i) {
                 let expected_line = ema_fast[i] - ema_slow[i];
                 assert!(
                     (line - expected_line).abs() < f64::EPSILON,
@@ -264,7 +258,7 @@ mod tests {
 
     #[test]
     fn macd_calculate_default_uses_defaults() {
-        let bars: Vec<OhlcvBar> = (0..40)
+        let bars: OhlcvSeries = (0..40)
             .map(|i| {
                 let month = i / 28 + 1;
                 let day = i % 28 + 1;
@@ -288,12 +282,12 @@ mod tests {
             series_default.indicator_type,
             series_explicit.indicator_type
         );
-        assert_eq!(series_default.values.len(), series_explicit.values.len());
+        assert_eq!(series_default.len(), series_explicit.len());
     }
 
     #[test]
     fn macd_custom_parameters() {
-        let bars: Vec<OhlcvBar> = (0..20)
+        let bars: OhlcvSeries = (0..20)
             .map(|i| OhlcvBar {
                 code: "TEST".into(),
                 exchange: "TEST".into(),
@@ -309,7 +303,7 @@ mod tests {
         let series = calculate_macd(&bars, 5, 10, 3);
 
         let warmup = 10 - 1 + 3 - 1;
-        assert!(!series.values[warmup - 1].valid);
-        assert!(series.values[warmup].valid);
+        assert!(!series.is_valid(warmup - 1));
+        assert!(series.is_valid(warmup));
     }
 }
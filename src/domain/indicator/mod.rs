@@ -1,10 +1,10 @@
 //! Technical indicator implementations (TRD Section 3.2).
 //!
 //! This module provides types for representing indicator values and series:
-//! - `IndicatorPoint`: A single point in an indicator time series
-//! - `IndicatorValue`: Enum for different indicator output shapes
+//! - `IndicatorValue`: Enum for different indicator output shapes (a single-bar view)
 //! - `IndicatorType`: Enum for indicator identity + parameters (serves as HashMap key)
-//! - `IndicatorSeries`: A time series of indicator values
+//! - `IndicatorColumns`: Dense per-field output columns, one `f64` per bar
+//! - `IndicatorSeries`: A bar-aligned indicator series with its warmup length
 
 mod bollinger;
 pub mod ema;
@@ -23,18 +23,10 @@ pub use roc::*;
 pub use rsi::*;
 pub use wma::*;
 
-use crate::domain::ohlcv::OhlcvBar;
-use chrono::NaiveDate;
+use crate::domain::ohlcv::OhlcvSeries;
 use std::fmt;
 
-#[derive(Debug, Clone)]
-pub struct IndicatorPoint {
-    pub date: NaiveDate,
-    pub valid: bool,
-    pub value: IndicatorValue,
-}
-
-#[derive(Debug, Clone)]
+#[derive(Debug, Clone, PartialEq)]
 pub enum IndicatorValue {
     Simple(f64),
     Macd {
@@ -89,48 +81,124 @@ pub enum IndicatorType {
     Pivot,
 }
 
-#[derive(Debug, Clone)]
-pub struct IndicatorSeries {
-    pub indicator_type: IndicatorType,
-    pub values: Vec<IndicatorPoint>,
+/// Indicator output stored column-wise: one `Vec<f64>` per output field, each
+/// indexed by bar position in the owning `OhlcvSeries`.
+#[derive(Debug, Clone, PartialEq)]
+pub enum IndicatorColumns {
+    Simple(Vec<f64>),
+    Macd {
+        line: Vec<f64>,
+        signal: Vec<f64>,
+        histogram: Vec<f64>,
+    },
+    Stochastic {
+        k: Vec<f64>,
+        d: Vec<f64>,
+    },
+    Bollinger {
+        upper: Vec<f64>,
+        middle: Vec<f64>,
+        lower: Vec<f64>,
+    },
+    Pivot {
+        pivot: Vec<f64>,
+        r1: Vec<f64>,
+        r2: Vec<f64>,
+        r3: Vec<f64>,
+        s1: Vec<f64>,
+        s2: Vec<f64>,
+        s3: Vec<f64>,
+    },
 }
 
-pub fn compute_pivot(bars: &[OhlcvBar]) -> IndicatorSeries {
-    let mut values = Vec::with_capacity(bars.len());
-
-    for (i, bar) in bars.iter().enumerate() {
-        if i == 0 {
-            values.push(IndicatorPoint {
-                date: bar.date,
-                valid: false,
-                value: IndicatorValue::Pivot {
-                    pivot: 0.0,
-                    r1: 0.0,
-                    r2: 0.0,
-                    r3: 0.0,
-                    s1: 0.0,
-                    s2: 0.0,
-                    s3: 0.0,
+impl IndicatorColumns {
+    /// Number of bars covered (every column has the same length).
+    pub fn len(&self) -> usize {
+        match self {
+            IndicatorColumns::Simple(v) => v.len(),
+            IndicatorColumns::Macd { line, .. } => line.len(),
+            IndicatorColumns::Stochastic { k, .. } => k.len(),
+            IndicatorColumns::Bollinger { middle, .. } => middle.len(),
+            IndicatorColumns::Pivot { pivot, .. } => pivot.len(),
+        }
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Zero-length columns of the shape `indicator_type` produces.
+    pub fn empty_for(indicator_type: &IndicatorType) -> Self {
+        match indicator_type {
+            IndicatorType::Macd { .. } => IndicatorColumns::Macd {
+                line: Vec::new(),
+                signal: Vec::new(),
+                histogram: Vec::new(),
+            },
+            IndicatorType::Stochastic { .. } => IndicatorColumns::Stochastic {
+                k: Vec::new(),
+                d: Vec::new(),
+            },
+            IndicatorType::Bollinger { .. } => IndicatorColumns::Bollinger {
+                upper: Vec::new(),
+                middle: Vec::new(),
+                lower: Vec::new(),
+            },
+            IndicatorType::Pivot => IndicatorColumns::Pivot {
+                pivot: Vec::new(),
+                r1: Vec::new(),
+                r2: Vec::new(),
+                r3: Vec::new(),
+                s1: Vec::new(),
+                s2: Vec::new(),
+                s3: Vec::new(),
+            },
+            _ => IndicatorColumns::Simple(Vec::new()),
+        }
+    }
+
+    /// Append one bar's value. Panics if `value` has a different shape.
+    pub fn push(&mut self, value: &IndicatorValue) {
+        match (self, value) {
+            (IndicatorColumns::Simple(col), IndicatorValue::Simple(v)) => col.push(*v),
+            (
+                IndicatorColumns::Macd {
+                    line,
+                    signal,
+                    histogram,
                 },
-            });
-        } else {
-            let prev = &bars[i - 1];
-            let h = prev.high;
-            let l = prev.low;
-            let c = prev.close;
-
-            let pivot = (h + l + c) / 3.0;
-            let r1 = (2.0 * pivot) - l;
-            let s1 = (2.0 * pivot) - h;
-            let r2 = pivot + (h - l);
-            let s2 = pivot - (h - l);
-            let r3 = h + 2.0 * (pivot - l);
-            let s3 = l - 2.0 * (h - pivot);
-
-            values.push(IndicatorPoint {
-                date: bar.date,
-                valid: true,
-                value: IndicatorValue::Pivot {
+                IndicatorValue::Macd {
+                    line: l,
+                    signal: s,
+                    histogram: h,
+                },
+            ) => {
+                line.push(*l);
+                signal.push(*s);
+                histogram.push(*h);
+            }
+            (IndicatorColumns::Stochastic { k, d }, IndicatorValue::Stochastic { k: kv, d: dv }) => {
+                k.push(*kv);
+                d.push(*dv);
+            }
+            (
+                IndicatorColumns::Bollinger {
+                    upper,
+                    middle,
+                    lower,
+                },
+                IndicatorValue::Bollinger {
+                    upper: u,
+                    middle: m,
+                    lower: l,
+                },
+            ) => {
+                upper.push(*u);
+                middle.push(*m);
+                lower.push(*l);
+            }
+            (
+                IndicatorColumns::Pivot {
                     pivot,
                     r1,
                     r2,
@@ -139,16 +207,151 @@ pub fn compute_pivot(bars: &[OhlcvBar]) -> IndicatorSeries {
                     s2,
                     s3,
                 },
-            });
+                IndicatorValue::Pivot {
+                    pivot: p,
+                    r1: vr1,
+                    r2: vr2,
+                    r3: vr3,
+                    s1: vs1,
+                    s2: vs2,
+                    s3: vs3,
+                },
+            ) => {
+                pivot.push(*p);
+                r1.push(*vr1);
+                r2.push(*vr2);
+                r3.push(*vr3);
+                s1.push(*vs1);
+                s2.push(*vs2);
+                s3.push(*vs3);
+            }
+            (_, value) => panic!("cannot append {value:?}: column shape differs"),
         }
     }
+}
 
-    IndicatorSeries {
-        indicator_type: IndicatorType::Pivot,
-        values,
+/// A bar-aligned indicator series.
+///
+/// Every indicator is invalid for a leading warmup run and valid afterwards,
+/// so validity is stored as the single `warmup` offset rather than per bar.
+/// Warmup slots in `columns` hold 0.0. Dates are not repeated here; bar `i`
+/// of the series is bar `i` of the `OhlcvSeries` it was computed from.
+#[derive(Debug, Clone, PartialEq)]
+pub struct IndicatorSeries {
+    pub indicator_type: IndicatorType,
+    /// Number of leading bars without a valid value (may exceed `len()`).
+    pub warmup: usize,
+    pub columns: IndicatorColumns,
+}
+
+impl IndicatorSeries {
+    pub fn new(indicator_type: IndicatorType, warmup: usize, columns: IndicatorColumns) -> Self {
+        Self {
+            indicator_type,
+            warmup,
+            columns,
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.columns.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.columns.is_empty()
+    }
+
+    pub fn is_valid(&self, index: usize) -> bool {
+        index >= self.warmup && index < self.len()
+    }
+
+    /// Row view of bar `index`, regardless of validity. Panics if out of range.
+    pub fn value_at(&self, index: usize) -> IndicatorValue {
+        match &self.columns {
+            IndicatorColumns::Simple(v) => IndicatorValue::Simple(v[index]),
+            IndicatorColumns::Macd {
+                line,
+                signal,
+                histogram,
+            } => IndicatorValue::Macd {
+                line: line[index],
+                signal: signal[index],
+                histogram: histogram[index],
+            },
+            IndicatorColumns::Stochastic { k, d } => IndicatorValue::Stochastic {
+                k: k[index],
+                d: d[index],
+            },
+            IndicatorColumns::Bollinger {
+                upper,
+                middle,
+                lower,
+            } => IndicatorValue::Bollinger {
+                upper: upper[index],
+                middle: middle[index],
+                lower: lower[index],
+            },
+            IndicatorColumns::Pivot {
+                pivot,
+                r1,
+                r2,
+                r3,
+                s1,
+                s2,
+                s3,
+            } => IndicatorValue::Pivot {
+                pivot: pivot[index],
+                r1: r1[index],
+                r2: r2[index],
+                r3: r3[index],
+                s1: s1[index],
+                s2: s2[index],
+                s3: s3[index],
+            },
+        }
     }
 }
 
+pub fn compute_pivot(bars: &OhlcvSeries) -> IndicatorSeries {
+    let n = bars.len();
+    let mut pivot = vec![0.0; n];
+    let mut r1 = vec![0.0; n];
+    let mut r2 = vec![0.0; n];
+    let mut r3 = vec![0.0; n];
+    let mut s1 = vec![0.0; n];
+    let mut s2 = vec![0.0; n];
+    let mut s3 = vec![0.0; n];
+
+    for i in 1..n {
+        let h = bars.high[i - 1];
+        let l = bars.low[i - 1];
+        let c = bars.close[i - 1];
+
+        let p = (h + l + c) / 3.0;
+        pivot[i] = p;
+        r1[i] = (2.0 * p) - l;
+        s1[i] = (2.0 * p) - h;
+        r2[i] = p + (h - l);
+        s2[i] = p - (h - l);
+        r3[i] = h + 2.0 * (p - l);
+        s3[i] = l - 2.0 * (h - p);
+    }
+
+    IndicatorSeries::new(
+        IndicatorType::Pivot,
+        1,
+        IndicatorColumns::Pivot {
+            pivot,
+            r1,
+            r2,
+            r3,
+            s1,
+            s2,
+            s3,
+        },
+    )
+}
+
 impl fmt::Display for IndicatorType {
     fn fmt(&self, f: &mut fmt::Formatter<'_>) -> fmt::Result {
         match self {
@@ -182,6 +385,8 @@ impl fmt::Display for IndicatorType {
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::ohlcv::OhlcvBar;
+    use chrono::NaiveDate;
 
     #[test]
     fn indicator_type_display_sma() {
@@ -240,7 +445,7 @@ mod tests {
 
     #[test]
     fn pivot_first_bar_invalid() {
-        let bars = vec![OhlcvBar {
+        let bars: OhlcvSeries = vec![OhlcvBar {
             code: "TEST".into(),
             exchange: "ASX".into(),
             date: NaiveDate::from_ymd_opt(2024, 1, 1).unwrap(),
@@ -249,17 +454,18 @@ mod tests {
             low: 90.0,
             close: 105.0,
             volume: 1000,
-        }];
+        }]
+        .into();
 
         let series = compute_pivot(&bars);
         assert_eq!(series.indicator_type, IndicatorType::Pivot);
-        assert_eq!(series.values.len(), 1);
-        assert!(!series.values[0].valid);
+        assert_eq!(series.len(), 1);
+        assert!(!series.is_valid(0));
     }
 
     #[test]
     fn pivot_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             OhlcvBar {
                 code: "TEST".into(),
                 exchange: "ASX".into(),
@@ -280,20 +486,21 @@ mod tests {
                 close: 110.0,
                 volume: 1200,
             },
-        ];
+        ]
+        .into();
 
         let series = compute_pivot(&bars);
-        assert_eq!(series.values.len(), 2);
+        assert_eq!(series.len(), 2);
 
-        assert!(!series.values[0].valid);
+        assert!(!series.is_valid(0));
 
-        assert!(series.values[1].valid);
+        assert!(series.is_valid(1));
         let h = 110.0;
         let l = 90.0;
         let c = 105.0;
         let pivot = (h + l + c) / 3.0;
 
-        match &series.values[1].value {
+        match &series.value_at(1) {
             IndicatorValue::Pivot {
                 pivot: p,
                 r1,
@@ -314,4 +521,21 @@ mod tests {
             _ => panic!("Expected Pivot value"),
         }
     }
+
+    #[test]
+    fn series_validity_is_warmup_prefix() {
+        let series = IndicatorSeries::new(
+            IndicatorType::Sma(3),
+            2,
+            IndicatorColumns::Simple(vec![0.0, 0.0, 20.0, 30.0]),
+        );
+
+        assert_eq!(series.len(), 4);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
+        assert!(series.is_valid(3));
+        assert!(!series.is_valid(4));
+        assert_eq!(series.value_at(3), IndicatorValue::Simple(30.0));
+    }
 }
@@ -1,7 +1,7 @@
 //! OBV (On-Balance Volume) indicator implementation (TRD Section 4.4.11).
 
-use crate::domain::indicator::{IndicatorPoint, IndicatorSeries, IndicatorType, IndicatorValue};
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::indicator::{IndicatorColumns, IndicatorSeries, IndicatorType};
+use crate::domain::ohlcv::OhlcvSeries;
 
 /// Calculate OBV (On-Balance Volume) indicator.
 ///
@@ -11,37 +11,34 @@ use crate::domain::ohlcv::OhlcvBar;
 /// If close[i] == close[i-1]: OBV[i] = OBV[i-1]
 ///
 /// No warmup period; all bars are valid.
-pub fn calculate_obv(bars: &[OhlcvBar]) -> IndicatorSeries {
+pub fn calculate_obv(bars: &OhlcvSeries) -> IndicatorSeries {
     let mut values = Vec::with_capacity(bars.len());
     let mut obv: f64 = 0.0;
     let mut prev_close: f64 = 0.0;
 
-    for (i, bar) in bars.iter().enumerate() {
+    for i in 0..bars.len() {
+        let close = bars.close[i];
+        let volume = bars.volume[i] as f64;
         if i == 0 {
-            obv = bar.volume as f64;
-        } else if bar.close > prev_close {
-            obv += bar.volume as f64;
-        } else if bar.close < prev_close {
-            obv -= bar.volume as f64;
+            obv = volume;
+        } else if close > prev_close {
+            obv += volume;
+        } else if close < prev_close {
+            obv -= volume;
         }
-        prev_close = bar.close;
+        prev_close = close;
 
-        values.push(IndicatorPoint {
-            date: bar.date,
-            valid: true,
-            value: IndicatorValue::Simple(obv),
-        });
+        values.push(obv);
     }
 
-    IndicatorSeries {
-        indicator_type: IndicatorType::Obv,
-        values,
-    }
+    IndicatorSeries::new(IndicatorType::Obv, 0, IndicatorColumns::Simple(values))
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
+    use crate::domain::ohlcv::OhlcvBar;
     use chrono::NaiveDate;
 
     fn make_bar(date: &str, close: f64, volume: i64) -> OhlcvBar {
@@ -59,11 +56,11 @@ mod tests {
 
     #[test]
     fn obv_first_bar_is_volume() {
-        let bars = vec![make_bar("2024-01-01", 100.0, 1000)];
+        let bars: OhlcvSeries = vec![make_bar("2024-01-01", 100.0, 1000)].into();
         let series = calculate_obv(&bars);
-        assert_eq!(series.values.len(), 1);
-        assert!(series.values[0].valid);
-        if let IndicatorValue::Simple(v) = series.values[0].value {
+        assert_eq!(series.len(), 1);
+        assert!(series.is_valid(0));
+        if let IndicatorValue::Simple(v) = series.value_at(0) {
             assert!((v - 1000.0).abs() < f64::EPSILON);
         } else {
             panic!("Expected Simple value");
@@ -72,12 +69,13 @@ mod tests {
 
     #[test]
     fn obv_adds_volume_on_up_day() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 100.0, 1000),
             make_bar("2024-01-02", 105.0, 500),
-        ];
+        ]
+        .into();
         let series = calculate_obv(&bars);
-        if let IndicatorValue::Simple(v) = series.values[1].value {
+        if let IndicatorValue::Simple(v) = series.value_at(1) {
             assert!((v - 1500.0).abs() < f64::EPSILON);
         } else {
             panic!("Expected Simple value");
@@ -86,12 +84,13 @@ mod tests {
 
     #[test]
     fn obv_subtracts_volume_on_down_day() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 100.0, 1000),
             make_bar("2024-01-02", 95.0, 300),
-        ];
+        ]
+        .into();
         let series = calculate_obv(&bars);
-        if let IndicatorValue::Simple(v) = series.values[1].value {
+        if let IndicatorValue::Simple(v) = series.value_at(1) {
             assert!((v - 700.0).abs() < f64::EPSILON);
         } else {
             panic!("Expected Simple value");
@@ -100,12 +99,13 @@ mod tests {
 
     #[test]
     fn obv_unchanged_on_flat_day() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 100.0, 1000),
             make_bar("2024-01-02", 100.0, 500),
-        ];
+        ]
+        .into();
         let series = calculate_obv(&bars);
-        if let IndicatorValue::Simple(v) = series.values[1].value {
+        if let IndicatorValue::Simple(v) = series.value_at(1) {
             assert!((v - 1000.0).abs() < f64::EPSILON);
         } else {
             panic!("Expected Simple value");
@@ -114,20 +114,21 @@ mod tests {
 
     #[test]
     fn obv_all_bars_valid() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 100.0, 1000),
             make_bar("2024-01-02", 105.0, 500),
             make_bar("2024-01-03", 102.0, 200),
-        ];
+        ]
+        .into();
         let series = calculate_obv(&bars);
-        for point in &series.values {
-            assert!(point.valid);
+        for i in 0..series.len() {
+            assert!(series.is_valid(i));
         }
     }
 
     #[test]
     fn obv_indicator_type() {
-        let bars = vec![make_bar("2024-01-01", 100.0, 1000)];
+        let bars: OhlcvSeries = vec![make_bar("2024-01-01", 100.0, 1000)].into();
         let series = calculate_obv(&bars);
         assert_eq!(series.indicator_type, IndicatorType::Obv);
     }
@@ -4,19 +4,18 @@
 //! If C[i-n] == 0: ROC = 0
 //! Warmup: first n bars invalid.
 
-use crate::domain::indicator::{IndicatorPoint, IndicatorSeries, IndicatorType, IndicatorValue};
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::indicator::{IndicatorColumns, IndicatorSeries, IndicatorType};
+use crate::domain::ohlcv::OhlcvSeries;
 
-pub fn calculate_roc(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
+pub fn calculate_roc(bars: &OhlcvSeries, period: usize) -> IndicatorSeries {
     let mut values = Vec::with_capacity(bars.len());
 
     for i in 0..bars.len() {
-        let date = bars[i].date;
         let valid = i >= period;
 
         let value = if valid {
-            let prev_close = bars[i - period].close;
-            let curr_close = bars[i].close;
+            let prev_close = bars.close[i - period];
+            let curr_close = bars.close[i];
 
             if prev_close == 0.0 {
                 0.0
@@ -27,25 +26,24 @@ pub fn calculate_roc(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
             0.0
         };
 
-        values.push(IndicatorPoint {
-            date,
-            valid,
-            value: IndicatorValue::Simple(value),
-        });
+        values.push(value);
     }
 
-    IndicatorSeries {
-        indicator_type: IndicatorType::Roc(period),
-        values,
-    }
+    IndicatorSeries::new(
+        IndicatorType::Roc(period),
+        period,
+        IndicatorColumns::Simple(values),
+    )
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
+    use crate::domain::ohlcv::OhlcvBar;
     use chrono::NaiveDate;
 
-    fn make_bars(prices: &[f64]) -> Vec<OhlcvBar> {
+    fn make_bars(prices: &[f64]) -> OhlcvSeries {
         prices
             .iter()
             .enumerate()
@@ -67,11 +65,11 @@ mod tests {
         let bars = make_bars(&[100.0, 105.0, 110.0, 115.0, 120.0]);
         let series = calculate_roc(&bars, 3);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(!series.values[2].valid);
-        assert!(series.values[3].valid);
-        assert!(series.values[4].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(!series.is_valid(2));
+        assert!(series.is_valid(3));
+        assert!(series.is_valid(4));
     }
 
     #[test]
@@ -79,17 +77,17 @@ mod tests {
         let bars = make_bars(&[100.0, 105.0, 110.0, 115.0]);
         let series = calculate_roc(&bars, 2);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
 
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             let expected = ((110.0 - 100.0) / 100.0) * 100.0;
             assert!((v - expected).abs() < f64::EPSILON);
         } else {
             panic!("Expected Simple value");
         }
 
-        if let IndicatorValue::Simple(v) = series.values[3].value {
+        if let IndicatorValue::Simple(v) = series.value_at(3) {
             let expected = ((115.0 - 105.0) / 105.0) * 100.0;
             assert!((v - expected).abs() < f64::EPSILON);
         } else {
@@ -102,8 +100,8 @@ mod tests {
         let bars = make_bars(&[0.0, 100.0, 110.0]);
         let series = calculate_roc(&bars, 2);
 
-        assert!(series.values[2].valid);
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        assert!(series.is_valid(2));
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             assert!((v - 0.0).abs() < f64::EPSILON);
         } else {
             panic!("Expected Simple value");
@@ -115,8 +113,8 @@ mod tests {
         let bars = make_bars(&[100.0, 90.0, 80.0]);
         let series = calculate_roc(&bars, 2);
 
-        assert!(series.values[2].valid);
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        assert!(series.is_valid(2));
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             let expected = ((80.0 - 100.0) / 100.0) * 100.0;
             assert!((v - expected).abs() < f64::EPSILON);
             assert!(v < 0.0);
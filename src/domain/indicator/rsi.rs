@@ -9,38 +9,26 @@
 //!
 //! Warmup: first n bars are invalid (need n price changes to compute initial average).
 
-use crate::domain::indicator::{IndicatorPoint, IndicatorSeries, IndicatorType, IndicatorValue};
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::indicator::{IndicatorColumns, IndicatorSeries, IndicatorType};
+use crate::domain::ohlcv::OhlcvSeries;
 
-pub fn calculate_rsi(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
+pub fn calculate_rsi(bars: &OhlcvSeries, period: usize) -> IndicatorSeries {
     if period == 0 || bars.len() < 2 {
-        let values: Vec<IndicatorPoint> = bars
-            .iter()
-            .map(|b| IndicatorPoint {
-                date: b.date,
-                valid: false,
-                value: IndicatorValue::Simple(0.0),
-            })
-            .collect();
-
-        return IndicatorSeries {
-            indicator_type: IndicatorType::Rsi(period),
-            values,
-        };
+        return IndicatorSeries::new(
+            IndicatorType::Rsi(period),
+            bars.len(),
+            IndicatorColumns::Simple(vec![0.0; bars.len()]),
+        );
     }
 
     let mut values = Vec::with_capacity(bars.len());
-    values.push(IndicatorPoint {
-        date: bars[0].date,
-        valid: false,
-        value: IndicatorValue::Simple(0.0),
-    });
+    values.push(0.0);
 
     let mut gains: Vec<f64> = Vec::new();
     let mut losses: Vec<f64> = Vec::new();
 
     for i in 1..bars.len() {
-        let change = bars[i].close - bars[i - 1].close;
+        let change = bars.close[i] - bars.close[i - 1];
         gains.push(if change > 0.0 { change } else { 0.0 });
         losses.push(if change < 0.0 { -change } else { 0.0 });
     }
@@ -48,15 +36,11 @@ pub fn calculate_rsi(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
     let mut avg_gain = 0.0;
     let mut avg_loss = 0.0;
 
-    for (i, bar) in bars.iter().enumerate().skip(1) {
+    for i in 1..bars.len() {
         let gain_idx = i - 1;
 
         if gain_idx < period - 1 {
-            values.push(IndicatorPoint {
-                date: bar.date,
-                valid: false,
-                value: IndicatorValue::Simple(0.0),
-            });
+            values.push(0.0);
         } else if gain_idx == period - 1 {
             avg_gain = gains[..period].iter().sum::<f64>() / period as f64;
             avg_loss = losses[..period].iter().sum::<f64>() / period as f64;
@@ -65,11 +49,7 @@ pub fn calculate_rsi(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
             } else {
                 100.0 - (100.0 / (1.0 + avg_gain / avg_loss))
             };
-            values.push(IndicatorPoint {
-                date: bar.date,
-                valid: true,
-                value: IndicatorValue::Simple(rsi),
-            });
+            values.push(rsi);
         } else {
             avg_gain = (avg_gain * (period - 1) as f64 + gains[gain_idx]) / period as f64;
             avg_loss = (avg_loss * (period - 1) as f64 + losses[gain_idx]) / period as f64;
@@ -78,23 +58,22 @@ pub fn calculate_rsi(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
             } else {
                 100.0 - (100.0 / (1.0 + avg_gain / avg_loss))
             };
-            values.push(IndicatorPoint {
-                date: bar.date,
-                valid: true,
-                value: IndicatorValue::Simple(rsi),
-            });
+            values.push(rsi);
         }
     }
 
-    IndicatorSeries {
-        indicator_type: IndicatorType::Rsi(period),
-        values,
-    }
+    IndicatorSeries::new(
+        IndicatorType::Rsi(period),
+        period,
+        IndicatorColumns::Simple(values),
+    )
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
+    use crate::domain::ohlcv::OhlcvBar;
     use chrono::NaiveDate;
 
     fn make_bar(date: &str, close: f64) -> OhlcvBar {
@@ -112,22 +91,22 @@ mod tests {
 
     #[test]
     fn rsi_empty_bars() {
-        let bars: Vec<OhlcvBar> = vec![];
+        let bars = OhlcvSeries::new();
         let series = calculate_rsi(&bars, 14);
-        assert_eq!(series.values.len(), 0);
+        assert_eq!(series.len(), 0);
     }
 
     #[test]
     fn rsi_single_bar() {
-        let bars = vec![make_bar("2024-01-01", 100.0)];
+        let bars: OhlcvSeries = vec![make_bar("2024-01-01", 100.0)].into();
         let series = calculate_rsi(&bars, 14);
-        assert_eq!(series.values.len(), 1);
-        assert!(!series.values[0].valid);
+        assert_eq!(series.len(), 1);
+        assert!(!series.is_valid(0));
     }
 
     #[test]
     fn rsi_warmup_period() {
-        let bars: Vec<OhlcvBar> = (1..=15)
+        let bars: OhlcvSeries = (1..=15)
             .map(|i| {
                 let date = format!("2024-01-{:02}", i);
                 make_bar(&date, 100.0 + (i as f64 % 5.0) * 2.0)
@@ -136,17 +115,17 @@ mod tests {
 
         let series = calculate_rsi(&bars, 14);
 
-        assert_eq!(series.values.len(), 15);
+        assert_eq!(series.len(), 15);
 
         for i in 0..14 {
-            assert!(!series.values[i].valid, "Bar {} should be invalid", i);
+            assert!(!series.is_valid(i), "Bar {} should be invalid", i);
         }
-        assert!(series.values[14].valid, "Bar 14 should be valid");
+        assert!(series.is_valid(14), "Bar 14 should be valid");
     }
 
     #[test]
     fn rsi_all_gains_no_losses() {
-        let bars: Vec<OhlcvBar> = (0..15)
+        let bars: OhlcvSeries = (0..15)
             .map(|i| {
                 let day = i + 1;
                 let date = format!("2024-01-{:02}", day);
@@ -156,7 +135,7 @@ mod tests {
 
         let series = calculate_rsi(&bars, 14);
 
-        if let IndicatorValue::Simple(rsi) = series.values[14].value {
+        if let IndicatorValue::Simple(rsi) = series.value_at(14) {
             assert!(
                 (rsi - 100.0).abs() < f64::EPSILON,
                 "RSI should be 100 when all gains"
@@ -168,7 +147,7 @@ mod tests {
 
     #[test]
     fn rsi_all_losses_no_gains() {
-        let bars: Vec<OhlcvBar> = (0..15)
+        let bars: OhlcvSeries = (0..15)
             .map(|i| {
                 let day = i + 1;
                 let date = format!("2024-01-{:02}", day);
@@ -178,7 +157,7 @@ mod tests {
 
         let series = calculate_rsi(&bars, 14);
 
-        if let IndicatorValue::Simple(rsi) = series.values[14].value {
+        if let IndicatorValue::Simple(rsi) = series.value_at(14) {
             assert!(
                 (rsi - 0.0).abs() < f64::EPSILON,
                 "RSI should be 0 when all losses"
@@ -190,7 +169,7 @@ mod tests {
 
     #[test]
     fn rsi_in_range() {
-        let bars: Vec<OhlcvBar> = (1..=20)
+        let bars: OhlcvSeries = (1..=20)
             .map(|i| {
                 let date = format!("2024-01-{:02}", i);
                 let close = 100.0 + (i as f64 % 7.0 - 3.0) * 2.0;
@@ -200,9 +179,9 @@ mod tests {
 
         let series = calculate_rsi(&bars, 14);
 
-        for point in &series.values {
-            if point.valid {
-                if let IndicatorValue::Simple(rsi) = point.value {
+        for i in 0..series.len() {
+            if series.is_valid(i) {
+                if let IndicatorValue::Simple(rsi) = series.value_at(i) {
                     assert!(rsi >= 0.0 && rsi <= 100.0, "RSI {} out of range", rsi);
                 }
             }
@@ -211,24 +190,25 @@ mod tests {
 
     #[test]
     fn rsi_indicator_type() {
-        let bars = vec![make_bar("2024-01-01", 100.0)];
+        let bars: OhlcvSeries = vec![make_bar("2024-01-01", 100.0)].into();
         let series = calculate_rsi(&bars, 14);
         assert_eq!(series.indicator_type, IndicatorType::Rsi(14));
     }
 
     #[test]
     fn rsi_zero_period() {
-        let bars = vec![make_bar("2024-01-01", 100.0), make_bar("2024-01-02", 101.0)];
+        let bars: OhlcvSeries =
+            vec![make_bar("2024-01-01", 100.0), make_bar("2024-01-02", 101.0)].into();
         let series = calculate_rsi(&bars, 0);
-        assert_eq!(series.values.len(), 2);
-        for point in &series.values {
-            assert!(!point.valid);
+        assert_eq!(series.len(), 2);
+        for i in 0..series.len() {
+            assert!(!series.is_valid(i));
         }
     }
 
     #[test]
     fn rsi_known_calculation() {
-        let bars: Vec<OhlcvBar> = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 44.0),
             make_bar("2024-01-02", 44.25),
             make_bar("2024-01-03", 44.50),
@@ -244,16 +224,17 @@ mod tests {
             make_bar("2024-01-13", 46.25),
             make_bar("2024-01-14", 46.0),
             make_bar("2024-01-15", 46.50),
-        ];
+        ]
+        .into();
 
         let series = calculate_rsi(&bars, 14);
 
-        assert!(series.values[14].valid);
+        assert!(series.is_valid(14));
 
         // Hand-calculated: avg_gain = 4.0/14, avg_loss = 1.5/14
         // RS = 4.0/1.5 = 8/3, RSI = 100 - 100/(1 + 8/3) = 800/11 ≈ 72.7272...
         let expected = 800.0 / 11.0;
-        if let IndicatorValue::Simple(rsi) = series.values[14].value {
+        if let IndicatorValue::Simple(rsi) = series.value_at(14) {
             assert!(
                 (rsi - expected).abs() < 1e-10,
                 "RSI should be {expected}, got {rsi}"
@@ -267,6 +248,7 @@ mod tests {
 #[cfg(test)]
 mod proptests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
     use crate::domain::ohlcv::OhlcvBar;
     use chrono::NaiveDate;
     use proptest::prelude::*;
@@ -274,7 +256,7 @@ mod proptests {
     proptest! {
         #[test]
         fn rsi_is_bounded(values in prop::collection::vec(1.0..1000.0f64, 20..100)) {
-            let bars: Vec<OhlcvBar> = values.iter().enumerate().map(|(i, &close)| {
+            let bars: OhlcvSeries = values.iter().enumerate().map(|(i, &close)| {
                 let day = (i % 28) + 1;
                 let month = (i / 28) % 12 + 1;
                 let year = 2024 + (i / 336) as i32;
@@ -291,10 +273,10 @@ mod proptests {
             }).collect();
 
             let series = calculate_rsi(&bars, 14);
-            prop_assert_eq!(series.values.len(), bars.len());
-            for point in &series.values {
-                if point.valid {
-                    if let IndicatorValue::Simple(rsi) = point.value {
+            prop_assert_eq!(series.len(), bars.len());
+            for i in 0..series.len() {
+                if series.is_valid(i) {
+                    if let IndicatorValue::Simple(rsi) = series.value_at(i) {
                         prop_assert!(rsi >= 0.0 && rsi <= 100.0,
                             "RSI {} out of [0, 100] range", rsi);
                     }
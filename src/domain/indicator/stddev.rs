@@ -4,27 +4,26 @@
 //! STDDEV(n)[i] = sqrt(sum((C[i-j] - SMA(n)[i])^2 for j in 0..n-1) / n)
 //! Warmup: first (n-1) bars are invalid.
 
-use crate::domain::indicator::{IndicatorPoint, IndicatorSeries, IndicatorType, IndicatorValue};
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::indicator::{IndicatorColumns, IndicatorSeries, IndicatorType};
+use crate::domain::ohlcv::OhlcvSeries;
 
-pub fn calculate_stddev(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
+pub fn calculate_stddev(bars: &OhlcvSeries, period: usize) -> IndicatorSeries {
     let mut values = Vec::with_capacity(bars.len());
     let warmup = period.saturating_sub(1);
 
     for i in 0..bars.len() {
-        let date = bars[i].date;
         let valid = i >= warmup;
 
         let value = if valid {
             let start = i + 1 - period;
-            let window = &bars[start..=i];
+            let window = &bars.close[start..=i];
 
-            let sma: f64 = window.iter().map(|b| b.close).sum::<f64>() / period as f64;
+            let sma: f64 = window.iter().sum::<f64>() / period as f64;
 
             let variance: f64 = window
                 .iter()
-                .map(|b| {
-                    let diff = b.close - sma;
+                .map(|&close| {
+                    let diff = close - sma;
                     diff * diff
                 })
                 .sum::<f64>()
@@ -35,25 +34,24 @@ pub fn calculate_stddev(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
             0.0
         };
 
-        values.push(IndicatorPoint {
-            date,
-            valid,
-            value: IndicatorValue::Simple(value),
-        });
+        values.push(value);
     }
 
-    IndicatorSeries {
-        indicator_type: IndicatorType::Stddev(period),
-        values,
-    }
+    IndicatorSeries::new(
+        IndicatorType::Stddev(period),
+        warmup,
+        IndicatorColumns::Simple(values),
+    )
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
+    use crate::domain::ohlcv::OhlcvBar;
     use chrono::NaiveDate;
 
-    fn make_bars(prices: &[f64]) -> Vec<OhlcvBar> {
+    fn make_bars(prices: &[f64]) -> OhlcvSeries {
         prices
             .iter()
             .enumerate()
@@ -75,11 +73,11 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0, 40.0, 50.0]);
         let series = calculate_stddev(&bars, 3);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
-        assert!(series.values[3].valid);
-        assert!(series.values[4].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
+        assert!(series.is_valid(3));
+        assert!(series.is_valid(4));
     }
 
     #[test]
@@ -87,10 +85,10 @@ mod tests {
         let bars = make_bars(&[100.0, 100.0, 100.0, 100.0, 100.0]);
         let series = calculate_stddev(&bars, 3);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
 
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             assert!((v - 0.0).abs() < f64::EPSILON);
         } else {
             panic!("Expected Simple value");
@@ -102,10 +100,10 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0]);
         let series = calculate_stddev(&bars, 3);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
 
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             let sma: f64 = (10.0 + 20.0 + 30.0) / 3.0;
             let expected: f64 =
                 ((10.0 - sma).powi(2) + (20.0 - sma).powi(2) + (30.0 - sma).powi(2)) / 3.0;
@@ -121,8 +119,8 @@ mod tests {
         let bars = make_bars(&[2.0, 4.0, 4.0, 4.0, 5.0, 5.0, 7.0, 9.0]);
         let series = calculate_stddev(&bars, 8);
 
-        assert!(series.values[7].valid);
-        if let IndicatorValue::Simple(v) = series.values[7].value {
+        assert!(series.is_valid(7));
+        if let IndicatorValue::Simple(v) = series.value_at(7) {
             let expected: f64 = 2.0;
             assert!((v - expected).abs() < 1e-10);
         } else {
@@ -4,15 +4,16 @@
 //! WMA(n) = (1*P[i-n+1] + 2*P[i-n+2] + ... + n*P[i]) / (n*(n+1)/2)
 //! Warmup: first (n-1) bars are invalid.
 
-use crate::domain::indicator::{IndicatorPoint, IndicatorSeries, IndicatorType, IndicatorValue};
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::indicator::{IndicatorColumns, IndicatorSeries, IndicatorType};
+use crate::domain::ohlcv::OhlcvSeries;
 
-pub fn calculate_wma(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
+pub fn calculate_wma(bars: &OhlcvSeries, period: usize) -> IndicatorSeries {
     if period == 0 || bars.is_empty() {
-        return IndicatorSeries {
-            indicator_type: IndicatorType::Wma(period),
-            values: Vec::new(),
-        };
+        return IndicatorSeries::new(
+            IndicatorType::Wma(period),
+            0,
+            IndicatorColumns::Simple(Vec::new()),
+        );
     }
 
     let mut values = Vec::with_capacity(bars.len());
@@ -20,38 +21,37 @@ pub fn calculate_wma(bars: &[OhlcvBar], period: usize) -> IndicatorSeries {
     let mut weighted_sum: f64 = 0.0;
     let mut window_sum: f64 = 0.0;
 
-    for (i, bar) in bars.iter().enumerate() {
+    let closes = &bars.close;
+
+    for (i, &close) in closes.iter().enumerate() {
         if i < period {
             let weight = (i + 1) as f64;
-            weighted_sum += weight * bar.close;
-            window_sum += bar.close;
+            weighted_sum += weight * close;
+            window_sum += close;
         } else {
-            weighted_sum += period as f64 * bar.close - window_sum;
-            window_sum += bar.close - bars[i - period].close;
+            weighted_sum += period as f64 * close - window_sum;
+            window_sum += close - closes[i - period];
         }
 
         let valid = i >= period - 1;
-        let wma = if valid { weighted_sum / divisor } else { 0.0 };
-
-        values.push(IndicatorPoint {
-            date: bar.date,
-            valid,
-            value: IndicatorValue::Simple(wma),
-        });
+        values.push(if valid { weighted_sum / divisor } else { 0.0 });
     }
 
-    IndicatorSeries {
-        indicator_type: IndicatorType::Wma(period),
-        values,
-    }
+    IndicatorSeries::new(
+        IndicatorType::Wma(period),
+        period - 1,
+        IndicatorColumns::Simple(values),
+    )
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
+    use crate::domain::ohlcv::OhlcvBar;
     use chrono::NaiveDate;
 
-    fn make_bars(prices: &[f64]) -> Vec<OhlcvBar> {
+    fn make_bars(prices: &[f64]) -> OhlcvSeries {
         prices
             .iter()
             .enumerate()
@@ -73,11 +73,11 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0, 40.0, 50.0]);
         let series = calculate_wma(&bars, 3);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
-        assert!(series.values[3].valid);
-        assert!(series.values[4].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
+        assert!(series.is_valid(3));
+        assert!(series.is_valid(4));
     }
 
     #[test]
@@ -85,14 +85,14 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0]);
         let series = calculate_wma(&bars, 1);
 
-        assert!(series.values[0].valid);
-        assert!(series.values[1].valid);
-        assert!(series.values[2].valid);
+        assert!(series.is_valid(0));
+        assert!(series.is_valid(1));
+        assert!(series.is_valid(2));
 
-        if let IndicatorValue::Simple(v) = series.values[0].value {
+        if let IndicatorValue::Simple(v) = series.value_at(0) {
             assert!((v - 10.0).abs() < f64::EPSILON);
         }
-        if let IndicatorValue::Simple(v) = series.values[1].value {
+        if let IndicatorValue::Simple(v) = series.value_at(1) {
             assert!((v - 20.0).abs() < f64::EPSILON);
         }
     }
@@ -102,10 +102,10 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0]);
         let series = calculate_wma(&bars, 3);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
 
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             let divisor = (3.0 * 4.0) / 2.0;
             let expected = (1.0 * 10.0 + 2.0 * 20.0 + 3.0 * 30.0) / divisor;
             assert!((v - expected).abs() < f64::EPSILON);
@@ -119,7 +119,7 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0, 40.0]);
         let series = calculate_wma(&bars, 3);
 
-        if let IndicatorValue::Simple(v) = series.values[3].value {
+        if let IndicatorValue::Simple(v) = series.value_at(3) {
             let divisor = (3.0 * 4.0) / 2.0;
             let expected = (1.0 * 20.0 + 2.0 * 30.0 + 3.0 * 40.0) / divisor;
             assert!((v - expected).abs() < f64::EPSILON);
@@ -133,7 +133,7 @@ mod tests {
         let bars = make_bars(&[100.0, 100.0, 100.0]);
         let series = calculate_wma(&bars, 3);
 
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             assert!((v - 100.0).abs() < f64::EPSILON);
         }
     }
@@ -151,22 +151,22 @@ mod tests {
         let bars = make_bars(&[10.0, 20.0, 30.0, 40.0, 50.0]);
         let series = calculate_wma(&bars, 3);
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
 
         let divisor = (3.0 * 4.0) / 2.0;
 
-        if let IndicatorValue::Simple(v) = series.values[2].value {
+        if let IndicatorValue::Simple(v) = series.value_at(2) {
             let expected = (1.0 * 10.0 + 2.0 * 20.0 + 3.0 * 30.0) / divisor;
             assert!((v - expected).abs() < f64::EPSILON);
         }
 
-        if let IndicatorValue::Simple(v) = series.values[3].value {
+        if let IndicatorValue::Simple(v) = series.value_at(3) {
             let expected = (1.0 * 20.0 + 2.0 * 30.0 + 3.0 * 40.0) / divisor;
             assert!((v - expected).abs() < f64::EPSILON);
         }
 
-        if let IndicatorValue::Simple(v) = series.values[4].value {
+        if let IndicatorValue::Simple(v) = series.value_at(4) {
             let expected = (1.0 * 30.0 + 2.0 * 40.0 + 3.0 * 50.0) / divisor;
             assert!((v - expected).abs() < f64::EPSILON);
         }
@@ -174,15 +174,15 @@ mod tests {
 
     #[test]
     fn wma_empty_bars() {
-        let bars: Vec<OhlcvBar> = vec![];
+        let bars = OhlcvSeries::new();
         let series = calculate_wma(&bars, 3);
-        assert!(series.values.is_empty());
+        assert!(series.is_empty());
     }
 
     #[test]
     fn wma_period_0() {
         let bars = make_bars(&[10.0, 20.0]);
         let series = calculate_wma(&bars, 0);
-        assert!(series.values.is_empty());
+        assert!(series.is_empty());
     }
 }
@@ -1,22 +1,92 @@
 //! Shared indicator pre-computation logic and caching (TRD Section 4.5).
 //!
 //! This module provides:
-//! - `IndicatorCache`: A HashMap-based cache for pre-computed indicator series
-//! - Calculation functions for all 13 indicator types from TRD Section 4.1
+//! - `IndicatorCache`: A HashMap-based cache for pre-computed indicator series,
+//!   holding shared `Arc`s so one series can back many strategies
+//! - Calculation functions for all 13 indicator types from TRD Section 4.1,
+//!   assembled from shared `indicator_kernel` columns where types overlap
 
 use crate::domain::indicator::{
-    calculate_bollinger, calculate_ema, calculate_macd, IndicatorPoint, IndicatorSeries,
-    IndicatorType, IndicatorValue,
+    calculate_bollinger, calculate_ema, calculate_macd, compute_pivot, macd_from_emas,
+    IndicatorColumns, IndicatorSeries, IndicatorType, IndicatorValue,
 };
-use crate::domain::ohlcv::OhlcvBar;
-use chrono::NaiveDate;
+use crate::domain::indicator_kernel::{Kernel, KernelSet};
+use crate::domain::ohlcv::OhlcvSeries;
 use std::collections::HashMap;
+use std::sync::Arc;
 
-pub type IndicatorCache = HashMap<IndicatorType, IndicatorSeries>;
+pub type IndicatorCache = HashMap<IndicatorType, Arc<IndicatorSeries>>;
 
-pub fn compute_indicator(bars: &[OhlcvBar], indicator_type: &IndicatorType) -> IndicatorSeries {
-    let values = match indicator_type {
-        IndicatorType::Sma(period) => compute_sma(bars, *period),
+pub fn compute_indicator(bars: &OhlcvSeries, indicator_type: &IndicatorType) -> IndicatorSeries {
+    let kernels = KernelSet::compute(bars, kernel_deps(indicator_type, bars));
+    compute_from_kernels(bars, indicator_type, &kernels)
+}
+
+/// Compute every distinct type in `indicator_types`.
+///
+/// The request is planned as a dependency graph first: each type names the
+/// shared kernels it is built from (`kernel_deps`), every distinct kernel is
+/// computed once, and the indicators are then assembled from those columns.
+/// `Sma(20)` and `Stddev(20)` together cost one rolling sum and one rolling
+/// sum of squares; Bollinger bands of one period share a single two-pass
+/// window mean and deviation; `Ema(12)` and `Macd{12,26,9}` share the
+/// 12-period EMA.
+pub fn compute_indicators(bars: &OhlcvSeries, indicator_types: &[IndicatorType]) -> IndicatorCache {
+    let kernels = KernelSet::compute(
+        bars,
+        indicator_types
+            .iter()
+            .flat_map(|it| kernel_deps(it, bars)),
+    );
+    let mut cache = IndicatorCache::new();
+    for it in indicator_types {
+        if !cache.contains_key(it) {
+            cache.insert(it.clone(), Arc::new(compute_from_kernels(bars, it, &kernels)));
+        }
+    }
+    cache
+}
+
+/// Shared kernels `indicator_type` is assembled from. Degenerate parameters
+/// (zero periods, no bars) need none and take the direct path.
+pub fn kernel_deps(indicator_type: &IndicatorType, bars: &OhlcvSeries) -> Vec<Kernel> {
+    if bars.is_empty() {
+        return Vec::new();
+    }
+    match *indicator_type {
+        IndicatorType::Sma(period) if period > 0 => vec![Kernel::CloseSum(period)],
+        IndicatorType::Stddev(period) if period > 0 => {
+            vec![Kernel::CloseSum(period), Kernel::CloseSumSq(period)]
+        }
+        IndicatorType::Bollinger { period, .. } if period > 0 => {
+            vec![Kernel::CloseMean(period), Kernel::CloseDeviation(period)]
+        }
+        IndicatorType::Ema(period) if period > 0 => vec![Kernel::CloseEma(period)],
+        IndicatorType::Macd { fast, slow, signal } if fast > 0 && slow > 0 && signal > 0 => {
+            vec![Kernel::CloseEma(fast), Kernel::CloseEma(slow)]
+        }
+        IndicatorType::Stochastic { k_period, d_period } if k_period > 0 && d_period > 0 => {
+            vec![Kernel::LowMin(k_period), Kernel::HighMax(k_period)]
+        }
+        _ => Vec::new(),
+    }
+}
+
+/// Assemble `indicator_type` over `bars` from `kernels`, which must hold
+/// every kernel in its `kernel_deps`.
+pub fn compute_from_kernels(
+    bars: &OhlcvSeries,
+    indicator_type: &IndicatorType,
+    kernels: &KernelSet,
+) -> IndicatorSeries {
+    let planned = !kernel_deps(indicator_type, bars).is_empty();
+    let (warmup, columns) = match indicator_type {
+        IndicatorType::Sma(period) if planned => sma_from(kernels, *period),
+        IndicatorType::Sma(_) => empty_simple(),
+        IndicatorType::Ema(period) if planned => {
+            let values = kernels.get(Kernel::CloseEma(*period)).to_vec();
+            (period - 1, IndicatorColumns::Simple(values))
+        }
         IndicatorType::Ema(period) => {
             return calculate_ema(bars, *period);
         }
@@ -24,52 +94,62 @@ pub fn compute_indicator(bars: &[OhlcvBar], indicator_type: &IndicatorType) -> I
         IndicatorType::Rsi(period) => compute_rsi(bars, *period),
         IndicatorType::Roc(period) => compute_roc(bars, *period),
         IndicatorType::Atr(period) => compute_atr(bars, *period),
-        IndicatorType::Stddev(period) => compute_stddev(bars, *period),
+        IndicatorType::Stddev(period) if planned => stddev_from(kernels, *period),
+        IndicatorType::Stddev(_) => empty_simple(),
         IndicatorType::Obv => compute_obv(bars),
         IndicatorType::Vwap => compute_vwap(bars),
+        IndicatorType::Macd { fast, slow, signal } if planned => {
+            return macd_from_emas(
+                *fast,
+                *slow,
+                *signal,
+                kernels.get(Kernel::CloseEma(*fast)),
+                kernels.get(Kernel::CloseEma(*slow)),
+            );
+        }
         IndicatorType::Macd { fast, slow, signal } => {
             return calculate_macd(bars, *fast, *slow, *signal);
         }
-        IndicatorType::Stochastic { k_period, d_period } => {
-            compute_stochastic(bars, *k_period, *d_period)
+        IndicatorType::Stochastic { k_period, d_period } if planned => {
+            stochastic_from(bars, kernels, *k_period, *d_period)
         }
+        IndicatorType::Stochastic { .. } => (
+            0,
+            IndicatorColumns::Stochastic {
+                k: Vec::new(),
+                d: Vec::new(),
+            },
+        ),
+        IndicatorType::Bollinger {
+            period,
+            stddev_mult_x100,
+        } if planned => bollinger_from(kernels, *period, *stddev_mult_x100),
         IndicatorType::Bollinger {
             period,
             stddev_mult_x100,
         } => {
             return calculate_bollinger(bars, *period, *stddev_mult_x100);
         }
-        IndicatorType::Pivot => compute_pivot(bars),
+        IndicatorType::Pivot => {
+            return compute_pivot(bars);
+        }
     };
 
-    IndicatorSeries {
-        indicator_type: indicator_type.clone(),
-        values,
-    }
-}
-
-pub fn compute_indicators(bars: &[OhlcvBar], indicator_types: &[IndicatorType]) -> IndicatorCache {
-    let mut cache = IndicatorCache::new();
-    for it in indicator_types {
-        if !cache.contains_key(it) {
-            cache.insert(it.clone(), compute_indicator(bars, it));
-        }
-    }
-    cache
+    IndicatorSeries::new(indicator_type.clone(), warmup, columns)
 }
 
+/// Simple value of `indicator_type` at `bar_index`, if computed and past warmup.
+///
+/// Series carry no dates; resolve a date to its bar index via `CodeData::get_bar_index`.
 pub fn get_indicator_value(
     cache: &IndicatorCache,
     indicator_type: &IndicatorType,
-    date: NaiveDate,
+    bar_index: usize,
 ) -> Option<f64> {
-    cache.get(indicator_type).and_then(|series| {
-        series
-            .values
-            .iter()
-            .find(|p| p.date == date && p.valid)
-            .and_then(|p| extract_simple_value(&p.value))
-    })
+    cache
+        .get(indicator_type)
+        .filter(|series| series.is_valid(bar_index))
+        .and_then(|series| extract_simple_value(&series.value_at(bar_index)))
 }
 
 pub fn extract_simple_value(value: &IndicatorValue) -> Option<f64> {
@@ -79,37 +159,24 @@ pub fn extract_simple_value(value: &IndicatorValue) -> Option<f64> {
     }
 }
 
-fn make_point(date: NaiveDate, valid: bool, value: IndicatorValue) -> IndicatorPoint {
-    IndicatorPoint { date, valid, value }
+/// Warmup length and columns of an indicator that produced no output.
+fn empty_simple() -> (usize, IndicatorColumns) {
+    (0, IndicatorColumns::Simple(Vec::new()))
 }
 
-fn compute_sma(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
-    if period == 0 || bars.is_empty() {
-        return Vec::new();
-    }
-
-    let mut result = Vec::with_capacity(bars.len());
-    let mut sum = 0.0;
-
-    for (i, bar) in bars.iter().enumerate() {
-        sum += bar.close;
-
-        if i >= period {
-            sum -= bars[i - period].close;
-        }
-
-        let valid = i >= period - 1;
-        let value = if valid { sum / period as f64 } else { 0.0 };
-
-        result.push(make_point(bar.date, valid, IndicatorValue::Simple(value)));
-    }
-
-    result
+fn sma_from(kernels: &KernelSet, period: usize) -> (usize, IndicatorColumns) {
+    let sums = kernels.get(Kernel::CloseSum(period));
+    let result = sums
+        .iter()
+        .enumerate()
+        .map(|(i, sum)| if i >= period - 1 { sum / period as f64 } else { 0.0 })
+        .collect();
+    (period - 1, IndicatorColumns::Simple(result))
 }
 
-fn compute_wma(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
+fn compute_wma(bars: &OhlcvSeries, period: usize) -> (usize, IndicatorColumns) {
     if period == 0 || bars.is_empty() {
-        return Vec::new();
+        return empty_simple();
     }
 
     let mut result = Vec::with_capacity(bars.len());
@@ -117,43 +184,38 @@ fn compute_wma(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
     let mut weighted_sum = 0.0;
     let mut window_sum = 0.0;
 
-    for (i, bar) in bars.iter().enumerate() {
+    for i in 0..bars.len() {
         if i < period {
             let weight = (i + 1) as f64;
-            weighted_sum += weight * bar.close;
-            window_sum += bar.close;
+            weighted_sum += weight * bars.close[i];
+            window_sum += bars.close[i];
         } else {
             // Recurrence: new_weighted = old_weighted + period*new_close - old_window_sum
             // window_sum must be updated AFTER use (it represents the previous window).
-            weighted_sum += period as f64 * bar.close - window_sum;
-            window_sum += bar.close - bars[i - period].close;
+            weighted_sum += period as f64 * bars.close[i] - window_sum;
+            window_sum += bars.close[i] - bars.close[i - period];
         }
 
         let valid = i >= period - 1;
-        let wma = if valid { weighted_sum / divisor } else { 0.0 };
-
-        result.push(make_point(bar.date, valid, IndicatorValue::Simple(wma)));
+        result.push(if valid { weighted_sum / divisor } else { 0.0 });
     }
 
-    result
+    (period - 1, IndicatorColumns::Simple(result))
 }
 
-fn compute_rsi(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
+fn compute_rsi(bars: &OhlcvSeries, period: usize) -> (usize, IndicatorColumns) {
     if period == 0 || bars.len() < 2 {
-        return bars
-            .iter()
-            .map(|b| make_point(b.date, false, IndicatorValue::Simple(0.0)))
-            .collect();
+        return (bars.len(), IndicatorColumns::Simple(vec![0.0; bars.len()]));
     }
 
     let mut result = Vec::with_capacity(bars.len());
-    result.push(make_point(bars[0].date, false, IndicatorValue::Simple(0.0)));
+    result.push(0.0);
 
     let mut gains: Vec<f64> = Vec::new();
     let mut losses: Vec<f64> = Vec::new();
 
     for i in 1..bars.len() {
-        let change = bars[i].close - bars[i - 1].close;
+        let change = bars.close[i] - bars.close[i - 1];
         gains.push(if change > 0.0 { change } else { 0.0 });
         losses.push(if change < 0.0 { -change } else { 0.0 });
     }
@@ -161,13 +223,13 @@ fn compute_rsi(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
     let mut avg_gain = 0.0;
     let mut avg_loss = 0.0;
 
-    for (i, bar) in bars.iter().enumerate().skip(1) {
+    for i in 1..bars.len() {
         let gain_idx = i - 1;
 
         if gain_idx < period - 1 {
             avg_gain = gains[..=gain_idx].iter().sum::<f64>() / (gain_idx + 1) as f64;
             avg_loss = losses[..=gain_idx].iter().sum::<f64>() / (gain_idx + 1) as f64;
-            result.push(make_point(bar.date, false, IndicatorValue::Simple(0.0)));
+            result.push(0.0);
         } else if gain_idx == period - 1 {
             avg_gain = gains[..period].iter().sum::<f64>() / period as f64;
             avg_loss = losses[..period].iter().sum::<f64>() / period as f64;
@@ -176,7 +238,7 @@ fn compute_rsi(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
             } else {
                 100.0 - (100.0 / (1.0 + avg_gain / avg_loss))
             };
-            result.push(make_point(bar.date, true, IndicatorValue::Simple(rsi)));
+            result.push(rsi);
         } else {
             avg_gain = (avg_gain * (period - 1) as f64 + gains[gain_idx]) / period as f64;
             avg_loss = (avg_loss * (period - 1) as f64 + losses[gain_idx]) / period as f64;
@@ -185,259 +247,231 @@ fn compute_rsi(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
             } else {
                 100.0 - (100.0 / (1.0 + avg_gain / avg_loss))
             };
-            result.push(make_point(bar.date, true, IndicatorValue::Simple(rsi)));
+            result.push(rsi);
         }
     }
 
-    result
+    (period, IndicatorColumns::Simple(result))
 }
 
-fn compute_roc(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
+fn compute_roc(bars: &OhlcvSeries, period: usize) -> (usize, IndicatorColumns) {
     if period == 0 || bars.is_empty() {
-        return Vec::new();
+        return empty_simple();
     }
 
     let mut result = Vec::with_capacity(bars.len());
 
-    for (i, bar) in bars.iter().enumerate() {
+    for i in 0..bars.len() {
         let valid = i >= period;
         let roc = if valid {
-            let prev_close = bars[i - period].close;
+            let prev_close = bars.close[i - period];
             if prev_close == 0.0 {
                 0.0
             } else {
-                ((bar.close - prev_close) / prev_close) * 100.0
+                ((bars.close[i] - prev_close) / prev_close) * 100.0
             }
         } else {
             0.0
         };
-        result.push(make_point(bar.date, valid, IndicatorValue::Simple(roc)));
+        result.push(roc);
     }
 
-    result
+    (period, IndicatorColumns::Simple(result))
 }
 
-fn compute_atr(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
+fn compute_atr(bars: &OhlcvSeries, period: usize) -> (usize, IndicatorColumns) {
     if period == 0 || bars.is_empty() {
-        return Vec::new();
+        return empty_simple();
     }
 
     let mut result = Vec::with_capacity(bars.len());
     let mut tr_sum = 0.0;
     let mut atr = 0.0;
 
-    for (i, bar) in bars.iter().enumerate() {
+    for i in 0..bars.len() {
         let tr = if i == 0 {
-            bar.high - bar.low
+            bars.high[i] - bars.low[i]
         } else {
-            bar.true_range(bars[i - 1].close)
+            bars.true_range(i, bars.close[i - 1])
         };
 
         if i < period - 1 {
             tr_sum += tr;
-            result.push(make_point(bar.date, false, IndicatorValue::Simple(0.0)));
+            result.push(0.0);
         } else if i == period - 1 {
             tr_sum += tr;
             atr = tr_sum / period as f64;
-            result.push(make_point(bar.date, true, IndicatorValue::Simple(atr)));
+            result.push(atr);
         } else {
             atr = (atr * (period - 1) as f64 + tr) / period as f64;
-            result.push(make_point(bar.date, true, IndicatorValue::Simple(atr)));
+            result.push(atr);
         }
     }
 
-    result
+    (period - 1, IndicatorColumns::Simple(result))
 }
 
-fn compute_stddev(bars: &[OhlcvBar], period: usize) -> Vec<IndicatorPoint> {
-    if period == 0 || bars.is_empty() {
-        return Vec::new();
-    }
-
-    let mut result = Vec::with_capacity(bars.len());
-    let mut sum = 0.0;
-    let mut sum_sq = 0.0;
-
-    for (i, bar) in bars.iter().enumerate() {
-        sum += bar.close;
-        sum_sq += bar.close * bar.close;
-
-        if i >= period {
-            let old_close = bars[i - period].close;
-            sum -= old_close;
-            sum_sq -= old_close * old_close;
-        }
+/// Population stddev per bar from the shared rolling sum and sum of squares.
+fn stddev_from(kernels: &KernelSet, period: usize) -> (usize, IndicatorColumns) {
+    let sums = kernels.get(Kernel::CloseSum(period));
+    let sums_sq = kernels.get(Kernel::CloseSumSq(period));
+    let result = sums
+        .iter()
+        .zip(sums_sq)
+        .enumerate()
+        .map(|(i, (sum, sum_sq))| {
+            if i >= period - 1 {
+                let mean = sum / period as f64;
+                let variance = sum_sq / period as f64 - mean * mean;
+                variance.max(0.0).sqrt()
+            } else {
+                0.0
+            }
+        })
+        .collect();
+    (period - 1, IndicatorColumns::Simple(result))
+}
 
-        let valid = i >= period - 1;
-        let stddev = if valid {
-            let mean = sum / period as f64;
-            let variance = sum_sq / period as f64 - mean * mean;
-            variance.max(0.0).sqrt()
+/// Bands from the shared two-pass window mean and deviation, with the same
+/// arithmetic as `calculate_bollinger`.
+fn bollinger_from(
+    kernels: &KernelSet,
+    period: usize,
+    stddev_mult_x100: u32,
+) -> (usize, IndicatorColumns) {
+    let means = kernels.get(Kernel::CloseMean(period));
+    let deviations = kernels.get(Kernel::CloseDeviation(period));
+    let mult = stddev_mult_x100 as f64 / 100.0;
+    let mut upper = Vec::with_capacity(means.len());
+    let mut middle = Vec::with_capacity(means.len());
+    let mut lower = Vec::with_capacity(means.len());
+
+    for (i, (&mean, &stddev)) in means.iter().zip(deviations).enumerate() {
+        if i >= period - 1 {
+            upper.push(mean + mult * stddev);
+            middle.push(mean);
+            lower.push(mean - mult * stddev);
         } else {
-            0.0
-        };
-
-        result.push(make_point(bar.date, valid, IndicatorValue::Simple(stddev)));
+            upper.push(0.0);
+            middle.push(0.0);
+            lower.push(0.0);
+        }
     }
 
-    result
+    (
+        period - 1,
+        IndicatorColumns::Bollinger {
+            upper,
+            middle,
+            lower,
+        },
+    )
 }
 
-fn compute_obv(bars: &[OhlcvBar]) -> Vec<IndicatorPoint> {
+fn compute_obv(bars: &OhlcvSeries) -> (usize, IndicatorColumns) {
     if bars.is_empty() {
-        return Vec::new();
+        return empty_simple();
     }
 
     let mut result = Vec::with_capacity(bars.len());
-    let mut obv = bars[0].volume as f64;
+    let mut obv = bars.volume[0] as f64;
 
-    result.push(make_point(bars[0].date, true, IndicatorValue::Simple(obv)));
+    result.push(obv);
 
     for i in 1..bars.len() {
-        let change = bars[i].close - bars[i - 1].close;
+        let change = bars.close[i] - bars.close[i - 1];
         if change > 0.0 {
-            obv += bars[i].volume as f64;
+            obv += bars.volume[i] as f64;
         } else if change < 0.0 {
-            obv -= bars[i].volume as f64;
+            obv -= bars.volume[i] as f64;
         }
-        result.push(make_point(bars[i].date, true, IndicatorValue::Simple(obv)));
+        result.push(obv);
     }
 
-    result
+    (0, IndicatorColumns::Simple(result))
 }
 
-fn compute_vwap(bars: &[OhlcvBar]) -> Vec<IndicatorPoint> {
+fn compute_vwap(bars: &OhlcvSeries) -> (usize, IndicatorColumns) {
     if bars.is_empty() {
-        return Vec::new();
+        return empty_simple();
     }
 
     let mut result = Vec::with_capacity(bars.len());
     let mut cum_tp_vol = 0.0;
     let mut cum_vol = 0.0;
 
-    for bar in bars {
-        let tp = bar.typical_price();
-        cum_tp_vol += tp * bar.volume as f64;
-        cum_vol += bar.volume as f64;
+    for i in 0..bars.len() {
+        let tp = bars.typical_price(i);
+        cum_tp_vol += tp * bars.volume[i] as f64;
+        cum_vol += bars.volume[i] as f64;
 
         let vwap = if cum_vol == 0.0 {
             0.0
         } else {
             cum_tp_vol / cum_vol
         };
-        result.push(make_point(bar.date, true, IndicatorValue::Simple(vwap)));
+        result.push(vwap);
     }
 
-    result
+    (0, IndicatorColumns::Simple(result))
 }
 
-fn compute_stochastic(bars: &[OhlcvBar], k_period: usize, d_period: usize) -> Vec<IndicatorPoint> {
-    if bars.is_empty() || k_period == 0 || d_period == 0 {
-        return Vec::new();
-    }
-
-    let mut result = Vec::with_capacity(bars.len());
+fn stochastic_from(
+    bars: &OhlcvSeries,
+    kernels: &KernelSet,
+    k_period: usize,
+    d_period: usize,
+) -> (usize, IndicatorColumns) {
+    let lowest_lows = kernels.get(Kernel::LowMin(k_period));
+    let highest_highs = kernels.get(Kernel::HighMax(k_period));
     let mut k_values: Vec<f64> = Vec::with_capacity(bars.len());
-
-    for (i, bar) in bars.iter().enumerate() {
-        let valid_k = i >= k_period - 1;
-
-        let k = if valid_k {
-            let start = i + 1 - k_period;
-            let lowest_low = bars[start..=i]
-                .iter()
-                .map(|b| b.low)
-                .fold(f64::INFINITY, f64::min);
-            let highest_high = bars[start..=i]
-                .iter()
-                .map(|b| b.high)
-                .fold(f64::NEG_INFINITY, f64::max);
-
+    let mut d_values: Vec<f64> = Vec::with_capacity(bars.len());
+    let warmup = k_period - 1 + d_period - 1;
+    // Running sum of the last `d_period` %K values for %D.
+    let mut k_sum = 0.0;
+
+    for i in 0..bars.len() {
+        let k = if i >= k_period - 1 {
+            let (lowest_low, highest_high) = (lowest_lows[i], highest_highs[i]);
             if (highest_high - lowest_low).abs() < f64::EPSILON {
                 50.0
             } else {
-                100.0 * (bar.close - lowest_low) / (highest_high - lowest_low)
+                100.0 * (bars.close[i] - lowest_low) / (highest_high - lowest_low)
             }
         } else {
             0.0
         };
 
         k_values.push(k);
+        k_sum += k;
+        if i >= d_period {
+            k_sum -= k_values[i - d_period];
+        }
 
-        let valid = i >= k_period - 1 + d_period - 1;
-
-        let d = if valid {
-            let start = k_values.len() - d_period;
-            k_values[start..].iter().sum::<f64>() / d_period as f64
+        let d = if i >= warmup {
+            k_sum / d_period as f64
         } else {
             0.0
         };
 
-        result.push(make_point(
-            bar.date,
-            valid,
-            IndicatorValue::Stochastic { k, d },
-        ));
+        d_values.push(d);
     }
 
-    result
-}
-
-fn compute_pivot(bars: &[OhlcvBar]) -> Vec<IndicatorPoint> {
-    if bars.is_empty() {
-        return Vec::new();
-    }
-
-    let mut result = Vec::with_capacity(bars.len());
-    result.push(make_point(
-        bars[0].date,
-        false,
-        IndicatorValue::Pivot {
-            pivot: 0.0,
-            r1: 0.0,
-            r2: 0.0,
-            r3: 0.0,
-            s1: 0.0,
-            s2: 0.0,
-            s3: 0.0,
+    (
+        warmup,
+        IndicatorColumns::Stochastic {
+            k: k_values,
+            d: d_values,
         },
-    ));
-
-    for i in 1..bars.len() {
-        let prev = &bars[i - 1];
-        let h = prev.high;
-        let l = prev.low;
-        let c = prev.close;
-
-        let pivot = (h + l + c) / 3.0;
-        let r1 = 2.0 * pivot - l;
-        let s1 = 2.0 * pivot - h;
-        let r2 = pivot + (h - l);
-        let s2 = pivot - (h - l);
-        let r3 = h + 2.0 * (pivot - l);
-        let s3 = l - 2.0 * (h - pivot);
-
-        result.push(make_point(
-            bars[i].date,
-            true,
-            IndicatorValue::Pivot {
-                pivot,
-                r1,
-                r2,
-                r3,
-                s1,
-                s2,
-                s3,
-            },
-        ));
-    }
-
-    result
+    )
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::IndicatorValue;
+    use crate::domain::ohlcv::OhlcvBar;
+    use chrono::NaiveDate;
 
     fn make_bar(date: &str, close: f64, high: f64, low: f64, volume: i64) -> OhlcvBar {
         OhlcvBar {
@@ -458,83 +492,86 @@ mod tests {
 
     #[test]
     fn sma_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_simple_bar("2024-01-01", 10.0),
             make_simple_bar("2024-01-02", 20.0),
             make_simple_bar("2024-01-03", 30.0),
             make_simple_bar("2024-01-04", 40.0),
             make_simple_bar("2024-01-05", 50.0),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(&bars, &IndicatorType::Sma(3));
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
 
-        let v2 = extract_simple_value(&series.values[2].value).unwrap();
+        let v2 = extract_simple_value(&series.value_at(2)).unwrap();
         assert!((v2 - 20.0).abs() < f64::EPSILON);
 
-        let v3 = extract_simple_value(&series.values[3].value).unwrap();
+        let v3 = extract_simple_value(&series.value_at(3)).unwrap();
         assert!((v3 - 30.0).abs() < f64::EPSILON);
 
-        let v4 = extract_simple_value(&series.values[4].value).unwrap();
+        let v4 = extract_simple_value(&series.value_at(4)).unwrap();
         assert!((v4 - 40.0).abs() < f64::EPSILON);
     }
 
     #[test]
     fn ema_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_simple_bar("2024-01-01", 10.0),
             make_simple_bar("2024-01-02", 20.0),
             make_simple_bar("2024-01-03", 30.0),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(&bars, &IndicatorType::Ema(3));
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
 
-        let v2 = extract_simple_value(&series.values[2].value).unwrap();
+        let v2 = extract_simple_value(&series.value_at(2)).unwrap();
         assert!((v2 - 20.0).abs() < f64::EPSILON);
     }
 
     #[test]
     fn wma_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_simple_bar("2024-01-01", 10.0),
             make_simple_bar("2024-01-02", 20.0),
             make_simple_bar("2024-01-03", 30.0),
             make_simple_bar("2024-01-04", 40.0),
             make_simple_bar("2024-01-05", 50.0),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(&bars, &IndicatorType::Wma(3));
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
 
         // i=2: (1*10 + 2*20 + 3*30) / 6 = 140/6
-        let v2 = extract_simple_value(&series.values[2].value).unwrap();
+        let v2 = extract_simple_value(&series.value_at(2)).unwrap();
         let expected2 = (1.0 * 10.0 + 2.0 * 20.0 + 3.0 * 30.0) / 6.0;
         assert!((v2 - expected2).abs() < f64::EPSILON);
 
         // i=3: (1*20 + 2*30 + 3*40) / 6 = 200/6 (sliding window)
-        let v3 = extract_simple_value(&series.values[3].value).unwrap();
+        let v3 = extract_simple_value(&series.value_at(3)).unwrap();
         let expected3 = (1.0 * 20.0 + 2.0 * 30.0 + 3.0 * 40.0) / 6.0;
         assert!((v3 - expected3).abs() < f64::EPSILON);
 
         // i=4: (1*30 + 2*40 + 3*50) / 6 = 260/6
-        let v4 = extract_simple_value(&series.values[4].value).unwrap();
+        let v4 = extract_simple_value(&series.value_at(4)).unwrap();
         let expected4 = (1.0 * 30.0 + 2.0 * 40.0 + 3.0 * 50.0) / 6.0;
         assert!((v4 - expected4).abs() < f64::EPSILON);
     }
 
     #[test]
     fn rsi_calculation() {
-        let bars: Vec<OhlcvBar> = (1..=15)
+        let bars: OhlcvSeries = (1..=15)
             .map(|i| {
                 let date = format!("2024-01-{:02}", i);
                 let close = 100.0 + (i as f64 % 5.0) * 2.0;
@@ -544,70 +581,73 @@ mod tests {
 
         let series = compute_indicator(&bars, &IndicatorType::Rsi(14));
 
-        assert!(series.values.len() == 15);
+        assert!(series.len() == 15);
 
         for i in 0..14 {
-            assert!(!series.values[i].valid);
+            assert!(!series.is_valid(i));
         }
-        assert!(series.values[14].valid);
+        assert!(series.is_valid(14));
 
-        let rsi = extract_simple_value(&series.values[14].value).unwrap();
+        let rsi = extract_simple_value(&series.value_at(14)).unwrap();
         assert!(rsi >= 0.0 && rsi <= 100.0);
     }
 
     #[test]
     fn roc_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_simple_bar("2024-01-01", 100.0),
             make_simple_bar("2024-01-02", 105.0),
             make_simple_bar("2024-01-03", 110.0),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(&bars, &IndicatorType::Roc(2));
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
 
-        let roc = extract_simple_value(&series.values[2].value).unwrap();
+        let roc = extract_simple_value(&series.value_at(2)).unwrap();
         let expected = ((110.0 - 100.0) / 100.0) * 100.0;
         assert!((roc - expected).abs() < f64::EPSILON);
     }
 
     #[test]
     fn atr_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 100.0, 105.0, 95.0, 1000),
             make_bar("2024-01-02", 102.0, 108.0, 98.0, 1000),
             make_bar("2024-01-03", 104.0, 110.0, 100.0, 1000),
             make_bar("2024-01-04", 106.0, 112.0, 102.0, 1000),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(&bars, &IndicatorType::Atr(3));
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
-        assert!(series.values[3].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
+        assert!(series.is_valid(3));
     }
 
     #[test]
     fn stddev_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_simple_bar("2024-01-01", 10.0),
             make_simple_bar("2024-01-02", 20.0),
             make_simple_bar("2024-01-03", 30.0),
             make_simple_bar("2024-01-04", 40.0),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(&bars, &IndicatorType::Stddev(3));
 
-        assert!(!series.values[0].valid);
-        assert!(!series.values[1].valid);
-        assert!(series.values[2].valid);
-        assert!(series.values[3].valid);
+        assert!(!series.is_valid(0));
+        assert!(!series.is_valid(1));
+        assert!(series.is_valid(2));
+        assert!(series.is_valid(3));
 
-        let v2 = extract_simple_value(&series.values[2].value).unwrap();
+        let v2 = extract_simple_value(&series.value_at(2)).unwrap();
         let mean = 20.0;
         let expected = ((10.0_f64 - mean).powi(2) + (20.0 - mean).powi(2) + (30.0 - mean).powi(2))
             .sqrt()
@@ -617,49 +657,51 @@ mod tests {
 
     #[test]
     fn obv_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 100.0, 100.0, 100.0, 1000),
             make_bar("2024-01-02", 102.0, 102.0, 102.0, 2000),
             make_bar("2024-01-03", 99.0, 99.0, 99.0, 1500),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(&bars, &IndicatorType::Obv);
 
-        assert!(series.values[0].valid);
-        assert!(series.values[1].valid);
-        assert!(series.values[2].valid);
+        assert!(series.is_valid(0));
+        assert!(series.is_valid(1));
+        assert!(series.is_valid(2));
 
-        let v0 = extract_simple_value(&series.values[0].value).unwrap();
+        let v0 = extract_simple_value(&series.value_at(0)).unwrap();
         assert!((v0 - 1000.0).abs() < f64::EPSILON);
 
-        let v1 = extract_simple_value(&series.values[1].value).unwrap();
+        let v1 = extract_simple_value(&series.value_at(1)).unwrap();
         assert!((v1 - 3000.0).abs() < f64::EPSILON);
 
-        let v2 = extract_simple_value(&series.values[2].value).unwrap();
+        let v2 = extract_simple_value(&series.value_at(2)).unwrap();
         assert!((v2 - 1500.0).abs() < f64::EPSILON);
     }
 
     #[test]
     fn vwap_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 100.0, 102.0, 98.0, 1000),
             make_bar("2024-01-02", 102.0, 104.0, 100.0, 2000),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(&bars, &IndicatorType::Vwap);
 
-        assert!(series.values[0].valid);
-        assert!(series.values[1].valid);
+        assert!(series.is_valid(0));
+        assert!(series.is_valid(1));
 
         let tp0 = (102.0 + 98.0 + 100.0) / 3.0;
         let expected_vwap0 = tp0 * 1000.0 / 1000.0;
-        let v0 = extract_simple_value(&series.values[0].value).unwrap();
+        let v0 = extract_simple_value(&series.value_at(0)).unwrap();
         assert!((v0 - expected_vwap0).abs() < 1e-10);
     }
 
     #[test]
     fn macd_calculation() {
-        let bars: Vec<OhlcvBar> = (0..35)
+        let bars: OhlcvSeries = (0..35)
             .map(|i| {
                 let day = i % 28 + 1;
                 let month = i / 28 + 1;
@@ -679,15 +721,15 @@ mod tests {
 
         let warmup = 26 - 1 + 9 - 1;
         for i in 0..warmup {
-            assert!(!series.values[i].valid, "Index {} should not be valid", i);
+            assert!(!series.is_valid(i), "Index {} should not be valid", i);
         }
-        assert!(series.values[warmup].valid);
+        assert!(series.is_valid(warmup));
 
         if let IndicatorValue::Macd {
             line,
             signal,
             histogram,
-        } = series.values[warmup].value
+        } = series.value_at(warmup)
         {
             assert!((histogram - (line - signal)).abs() < f64::EPSILON);
         } else {
@@ -697,13 +739,14 @@ mod tests {
 
     #[test]
     fn stochastic_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 100.0, 105.0, 95.0, 1000),
             make_bar("2024-01-02", 102.0, 108.0, 98.0, 1000),
             make_bar("2024-01-03", 104.0, 110.0, 100.0, 1000),
             make_bar("2024-01-04", 106.0, 112.0, 102.0, 1000),
             make_bar("2024-01-05", 108.0, 114.0, 104.0, 1000),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(
             &bars,
@@ -713,9 +756,9 @@ mod tests {
             },
         );
 
-        assert!(series.values[4].valid);
+        assert!(series.is_valid(4));
 
-        if let IndicatorValue::Stochastic { k, d } = series.values[4].value {
+        if let IndicatorValue::Stochastic { k, d } = series.value_at(4) {
             assert!(k >= 0.0 && k <= 100.0);
             assert!(d >= 0.0 && d <= 100.0);
         } else {
@@ -725,12 +768,13 @@ mod tests {
 
     #[test]
     fn bollinger_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_simple_bar("2024-01-01", 10.0),
             make_simple_bar("2024-01-02", 20.0),
             make_simple_bar("2024-01-03", 30.0),
             make_simple_bar("2024-01-04", 40.0),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(
             &bars,
@@ -740,13 +784,13 @@ mod tests {
             },
         );
 
-        assert!(series.values[2].valid);
+        assert!(series.is_valid(2));
 
         if let IndicatorValue::Bollinger {
             upper,
             middle,
             lower,
-        } = series.values[2].value
+        } = series.value_at(2)
         {
             assert!((middle - 20.0).abs() < f64::EPSILON);
             assert!(upper > middle);
@@ -758,15 +802,16 @@ mod tests {
 
     #[test]
     fn pivot_calculation() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_bar("2024-01-01", 100.0, 105.0, 95.0, 1000),
             make_bar("2024-01-02", 102.0, 108.0, 98.0, 1000),
-        ];
+        ]
+        .into();
 
         let series = compute_indicator(&bars, &IndicatorType::Pivot);
 
-        assert!(!series.values[0].valid);
-        assert!(series.values[1].valid);
+        assert!(!series.is_valid(0));
+        assert!(series.is_valid(1));
 
         if let IndicatorValue::Pivot {
             pivot,
@@ -776,7 +821,7 @@ mod tests {
             s1,
             s2,
             s3,
-        } = series.values[1].value
+        } = series.value_at(1)
         {
             let expected_pivot = (105.0 + 95.0 + 100.0) / 3.0;
             assert!((pivot - expected_pivot).abs() < f64::EPSILON);
@@ -799,11 +844,12 @@ mod tests {
 
     #[test]
     fn indicator_cache_compute_indicators() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_simple_bar("2024-01-01", 10.0),
             make_simple_bar("2024-01-02", 20.0),
             make_simple_bar("2024-01-03", 30.0),
-        ];
+        ]
+        .into();
 
         let indicator_types = vec![
             IndicatorType::Sma(2),
@@ -821,18 +867,130 @@ mod tests {
 
     #[test]
     fn get_indicator_value_from_cache() {
-        let bars = vec![
+        let bars: OhlcvSeries = vec![
             make_simple_bar("2024-01-01", 10.0),
             make_simple_bar("2024-01-02", 20.0),
             make_simple_bar("2024-01-03", 30.0),
-        ];
+        ]
+        .into();
 
         let cache = compute_indicators(&bars, &[IndicatorType::Sma(2)]);
 
-        let date = NaiveDate::from_ymd_opt(2024, 1, 2).unwrap();
-        let value = get_indicator_value(&cache, &IndicatorType::Sma(2), date);
+        let value = get_indicator_value(&cache, &IndicatorType::Sma(2), 1);
 
         assert!(value.is_some());
         assert!((value.unwrap() - 15.0).abs() < f64::EPSILON);
+
+        // Bar 0 is still in warmup, bar 3 is past the end.
+        assert!(get_indicator_value(&cache, &IndicatorType::Sma(2), 0).is_none());
+        assert!(get_indicator_value(&cache, &IndicatorType::Sma(2), 3).is_none());
+    }
+
+    fn wavy_series(n: usize) -> OhlcvSeries {
+        let start = NaiveDate::from_ymd_opt(2024, 1, 1).unwrap();
+        (0..n)
+            .map(|i| {
+                let close = 100.0 + 8.0 * (i as f64 * 0.31).sin();
+                OhlcvBar {
+                    code: "TEST".into(),
+                    exchange: "ASX".into(),
+                    date: start + chrono::Duration::days(i as i64),
+                    open: close,
+                    high: close + 1.5 + (i % 3) as f64,
+                    low: close - 1.0 - (i % 4) as f64,
+                    close,
+                    volume: 1000,
+                }
+            })
+            .collect()
+    }
+
+    #[test]
+    fn shared_kernels_match_standalone_computation() {
+        let bars = wavy_series(60);
+        let types = vec![
+            IndicatorType::Sma(20),
+            IndicatorType::Stddev(20),
+            IndicatorType::Bollinger {
+                period: 20,
+                stddev_mult_x100: 200,
+            },
+            IndicatorType::Ema(12),
+            IndicatorType::Ema(26),
+            IndicatorType::Macd {
+                fast: 12,
+                slow: 26,
+                signal: 9,
+            },
+            IndicatorType::Stochastic {
+                k_period: 14,
+                d_period: 3,
+            },
+        ];
+
+        let cache = compute_indicators(&bars, &types);
+
+        for it in &types {
+            assert_eq!(*cache[it], compute_indicator(&bars, it), "{it} differs");
+        }
+        assert_eq!(*cache[&IndicatorType::Ema(12)], calculate_ema(&bars, 12));
+        assert_eq!(
+            *cache[&IndicatorType::Macd {
+                fast: 12,
+                slow: 26,
+                signal: 9
+            }],
+            calculate_macd(&bars, 12, 26, 9)
+        );
+    }
+
+    #[test]
+    fn bollinger_from_kernels_matches_two_pass_reference() {
+        // Volatile bars then a flat stretch, whose bands must collapse to
+        // exactly zero width.
+        let mut bars = wavy_series(60);
+        for i in 40..60 {
+            bars.close[i] = 101.25;
+        }
+        let types: Vec<IndicatorType> = [200, 250]
+            .into_iter()
+            .map(|stddev_mult_x100| IndicatorType::Bollinger {
+                period: 20,
+                stddev_mult_x100,
+            })
+            .collect();
+        let cache = compute_indicators(&bars, &types);
+
+        for (it, mult) in types.iter().zip([200, 250]) {
+            assert_eq!(*cache[it], calculate_bollinger(&bars, 20, mult), "{it}");
+        }
+        let IndicatorValue::Bollinger { upper, lower, .. } = cache[&types[0]].value_at(59) else {
+            panic!("expected Bollinger values");
+        };
+        assert_eq!(upper, lower);
+    }
+
+    #[test]
+    fn stochastic_long_period_matches_window_reference() {
+        let bars = wavy_series(300);
+        let (k_period, d_period) = (120, 5);
+        let series = compute_indicator(&bars, &IndicatorType::Stochastic { k_period, d_period });
+
+        let mut ks = Vec::new();
+        for i in 0..bars.len() {
+            let window = (i + 1).saturating_sub(k_period)..=i;
+            let low = bars.low[window.clone()].iter().copied().fold(f64::INFINITY, f64::min);
+            let high = bars.high[window].iter().copied().fold(f64::NEG_INFINITY, f64::max);
+            ks.push(100.0 * (bars.close[i] - low) / (high - low));
+            if i < series.warmup {
+                continue;
+            }
+            let IndicatorValue::Stochastic { k, d } = series.value_at(i) else {
+                panic!("expected Stochastic values");
+            };
+            let d_ref = ks[ks.len() - d_period..].iter().sum::<f64>() / d_period as f64;
+            assert_eq!(k, ks[i], "bar {i}");
+            assert!((d - d_ref).abs() < 1e-9, "bar {i}: {d} vs {d_ref}");
+        }
     }
 }
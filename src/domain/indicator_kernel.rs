@@ -0,0 +1,356 @@
+//! Shared intermediate kernels for indicator computation (TRD Section 4.5).
+//!
+//! Several indicators are built from the same building blocks: `Sma(20)`
+//! and `Stddev(20)` both need the trailing 20-bar sum of closes, the latter
+//! also the sum of squares; Bollinger bands of one period share the window
+//! mean and deviation whatever their multiplier; `Macd{12,26,9}` needs
+//! `Ema(12)` and `Ema(26)`; `Stochastic` needs rolling lows and highs.
+//! `compute_indicators` maps each requested `IndicatorType` to its
+//! `Kernel` dependencies, computes every distinct kernel once into a
+//! `KernelSet`, and assembles the indicators from those shared columns.
+//!
+//! Rolling extrema use a monotonic deque (`RollingExtremum`), so their cost
+//! is O(n) regardless of the window length. `rolling_min` / `rolling_max`
+//! are public for channel-style indicators (Donchian, Williams %R).
+
+use crate::domain::codec::{ByteReader, ByteWriter};
+use crate::domain::error::SamtraderError;
+use crate::domain::indicator::{ema_values, window_moments};
+use crate::domain::ohlcv::OhlcvSeries;
+use std::collections::{HashMap, VecDeque};
+use std::sync::Arc;
+
+/// A per-bar intermediate column, identified by what it is computed from.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash)]
+pub enum Kernel {
+    /// Trailing `period`-bar sum of closes (partial sums before the window fills).
+    CloseSum(usize),
+    /// Trailing `period`-bar sum of squared closes.
+    CloseSumSq(usize),
+    /// Mean of the trailing `period` closes, summed afresh for each window;
+    /// 0.0 before `period - 1`.
+    CloseMean(usize),
+    /// Population standard deviation of the trailing `period` closes around
+    /// `CloseMean` (two-pass, so a flat window gives exactly 0.0); 0.0
+    /// before `period - 1`.
+    CloseDeviation(usize),
+    /// EMA of closes seeded with the first SMA; 0.0 before `period - 1`.
+    CloseEma(usize),
+    /// Lowest low over the trailing `period` bars (fewer at the start).
+    LowMin(usize),
+    /// Highest high over the trailing `period` bars (fewer at the start).
+    HighMax(usize),
+}
+
+/// The computed columns for a planned set of kernels over one series.
+///
+/// Columns are `Arc`s so a longer-lived cache (`IndicatorStore`) can lend
+/// the ones it already holds to a new set without copying them.
+#[derive(Debug, Default)]
+pub struct KernelSet {
+    columns: HashMap<Kernel, Arc<Vec<f64>>>,
+}
+
+impl KernelSet {
+    /// Compute each distinct kernel in `kernels` once.
+    pub fn compute(bars: &OhlcvSeries, kernels: impl IntoIterator<Item = Kernel>) -> Self {
+        let mut columns = HashMap::new();
+        for kernel in kernels {
+            columns
+                .entry(kernel)
+                .or_insert_with(|| Arc::new(kernel.compute(bars)));
+        }
+        KernelSet { columns }
+    }
+
+    /// A set of already computed columns.
+    pub fn from_columns(columns: impl IntoIterator<Item = (Kernel, Arc<Vec<f64>>)>) -> Self {
+        KernelSet {
+            columns: columns.into_iter().collect(),
+        }
+    }
+
+    /// Number of distinct kernels computed.
+    pub fn len(&self) -> usize {
+        self.columns.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.columns.is_empty()
+    }
+
+    /// Column for a kernel that was part of the plan.
+    pub fn get(&self, kernel: Kernel) -> &[f64] {
+        self.columns
+            .get(&kernel)
+            .map(|column| column.as_slice())
+            .unwrap_or_else(|| panic!("kernel {kernel:?} was not planned"))
+    }
+}
+
+impl Kernel {
+    /// This kernel's column over `bars`.
+    pub fn compute(self, bars: &OhlcvSeries) -> Vec<f64> {
+        match self {
+            Kernel::CloseSum(period) => rolling_sum(&bars.close, period, |v| v),
+            Kernel::CloseSumSq(period) => rolling_sum(&bars.close, period, |v| v * v),
+            Kernel::CloseMean(period) => window_column(&bars.close, period, |(mean, _)| mean),
+            Kernel::CloseDeviation(period) => window_column(&bars.close, period, |(_, dev)| dev),
+            Kernel::CloseEma(period) => ema_values(&bars.close, period),
+            Kernel::LowMin(period) => rolling_min(&bars.low, period),
+            Kernel::HighMax(period) => rolling_max(&bars.high, period),
+        }
+    }
+}
+
+/// Running window sum of `f(value)`: add the new bar, drop the one leaving.
+fn rolling_sum(values: &[f64], period: usize, f: impl Fn(f64) -> f64) -> Vec<f64> {
+    let mut out = Vec::with_capacity(values.len());
+    let mut sum = 0.0;
+    for i in 0..values.len() {
+        sum += f(values[i]);
+        if i >= period {
+            sum -= f(values[i - period]);
+        }
+        out.push(sum);
+    }
+    out
+}
+
+/// `window_moments` of every full `period` window, picked by `pick`; 0.0
+/// before the first. O(n * period), like the two-pass reference it matches.
+fn window_column(values: &[f64], period: usize, pick: impl Fn((f64, f64)) -> f64) -> Vec<f64> {
+    (0..values.len())
+        .map(|i| {
+            if i + 1 >= period {
+                pick(window_moments(values, period, i))
+            } else {
+                0.0
+            }
+        })
+        .collect()
+}
+
+/// Minimum over the trailing `period` values at every index (fewer at the
+/// start). O(n) for any period.
+pub fn rolling_min(values: &[f64], period: usize) -> Vec<f64> {
+    let mut window = RollingExtremum::min(period);
+    values.iter().map(|&v| window.push(v)).collect()
+}
+
+/// Maximum over the trailing `period` values at every index (fewer at the
+/// start). O(n) for any period.
+pub fn rolling_max(values: &[f64], period: usize) -> Vec<f64> {
+    let mut window = RollingExtremum::max(period);
+    values.iter().map(|&v| window.push(v)).collect()
+}
+
+/// Streaming min or max over the last `period` pushed values.
+///
+/// Keeps a deque of candidate `(index, value)` pairs whose values are
+/// monotonic from front to back: a new value evicts every candidate it
+/// beats, and the front leaves once it falls out of the window. Each value
+/// enters and leaves the deque once, so `push` is O(1) amortized. NaN
+/// values never become the extremum (as with `f64::min` / `f64::max`).
+#[derive(Debug, Clone)]
+pub struct RollingExtremum {
+    period: usize,
+    /// `true` tracks the maximum, `false` the minimum.
+    is_max: bool,
+    next_index: usize,
+    candidates: VecDeque<(usize, f64)>,
+}
+
+impl RollingExtremum {
+    pub fn min(period: usize) -> Self {
+        Self::new(period, false)
+    }
+
+    pub fn max(period: usize) -> Self {
+        Self::new(period, true)
+    }
+
+    fn new(period: usize, is_max: bool) -> Self {
+        RollingExtremum {
+            period: period.max(1),
+            is_max,
+            next_index: 0,
+            candidates: VecDeque::new(),
+        }
+    }
+
+    /// Add the next value; returns the extremum of the current window
+    /// (NaN only while every value in the window is NaN).
+    pub fn push(&mut self, value: f64) -> f64 {
+        let index = self.next_index;
+        self.next_index += 1;
+
+        if !value.is_nan() {
+            while let Some(&(_, back)) = self.candidates.back() {
+                let dominated = if self.is_max {
+                    back <= value
+                } else {
+                    back >= value
+                };
+                if !dominated {
+                    break;
+                }
+                self.candidates.pop_back();
+            }
+            self.candidates.push_back((index, value));
+        }
+        while let Some(&(front, _)) = self.candidates.front() {
+            if front + self.period > index {
+                break;
+            }
+            self.candidates.pop_front();
+        }
+
+        self.current()
+    }
+
+    /// Whether this is a `period` window of the given direction that has
+    /// seen exactly `pushed` values.
+    pub(crate) fn is_window(&self, period: usize, is_max: bool, pushed: usize) -> bool {
+        self.period == period && self.is_max == is_max && self.next_index == pushed
+    }
+
+    /// Extremum of the current window without pushing.
+    pub fn current(&self) -> f64 {
+        self.candidates.front().map_or(f64::NAN, |&(_, v)| v)
+    }
+
+    pub(crate) fn encode(&self, w: &mut ByteWriter) {
+        w.usize(self.period);
+        w.bool(self.is_max);
+        w.usize(self.next_index);
+        w.usize(self.candidates.len());
+        for &(index, value) in &self.candidates {
+            w.usize(index);
+            w.f64(value);
+        }
+    }
+
+    pub(crate) fn decode(r: &mut ByteReader) -> Result<Self, SamtraderError> {
+        let period = r.usize()?;
+        let is_max = r.bool()?;
+        let next_index = r.usize()?;
+        let len = r.usize()?;
+        if period == 0 || len > period {
+            return Err(r.error(format!("{len} candidates in a window of {period}")));
+        }
+        let candidates: VecDeque<(usize, f64)> = (0..len)
+            .map(|_| Ok((r.usize()?, r.f64()?)))
+            .collect::<Result<_, SamtraderError>>()?;
+        // Candidates must be pushed values still inside the window, in
+        // push order.
+        let in_window =
+            |&(index, _): &(usize, f64)| index < next_index && next_index - index <= period;
+        if !candidates.iter().all(in_window)
+            || candidates
+                .iter()
+                .zip(candidates.iter().skip(1))
+                .any(|(a, b)| a.0 >= b.0)
+        {
+            return Err(r.error("window candidates out of order or range"));
+        }
+        Ok(RollingExtremum {
+            period,
+            is_max,
+            next_index,
+            candidates,
+        })
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::domain::ohlcv::OhlcvBar;
+    use chrono::NaiveDate;
+
+    fn make_series(closes: &[f64]) -> OhlcvSeries {
+        closes
+            .iter()
+            .enumerate()
+            .map(|(i, &close)| OhlcvBar {
+                code: "TEST".into(),
+                exchange: "ASX".into(),
+                date: NaiveDate::from_ymd_opt(2024, 1, 1).unwrap()
+                    + chrono::Duration::days(i as i64),
+                open: close,
+                high: close + 1.0,
+                low: close - 1.0,
+                close,
+                volume: 1000,
+            })
+            .collect()
+    }
+
+    #[test]
+    fn duplicate_kernels_are_computed_once() {
+        let bars = make_series(&[1.0, 2.0, 3.0]);
+        let set = KernelSet::compute(
+            &bars,
+            [
+                Kernel::CloseSum(2),
+                Kernel::CloseSum(2),
+                Kernel::CloseSumSq(2),
+            ],
+        );
+        assert_eq!(set.len(), 2);
+    }
+
+    #[test]
+    fn rolling_columns() {
+        let bars = make_series(&[1.0, 2.0, 3.0, 4.0]);
+        let set = KernelSet::compute(
+            &bars,
+            [
+                Kernel::CloseSum(2),
+                Kernel::CloseSumSq(2),
+                Kernel::LowMin(3),
+                Kernel::HighMax(3),
+            ],
+        );
+
+        assert_eq!(set.get(Kernel::CloseSum(2)), [1.0, 3.0, 5.0, 7.0]);
+        assert_eq!(set.get(Kernel::CloseSumSq(2)), [1.0, 5.0, 13.0, 25.0]);
+        assert_eq!(set.get(Kernel::LowMin(3)), [0.0, 0.0, 0.0, 1.0]);
+        assert_eq!(set.get(Kernel::HighMax(3)), [2.0, 3.0, 4.0, 5.0]);
+    }
+
+    #[test]
+    fn rolling_extrema_match_window_scan() {
+        let values: Vec<f64> = (0..200)
+            .map(|i| ((i * 37 % 101) as f64).sin() * 50.0 + (i % 7) as f64)
+            .collect();
+        for period in [1, 2, 5, 14, 64, 250] {
+            let mins = rolling_min(&values, period);
+            let maxs = rolling_max(&values, period);
+            for i in 0..values.len() {
+                let window = &values[(i + 1).saturating_sub(period)..=i];
+                let lo = window.iter().copied().fold(f64::INFINITY, f64::min);
+                let hi = window.iter().copied().fold(f64::NEG_INFINITY, f64::max);
+                assert_eq!(mins[i], lo, "min period {period} index {i}");
+                assert_eq!(maxs[i], hi, "max period {period} index {i}");
+            }
+        }
+    }
+
+    #[test]
+    fn rolling_extremum_skips_nan() {
+        let mut max = RollingExtremum::max(2);
+        assert!(max.push(f64::NAN).is_nan());
+        assert_eq!(max.push(3.0), 3.0);
+        assert_eq!(max.push(f64::NAN), 3.0);
+        assert!(max.push(f64::NAN).is_nan());
+    }
+
+    #[test]
+    #[should_panic(expected = "was not planned")]
+    fn unplanned_kernel_panics() {
+        let bars = make_series(&[1.0]);
+        KernelSet::compute(&bars, []).get(Kernel::CloseEma(3));
+    }
+}
@@ -0,0 +1,225 @@
+//! Universe-level shared indicator store (TRD Section 4.5, 8.1).
+//!
+//! `CodeData::indicators` holds what one run asked for up front. When many
+//! strategies run over the same loaded universe (a parameter sweep), each
+//! needs its own subset of indicators, and many of those overlap. The store
+//! computes each `(code, IndicatorType)` series lazily, at most once, and
+//! hands out `Arc` clones, so cost scales with the number of distinct
+//! indicators rather than with the number of strategies.
+//!
+//! The shared kernels indicators are assembled from (`indicator_kernel`) are
+//! cached per code in the same way, so `Sma(20)` requested by one strategy
+//! and `Stddev(20)` by another cost one rolling sum between them, as they
+//! would in a single `compute_indicators` call.
+//!
+//! Codes are identified by `SymbolId`, their position in the `CodeData`
+//! slice the store was built over. Series already present in
+//! `CodeData::indicators` are shared as-is rather than recomputed.
+
+use crate::domain::code_data::CodeData;
+use crate::domain::indicator::{IndicatorSeries, IndicatorType};
+use crate::domain::indicator_helpers::{IndicatorCache, compute_from_kernels, kernel_deps};
+use crate::domain::indicator_kernel::{Kernel, KernelSet};
+use crate::domain::symbol::SymbolId;
+use std::collections::HashMap;
+use std::hash::Hash;
+use std::sync::{Arc, Mutex, OnceLock};
+
+type Slot<T> = Arc<OnceLock<Arc<T>>>;
+type Slots<K, T> = Mutex<HashMap<(SymbolId, K), Slot<T>>>;
+
+/// Lazily computed, read-only indicator series for one loaded universe.
+///
+/// `Sync`: any number of threads may request series concurrently. Callers
+/// asking for the same series while it is being computed wait for that one
+/// computation instead of repeating it.
+pub struct IndicatorStore<'a> {
+    code_data: &'a [CodeData],
+    slots: Slots<IndicatorType, IndicatorSeries>,
+    kernels: Slots<Kernel, Vec<f64>>,
+}
+
+/// The slot for `key`, created empty on first use. The map lock is held
+/// only to find it; the value is computed outside, so unrelated entries are
+/// computed in parallel.
+fn slot<K: Eq + Hash, T>(slots: &Slots<K, T>, symbol: SymbolId, key: K) -> Slot<T> {
+    let mut slots = slots.lock().unwrap_or_else(|e| e.into_inner());
+    Arc::clone(slots.entry((symbol, key)).or_default())
+}
+
+fn filled<K, T>(slots: &Slots<K, T>) -> usize {
+    slots
+        .lock()
+        .unwrap_or_else(|e| e.into_inner())
+        .values()
+        .filter(|slot| slot.get().is_some())
+        .count()
+}
+
+impl<'a> IndicatorStore<'a> {
+    pub fn new(code_data: &'a [CodeData]) -> Self {
+        IndicatorStore {
+            code_data,
+            slots: Mutex::new(HashMap::new()),
+            kernels: Mutex::new(HashMap::new()),
+        }
+    }
+
+    /// The series for `indicator_type` on `symbol`, computing it on first use.
+    pub fn get(&self, symbol: SymbolId, indicator_type: &IndicatorType) -> Arc<IndicatorSeries> {
+        let cd = &self.code_data[symbol.index()];
+        if let Some(series) = cd.indicators.get(indicator_type) {
+            return Arc::clone(series);
+        }
+
+        let slot = slot(&self.slots, symbol, indicator_type.clone());
+        Arc::clone(slot.get_or_init(|| {
+            let kernels = self.kernels(symbol, kernel_deps(indicator_type, &cd.ohlcv));
+            Arc::new(compute_from_kernels(&cd.ohlcv, indicator_type, &kernels))
+        }))
+    }
+
+    /// `kernels` over `symbol`'s bars, each computed on first use.
+    fn kernels(&self, symbol: SymbolId, kernels: Vec<Kernel>) -> KernelSet {
+        let ohlcv = &self.code_data[symbol.index()].ohlcv;
+        KernelSet::from_columns(kernels.into_iter().map(|kernel| {
+            let slot = slot(&self.kernels, symbol, kernel);
+            let column = slot.get_or_init(|| Arc::new(kernel.compute(ohlcv)));
+            (kernel, Arc::clone(column))
+        }))
+    }
+
+    /// An indicator map for `symbol` holding just `indicator_types`.
+    pub fn indicators_for(
+        &self,
+        symbol: SymbolId,
+        indicator_types: &[IndicatorType],
+    ) -> IndicatorCache {
+        indicator_types
+            .iter()
+            .map(|t| (t.clone(), self.get(symbol, t)))
+            .collect()
+    }
+
+    /// Number of series the store itself has computed so far.
+    pub fn computed_count(&self) -> usize {
+        filled(&self.slots)
+    }
+
+    /// Number of shared kernel columns computed so far, across all codes.
+    pub fn kernel_count(&self) -> usize {
+        filled(&self.kernels)
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::domain::indicator_helpers::compute_indicators;
+    use crate::domain::ohlcv::OhlcvBar;
+    use chrono::NaiveDate;
+    use std::thread;
+
+    fn make_code_data(code: &str, n: usize) -> CodeData {
+        let start = NaiveDate::from_ymd_opt(2024, 1, 1).unwrap();
+        let bars: Vec<OhlcvBar> = (0..n)
+            .map(|i| OhlcvBar {
+                code: code.to_string(),
+                exchange: "ASX".to_string(),
+                date: start + chrono::Duration::days(i as i64),
+                open: 100.0,
+                high: 105.0,
+                low: 95.0,
+                close: 100.0 + (i as f64 * 0.3).sin() * 5.0,
+                volume: 1000,
+            })
+            .collect();
+        CodeData::new(code.to_string(), "ASX".to_string(), bars)
+    }
+
+    #[test]
+    fn computes_each_series_once_and_shares_it() {
+        let code_data = vec![make_code_data("BHP", 50), make_code_data("CBA", 50)];
+        let store = IndicatorStore::new(&code_data);
+        let bhp = SymbolId(0);
+
+        let a = store.get(bhp, &IndicatorType::Ema(12));
+        let b = store.get(bhp, &IndicatorType::Ema(12));
+        store.get(SymbolId(1), &IndicatorType::Ema(12));
+
+        assert!(Arc::ptr_eq(&a, &b));
+        assert_eq!(store.computed_count(), 2);
+        assert_eq!(
+            *a,
+            *compute_indicators(&code_data[0].ohlcv, &[IndicatorType::Ema(12)])
+                [&IndicatorType::Ema(12)]
+        );
+    }
+
+    #[test]
+    fn kernels_are_shared_across_requests() {
+        let code_data = vec![make_code_data("BHP", 60)];
+        let store = IndicatorStore::new(&code_data);
+        let bhp = SymbolId(0);
+        let bollinger = |stddev_mult_x100| IndicatorType::Bollinger {
+            period: 20,
+            stddev_mult_x100,
+        };
+
+        // As if from three strategies: one rolling sum and sum of squares,
+        // and one window mean and deviation for both band widths.
+        store.indicators_for(bhp, &[IndicatorType::Sma(20), bollinger(200)]);
+        store.indicators_for(bhp, &[IndicatorType::Stddev(20)]);
+        store.indicators_for(bhp, &[bollinger(250), IndicatorType::Rsi(14)]);
+
+        assert_eq!(store.computed_count(), 5);
+        assert_eq!(store.kernel_count(), 4);
+        let types = [
+            IndicatorType::Sma(20),
+            IndicatorType::Stddev(20),
+            bollinger(200),
+            bollinger(250),
+            IndicatorType::Rsi(14),
+        ];
+        let batch = compute_indicators(&code_data[0].ohlcv, &types);
+        for t in &types {
+            assert_eq!(*store.get(bhp, t), *batch[t], "{t}");
+        }
+    }
+
+    #[test]
+    fn reuses_precomputed_code_indicators() {
+        let mut code_data = vec![make_code_data("BHP", 40)];
+        code_data[0].indicators = compute_indicators(&code_data[0].ohlcv, &[IndicatorType::Sma(5)]);
+        let store = IndicatorStore::new(&code_data);
+
+        let sma = store.get(SymbolId(0), &IndicatorType::Sma(5));
+
+        assert!(Arc::ptr_eq(
+            &sma,
+            &code_data[0].indicators[&IndicatorType::Sma(5)]
+        ));
+        assert_eq!(store.computed_count(), 0);
+    }
+
+    #[test]
+    fn concurrent_requests_share_one_computation() {
+        let code_data = vec![make_code_data("BHP", 200)];
+        let store = IndicatorStore::new(&code_data);
+        let types = [IndicatorType::Rsi(14), IndicatorType::Sma(20)];
+
+        let maps: Vec<IndicatorCache> = thread::scope(|scope| {
+            let handles: Vec<_> = (0..4)
+                .map(|_| scope.spawn(|| store.indicators_for(SymbolId(0), &types)))
+                .collect();
+            handles.into_iter().map(|h| h.join().unwrap()).collect()
+        });
+
+        assert_eq!(store.computed_count(), 2);
+        for map in &maps[1..] {
+            for t in &types {
+                assert!(Arc::ptr_eq(&map[t], &maps[0][t]));
+            }
+        }
+    }
+}
@@ -0,0 +1,1069 @@
+//! Incremental (push-a-bar) indicator computation (TRD Section 4.5).
+//!
+//! The batch functions in `indicator_helpers` recompute a whole history. An
+//! `IndicatorState` instead carries just enough state to produce the next
+//! bar's value from the previous ones, so appending new bars costs O(new
+//! bars) rather than O(history). Each state performs the same floating-point
+//! operations in the same order as its batch counterpart, so a replayed
+//! series is bit-for-bit equal to `compute_indicator` over the same
+//! non-empty history (RSI needs at least two bars).
+//!
+//! States serialize to a compact binary form (`to_bytes` / `from_bytes`) so
+//! a nightly update can persist them alongside the stored series and resume
+//! from where the previous run stopped.
+
+use crate::domain::codec::{ByteReader, ByteWriter};
+use crate::domain::error::SamtraderError;
+use crate::domain::indicator::{
+    IndicatorColumns, IndicatorSeries, IndicatorType, IndicatorValue, window_moments,
+};
+use crate::domain::indicator_kernel::RollingExtremum;
+use crate::domain::ohlcv::{OhlcvBar, OhlcvSeries};
+use std::collections::VecDeque;
+
+/// Format version written at the start of every encoded state.
+const STATE_VERSION: u8 = 2;
+
+/// Streaming state for one `IndicatorType` over one code's bars.
+#[derive(Debug, Clone)]
+pub struct IndicatorState {
+    indicator_type: IndicatorType,
+    bars_seen: usize,
+    kind: Kind,
+}
+
+/// Per-indicator running state. Windows hold the trailing inputs the next
+/// update subtracts; scalars mirror the accumulators of the batch loops.
+#[derive(Debug, Clone)]
+enum Kind {
+    Sma {
+        closes: VecDeque<f64>,
+        sum: f64,
+    },
+    /// Stddev: rolling sum and sum of squares.
+    Moments {
+        closes: VecDeque<f64>,
+        sum: f64,
+        sum_sq: f64,
+    },
+    /// Bollinger: the trailing closes, for a two-pass mean and deviation.
+    Window {
+        closes: VecDeque<f64>,
+    },
+    Ema(EmaState),
+    Wma {
+        closes: VecDeque<f64>,
+        weighted_sum: f64,
+        window_sum: f64,
+    },
+    Rsi {
+        prev_close: f64,
+        gain_sum: f64,
+        loss_sum: f64,
+        avg_gain: f64,
+        avg_loss: f64,
+    },
+    Roc {
+        closes: VecDeque<f64>,
+    },
+    Atr {
+        prev_close: f64,
+        tr_sum: f64,
+        atr: f64,
+    },
+    Obv {
+        prev_close: f64,
+        obv: f64,
+    },
+    Vwap {
+        cum_tp_vol: f64,
+        cum_vol: f64,
+    },
+    Macd {
+        fast: EmaState,
+        slow: EmaState,
+        signal_sum: f64,
+        signal_ema: f64,
+    },
+    Stochastic {
+        lows: RollingExtremum,
+        highs: RollingExtremum,
+        ks: VecDeque<f64>,
+        k_sum: f64,
+    },
+    Pivot {
+        prev_high: f64,
+        prev_low: f64,
+        prev_close: f64,
+    },
+}
+
+/// EMA seeded with the SMA of the first `period` values, as `ema_values`.
+#[derive(Debug, Clone, Default)]
+struct EmaState {
+    sum: f64,
+    ema: f64,
+}
+
+impl EmaState {
+    /// Feed value `i`; returns the EMA, or 0.0 before `period - 1`.
+    fn push(&mut self, i: usize, period: usize, value: f64) -> f64 {
+        if i < period - 1 {
+            self.sum += value;
+            0.0
+        } else if i == period - 1 {
+            self.sum += value;
+            self.ema = self.sum / period as f64;
+            self.ema
+        } else {
+            let k = 2.0 / (period as f64 + 1.0);
+            self.ema = value * k + self.ema * (1.0 - k);
+            self.ema
+        }
+    }
+
+    fn encode(&self, w: &mut ByteWriter) {
+        w.f64(self.sum);
+        w.f64(self.ema);
+    }
+
+    fn decode(r: &mut ByteReader) -> Result<Self, SamtraderError> {
+        Ok(EmaState {
+            sum: r.f64()?,
+            ema: r.f64()?,
+        })
+    }
+}
+
+/// Push `value` onto a window of at most `period` values, returning the one
+/// that fell out.
+fn slide(window: &mut VecDeque<f64>, period: usize, value: f64) -> Option<f64> {
+    window.push_back(value);
+    if window.len() > period {
+        window.pop_front()
+    } else {
+        None
+    }
+}
+
+impl IndicatorState {
+    /// Fresh state for `indicator_type`, or `None` for degenerate parameters
+    /// (a zero period) for which the batch path produces no values.
+    pub fn new(indicator_type: &IndicatorType) -> Option<Self> {
+        let kind = match *indicator_type {
+            IndicatorType::Sma(p) if p > 0 => Kind::Sma {
+                closes: VecDeque::with_capacity(p + 1),
+                sum: 0.0,
+            },
+            IndicatorType::Stddev(p) if p > 0 => Kind::Moments {
+                closes: VecDeque::with_capacity(p + 1),
+                sum: 0.0,
+                sum_sq: 0.0,
+            },
+            IndicatorType::Bollinger { period, .. } if period > 0 => Kind::Window {
+                closes: VecDeque::with_capacity(period + 1),
+            },
+            IndicatorType::Ema(p) if p > 0 => Kind::Ema(EmaState::default()),
+            IndicatorType::Wma(p) if p > 0 => Kind::Wma {
+                closes: VecDeque::with_capacity(p + 1),
+                weighted_sum: 0.0,
+                window_sum: 0.0,
+            },
+            IndicatorType::Rsi(p) if p > 0 => Kind::Rsi {
+                prev_close: 0.0,
+                gain_sum: 0.0,
+                loss_sum: 0.0,
+                avg_gain: 0.0,
+                avg_loss: 0.0,
+            },
+            IndicatorType::Roc(p) if p > 0 => Kind::Roc {
+                closes: VecDeque::with_capacity(p + 2),
+            },
+            IndicatorType::Atr(p) if p > 0 => Kind::Atr {
+                prev_close: 0.0,
+                tr_sum: 0.0,
+                atr: 0.0,
+            },
+            IndicatorType::Obv => Kind::Obv {
+                prev_close: 0.0,
+                obv: 0.0,
+            },
+            IndicatorType::Vwap => Kind::Vwap {
+                cum_tp_vol: 0.0,
+                cum_vol: 0.0,
+            },
+            IndicatorType::Macd { fast, slow, signal } if fast > 0 && slow > 0 && signal > 0 => {
+                Kind::Macd {
+                    fast: EmaState::default(),
+                    slow: EmaState::default(),
+                    signal_sum: 0.0,
+                    signal_ema: 0.0,
+                }
+            }
+            IndicatorType::Stochastic { k_period, d_period } if k_period > 0 && d_period > 0 => {
+                Kind::Stochastic {
+                    lows: RollingExtremum::min(k_period),
+                    highs: RollingExtremum::max(k_period),
+                    ks: VecDeque::with_capacity(d_period + 1),
+                    k_sum: 0.0,
+                }
+            }
+            IndicatorType::Pivot => Kind::Pivot {
+                prev_high: 0.0,
+                prev_low: 0.0,
+                prev_close: 0.0,
+            },
+            _ => return None,
+        };
+        Some(IndicatorState {
+            indicator_type: indicator_type.clone(),
+            bars_seen: 0,
+            kind,
+        })
+    }
+
+    /// Stream all of `bars` through a fresh state, returning the state
+    /// positioned after the last bar and the full series it produced.
+    pub fn replay(
+        indicator_type: &IndicatorType,
+        bars: &OhlcvSeries,
+    ) -> Option<(Self, IndicatorSeries)> {
+        let mut state = Self::new(indicator_type)?;
+        let mut series = IndicatorSeries::new(
+            indicator_type.clone(),
+            state.warmup(),
+            IndicatorColumns::empty_for(indicator_type),
+        );
+        state.extend(&mut series, bars);
+        Some((state, series))
+    }
+
+    pub fn indicator_type(&self) -> &IndicatorType {
+        &self.indicator_type
+    }
+
+    /// Number of bars pushed so far.
+    pub fn bars_seen(&self) -> usize {
+        self.bars_seen
+    }
+
+    /// Leading bars without a valid value, as in the batch `IndicatorSeries`.
+    pub fn warmup(&self) -> usize {
+        match self.indicator_type {
+            IndicatorType::Sma(p)
+            | IndicatorType::Ema(p)
+            | IndicatorType::Wma(p)
+            | IndicatorType::Atr(p)
+            | IndicatorType::Stddev(p)
+            | IndicatorType::Bollinger { period: p, .. } => p - 1,
+            IndicatorType::Rsi(p) | IndicatorType::Roc(p) => p,
+            IndicatorType::Obv | IndicatorType::Vwap => 0,
+            IndicatorType::Macd { slow, signal, .. } => slow - 1 + signal - 1,
+            IndicatorType::Stochastic { k_period, d_period } => k_period - 1 + d_period - 1,
+            IndicatorType::Pivot => 1,
+        }
+    }
+
+    /// Whether the most recently pushed value is past warmup.
+    pub fn is_ready(&self) -> bool {
+        self.bars_seen > self.warmup()
+    }
+
+    /// Consume the next bar and return its value. Values inside the warmup
+    /// are the same 0.0 placeholders the batch series stores.
+    pub fn push(&mut self, bar: &OhlcvBar) -> IndicatorValue {
+        self.push_ohlcv(bar.high, bar.low, bar.close, bar.volume)
+    }
+
+    /// `push` for bar `i` of a columnar series.
+    pub fn push_at(&mut self, bars: &OhlcvSeries, i: usize) -> IndicatorValue {
+        self.push_ohlcv(bars.high[i], bars.low[i], bars.close[i], bars.volume[i])
+    }
+
+    /// Append the bars of `bars` this state has not seen yet to `series`.
+    ///
+    /// `series` must be the output of this state so far (same type, one
+    /// value per bar seen), and `bars` the same history extended by new bars.
+    pub fn extend(&mut self, series: &mut IndicatorSeries, bars: &OhlcvSeries) {
+        assert_eq!(
+            series.indicator_type, self.indicator_type,
+            "series type differs"
+        );
+        assert_eq!(
+            series.len(),
+            self.bars_seen,
+            "series is not in step with state"
+        );
+        for i in self.bars_seen..bars.len() {
+            let value = self.push_at(bars, i);
+            series.columns.push(&value);
+        }
+    }
+
+    fn push_ohlcv(&mut self, high: f64, low: f64, close: f64, volume: i64) -> IndicatorValue {
+        let i = self.bars_seen;
+        self.bars_seen += 1;
+        let warmup = self.warmup();
+        let valid = i >= warmup;
+
+        let value = match (&self.indicator_type, &mut self.kind) {
+            (&IndicatorType::Sma(period), Kind::Sma { closes, sum }) => {
+                *sum += close;
+                if let Some(old) = slide(closes, period, close) {
+                    *sum -= old;
+                }
+                if valid { *sum / period as f64 } else { 0.0 }
+            }
+            (
+                &IndicatorType::Stddev(period),
+                Kind::Moments {
+                    closes,
+                    sum,
+                    sum_sq,
+                },
+            ) => {
+                let (_, stddev) = push_moments(closes, sum, sum_sq, period, close);
+                if valid { stddev } else { 0.0 }
+            }
+            (
+                &IndicatorType::Bollinger {
+                    period,
+                    stddev_mult_x100,
+                },
+                Kind::Window { closes },
+            ) => {
+                slide(closes, period, close);
+                let mult = stddev_mult_x100 as f64 / 100.0;
+                return if valid {
+                    let (mean, stddev) =
+                        window_moments(closes.make_contiguous(), period, period - 1);
+                    IndicatorValue::Bollinger {
+                        upper: mean + mult * stddev,
+                        middle: mean,
+                        lower: mean - mult * stddev,
+                    }
+                } else {
+                    IndicatorValue::Bollinger {
+                        upper: 0.0,
+                        middle: 0.0,
+                        lower: 0.0,
+                    }
+                };
+            }
+            (&IndicatorType::Ema(period), Kind::Ema(ema)) => ema.push(i, period, close),
+            (
+                &IndicatorType::Wma(period),
+                Kind::Wma {
+                    closes,
+                    weighted_sum,
+                    window_sum,
+                },
+            ) => {
+                if i < period {
+                    let weight = (i + 1) as f64;
+                    *weighted_sum += weight * close;
+                    *window_sum += close;
+                } else {
+                    // The window sum still covers the previous window here.
+                    *weighted_sum += period as f64 * close - *window_sum;
+                    *window_sum += close - closes[0];
+                }
+                slide(closes, period, close);
+                let divisor = (period * (period + 1)) as f64 / 2.0;
+                if valid { *weighted_sum / divisor } else { 0.0 }
+            }
+            (
+                &IndicatorType::Rsi(period),
+                Kind::Rsi {
+                    prev_close,
+                    gain_sum,
+                    loss_sum,
+                    avg_gain,
+                    avg_loss,
+                },
+            ) => {
+                let value = if i == 0 {
+                    0.0
+                } else {
+                    let change = close - *prev_close;
+                    let gain = if change > 0.0 { change } else { 0.0 };
+                    let loss = if change < 0.0 { -change } else { 0.0 };
+                    let gain_idx = i - 1;
+                    if gain_idx < period {
+                        *gain_sum += gain;
+                        *loss_sum += loss;
+                    }
+                    if gain_idx < period - 1 {
+                        0.0
+                    } else {
+                        if gain_idx == period - 1 {
+                            *avg_gain = *gain_sum / period as f64;
+                            *avg_loss = *loss_sum / period as f64;
+                        } else {
+                            *avg_gain = (*avg_gain * (period - 1) as f64 + gain) / period as f64;
+                            *avg_loss = (*avg_loss * (period - 1) as f64 + loss) / period as f64;
+                        }
+                        if *avg_loss == 0.0 {
+                            100.0
+                        } else {
+                            100.0 - (100.0 / (1.0 + *avg_gain / *avg_loss))
+                        }
+                    }
+                };
+                *prev_close = close;
+                value
+            }
+            (&IndicatorType::Roc(period), Kind::Roc { closes }) => {
+                slide(closes, period + 1, close);
+                if valid {
+                    let prev_close = closes[0];
+                    if prev_close == 0.0 {
+                        0.0
+                    } else {
+                        ((close - prev_close) / prev_close) * 100.0
+                    }
+                } else {
+                    0.0
+                }
+            }
+            (
+                &IndicatorType::Atr(period),
+                Kind::Atr {
+                    prev_close,
+                    tr_sum,
+                    atr,
+                },
+            ) => {
+                let tr = if i == 0 {
+                    high - low
+                } else {
+                    let hl = high - low;
+                    let hc = (high - *prev_close).abs();
+                    let lc = (low - *prev_close).abs();
+                    hl.max(hc).max(lc)
+                };
+                *prev_close = close;
+                if i < period - 1 {
+                    *tr_sum += tr;
+                    0.0
+                } else if i == period - 1 {
+                    *tr_sum += tr;
+                    *atr = *tr_sum / period as f64;
+                    *atr
+                } else {
+                    *atr = (*atr * (period - 1) as f64 + tr) / period as f64;
+                    *atr
+                }
+            }
+            (IndicatorType::Obv, Kind::Obv { prev_close, obv }) => {
+                if i == 0 {
+                    *obv = volume as f64;
+                } else {
+                    let change = close - *prev_close;
+                    if change > 0.0 {
+                        *obv += volume as f64;
+                    } else if change < 0.0 {
+                        *obv -= volume as f64;
+                    }
+                }
+                *prev_close = close;
+                *obv
+            }
+            (
+                IndicatorType::Vwap,
+                Kind::Vwap {
+                    cum_tp_vol,
+                    cum_vol,
+                },
+            ) => {
+                let tp = (high + low + close) / 3.0;
+                *cum_tp_vol += tp * volume as f64;
+                *cum_vol += volume as f64;
+                if *cum_vol == 0.0 {
+                    0.0
+                } else {
+                    *cum_tp_vol / *cum_vol
+                }
+            }
+            (
+                &IndicatorType::Macd {
+                    fast: fast_period,
+                    slow: slow_period,
+                    signal,
+                },
+                Kind::Macd {
+                    fast,
+                    slow,
+                    signal_sum,
+                    signal_ema,
+                },
+            ) => {
+                let line = fast.push(i, fast_period, close) - slow.push(i, slow_period, close);
+                let macd_warmup = slow_period - 1;
+                let signal_value = if i < macd_warmup {
+                    0.0
+                } else if i < macd_warmup + signal {
+                    *signal_sum += line;
+                    if i == macd_warmup + signal - 1 {
+                        *signal_ema = *signal_sum / signal as f64;
+                        *signal_ema
+                    } else {
+                        0.0
+                    }
+                } else {
+                    let k = 2.0 / (signal as f64 + 1.0);
+                    *signal_ema = line * k + *signal_ema * (1.0 - k);
+                    *signal_ema
+                };
+                return IndicatorValue::Macd {
+                    line,
+                    signal: signal_value,
+                    histogram: line - signal_value,
+                };
+            }
+            (
+                &IndicatorType::Stochastic { k_period, d_period },
+                Kind::Stochastic {
+                    lows,
+                    highs,
+                    ks,
+                    k_sum,
+                },
+            ) => {
+                let (lowest_low, highest_high) = (lows.push(low), highs.push(high));
+                let k = if i >= k_period - 1 {
+                    if (highest_high - lowest_low).abs() < f64::EPSILON {
+                        50.0
+                    } else {
+                        100.0 * (close - lowest_low) / (highest_high - lowest_low)
+                    }
+                } else {
+                    0.0
+                };
+                *k_sum += k;
+                if let Some(old) = slide(ks, d_period, k) {
+                    *k_sum -= old;
+                }
+                let d = if valid { *k_sum / d_period as f64 } else { 0.0 };
+                return IndicatorValue::Stochastic { k, d };
+            }
+            (
+                IndicatorType::Pivot,
+                Kind::Pivot {
+                    prev_high,
+                    prev_low,
+                    prev_close,
+                },
+            ) => {
+                let value = if i == 0 {
+                    IndicatorValue::Pivot {
+                        pivot: 0.0,
+                        r1: 0.0,
+                        r2: 0.0,
+                        r3: 0.0,
+                        s1: 0.0,
+                        s2: 0.0,
+                        s3: 0.0,
+                    }
+                } else {
+                    let (h, l, c) = (*prev_high, *prev_low, *prev_close);
+                    let p = (h + l + c) / 3.0;
+                    IndicatorValue::Pivot {
+                        pivot: p,
+                        r1: (2.0 * p) - l,
+                        r2: p + (h - l),
+                        r3: h + 2.0 * (p - l),
+                        s1: (2.0 * p) - h,
+                        s2: p - (h - l),
+                        s3: l - 2.0 * (h - p),
+                    }
+                };
+                (*prev_high, *prev_low, *prev_close) = (high, low, close);
+                return value;
+            }
+            (indicator_type, _) => unreachable!("state kind does not match {indicator_type}"),
+        };
+        IndicatorValue::Simple(value)
+    }
+
+    /// Encode this state (type, position and accumulators) losslessly.
+    pub fn to_bytes(&self) -> Vec<u8> {
+        let mut w = ByteWriter::new();
+        w.u8(STATE_VERSION);
+        encode_type(&mut w, &self.indicator_type);
+        w.usize(self.bars_seen);
+        self.kind.encode(&mut w);
+        w.into_bytes()
+    }
+
+    /// Decode a state written by `to_bytes`.
+    pub fn from_bytes(bytes: &[u8]) -> Result<Self, SamtraderError> {
+        let mut r = ByteReader::new(bytes, "indicator state");
+        let version = r.u8()?;
+        if version != STATE_VERSION {
+            return Err(r.error(format!("unsupported version {version}")));
+        }
+        let indicator_type = decode_type(&mut r)?;
+        let bars_seen = r.usize()?;
+        let Some(fresh) = Self::new(&indicator_type) else {
+            return Err(r.error(format!("degenerate indicator {indicator_type}")));
+        };
+        let kind = fresh.kind.decode(&mut r)?;
+        kind.check(&indicator_type, bars_seen)
+            .map_err(|reason| r.error(reason))?;
+        r.finish()?;
+        Ok(IndicatorState {
+            indicator_type,
+            bars_seen,
+            kind,
+        })
+    }
+}
+
+/// Add `close` to a rolling sum and sum of squares over `period` closes and
+/// return `(mean, population stddev)`, as `stddev_from` computes them.
+fn push_moments(
+    closes: &mut VecDeque<f64>,
+    sum: &mut f64,
+    sum_sq: &mut f64,
+    period: usize,
+    close: f64,
+) -> (f64, f64) {
+    *sum += close;
+    *sum_sq += close * close;
+    if let Some(old) = slide(closes, period, close) {
+        *sum -= old;
+        *sum_sq -= old * old;
+    }
+    let mean = *sum / period as f64;
+    let variance = *sum_sq / period as f64 - mean * mean;
+    (mean, variance.max(0.0).sqrt())
+}
+
+impl Kind {
+    fn encode(&self, w: &mut ByteWriter) {
+        match self {
+            Kind::Sma { closes, sum } => {
+                w.f64s(closes.iter());
+                w.f64(*sum);
+            }
+            Kind::Moments {
+                closes,
+                sum,
+                sum_sq,
+            } => {
+                w.f64s(closes.iter());
+                w.f64(*sum);
+                w.f64(*sum_sq);
+            }
+            Kind::Ema(ema) => ema.encode(w),
+            Kind::Wma {
+                closes,
+                weighted_sum,
+                window_sum,
+            } => {
+                w.f64s(closes.iter());
+                w.f64(*weighted_sum);
+                w.f64(*window_sum);
+            }
+            Kind::Rsi {
+                prev_close,
+                gain_sum,
+                loss_sum,
+                avg_gain,
+                avg_loss,
+            } => {
+                for v in [prev_close, gain_sum, loss_sum, avg_gain, avg_loss] {
+                    w.f64(*v);
+                }
+            }
+            Kind::Roc { closes } | Kind::Window { closes } => w.f64s(closes.iter()),
+            Kind::Atr {
+                prev_close,
+                tr_sum,
+                atr,
+            } => {
+                for v in [prev_close, tr_sum, atr] {
+                    w.f64(*v);
+                }
+            }
+            Kind::Obv { prev_close, obv } => {
+                w.f64(*prev_close);
+                w.f64(*obv);
+            }
+            Kind::Vwap {
+                cum_tp_vol,
+                cum_vol,
+            } => {
+                w.f64(*cum_tp_vol);
+                w.f64(*cum_vol);
+            }
+            Kind::Macd {
+                fast,
+                slow,
+                signal_sum,
+                signal_ema,
+            } => {
+                fast.encode(w);
+                slow.encode(w);
+                w.f64(*signal_sum);
+                w.f64(*signal_ema);
+            }
+            Kind::Stochastic {
+                lows,
+                highs,
+                ks,
+                k_sum,
+            } => {
+                lows.encode(w);
+                highs.encode(w);
+                w.f64s(ks.iter());
+                w.f64(*k_sum);
+            }
+            Kind::Pivot {
+                prev_high,
+                prev_low,
+                prev_close,
+            } => {
+                for v in [prev_high, prev_low, prev_close] {
+                    w.f64(*v);
+                }
+            }
+        }
+    }
+
+    /// Decode fields into the shape of `self` (a fresh state of the same
+    /// indicator type).
+    fn decode(self, r: &mut ByteReader) -> Result<Kind, SamtraderError> {
+        let window = |r: &mut ByteReader| r.f64s().map(VecDeque::from);
+        Ok(match self {
+            Kind::Sma { .. } => Kind::Sma {
+                closes: window(r)?,
+                sum: r.f64()?,
+            },
+            Kind::Moments { .. } => Kind::Moments {
+                closes: window(r)?,
+                sum: r.f64()?,
+                sum_sq: r.f64()?,
+            },
+            Kind::Ema(_) => Kind::Ema(EmaState::decode(r)?),
+            Kind::Wma { .. } => Kind::Wma {
+                closes: window(r)?,
+                weighted_sum: r.f64()?,
+                window_sum: r.f64()?,
+            },
+            Kind::Rsi { .. } => Kind::Rsi {
+                prev_close: r.f64()?,
+                gain_sum: r.f64()?,
+                loss_sum: r.f64()?,
+                avg_gain: r.f64()?,
+                avg_loss: r.f64()?,
+            },
+            Kind::Roc { .. } => Kind::Roc { closes: window(r)? },
+            Kind::Window { .. } => Kind::Window { closes: window(r)? },
+            Kind::Atr { .. } => Kind::Atr {
+                prev_close: r.f64()?,
+                tr_sum: r.f64()?,
+                atr: r.f64()?,
+            },
+            Kind::Obv { .. } => Kind::Obv {
+                prev_close: r.f64()?,
+                obv: r.f64()?,
+            },
+            Kind::Vwap { .. } => Kind::Vwap {
+                cum_tp_vol: r.f64()?,
+                cum_vol: r.f64()?,
+            },
+            Kind::Macd { .. } => Kind::Macd {
+                fast: EmaState::decode(r)?,
+                slow: EmaState::decode(r)?,
+                signal_sum: r.f64()?,
+                signal_ema: r.f64()?,
+            },
+            Kind::Stochastic { .. } => Kind::Stochastic {
+                lows: RollingExtremum::decode(r)?,
+                highs: RollingExtremum::decode(r)?,
+                ks: window(r)?,
+                k_sum: r.f64()?,
+            },
+            Kind::Pivot { .. } => Kind::Pivot {
+                prev_high: r.f64()?,
+                prev_low: r.f64()?,
+                prev_close: r.f64()?,
+            },
+        })
+    }
+}
+
+impl Kind {
+    /// Check a decoded state against its type and bar count, so a corrupt
+    /// state is rejected here rather than panicking in `push`: each window
+    /// must hold exactly the trailing values `bars_seen` bars leave in it.
+    fn check(&self, indicator_type: &IndicatorType, bars_seen: usize) -> Result<(), String> {
+        let expect = |name: &str, len: usize, capacity: usize| {
+            let want = bars_seen.min(capacity);
+            if len == want {
+                Ok(())
+            } else {
+                Err(format!(
+                    "{name} window holds {len} values, expected {want} after {bars_seen} bars"
+                ))
+            }
+        };
+        match (indicator_type, self) {
+            (&IndicatorType::Sma(period), Kind::Sma { closes, .. })
+            | (&IndicatorType::Stddev(period), Kind::Moments { closes, .. })
+            | (&IndicatorType::Bollinger { period, .. }, Kind::Window { closes })
+            | (&IndicatorType::Wma(period), Kind::Wma { closes, .. }) => {
+                expect("close", closes.len(), period)
+            }
+            (&IndicatorType::Roc(period), Kind::Roc { closes }) => {
+                expect("close", closes.len(), period + 1)
+            }
+            (
+                &IndicatorType::Stochastic { k_period, d_period },
+                Kind::Stochastic {
+                    lows, highs, ks, ..
+                },
+            ) => {
+                if !lows.is_window(k_period, false, bars_seen)
+                    || !highs.is_window(k_period, true, bars_seen)
+                {
+                    return Err(format!(
+                        "low/high windows do not match {indicator_type} after {bars_seen} bars"
+                    ));
+                }
+                expect("%K", ks.len(), d_period)
+            }
+            _ => Ok(()),
+        }
+    }
+}
+
+fn encode_type(w: &mut ByteWriter, indicator_type: &IndicatorType) {
+    let single = |w: &mut ByteWriter, tag: u8, period: usize| {
+        w.u8(tag);
+        w.usize(period);
+    };
+    match *indicator_type {
+        IndicatorType::Sma(p) => single(w, 0, p),
+        IndicatorType::Ema(p) => single(w, 1, p),
+        IndicatorType::Wma(p) => single(w, 2, p),
+        IndicatorType::Rsi(p) => single(w, 3, p),
+        IndicatorType::Roc(p) => single(w, 4, p),
+        IndicatorType::Atr(p) => single(w, 5, p),
+        IndicatorType::Stddev(p) => single(w, 6, p),
+        IndicatorType::Obv => w.u8(7),
+        IndicatorType::Vwap => w.u8(8),
+        IndicatorType::Macd { fast, slow, signal } => {
+            w.u8(9);
+            w.usize(fast);
+            w.usize(slow);
+            w.usize(signal);
+        }
+        IndicatorType::Stochastic { k_period, d_period } => {
+            w.u8(10);
+            w.usize(k_period);
+            w.usize(d_period);
+        }
+        IndicatorType::Bollinger {
+            period,
+            stddev_mult_x100,
+        } => {
+            w.u8(11);
+            w.usize(period);
+            w.u32(stddev_mult_x100);
+        }
+        IndicatorType::Pivot => w.u8(12),
+    }
+}
+
+fn decode_type(r: &mut ByteReader) -> Result<IndicatorType, SamtraderError> {
+    Ok(match r.u8()? {
+        0 => IndicatorType::Sma(r.usize()?),
+        1 => IndicatorType::Ema(r.usize()?),
+        2 => IndicatorType::Wma(r.usize()?),
+        3 => IndicatorType::Rsi(r.usize()?),
+        4 => IndicatorType::Roc(r.usize()?),
+        5 => IndicatorType::Atr(r.usize()?),
+        6 => IndicatorType::Stddev(r.usize()?),
+        7 => IndicatorType::Obv,
+        8 => IndicatorType::Vwap,
+        9 => IndicatorType::Macd {
+            fast: r.usize()?,
+            slow: r.usize()?,
+            signal: r.usize()?,
+        },
+        10 => IndicatorType::Stochastic {
+            k_period: r.usize()?,
+            d_period: r.usize()?,
+        },
+        11 => IndicatorType::Bollinger {
+            period: r.usize()?,
+            stddev_mult_x100: r.u32()?,
+        },
+        12 => IndicatorType::Pivot,
+        tag => return Err(r.error(format!("unknown indicator tag {tag}"))),
+    })
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::domain::indicator_helpers::compute_indicator;
+    use chrono::NaiveDate;
+
+    fn all_types() -> Vec<IndicatorType> {
+        vec![
+            IndicatorType::Sma(20),
+            IndicatorType::Ema(12),
+            IndicatorType::Wma(10),
+            IndicatorType::Rsi(14),
+            IndicatorType::Roc(5),
+            IndicatorType::Atr(14),
+            IndicatorType::Stddev(20),
+            IndicatorType::Obv,
+            IndicatorType::Vwap,
+            IndicatorType::Macd {
+                fast: 12,
+                slow: 26,
+                signal: 9,
+            },
+            IndicatorType::Stochastic {
+                k_period: 14,
+                d_period: 3,
+            },
+            IndicatorType::Bollinger {
+                period: 20,
+                stddev_mult_x100: 200,
+            },
+            IndicatorType::Pivot,
+        ]
+    }
+
+    /// Uneven prices with flat stretches, gaps and a zero-range bar.
+    fn history(n: usize) -> OhlcvSeries {
+        let start = NaiveDate::from_ymd_opt(2020, 1, 1).unwrap();
+        (0..n)
+            .map(|i| {
+                let close = if i % 17 < 3 {
+                    100.0
+                } else {
+                    100.0 + 9.0 * (i as f64 * 0.37).sin() + (i % 5) as f64 * 0.1
+                };
+                let spread = if i == 40 { 0.0 } else { 1.0 + (i % 3) as f64 };
+                OhlcvBar {
+                    code: "BHP".into(),
+                    exchange: "ASX".into(),
+                    date: start + chrono::Duration::days(i as i64),
+                    open: close,
+                    high: close + spread,
+                    low: close - spread * 0.5,
+                    close,
+                    volume: 1000 + (i as i64 % 7) * 150,
+                }
+            })
+            .collect()
+    }
+
+    #[test]
+    fn replay_matches_batch_for_every_type() {
+        let bars = history(150);
+        for it in all_types() {
+            let (state, series) = IndicatorState::replay(&it, &bars).unwrap();
+            assert_eq!(series, compute_indicator(&bars, &it), "{it} differs");
+            assert_eq!(state.bars_seen(), bars.len());
+            assert!(state.is_ready());
+        }
+    }
+
+    #[test]
+    fn resumed_state_matches_batch() {
+        let bars = history(150);
+        let head: OhlcvSeries = bars.to_bars("BHP", "ASX")[..90].iter().cloned().collect();
+        for it in all_types() {
+            let (state, mut series) = IndicatorState::replay(&it, &head).unwrap();
+            let mut resumed = IndicatorState::from_bytes(&state.to_bytes()).unwrap();
+            assert_eq!(resumed.indicator_type(), &it);
+
+            resumed.extend(&mut series, &bars);
+
+            assert_eq!(series, compute_indicator(&bars, &it), "{it} differs");
+        }
+    }
+
+    #[test]
+    fn push_reports_readiness_after_warmup() {
+        let bars = history(5).to_bars("BHP", "ASX");
+        let mut state = IndicatorState::new(&IndicatorType::Sma(3)).unwrap();
+
+        assert_eq!(state.push(&bars[0]), IndicatorValue::Simple(0.0));
+        state.push(&bars[1]);
+        assert!(!state.is_ready());
+        let IndicatorValue::Simple(sma) = state.push(&bars[2]) else {
+            panic!("expected Simple value");
+        };
+        assert!(state.is_ready());
+        assert!((sma - (bars[0].close + bars[1].close + bars[2].close) / 3.0).abs() < 1e-12);
+    }
+
+    #[test]
+    fn degenerate_types_have_no_state() {
+        assert!(IndicatorState::new(&IndicatorType::Sma(0)).is_none());
+        assert!(
+            IndicatorState::new(&IndicatorType::Macd {
+                fast: 12,
+                slow: 0,
+                signal: 9
+            })
+            .is_none()
+        );
+    }
+
+    #[test]
+    fn corrupt_state_is_rejected() {
+        let (state, _) = IndicatorState::replay(&IndicatorType::Rsi(14), &history(30)).unwrap();
+        let bytes = state.to_bytes();
+
+        assert!(IndicatorState::from_bytes(&bytes[..bytes.len() - 1]).is_err());
+        let mut bad_version = bytes.clone();
+        bad_version[0] = 99;
+        assert!(matches!(
+            IndicatorState::from_bytes(&bad_version),
+            Err(SamtraderError::Decode { .. })
+        ));
+    }
+
+    #[test]
+    fn inconsistent_windows_are_rejected() {
+        let bars = history(30);
+        for it in all_types() {
+            let (state, _) = IndicatorState::replay(&it, &bars).unwrap();
+
+            // Claiming more bars than the windows reflect must not decode
+            // into a state that would misbehave (or panic) on the next push.
+            let mut ahead = state.clone();
+            ahead.bars_seen = 3;
+            let decoded = IndicatorState::from_bytes(&ahead.to_bytes());
+            match it {
+                IndicatorType::Sma(_)
+                | IndicatorType::Wma(_)
+                | IndicatorType::Roc(_)
+                | IndicatorType::Stddev(_)
+                | IndicatorType::Bollinger { .. }
+                | IndicatorType::Stochastic { .. } => {
+                    assert!(decoded.is_err(), "{it} accepted a bad bar count")
+                }
+                _ => assert!(decoded.is_ok()),
+            }
+        }
+
+        let mut wma = IndicatorState::replay(&IndicatorType::Wma(10), &bars)
+            .unwrap()
+            .0;
+        if let Kind::Wma { closes, .. } = &mut wma.kind {
+            closes.clear();
+        }
+        assert!(IndicatorState::from_bytes(&wma.to_bytes()).is_err());
+    }
+}
@@ -0,0 +1,380 @@
+//! Per-code data loading and indicator pre-computation (TRD Section 8.1).
+//!
+//! Each code is independent, so fetching OHLCV and computing its indicators
+//! is fanned out over a scoped worker pool. Workers pull the next code index
+//! from a shared counter; results are written back by index so the returned
+//! order always matches the input `codes` order, whatever the thread timing.
+
+use crate::domain::code_data::CodeData;
+use crate::domain::error::SamtraderError;
+use crate::domain::indicator::IndicatorType;
+use crate::domain::indicator_helpers::compute_indicators;
+use crate::domain::ohlcv::OhlcvSeries;
+use crate::ports::data_port::DataPort;
+use chrono::NaiveDate;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::thread;
+
+/// Resolve a configured worker count: `0` means one worker per available core.
+pub fn resolve_workers(workers: usize) -> usize {
+    if workers > 0 {
+        workers
+    } else {
+        thread::available_parallelism()
+            .map(|n| n.get())
+            .unwrap_or(1)
+    }
+}
+
+/// Fetch the OHLCV series for every code, without computing indicators.
+///
+/// Codes are split into one contiguous batch per worker and each batch goes
+/// through `DataPort::fetch_ohlcv_batch`, so a database adapter answers a
+/// whole batch with a single query. If a batch fails, its codes are retried
+/// one by one so a single bad code (such as a missing CSV file) only costs
+/// its own slot. The exception is a connection or pool failure
+/// (`SamtraderError::Database`) from a port whose batch is one query: that
+/// fails the whole fetch, since retrying code by code would only repeat it.
+///
+/// Returns one result per code, in the same order as `codes`. With a worker
+/// count of 1 (or a single code) everything runs on the calling thread.
+pub fn fetch_code_data(
+    data_port: &dyn DataPort,
+    codes: &[String],
+    exchange: &str,
+    start_date: NaiveDate,
+    end_date: NaiveDate,
+    workers: usize,
+) -> Result<Vec<Result<CodeData, SamtraderError>>, SamtraderError> {
+    let workers = resolve_workers(workers);
+    let batch_size = codes.len().div_ceil(workers).max(1);
+    let batches: Vec<&[String]> = codes.chunks(batch_size).collect();
+
+    par_map(&batches, workers, |batch| {
+        let to_code_data = |(code, ohlcv): (&String, OhlcvSeries)| {
+            CodeData::new(code.clone(), exchange.to_string(), ohlcv)
+        };
+        match data_port.fetch_ohlcv_batch(batch, exchange, start_date, end_date) {
+            Ok(series) => Ok(batch.iter().zip(series).map(to_code_data).map(Ok).collect()),
+            Err(e @ SamtraderError::Database { .. }) if data_port.batch_is_one_query() => Err(e),
+            Err(_) => Ok(batch
+                .iter()
+                .map(|code| {
+                    data_port
+                        .fetch_ohlcv_series(code, exchange, start_date, end_date)
+                        .map(|ohlcv| to_code_data((code, ohlcv)))
+                })
+                .collect::<Vec<_>>()),
+        }
+    })
+    .into_iter()
+    .collect::<Result<Vec<_>, _>>()
+    .map(|batches| batches.into_iter().flatten().collect())
+}
+
+/// Compute `indicator_types` for every already-loaded code in parallel.
+pub fn compute_code_indicators(
+    code_data: &mut [CodeData],
+    indicator_types: &[IndicatorType],
+    workers: usize,
+) {
+    let computed = par_map(code_data, workers, |cd| {
+        compute_indicators(&cd.ohlcv, indicator_types)
+    });
+    for (cd, indicators) in code_data.iter_mut().zip(computed) {
+        cd.indicators = indicators;
+    }
+}
+
+/// Map `f` over `items` on up to `workers` scoped threads, keeping input order.
+fn par_map<T, R, F>(items: &[T], workers: usize, f: F) -> Vec<R>
+where
+    T: Sync,
+    R: Send,
+    F: Fn(&T) -> R + Sync,
+{
+    let workers = resolve_workers(workers).min(items.len());
+    if workers <= 1 {
+        return items.iter().map(f).collect();
+    }
+
+    let next = AtomicUsize::new(0);
+    let mut slots: Vec<Option<R>> = (0..items.len()).map(|_| None).collect();
+
+    thread::scope(|scope| {
+        let handles: Vec<_> = (0..workers)
+            .map(|_| {
+                scope.spawn(|| {
+                    let mut done = Vec::new();
+                    loop {
+                        let i = next.fetch_add(1, Ordering::Relaxed);
+                        if i >= items.len() {
+                            break;
+                        }
+                        done.push((i, f(&items[i])));
+                    }
+                    done
+                })
+            })
+            .collect();
+
+        for handle in handles {
+            let done = handle
+                .join()
+                .unwrap_or_else(|panic| std::panic::resume_unwind(panic));
+            for (i, result) in done {
+                slots[i] = Some(result);
+            }
+        }
+    });
+
+    slots
+        .into_iter()
+        .map(|slot| slot.expect("every index is claimed by exactly one worker"))
+        .collect()
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::domain::ohlcv::OhlcvBar;
+    use std::collections::HashMap;
+
+    struct MockDataPort {
+        data: HashMap<String, Vec<OhlcvBar>>,
+        batch_error: Option<fn() -> SamtraderError>,
+        one_query: bool,
+    }
+
+    impl MockDataPort {
+        fn with_codes(codes: &[&str], bars: usize) -> Self {
+            let data = codes
+                .iter()
+                .enumerate()
+                .map(|(n, code)| {
+                    let series = (0..bars)
+                        .map(|i| OhlcvBar {
+                            code: code.to_string(),
+                            exchange: "ASX".to_string(),
+                            date: NaiveDate::from_ymd_opt(2024, 1, 1).unwrap()
+                                + chrono::Duration::days(i as i64),
+                            open: 100.0,
+                            high: 110.0,
+                            low: 90.0,
+                            close: 100.0 + n as f64 + i as f64,
+                            volume: 1000,
+                        })
+                        .collect();
+                    (code.to_string(), series)
+                })
+                .collect();
+            Self {
+                data,
+                batch_error: None,
+                one_query: false,
+            }
+        }
+    }
+
+    impl DataPort for MockDataPort {
+        fn fetch_ohlcv(
+            &self,
+            code: &str,
+            _exchange: &str,
+            _start_date: NaiveDate,
+            _end_date: NaiveDate,
+        ) -> Result<Vec<OhlcvBar>, SamtraderError> {
+            self.data
+                .get(code)
+                .cloned()
+                .ok_or_else(|| SamtraderError::NoData {
+                    code: code.to_string(),
+                    exchange: "ASX".to_string(),
+                })
+        }
+
+        fn fetch_ohlcv_batch(
+            &self,
+            codes: &[String],
+            exchange: &str,
+            start_date: NaiveDate,
+            end_date: NaiveDate,
+        ) -> Result<Vec<OhlcvSeries>, SamtraderError> {
+            if let Some(error) = self.batch_error {
+                return Err(error());
+            }
+            codes
+                .iter()
+                .map(|code| self.fetch_ohlcv_series(code, exchange, start_date, end_date))
+                .collect()
+        }
+
+        fn batch_is_one_query(&self) -> bool {
+            self.one_query
+        }
+
+        fn list_symbols(&self, _exchange: &str) -> Result<Vec<String>, SamtraderError> {
+            Ok(self.data.keys().cloned().collect())
+        }
+
+        fn get_data_range(
+            &self,
+            _code: &str,
+            _exchange: &str,
+        ) -> Result<Option<(NaiveDate, NaiveDate, usize)>, SamtraderError> {
+            Ok(None)
+        }
+    }
+
+    fn codes(names: &[&str]) -> Vec<String> {
+        names.iter().map(|s| s.to_string()).collect()
+    }
+
+    fn range() -> (NaiveDate, NaiveDate) {
+        (
+            NaiveDate::from_ymd_opt(2024, 1, 1).unwrap(),
+            NaiveDate::from_ymd_opt(2024, 12, 31).unwrap(),
+        )
+    }
+
+    /// Fetch then compute indicators, as the backtest pipeline does.
+    fn load(
+        port: &MockDataPort,
+        names: &[&str],
+        types: &[IndicatorType],
+        workers: usize,
+    ) -> Vec<CodeData> {
+        let (start, end) = range();
+        let mut loaded: Vec<CodeData> =
+            fetch_code_data(port, &codes(names), "ASX", start, end, workers)
+                .unwrap()
+                .into_iter()
+                .map(Result::unwrap)
+                .collect();
+        compute_code_indicators(&mut loaded, types, workers);
+        loaded
+    }
+
+    #[test]
+    fn resolve_workers_zero_means_auto() {
+        assert_eq!(resolve_workers(3), 3);
+        assert!(resolve_workers(0) >= 1);
+    }
+
+    #[test]
+    fn parallel_load_preserves_input_order() {
+        let names = ["BHP", "CBA", "NAB", "WBC", "RIO", "CSL", "WES", "ANZ"];
+        let port = MockDataPort::with_codes(&names, 40);
+
+        let loaded = load(&port, &names, &[IndicatorType::Sma(5)], 4);
+
+        let order: Vec<&str> = loaded.iter().map(|cd| cd.code.as_str()).collect();
+        assert_eq!(order, names);
+        for cd in &loaded {
+            assert_eq!(cd.bar_count(), 40);
+            assert!(cd.indicators.contains_key(&IndicatorType::Sma(5)));
+        }
+    }
+
+    #[test]
+    fn parallel_load_matches_sequential() {
+        let names = ["BHP", "CBA", "NAB"];
+        let port = MockDataPort::with_codes(&names, 30);
+        let types = vec![IndicatorType::Sma(3), IndicatorType::Rsi(14)];
+
+        let sequential = load(&port, &names, &types, 1);
+        let parallel = load(&port, &names, &types, 3);
+
+        for (a, b) in sequential.iter().zip(&parallel) {
+            assert_eq!(a.code, b.code);
+            assert_eq!(a.ohlcv, b.ohlcv);
+            assert_eq!(a.indicators, b.indicators);
+        }
+    }
+
+    #[test]
+    fn fetch_leaves_indicators_to_compute() {
+        let names = ["BHP", "CBA", "NAB", "WBC"];
+        let port = MockDataPort::with_codes(&names, 30);
+        let (start, end) = range();
+
+        let fetched = fetch_code_data(&port, &codes(&names), "ASX", start, end, 3).unwrap();
+        assert!(
+            fetched
+                .iter()
+                .all(|r| r.as_ref().unwrap().indicators.is_empty())
+        );
+
+        let types = vec![IndicatorType::Ema(5)];
+        for cd in load(&port, &names, &types, 3) {
+            assert_eq!(cd.indicators, compute_indicators(&cd.ohlcv, &types));
+        }
+    }
+
+    #[test]
+    fn failed_codes_keep_their_slot() {
+        let port = MockDataPort::with_codes(&["BHP", "NAB"], 30);
+        let (start, end) = range();
+
+        let loaded = fetch_code_data(
+            &port,
+            &codes(&["BHP", "MISSING", "NAB"]),
+            "ASX",
+            start,
+            end,
+            2,
+        )
+        .unwrap();
+
+        assert_eq!(loaded.len(), 3);
+        assert!(loaded[0].is_ok());
+        assert!(matches!(loaded[1], Err(SamtraderError::NoData { .. })));
+        assert_eq!(loaded[2].as_ref().unwrap().code, "NAB");
+    }
+
+    #[test]
+    fn failed_batch_falls_back_to_per_code_fetch() {
+        let mut port = MockDataPort::with_codes(&["BHP", "CBA"], 30);
+        port.batch_error = Some(|| SamtraderError::Database {
+            reason: "batch query failed".to_string(),
+        });
+        let (start, end) = range();
+
+        let fetched =
+            fetch_code_data(&port, &codes(&["BHP", "CBA"]), "ASX", start, end, 1).unwrap();
+
+        assert_eq!(fetched.len(), 2);
+        assert_eq!(fetched[0].as_ref().unwrap().code, "BHP");
+        assert_eq!(fetched[1].as_ref().unwrap().bar_count(), 30);
+    }
+
+    #[test]
+    fn failed_query_falls_back_to_per_code_fetch() {
+        let mut port = MockDataPort::with_codes(&["BHP", "CBA"], 30);
+        port.one_query = true;
+        port.batch_error = Some(|| SamtraderError::DatabaseQuery {
+            reason: "invalid row".to_string(),
+        });
+        let (start, end) = range();
+
+        let fetched =
+            fetch_code_data(&port, &codes(&["BHP", "CBA"]), "ASX", start, end, 1).unwrap();
+
+        assert!(fetched.iter().all(Result::is_ok));
+    }
+
+    #[test]
+    fn connection_error_from_one_query_batch_fails_the_fetch() {
+        let mut port = MockDataPort::with_codes(&["BHP", "CBA", "NAB"], 30);
+        port.one_query = true;
+        port.batch_error = Some(|| SamtraderError::Database {
+            reason: "connection refused".to_string(),
+        });
+        let (start, end) = range();
+
+        let result = fetch_code_data(&port, &codes(&["BHP", "CBA", "NAB"]), "ASX", start, end, 2);
+        assert!(
+            matches!(result, Err(SamtraderError::Database { reason }) if reason == "connection refused")
+        );
+    }
+}
@@ -1,18 +1,28 @@
 //! Core domain types and logic (TRD Section 2).
 
 pub mod backtest;
+pub mod checkpoint;
 pub mod code_data;
+pub mod codec;
 pub mod config_validation;
 pub mod error;
 pub mod execution;
 pub mod indicator;
 pub mod indicator_helpers;
+pub mod indicator_kernel;
+pub mod indicator_store;
+pub mod indicator_stream;
+pub mod loader;
 pub mod metrics;
 pub mod ohlcv;
 pub mod portfolio;
 pub mod position;
 pub mod rule;
+pub mod rule_compile;
 pub mod rule_eval;
 pub mod rule_parser;
+pub mod signal;
 pub mod strategy;
+pub mod sweep;
+pub mod symbol;
 pub mod universe;
@@ -1,4 +1,7 @@
 //! OHLCV bar representation (TRD Section 3.1).
+//!
+//! `OhlcvBar` is the row type exchanged with adapters; `OhlcvSeries` is the
+//! columnar store the backtest engine keeps per code.
 
 use chrono::NaiveDate;
 
@@ -29,6 +32,169 @@ impl OhlcvBar {
     }
 }
 
+/// Columnar OHLCV storage for a single code (TRD Section 3.1).
+///
+/// Each field lives in its own contiguous vector, so indicator kernels and the
+/// rule evaluator that only read `close` stream one column instead of whole
+/// rows. The code and exchange are held once by the owning `CodeData` rather
+/// than on every bar.
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct OhlcvSeries {
+    pub date: Vec<NaiveDate>,
+    pub open: Vec<f64>,
+    pub high: Vec<f64>,
+    pub low: Vec<f64>,
+    pub close: Vec<f64>,
+    pub volume: Vec<i64>,
+}
+
+impl OhlcvSeries {
+    pub fn new() -> Self {
+        Self::default()
+    }
+
+    pub fn with_capacity(capacity: usize) -> Self {
+        Self {
+            date: Vec::with_capacity(capacity),
+            open: Vec::with_capacity(capacity),
+            high: Vec::with_capacity(capacity),
+            low: Vec::with_capacity(capacity),
+            close: Vec::with_capacity(capacity),
+            volume: Vec::with_capacity(capacity),
+        }
+    }
+
+    pub fn len(&self) -> usize {
+        self.date.len()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.date.is_empty()
+    }
+
+    pub fn push(
+        &mut self,
+        date: NaiveDate,
+        open: f64,
+        high: f64,
+        low: f64,
+        close: f64,
+        volume: i64,
+    ) {
+        self.date.push(date);
+        self.open.push(open);
+        self.high.push(high);
+        self.low.push(low);
+        self.close.push(close);
+        self.volume.push(volume);
+    }
+
+    pub fn push_bar(&mut self, bar: &OhlcvBar) {
+        self.push(bar.date, bar.open, bar.high, bar.low, bar.close, bar.volume);
+    }
+
+    /// (high + low + close) / 3 at bar `i`
+    pub fn typical_price(&self, i: usize) -> f64 {
+        (self.high[i] + self.low[i] + self.close[i]) / 3.0
+    }
+
+    /// max(high - low, |high - prev_close|, |low - prev_close|) at bar `i`
+    pub fn true_range(&self, i: usize, prev_close: f64) -> f64 {
+        let hl = self.high[i] - self.low[i];
+        let hc = (self.high[i] - prev_close).abs();
+        let lc = (self.low[i] - prev_close).abs();
+        hl.max(hc).max(lc)
+    }
+
+    /// Materialize bar `i` as a row, e.g. for adapters that persist bars.
+    pub fn bar(&self, i: usize, code: &str, exchange: &str) -> OhlcvBar {
+        OhlcvBar {
+            code: code.to_string(),
+            exchange: exchange.to_string(),
+            date: self.date[i],
+            open: self.open[i],
+            high: self.high[i],
+            low: self.low[i],
+            close: self.close[i],
+            volume: self.volume[i],
+        }
+    }
+
+    /// Materialize every bar as rows tagged with `code` and `exchange`.
+    pub fn to_bars(&self, code: &str, exchange: &str) -> Vec<OhlcvBar> {
+        (0..self.len())
+            .map(|i| self.bar(i, code, exchange))
+            .collect()
+    }
+
+    /// Copy of the bars dated within `[start, end]`. The series must be
+    /// sorted by date; the bounds are found by binary search.
+    pub fn date_range(&self, start: NaiveDate, end: NaiveDate) -> Self {
+        let from = self.date.partition_point(|d| *d < start);
+        let to = self.date.partition_point(|d| *d <= end).max(from);
+        self.slice(from, to)
+    }
+
+    /// Copy of bars `from..to`.
+    pub fn slice(&self, from: usize, to: usize) -> Self {
+        Self {
+            date: self.date[from..to].to_vec(),
+            open: self.open[from..to].to_vec(),
+            high: self.high[from..to].to_vec(),
+            low: self.low[from..to].to_vec(),
+            close: self.close[from..to].to_vec(),
+            volume: self.volume[from..to].to_vec(),
+        }
+    }
+
+    /// Reorder all columns so dates ascend; equal dates keep their order.
+    pub fn sort_by_date(&mut self) {
+        if self.date.windows(2).all(|w| w[0] <= w[1]) {
+            return;
+        }
+        let mut order: Vec<usize> = (0..self.len()).collect();
+        order.sort_by_key(|&i| self.date[i]);
+        let mut sorted = Self::with_capacity(self.len());
+        for i in order {
+            sorted.push(
+                self.date[i],
+                self.open[i],
+                self.high[i],
+                self.low[i],
+                self.close[i],
+                self.volume[i],
+            );
+        }
+        *self = sorted;
+    }
+}
+
+impl From<&[OhlcvBar]> for OhlcvSeries {
+    fn from(bars: &[OhlcvBar]) -> Self {
+        let mut series = Self::with_capacity(bars.len());
+        for bar in bars {
+            series.push_bar(bar);
+        }
+        series
+    }
+}
+
+impl From<Vec<OhlcvBar>> for OhlcvSeries {
+    fn from(bars: Vec<OhlcvBar>) -> Self {
+        Self::from(bars.as_slice())
+    }
+}
+
+impl FromIterator<OhlcvBar> for OhlcvSeries {
+    fn from_iter<I: IntoIterator<Item = OhlcvBar>>(iter: I) -> Self {
+        let mut series = Self::new();
+        for bar in iter {
+            series.push_bar(&bar);
+        }
+        series
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -74,4 +240,70 @@ mod tests {
         // high-low=20, |110-130|=20, |90-130|=40 → 40
         assert!((bar.true_range(130.0) - 40.0).abs() < f64::EPSILON);
     }
+
+    #[test]
+    fn series_sort_by_date_moves_all_columns() {
+        let mut series = OhlcvSeries::new();
+        let d = |day| NaiveDate::from_ymd_opt(2024, 1, day).unwrap();
+        series.push(d(3), 3.0, 3.5, 2.5, 3.25, 300);
+        series.push(d(1), 1.0, 1.5, 0.5, 1.25, 100);
+        series.push(d(2), 2.0, 2.5, 1.5, 2.25, 200);
+
+        series.sort_by_date();
+
+        assert_eq!(series.date, vec![d(1), d(2), d(3)]);
+        assert_eq!(series.open, vec![1.0, 2.0, 3.0]);
+        assert_eq!(series.close, vec![1.25, 2.25, 3.25]);
+        assert_eq!(series.volume, vec![100, 200, 300]);
+    }
+
+    #[test]
+    fn series_date_range_slices_all_columns() {
+        let mut series = OhlcvSeries::new();
+        let d = |day| NaiveDate::from_ymd_opt(2024, 1, day).unwrap();
+        for day in [2, 3, 5, 8] {
+            series.push(d(day), day as f64, 0.0, 0.0, 0.0, day as i64);
+        }
+
+        let window = series.date_range(d(3), d(7));
+        assert_eq!(window.date, vec![d(3), d(5)]);
+        assert_eq!(window.open, vec![3.0, 5.0]);
+        assert_eq!(window.volume, vec![3, 5]);
+        assert_eq!(series.date_range(d(1), d(31)), series);
+        assert!(series.date_range(d(9), d(31)).is_empty());
+        assert!(series.date_range(d(5), d(4)).is_empty());
+    }
+
+    #[test]
+    fn series_from_bars_is_columnar() {
+        let mut second = sample_bar();
+        second.date = NaiveDate::from_ymd_opt(2024, 1, 16).unwrap();
+        second.close = 107.0;
+        let series = OhlcvSeries::from(vec![sample_bar(), second]);
+
+        assert_eq!(series.len(), 2);
+        assert_eq!(series.close, vec![105.0, 107.0]);
+        assert_eq!(series.volume, vec![50_000, 50_000]);
+        assert_eq!(
+            series.date[1],
+            NaiveDate::from_ymd_opt(2024, 1, 16).unwrap()
+        );
+    }
+
+    #[test]
+    fn series_helpers_match_bar_helpers() {
+        let bar = sample_bar();
+        let series = OhlcvSeries::from(vec![bar.clone()]);
+        assert!((series.typical_price(0) - bar.typical_price()).abs() < f64::EPSILON);
+        assert!((series.true_range(0, 70.0) - bar.true_range(70.0)).abs() < f64::EPSILON);
+    }
+
+    #[test]
+    fn series_bar_round_trip() {
+        let series = OhlcvSeries::from(vec![sample_bar()]);
+        let bar = series.bar(0, "BHP", "ASX");
+        assert_eq!(bar.code, "BHP");
+        assert_eq!(bar.exchange, "ASX");
+        assert!((bar.close - 105.0).abs() < f64::EPSILON);
+    }
 }
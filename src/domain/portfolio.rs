@@ -1,9 +1,10 @@
 //! Portfolio state and equity tracking (TRD Section 3.4/3.5).
 
 use chrono::NaiveDate;
-use std::collections::HashMap;
+use std::collections::BTreeMap;
 
 use super::position::{ClosedTrade, Position};
+use super::symbol::SymbolId;
 
 #[derive(Debug, Clone, PartialEq)]
 pub struct EquityPoint {
@@ -15,7 +16,8 @@ pub struct EquityPoint {
 pub struct Portfolio {
     pub cash: f64,
     pub initial_capital: f64,
-    pub positions: HashMap<String, Position>,
+    /// Open positions keyed by run-local symbol (see `domain::symbol`).
+    pub positions: BTreeMap<SymbolId, Position>,
     pub closed_trades: Vec<ClosedTrade>,
     pub equity_curve: Vec<EquityPoint>,
 }
@@ -25,26 +27,26 @@ impl Portfolio {
         Portfolio {
             cash: initial_capital,
             initial_capital,
-            positions: HashMap::new(),
+            positions: BTreeMap::new(),
             closed_trades: Vec::new(),
             equity_curve: Vec::new(),
         }
     }
 
     pub fn add_position(&mut self, position: Position) {
-        self.positions.insert(position.code.clone(), position);
+        self.positions.insert(position.symbol, position);
     }
 
-    pub fn get_position(&self, code: &str) -> Option<&Position> {
-        self.positions.get(code)
+    pub fn get_position(&self, symbol: SymbolId) -> Option<&Position> {
+        self.positions.get(&symbol)
     }
 
-    pub fn has_position(&self, code: &str) -> bool {
-        self.positions.contains_key(code)
+    pub fn has_position(&self, symbol: SymbolId) -> bool {
+        self.positions.contains_key(&symbol)
     }
 
-    pub fn remove_position(&mut self, code: &str) -> Option<Position> {
-        self.positions.remove(code)
+    pub fn remove_position(&mut self, symbol: SymbolId) -> Option<Position> {
+        self.positions.remove(&symbol)
     }
 
     pub fn position_count(&self) -> usize {
@@ -59,14 +61,20 @@ impl Portfolio {
         self.equity_curve.push(EquityPoint { date, equity });
     }
 
-    pub fn total_equity(&self, price_map: &HashMap<String, f64>) -> f64 {
+    /// Cash plus the market value of every position priced today.
+    ///
+    /// `prices` is indexed by `SymbolId`; `None` means the code has no bar
+    /// today and its position is left out.
+    pub fn total_equity(&self, prices: &[Option<f64>]) -> f64 {
         let position_value: f64 = self
             .positions
             .values()
             .filter_map(|pos| {
-                price_map
-                    .get(&pos.code)
-                    .map(|&price| pos.market_value(price))
+                prices
+                    .get(pos.symbol.index())
+                    .copied()
+                    .flatten()
+                    .map(|price| pos.market_value(price))
             })
             .sum();
         self.cash + position_value
@@ -77,8 +85,13 @@ impl Portfolio {
 mod tests {
     use super::*;
 
-    fn sample_position(code: &str, quantity: i64) -> Position {
+    const BHP: SymbolId = SymbolId(0);
+    const CBA: SymbolId = SymbolId(1);
+    const XYZ: SymbolId = SymbolId(2);
+
+    fn sample_position(symbol: SymbolId, code: &str, quantity: i64) -> Position {
         Position {
+            symbol,
             code: code.to_string(),
             exchange: "ASX".to_string(),
             quantity,
@@ -102,11 +115,11 @@ mod tests {
     #[test]
     fn add_and_get_position() {
         let mut portfolio = Portfolio::new(100000.0);
-        let pos = sample_position("BHP", 100);
+        let pos = sample_position(BHP, "BHP", 100);
         portfolio.add_position(pos);
 
-        assert!(portfolio.has_position("BHP"));
-        let retrieved = portfolio.get_position("BHP");
+        assert!(portfolio.has_position(BHP));
+        let retrieved = portfolio.get_position(BHP);
         assert!(retrieved.is_some());
         assert_eq!(retrieved.unwrap().quantity, 100);
     }
@@ -114,17 +127,17 @@ mod tests {
     #[test]
     fn remove_position() {
         let mut portfolio = Portfolio::new(100000.0);
-        portfolio.add_position(sample_position("BHP", 100));
+        portfolio.add_position(sample_position(BHP, "BHP", 100));
 
-        let removed = portfolio.remove_position("BHP");
+        let removed = portfolio.remove_position(BHP);
         assert!(removed.is_some());
-        assert!(!portfolio.has_position("BHP"));
+        assert!(!portfolio.has_position(BHP));
     }
 
     #[test]
     fn remove_nonexistent_position() {
         let mut portfolio = Portfolio::new(100000.0);
-        let removed = portfolio.remove_position("XYZ");
+        let removed = portfolio.remove_position(XYZ);
         assert!(removed.is_none());
     }
 
@@ -133,13 +146,13 @@ mod tests {
         let mut portfolio = Portfolio::new(100000.0);
         assert_eq!(portfolio.position_count(), 0);
 
-        portfolio.add_position(sample_position("BHP", 100));
+        portfolio.add_position(sample_position(BHP, "BHP", 100));
         assert_eq!(portfolio.position_count(), 1);
 
-        portfolio.add_position(sample_position("CBA", 50));
+        portfolio.add_position(sample_position(CBA, "CBA", 50));
         assert_eq!(portfolio.position_count(), 2);
 
-        portfolio.remove_position("BHP");
+        portfolio.remove_position(BHP);
         assert_eq!(portfolio.position_count(), 1);
     }
 
@@ -176,21 +189,19 @@ mod tests {
     #[test]
     fn total_equity_no_positions() {
         let portfolio = Portfolio::new(100000.0);
-        let price_map = HashMap::new();
-        let equity = portfolio.total_equity(&price_map);
+        let equity = portfolio.total_equity(&[]);
         assert!((equity - 100000.0).abs() < f64::EPSILON);
     }
 
     #[test]
     fn total_equity_with_positions() {
         let mut portfolio = Portfolio::new(100000.0);
-        portfolio.add_position(sample_position("BHP", 100));
+        portfolio.add_position(sample_position(BHP, "BHP", 100));
         portfolio.cash = 89000.0;
 
-        let mut price_map = HashMap::new();
-        price_map.insert("BHP".to_string(), 110.0);
+        let prices = [Some(110.0)];
 
-        let equity = portfolio.total_equity(&price_map);
+        let equity = portfolio.total_equity(&prices);
         assert!((equity - 100000.0).abs() < f64::EPSILON);
     }
 
@@ -198,6 +209,7 @@ mod tests {
     fn total_equity_uses_market_value() {
         let mut portfolio = Portfolio::new(50000.0);
         let pos = Position {
+            symbol: BHP,
             code: "BHP".to_string(),
             exchange: "ASX".to_string(),
             quantity: 100,
@@ -209,10 +221,22 @@ mod tests {
         portfolio.add_position(pos);
         portfolio.cash = 40000.0;
 
-        let mut price_map = HashMap::new();
-        price_map.insert("BHP".to_string(), 150.0);
+        let prices = [Some(150.0)];
 
-        let equity = portfolio.total_equity(&price_map);
+        let equity = portfolio.total_equity(&prices);
         assert!((equity - 55000.0).abs() < f64::EPSILON);
     }
+
+    #[test]
+    fn total_equity_skips_unpriced_positions() {
+        let mut portfolio = Portfolio::new(100000.0);
+        portfolio.add_position(sample_position(BHP, "BHP", 100));
+        portfolio.add_position(sample_position(CBA, "CBA", 10));
+        portfolio.cash = 80000.0;
+
+        let prices = [None, Some(200.0)];
+
+        let equity = portfolio.total_equity(&prices);
+        assert!((equity - 82000.0).abs() < f64::EPSILON);
+    }
 }
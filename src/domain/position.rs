@@ -2,8 +2,11 @@
 
 use chrono::NaiveDate;
 
+use super::symbol::SymbolId;
+
 #[derive(Debug, Clone, PartialEq)]
 pub struct Position {
+    pub symbol: SymbolId,
     pub code: String,
     pub exchange: String,
     pub quantity: i64,
@@ -71,6 +74,7 @@ mod tests {
 
     fn sample_long_position() -> Position {
         Position {
+            symbol: SymbolId(0),
             code: "BHP".into(),
             exchange: "ASX".into(),
             quantity: 100,
@@ -83,6 +87,7 @@ mod tests {
 
     fn sample_short_position() -> Position {
         Position {
+            symbol: SymbolId(1),
             code: "CBA".into(),
             exchange: "ASX".into(),
             quantity: -100,
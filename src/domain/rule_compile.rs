@@ -0,0 +1,641 @@
+//! Compiled rule evaluation (TRD Section 5.6).
+//!
+//! `rule_eval::evaluate` walks the `Rule` AST and hashes an `IndicatorType`
+//! for every indicator operand on every bar. `CompiledRule::compile` does
+//! that work once per code: each operand is resolved up front to a borrowed
+//! column slice (plus its warmup), a constant, or "missing". Per-bar
+//! evaluation is then plain slice indexing, with the same semantics as the
+//! reference evaluator, including NaN for unavailable indicator data.
+//!
+//! `CompiledRule::signals` evaluates the same program over the whole series
+//! at once: leaf comparisons become tight element-wise loops over the
+//! columns, composites become bitwise ops on `SignalBits`, and the temporal
+//! operators become run-length / sliding-window scans.
+//!
+//! `RuleStepper` is the streaming form: it is fed one bar at a time, in
+//! order, and keeps a run-length counter (`CONSECUTIVE`) or bars-since-true
+//! counter (`ANY_OF`) per temporal node, so each bar costs one evaluation of
+//! every node however wide or deeply nested the windows are. Neither counter
+//! refers to a bar index, so a `StepperState` saved after one series resumes
+//! on a later series that repeats only the last bar seen (for `CROSS_*`).
+
+use crate::domain::codec::{ByteReader, ByteWriter};
+use crate::domain::error::SamtraderError;
+use crate::domain::indicator_helpers::IndicatorCache;
+use crate::domain::ohlcv::OhlcvSeries;
+use crate::domain::rule::{Operand, Rule};
+use crate::domain::rule_eval::extract_field;
+use crate::domain::signal::SignalBits;
+use std::borrow::Cow;
+
+const EPSILON: f64 = 1e-9;
+
+/// An operand resolved against one code's data.
+#[derive(Debug, Clone, Copy)]
+enum Source<'a> {
+    /// Values are valid from `warmup` onwards.
+    Column {
+        values: &'a [f64],
+        warmup: usize,
+    },
+    Volume(&'a [i64]),
+    Constant(f64),
+    /// Indicator not computed, or lacking the requested field.
+    Missing,
+}
+
+impl Source<'_> {
+    #[inline]
+    fn at(self, bar_index: usize) -> f64 {
+        match self {
+            Source::Column { values, warmup } => {
+                if bar_index < warmup {
+                    f64::NAN
+                } else {
+                    values.get(bar_index).copied().unwrap_or(f64::NAN)
+                }
+            }
+            Source::Volume(volume) => volume[bar_index] as f64,
+            Source::Constant(v) => v,
+            Source::Missing => f64::NAN,
+        }
+    }
+}
+
+#[derive(Debug, Clone)]
+enum Node<'a> {
+    CrossAbove(Source<'a>, Source<'a>),
+    CrossBelow(Source<'a>, Source<'a>),
+    Above(Source<'a>, Source<'a>),
+    Below(Source<'a>, Source<'a>),
+    Between {
+        value: Source<'a>,
+        lower: f64,
+        upper: f64,
+    },
+    Equals(Source<'a>, Source<'a>),
+    And(Vec<Node<'a>>),
+    Or(Vec<Node<'a>>),
+    Not(Box<Node<'a>>),
+    /// `slot` indexes this node's state in a `RuleStepper`.
+    Consecutive {
+        node: Box<Node<'a>>,
+        count: usize,
+        slot: usize,
+    },
+    AnyOf {
+        node: Box<Node<'a>>,
+        count: usize,
+        slot: usize,
+    },
+}
+
+/// Per-node carry for the temporal operators while stepping bar by bar.
+#[derive(Debug, Clone, Copy, Default, PartialEq)]
+struct TemporalState {
+    /// `CONSECUTIVE`: length of the child's current run of true bars.
+    run: usize,
+    /// `ANY_OF`: bars since the child last held (0 on the bar it held).
+    since_true: Option<usize>,
+}
+
+/// The temporal carry of a `RuleStepper`, detached from the series it was
+/// stepped over so it can be saved and resumed with `CompiledRule::resume`.
+#[derive(Debug, Clone, Default, PartialEq)]
+pub struct StepperState(Vec<TemporalState>);
+
+impl StepperState {
+    pub fn encode(&self, w: &mut ByteWriter) {
+        w.usize(self.0.len());
+        for t in &self.0 {
+            w.usize(t.run);
+            w.bool(t.since_true.is_some());
+            w.usize(t.since_true.unwrap_or(0));
+        }
+    }
+
+    pub fn decode(r: &mut ByteReader) -> Result<Self, SamtraderError> {
+        let slots = r.count(17)?;
+        (0..slots)
+            .map(|_| {
+                let run = r.usize()?;
+                let has_true = r.bool()?;
+                let since = r.usize()?;
+                Ok(TemporalState {
+                    run,
+                    since_true: has_true.then_some(since),
+                })
+            })
+            .collect::<Result<_, _>>()
+            .map(StepperState)
+    }
+}
+
+/// A rule bound to one code's OHLCV and indicator columns.
+#[derive(Debug, Clone)]
+pub struct CompiledRule<'a> {
+    root: Node<'a>,
+    len: usize,
+    temporal_nodes: usize,
+}
+
+impl<'a> CompiledRule<'a> {
+    pub fn compile(rule: &Rule, ohlcv: &'a OhlcvSeries, indicators: &'a IndicatorCache) -> Self {
+        let mut temporal_nodes = 0;
+        let root = compile_node(rule, ohlcv, indicators, &mut temporal_nodes);
+        CompiledRule {
+            root,
+            len: ohlcv.len(),
+            temporal_nodes,
+        }
+    }
+
+    /// Evaluate at `bar_index`; identical results to `rule_eval::evaluate`.
+    pub fn evaluate(&self, bar_index: usize) -> bool {
+        eval_node(&self.root, bar_index)
+    }
+
+    /// Evaluate every bar of the series at once; bit `i` equals
+    /// `evaluate(i)`.
+    pub fn signals(&self) -> SignalBits {
+        signal_node(&self.root, self.len)
+    }
+
+    /// Start a streaming evaluation at bar 0.
+    pub fn stepper(&self) -> RuleStepper<'_, 'a> {
+        RuleStepper {
+            rule: self,
+            state: vec![TemporalState::default(); self.temporal_nodes],
+            next: 0,
+        }
+    }
+
+    /// Continue a streaming evaluation at `bar_index` from `state`, saved
+    /// by a stepper of the same rule just before the bar this series has at
+    /// `bar_index`. `None` if `state` was saved from a different rule.
+    pub fn resume(&self, bar_index: usize, state: StepperState) -> Option<RuleStepper<'_, 'a>> {
+        (state.0.len() == self.temporal_nodes).then(|| RuleStepper {
+            rule: self,
+            state: state.0,
+            next: bar_index,
+        })
+    }
+}
+
+/// Bar-by-bar evaluation of a `CompiledRule` with O(1) amortized temporal
+/// operators. Each `step` evaluates the next bar, starting at bar 0.
+#[derive(Debug, Clone)]
+pub struct RuleStepper<'r, 'a> {
+    rule: &'r CompiledRule<'a>,
+    state: Vec<TemporalState>,
+    next: usize,
+}
+
+impl RuleStepper<'_, '_> {
+    /// Index of the bar the next `step` evaluates.
+    pub fn position(&self) -> usize {
+        self.next
+    }
+
+    /// Temporal carry after the bars stepped so far.
+    pub fn state(&self) -> StepperState {
+        StepperState(self.state.clone())
+    }
+
+    /// Evaluate the next bar; agrees with `CompiledRule::evaluate` at that
+    /// index. Returns `None` once the series is exhausted.
+    pub fn step(&mut self) -> Option<bool> {
+        if self.next >= self.rule.len {
+            return None;
+        }
+        let result = step_node(&self.rule.root, self.next, &mut self.state);
+        self.next += 1;
+        Some(result)
+    }
+}
+
+fn compile_node<'a>(
+    rule: &Rule,
+    ohlcv: &'a OhlcvSeries,
+    indicators: &'a IndicatorCache,
+    slots: &mut usize,
+) -> Node<'a> {
+    let src = |operand: &Operand| compile_operand(operand, ohlcv, indicators);
+    let mut child = |rule: &Rule| compile_node(rule, ohlcv, indicators, &mut *slots);
+    match rule {
+        Rule::CrossAbove { left, right } => Node::CrossAbove(src(left), src(right)),
+        Rule::CrossBelow { left, right } => Node::CrossBelow(src(left), src(right)),
+        Rule::Above { left, right } => Node::Above(src(left), src(right)),
+        Rule::Below { left, right } => Node::Below(src(left), src(right)),
+        Rule::Between {
+            operand,
+            lower,
+            upper,
+        } => Node::Between {
+            value: src(operand),
+            lower: *lower,
+            upper: *upper,
+        },
+        Rule::Equals { left, right } => Node::Equals(src(left), src(right)),
+        Rule::And(rules) => Node::And(rules.iter().map(child).collect()),
+        Rule::Or(rules) => Node::Or(rules.iter().map(child).collect()),
+        Rule::Not(rule) => Node::Not(Box::new(child(rule))),
+        Rule::Consecutive { rule, count } => {
+            let node = Box::new(child(rule));
+            Node::Consecutive {
+                node,
+                count: *count,
+                slot: next_slot(slots),
+            }
+        }
+        Rule::AnyOf { rule, count } => {
+            let node = Box::new(child(rule));
+            Node::AnyOf {
+                node,
+                count: *count,
+                slot: next_slot(slots),
+            }
+        }
+    }
+}
+
+fn next_slot(slots: &mut usize) -> usize {
+    *slots += 1;
+    *slots - 1
+}
+
+fn compile_operand<'a>(
+    operand: &Operand,
+    ohlcv: &'a OhlcvSeries,
+    indicators: &'a IndicatorCache,
+) -> Source<'a> {
+    let price = |values: &'a [f64]| Source::Column { values, warmup: 0 };
+    match operand {
+        Operand::Open => price(&ohlcv.open),
+        Operand::High => price(&ohlcv.high),
+        Operand::Low => price(&ohlcv.low),
+        Operand::Close => price(&ohlcv.close),
+        Operand::Volume => Source::Volume(&ohlcv.volume),
+        Operand::Constant(v) => Source::Constant(*v),
+        Operand::Indicator(ind_ref) => indicators
+            .get(&ind_ref.indicator_type)
+            .and_then(|series| {
+                extract_field(&series.columns, ind_ref.field).map(|values| Source::Column {
+                    values,
+                    warmup: series.warmup,
+                })
+            })
+            .unwrap_or(Source::Missing),
+    }
+}
+
+fn eval_node(node: &Node<'_>, bar_index: usize) -> bool {
+    match node {
+        Node::CrossAbove(left, right) => {
+            bar_index >= 1
+                && left.at(bar_index) > right.at(bar_index)
+                && left.at(bar_index - 1) <= right.at(bar_index - 1)
+        }
+        Node::CrossBelow(left, right) => {
+            bar_index >= 1
+                && left.at(bar_index) < right.at(bar_index)
+                && left.at(bar_index - 1) >= right.at(bar_index - 1)
+        }
+        Node::Above(left, right) => left.at(bar_index) > right.at(bar_index),
+        Node::Below(left, right) => left.at(bar_index) < right.at(bar_index),
+        Node::Between {
+            value,
+            lower,
+            upper,
+        } => {
+            let v = value.at(bar_index);
+            v >= *lower && v <= *upper
+        }
+        Node::Equals(left, right) => (left.at(bar_index) - right.at(bar_index)).abs() < EPSILON,
+        Node::And(nodes) => nodes.iter().all(|n| eval_node(n, bar_index)),
+        Node::Or(nodes) => nodes.iter().any(|n| eval_node(n, bar_index)),
+        Node::Not(node) => !eval_node(node, bar_index),
+        Node::Consecutive { node, count, .. } => {
+            if *count == 0 || bar_index + 1 < *count {
+                return false;
+            }
+            ((bar_index + 1 - *count)..=bar_index).all(|i| eval_node(node, i))
+        }
+        Node::AnyOf { node, count, .. } => {
+            if *count == 0 {
+                return false;
+            }
+            let start = bar_index.saturating_sub(*count - 1);
+            (start..=bar_index).any(|i| eval_node(node, i))
+        }
+    }
+}
+
+impl<'a> Source<'a> {
+    /// Bars before this index read as NaN.
+    fn warmup(self) -> usize {
+        match self {
+            Source::Column { warmup, .. } => warmup,
+            _ => 0,
+        }
+    }
+
+    /// The operand as a dense column of `len` values, or `None` when it is
+    /// missing (every comparison against it is false).
+    fn lane(self, len: usize) -> Option<Cow<'a, [f64]>> {
+        match self {
+            Source::Column { values, .. } if values.len() >= len => {
+                Some(Cow::Borrowed(&values[..len]))
+            }
+            Source::Column { values, .. } => {
+                let mut padded = values.to_vec();
+                padded.resize(len, f64::NAN);
+                Some(Cow::Owned(padded))
+            }
+            Source::Volume(volume) => Some(Cow::Owned(
+                volume[..len].iter().map(|&v| v as f64).collect(),
+            )),
+            Source::Constant(v) => Some(Cow::Owned(vec![v; len])),
+            Source::Missing => None,
+        }
+    }
+}
+
+/// Element-wise comparison of two operands over the whole series.
+fn compare(
+    left: Source<'_>,
+    right: Source<'_>,
+    len: usize,
+    op: impl Fn(f64, f64) -> bool,
+) -> SignalBits {
+    let (Some(l), Some(r)) = (left.lane(len), right.lane(len)) else {
+        return SignalBits::new(len);
+    };
+    let mut bits = SignalBits::from_fn(len, |i| op(l[i], r[i]));
+    bits.clear_below(left.warmup().max(right.warmup()));
+    bits
+}
+
+/// Shifted comparison: `now` holds on bar `i` and `before` held on `i - 1`.
+fn cross(
+    left: Source<'_>,
+    right: Source<'_>,
+    len: usize,
+    now: impl Fn(f64, f64) -> bool,
+    before: impl Fn(f64, f64) -> bool,
+) -> SignalBits {
+    let (Some(l), Some(r)) = (left.lane(len), right.lane(len)) else {
+        return SignalBits::new(len);
+    };
+    let mut bits = SignalBits::from_fn(len, |i| {
+        i >= 1 && now(l[i], r[i]) && before(l[i - 1], r[i - 1])
+    });
+    bits.clear_below(left.warmup().max(right.warmup()) + 1);
+    bits
+}
+
+fn signal_node(node: &Node<'_>, len: usize) -> SignalBits {
+    match node {
+        Node::CrossAbove(left, right) => cross(*left, *right, len, |a, b| a > b, |a, b| a <= b),
+        Node::CrossBelow(left, right) => cross(*left, *right, len, |a, b| a < b, |a, b| a >= b),
+        Node::Above(left, right) => compare(*left, *right, len, |a, b| a > b),
+        Node::Below(left, right) => compare(*left, *right, len, |a, b| a < b),
+        Node::Between {
+            value,
+            lower,
+            upper,
+        } => {
+            let Some(v) = value.lane(len) else {
+                return SignalBits::new(len);
+            };
+            let mut bits = SignalBits::from_fn(len, |i| v[i] >= *lower && v[i] <= *upper);
+            bits.clear_below(value.warmup());
+            bits
+        }
+        Node::Equals(left, right) => compare(*left, *right, len, |a, b| (a - b).abs() < EPSILON),
+        Node::And(nodes) => {
+            let mut bits = SignalBits::new(len);
+            bits.not_assign();
+            for n in nodes {
+                bits.and_assign(&signal_node(n, len));
+            }
+            bits
+        }
+        Node::Or(nodes) => {
+            let mut bits = SignalBits::new(len);
+            for n in nodes {
+                bits.or_assign(&signal_node(n, len));
+            }
+            bits
+        }
+        Node::Not(node) => {
+            let mut bits = signal_node(node, len);
+            bits.not_assign();
+            bits
+        }
+        Node::Consecutive { node, count, .. } => signal_node(node, len).consecutive(*count),
+        Node::AnyOf { node, count, .. } => signal_node(node, len).any_of(*count),
+    }
+}
+
+/// One bar of a `RuleStepper`. Composites evaluate every child (no
+/// short-circuit) so that temporal state below them sees each bar.
+fn step_node(node: &Node<'_>, bar_index: usize, state: &mut [TemporalState]) -> bool {
+    match node {
+        Node::And(nodes) => nodes
+            .iter()
+            .fold(true, |all, n| step_node(n, bar_index, state) && all),
+        Node::Or(nodes) => nodes
+            .iter()
+            .fold(false, |any, n| step_node(n, bar_index, state) || any),
+        Node::Not(node) => !step_node(node, bar_index, state),
+        Node::Consecutive { node, count, slot } => {
+            let held = step_node(node, bar_index, state);
+            let run = &mut state[*slot].run;
+            *run = if held { *run + 1 } else { 0 };
+            *count > 0 && *run >= *count
+        }
+        Node::AnyOf { node, count, slot } => {
+            let held = step_node(node, bar_index, state);
+            let since = &mut state[*slot].since_true;
+            *since = if held {
+                Some(0)
+            } else {
+                since.map(|s| s.saturating_add(1))
+            };
+            since.is_some_and(|s| s < *count)
+        }
+        leaf => eval_node(leaf, bar_index),
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::domain::indicator::IndicatorType;
+    use crate::domain::indicator_helpers::compute_indicators;
+    use crate::domain::rule::extract_indicators;
+    use crate::domain::rule_eval;
+    use crate::domain::rule_parser::parse;
+    use chrono::NaiveDate;
+    use std::collections::HashMap;
+
+    fn make_series(n: usize) -> OhlcvSeries {
+        let mut series = OhlcvSeries::new();
+        let start = NaiveDate::from_ymd_opt(2024, 1, 1).unwrap();
+        for i in 0..n {
+            let close = 100.0 + 10.0 * ((i as f64) * 0.37).sin() + (i % 7) as f64;
+            series.push(
+                start + chrono::Duration::days(i as i64),
+                close - 1.0,
+                close + 2.0,
+                close - 2.5,
+                close,
+                1000 + (i as i64 % 5) * 100,
+            );
+        }
+        series
+    }
+
+    /// Compiled, vectorized and reference evaluators must agree on every bar.
+    fn assert_matches_oracle(source: &str) {
+        let rule = parse(source).unwrap();
+        let ohlcv = make_series(80);
+        let types: Vec<_> = extract_indicators(&rule).into_iter().collect();
+        let indicators = compute_indicators(&ohlcv, &types);
+        let compiled = CompiledRule::compile(&rule, &ohlcv, &indicators);
+        let signals = compiled.signals();
+        let mut stepper = compiled.stepper();
+
+        assert_eq!(signals.len(), ohlcv.len());
+        for i in 0..ohlcv.len() {
+            let expected = rule_eval::evaluate(&rule, &ohlcv, &indicators, i);
+            assert_eq!(
+                compiled.evaluate(i),
+                expected,
+                "{source} disagrees at bar {i}"
+            );
+            assert_eq!(
+                signals.get(i),
+                expected,
+                "{source} signal disagrees at bar {i}"
+            );
+            assert_eq!(
+                stepper.step(),
+                Some(expected),
+                "{source} stepper disagrees at bar {i}"
+            );
+        }
+        assert_eq!(stepper.step(), None);
+    }
+
+    #[test]
+    fn comparisons_match_reference() {
+        assert_matches_oracle("ABOVE(close, 105)");
+        assert_matches_oracle("BELOW(low, SMA(5))");
+        assert_matches_oracle("BETWEEN(RSI(14), 40, 60)");
+        assert_matches_oracle("EQUALS(volume, 1200)");
+    }
+
+    #[test]
+    fn crosses_match_reference() {
+        assert_matches_oracle("CROSS_ABOVE(SMA(5), SMA(20))");
+        assert_matches_oracle("CROSS_BELOW(close, EMA(10))");
+        assert_matches_oracle("CROSS_ABOVE(MACD_LINE(12,26,9), MACD_SIGNAL(12,26,9))");
+    }
+
+    #[test]
+    fn composites_and_temporal_match_reference() {
+        assert_matches_oracle("AND(ABOVE(close, SMA(10)), NOT(BELOW(RSI(14), 30)))");
+        assert_matches_oracle("OR(ABOVE(close, BOLLINGER_UPPER(20,2)), BELOW(close, 95))");
+        assert_matches_oracle("NOT(ABOVE(SMA(10), 0))");
+        assert_matches_oracle("CONSECUTIVE(ABOVE(close, open), 3)");
+        assert_matches_oracle("ANY_OF(CROSS_ABOVE(STOCHASTIC_K(14,3), 50), 5)");
+    }
+
+    #[test]
+    fn nested_temporal_match_reference() {
+        assert_matches_oracle("CONSECUTIVE(ANY_OF(ABOVE(close, SMA(5)), 20), 10)");
+        assert_matches_oracle("ANY_OF(CONSECUTIVE(BELOW(close, open), 2), 30)");
+        assert_matches_oracle(
+            "AND(CONSECUTIVE(ABOVE(close, 95), 4), ANY_OF(BELOW(RSI(14), 40), 10))",
+        );
+        assert_matches_oracle(
+            "NOT(OR(ANY_OF(ABOVE(close, 115), 0), CONSECUTIVE(ABOVE(volume, 1100), 2)))",
+        );
+    }
+
+    #[test]
+    fn stepper_tracks_position() {
+        let rule = parse("CONSECUTIVE(ABOVE(close, 0), 3)").unwrap();
+        let ohlcv = make_series(5);
+        let indicators = HashMap::new();
+        let compiled = CompiledRule::compile(&rule, &ohlcv, &indicators);
+        let mut stepper = compiled.stepper();
+
+        let stepped: Vec<_> = std::iter::from_fn(|| stepper.step()).collect();
+        assert_eq!(stepped, [false, false, true, true, true]);
+        assert_eq!(stepper.position(), 5);
+    }
+
+    #[test]
+    fn saved_stepper_resumes_on_later_series() {
+        let rule =
+            parse("AND(CONSECUTIVE(ABOVE(close, open), 2), ANY_OF(CROSS_ABOVE(close, 105), 6))")
+                .unwrap();
+        let full = make_series(80);
+        let indicators = HashMap::new();
+        let compiled = CompiledRule::compile(&rule, &full, &indicators);
+        let expected: Vec<_> = (0..full.len()).map(|i| compiled.evaluate(i)).collect();
+
+        let split = 37;
+        let mut stepper = compiled.stepper();
+        for _ in 0..split {
+            stepper.step();
+        }
+        let mut w = ByteWriter::new();
+        stepper.state().encode(&mut w);
+        let bytes = w.into_bytes();
+        let saved = StepperState::decode(&mut ByteReader::new(&bytes, "stepper")).unwrap();
+        assert_eq!(saved, stepper.state());
+
+        // The later series starts with the last bar already stepped.
+        let mut later = OhlcvSeries::new();
+        for i in split - 1..full.len() {
+            later.push_bar(&full.bar(i, "BHP", "ASX"));
+        }
+        let compiled_later = CompiledRule::compile(&rule, &later, &indicators);
+        let mut resumed = compiled_later.resume(1, saved).unwrap();
+        let stepped: Vec<_> = std::iter::from_fn(|| resumed.step()).collect();
+        assert_eq!(stepped, expected[split..]);
+
+        let other = parse("ABOVE(close, open)").unwrap();
+        let compiled_other = CompiledRule::compile(&other, &later, &indicators);
+        assert!(compiled_other.resume(1, stepper.state()).is_none());
+    }
+
+    #[test]
+    fn missing_indicator_is_false() {
+        let rule = parse("ABOVE(SMA(20), 0)").unwrap();
+        let ohlcv = make_series(30);
+        let indicators = HashMap::new();
+        let compiled = CompiledRule::compile(&rule, &ohlcv, &indicators);
+
+        assert!((0..ohlcv.len()).all(|i| !compiled.evaluate(i)));
+        assert_eq!(compiled.signals().count_ones(), 0);
+    }
+
+    #[test]
+    fn indicator_warmup_is_false() {
+        let rule = parse("ABOVE(SMA(10), 0)").unwrap();
+        let ohlcv = make_series(30);
+        let indicators = compute_indicators(&ohlcv, &[IndicatorType::Sma(10)]);
+        let compiled = CompiledRule::compile(&rule, &ohlcv, &indicators);
+
+        assert!(!compiled.evaluate(8));
+        assert!(compiled.evaluate(9));
+        let signals = compiled.signals();
+        assert!(!signals.get(8));
+        assert!(signals.get(9));
+    }
+}
@@ -13,22 +13,22 @@
 //!
 //! # Missing / Invalid Indicator Data
 //!
-//! When an indicator is missing from the map, out of range, or marked invalid,
-//! the operand resolves to `f64::NAN`. Since IEEE 754 NaN comparisons always
-//! return false, rules referencing unavailable data evaluate to false rather
-//! than triggering spurious signals.
-
-use crate::domain::indicator::{IndicatorSeries, IndicatorType, IndicatorValue};
-use crate::domain::ohlcv::OhlcvBar;
+//! When an indicator is missing from the map, out of range, still inside its
+//! warmup, or lacks the requested field, the operand resolves to `f64::NAN`.
+//! Since IEEE 754 NaN comparisons always return false, rules referencing
+//! unavailable data evaluate to false rather than triggering spurious signals.
+
+use crate::domain::indicator::IndicatorColumns;
+use crate::domain::indicator_helpers::IndicatorCache;
+use crate::domain::ohlcv::OhlcvSeries;
 use crate::domain::rule::{IndicatorField, IndicatorRef, Operand, Rule};
-use std::collections::HashMap;
 
 const EPSILON: f64 = 1e-9;
 
 pub fn evaluate(
     rule: &Rule,
-    ohlcv: &[OhlcvBar],
-    indicators: &HashMap<IndicatorType, IndicatorSeries>,
+    ohlcv: &OhlcvSeries,
+    indicators: &IndicatorCache,
     bar_index: usize,
 ) -> bool {
     match rule {
@@ -122,16 +122,16 @@ pub fn evaluate(
 
 fn resolve_operand(
     operand: &Operand,
-    ohlcv: &[OhlcvBar],
-    indicators: &HashMap<IndicatorType, IndicatorSeries>,
+    ohlcv: &OhlcvSeries,
+    indicators: &IndicatorCache,
     bar_index: usize,
 ) -> f64 {
     match operand {
-        Operand::Open => ohlcv[bar_index].open,
-        Operand::High => ohlcv[bar_index].high,
-        Operand::Low => ohlcv[bar_index].low,
-        Operand::Close => ohlcv[bar_index].close,
-        Operand::Volume => ohlcv[bar_index].volume as f64,
+        Operand::Open => ohlcv.open[bar_index],
+        Operand::High => ohlcv.high[bar_index],
+        Operand::Low => ohlcv.low[bar_index],
+        Operand::Close => ohlcv.close[bar_index],
+        Operand::Volume => ohlcv.volume[bar_index] as f64,
         Operand::Constant(v) => *v,
         Operand::Indicator(ind_ref) => resolve_indicator(ind_ref, indicators, bar_index),
     }
@@ -139,7 +139,7 @@ fn resolve_operand(
 
 fn resolve_indicator(
     ind_ref: &IndicatorRef,
-    indicators: &HashMap<IndicatorType, IndicatorSeries>,
+    indicators: &IndicatorCache,
     bar_index: usize,
 ) -> f64 {
     let series = match indicators.get(&ind_ref.indicator_type) {
@@ -147,164 +147,49 @@ fn resolve_indicator(
         None => return f64::NAN,
     };
 
-    if bar_index >= series.values.len() {
+    if !series.is_valid(bar_index) {
         return f64::NAN;
     }
 
-    let point = &series.values[bar_index];
-    if !point.valid {
-        return f64::NAN;
+    match extract_field(&series.columns, ind_ref.field) {
+        Some(column) => column[bar_index],
+        None => f64::NAN,
     }
-
-    extract_field(&point.value, ind_ref.field)
 }
 
-fn extract_field(value: &IndicatorValue, field: IndicatorField) -> f64 {
-    match (value, field) {
-        (IndicatorValue::Simple(v), IndicatorField::Value) => *v,
-        (
-            IndicatorValue::Macd {
-                line,
-                signal: _,
-                histogram: _,
-            },
-            IndicatorField::MacdLine,
-        ) => *line,
-        (
-            IndicatorValue::Macd {
-                line: _,
-                signal,
-                histogram: _,
-            },
-            IndicatorField::MacdSignal,
-        ) => *signal,
-        (
-            IndicatorValue::Macd {
-                line: _,
-                signal: _,
-                histogram,
-            },
-            IndicatorField::MacdHistogram,
-        ) => *histogram,
-        (IndicatorValue::Stochastic { k, d: _ }, IndicatorField::StochasticK) => *k,
-        (IndicatorValue::Stochastic { k: _, d }, IndicatorField::StochasticD) => *d,
-        (
-            IndicatorValue::Bollinger {
-                upper,
-                middle: _,
-                lower: _,
-            },
-            IndicatorField::BollingerUpper,
-        ) => *upper,
-        (
-            IndicatorValue::Bollinger {
-                upper: _,
-                middle,
-                lower: _,
-            },
-            IndicatorField::BollingerMiddle,
-        ) => *middle,
-        (
-            IndicatorValue::Bollinger {
-                upper: _,
-                middle: _,
-                lower,
-            },
-            IndicatorField::BollingerLower,
-        ) => *lower,
-        (
-            IndicatorValue::Pivot {
-                pivot,
-                r1: _,
-                r2: _,
-                r3: _,
-                s1: _,
-                s2: _,
-                s3: _,
-            },
-            IndicatorField::Pivot,
-        ) => *pivot,
-        (
-            IndicatorValue::Pivot {
-                pivot: _,
-                r1,
-                r2: _,
-                r3: _,
-                s1: _,
-                s2: _,
-                s3: _,
-            },
-            IndicatorField::R1,
-        ) => *r1,
-        (
-            IndicatorValue::Pivot {
-                pivot: _,
-                r1: _,
-                r2,
-                r3: _,
-                s1: _,
-                s2: _,
-                s3: _,
-            },
-            IndicatorField::R2,
-        ) => *r2,
-        (
-            IndicatorValue::Pivot {
-                pivot: _,
-                r1: _,
-                r2: _,
-                r3,
-                s1: _,
-                s2: _,
-                s3: _,
-            },
-            IndicatorField::R3,
-        ) => *r3,
-        (
-            IndicatorValue::Pivot {
-                pivot: _,
-                r1: _,
-                r2: _,
-                r3: _,
-                s1,
-                s2: _,
-                s3: _,
-            },
-            IndicatorField::S1,
-        ) => *s1,
-        (
-            IndicatorValue::Pivot {
-                pivot: _,
-                r1: _,
-                r2: _,
-                r3: _,
-                s1: _,
-                s2,
-                s3: _,
-            },
-            IndicatorField::S2,
-        ) => *s2,
-        (
-            IndicatorValue::Pivot {
-                pivot: _,
-                r1: _,
-                r2: _,
-                r3: _,
-                s1: _,
-                s2: _,
-                s3,
-            },
-            IndicatorField::S3,
-        ) => *s3,
-        _ => f64::NAN,
-    }
+/// Column holding `field`, or `None` when the indicator has no such output.
+pub(crate) fn extract_field(columns: &IndicatorColumns, field: IndicatorField) -> Option<&[f64]> {
+    let column = match (columns, field) {
+        (IndicatorColumns::Simple(v), IndicatorField::Value) => v,
+        (IndicatorColumns::Macd { line, .. }, IndicatorField::MacdLine) => line,
+        (IndicatorColumns::Macd { signal, .. }, IndicatorField::MacdSignal) => signal,
+        (IndicatorColumns::Macd { histogram, .. }, IndicatorField::MacdHistogram) => histogram,
+        (IndicatorColumns::Stochastic { k, .. }, IndicatorField::StochasticK) => k,
+        (IndicatorColumns::Stochastic { d, .. }, IndicatorField::StochasticD) => d,
+        (IndicatorColumns::Bollinger { upper, .. }, IndicatorField::BollingerUpper) => upper,
+        (IndicatorColumns::Bollinger { middle, .. }, IndicatorField::BollingerMiddle) => middle,
+        (IndicatorColumns::Bollinger { lower, .. }, IndicatorField::BollingerLower) => lower,
+        (IndicatorColumns::Pivot { pivot, .. }, IndicatorField::Pivot) => pivot,
+        (IndicatorColumns::Pivot { r1, .. }, IndicatorField::R1) => r1,
+        (IndicatorColumns::Pivot { r2, .. }, IndicatorField::R2) => r2,
+        (IndicatorColumns::Pivot { r3, .. }, IndicatorField::R3) => r3,
+        (IndicatorColumns::Pivot { s1, .. }, IndicatorField::S1) => s1,
+        (IndicatorColumns::Pivot { s2, .. }, IndicatorField::S2) => s2,
+        (IndicatorColumns::Pivot { s3, .. }, IndicatorField::S3) => s3,
+        _ => return None,
+    };
+    Some(column)
 }
 
 #[cfg(test)]
 mod tests {
     use super::*;
+    use crate::domain::indicator::{IndicatorSeries, IndicatorType};
+    use crate::domain::ohlcv::OhlcvBar;
     use crate::domain::rule::IndicatorRef;
     use chrono::NaiveDate;
+    use std::collections::HashMap;
+    use std::sync::Arc;
 
     fn make_bar(date: u32, open: f64, high: f64, low: f64, close: f64, volume: i64) -> OhlcvBar {
         OhlcvBar {
@@ -321,25 +206,14 @@ mod tests {
 
     fn make_simple_indicator(
         indicator_type: IndicatorType,
-        values: Vec<(u32, bool, f64)>,
+        warmup: usize,
+        values: Vec<f64>,
     ) -> IndicatorSeries {
-        IndicatorSeries {
-            indicator_type,
-            values: values
-                .into_iter()
-                .map(
-                    |(date, valid, v)| crate::domain::indicator::IndicatorPoint {
-                        date: NaiveDate::from_ymd_opt(2024, 1, date).unwrap(),
-                        valid,
-                        value: IndicatorValue::Simple(v),
-                    },
-                )
-                .collect(),
-        }
+        IndicatorSeries::new(indicator_type, warmup, IndicatorColumns::Simple(values))
     }
 
-    fn make_ohlcv(bars: Vec<OhlcvBar>) -> Vec<OhlcvBar> {
-        bars
+    fn make_ohlcv(bars: Vec<OhlcvBar>) -> OhlcvSeries {
+        OhlcvSeries::from(bars)
     }
 
     #[test]
@@ -642,11 +516,12 @@ mod tests {
 
         let sma_series = make_simple_indicator(
             IndicatorType::Sma(2),
-            vec![(1, false, 0.0), (2, true, 100.5), (3, true, 101.5)],
+            1,
+            vec![0.0, 100.5, 101.5],
         );
 
         let mut indicators = HashMap::new();
-        indicators.insert(IndicatorType::Sma(2), sma_series);
+        indicators.insert(IndicatorType::Sma(2), Arc::new(sma_series));
 
         let rule = Rule::Above {
             left: Operand::Indicator(IndicatorRef {
@@ -672,27 +547,19 @@ mod tests {
 
         let sma10 = make_simple_indicator(
             IndicatorType::Sma(10),
-            vec![
-                (1, false, 0.0),
-                (2, false, 0.0),
-                (3, true, 99.0),
-                (4, true, 102.0),
-            ],
+            2,
+            vec![0.0, 0.0, 99.0, 102.0],
         );
 
         let sma20 = make_simple_indicator(
             IndicatorType::Sma(20),
-            vec![
-                (1, false, 0.0),
-                (2, false, 0.0),
-                (3, true, 100.0),
-                (4, true, 101.0),
-            ],
+            2,
+            vec![0.0, 0.0, 100.0, 101.0],
         );
 
         let mut indicators = HashMap::new();
-        indicators.insert(IndicatorType::Sma(10), sma10);
-        indicators.insert(IndicatorType::Sma(20), sma20);
+        indicators.insert(IndicatorType::Sma(10), Arc::new(sma10));
+        indicators.insert(IndicatorType::Sma(20), Arc::new(sma20));
 
         let rule = Rule::CrossAbove {
             left: Operand::Indicator(IndicatorRef {
@@ -762,10 +629,10 @@ mod tests {
     fn evaluate_indicator_invalid() {
         let ohlcv = make_ohlcv(vec![make_bar(1, 100.0, 110.0, 90.0, 105.0, 1000)]);
 
-        let sma_series = make_simple_indicator(IndicatorType::Sma(20), vec![(1, false, 0.0)]);
+        let sma_series = make_simple_indicator(IndicatorType::Sma(20), 1, vec![0.0]);
 
         let mut indicators = HashMap::new();
-        indicators.insert(IndicatorType::Sma(20), sma_series);
+        indicators.insert(IndicatorType::Sma(20), Arc::new(sma_series));
 
         let rule = Rule::Above {
             left: Operand::Indicator(IndicatorRef {
@@ -864,4 +731,56 @@ mod tests {
         // 5e-9 is outside epsilon, should not be equal
         assert!(!evaluate(&rule, &ohlcv, &HashMap::new(), 1));
     }
+
+    #[test]
+    fn evaluate_indicator_reads_named_column() {
+        let ohlcv = make_ohlcv(vec![
+            make_bar(1, 100.0, 110.0, 90.0, 105.0, 1000),
+            make_bar(2, 100.0, 110.0, 90.0, 105.0, 1000),
+        ]);
+
+        let bollinger = IndicatorType::Bollinger {
+            period: 2,
+            stddev_mult_x100: 200,
+        };
+        let series = IndicatorSeries::new(
+            bollinger.clone(),
+            1,
+            IndicatorColumns::Bollinger {
+                upper: vec![0.0, 110.0],
+                middle: vec![0.0, 104.0],
+                lower: vec![0.0, 98.0],
+            },
+        );
+        let mut indicators = HashMap::new();
+        indicators.insert(bollinger.clone(), Arc::new(series));
+
+        let above_middle = Rule::Above {
+            left: Operand::Close,
+            right: Operand::Indicator(IndicatorRef {
+                indicator_type: bollinger.clone(),
+                field: IndicatorField::BollingerMiddle,
+            }),
+        };
+        let above_upper = Rule::Above {
+            left: Operand::Close,
+            right: Operand::Indicator(IndicatorRef {
+                indicator_type: bollinger.clone(),
+                field: IndicatorField::BollingerUpper,
+            }),
+        };
+        // A field the indicator does not produce resolves to NaN.
+        let wrong_field = Rule::Above {
+            left: Operand::Close,
+            right: Operand::Indicator(IndicatorRef {
+                indicator_type: bollinger,
+                field: IndicatorField::MacdLine,
+            }),
+        };
+
+        assert!(!evaluate(&above_middle, &ohlcv, &indicators, 0));
+        assert!(evaluate(&above_middle, &ohlcv, &indicators, 1));
+        assert!(!evaluate(&above_upper, &ohlcv, &indicators, 1));
+        assert!(!evaluate(&wrong_field, &ohlcv, &indicators, 1));
+    }
 }
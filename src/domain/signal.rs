@@ -0,0 +1,199 @@
+//! Packed per-bar signal bitsets (TRD Section 5.6).
+//!
+//! `CompiledRule::signals` evaluates a rule over a whole series at once and
+//! returns one bit per bar. Composite rules combine child bitsets 64 bars at
+//! a time, and the backtest loop reads entry/exit decisions with `get`.
+
+/// One boolean per bar, packed into 64-bit words.
+#[derive(Debug, Clone, PartialEq, Eq)]
+pub struct SignalBits {
+    words: Vec<u64>,
+    len: usize,
+}
+
+impl SignalBits {
+    /// All-false bitset of `len` bars.
+    pub fn new(len: usize) -> Self {
+        SignalBits {
+            words: vec![0; len.div_ceil(64)],
+            len,
+        }
+    }
+
+    /// Build from a per-bar predicate, packing 64 results per word.
+    pub fn from_fn(len: usize, mut f: impl FnMut(usize) -> bool) -> Self {
+        let mut bits = SignalBits::new(len);
+        for (w, word) in bits.words.iter_mut().enumerate() {
+            let base = w * 64;
+            let end = (base + 64).min(len);
+            let mut packed = 0u64;
+            for i in base..end {
+                packed |= (f(i) as u64) << (i - base);
+            }
+            *word = packed;
+        }
+        bits
+    }
+
+    pub fn len(&self) -> usize {
+        self.len
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len == 0
+    }
+
+    /// Bit for bar `i`; out-of-range bars read as false.
+    #[inline]
+    pub fn get(&self, i: usize) -> bool {
+        i < self.len && (self.words[i / 64] >> (i % 64)) & 1 == 1
+    }
+
+    pub fn set(&mut self, i: usize, value: bool) {
+        let mask = 1u64 << (i % 64);
+        if value {
+            self.words[i / 64] |= mask;
+        } else {
+            self.words[i / 64] &= !mask;
+        }
+    }
+
+    pub fn count_ones(&self) -> usize {
+        self.words.iter().map(|w| w.count_ones() as usize).sum()
+    }
+
+    pub fn and_assign(&mut self, other: &SignalBits) {
+        for (a, b) in self.words.iter_mut().zip(&other.words) {
+            *a &= b;
+        }
+    }
+
+    pub fn or_assign(&mut self, other: &SignalBits) {
+        for (a, b) in self.words.iter_mut().zip(&other.words) {
+            *a |= b;
+        }
+    }
+
+    pub fn not_assign(&mut self) {
+        for w in &mut self.words {
+            *w = !*w;
+        }
+        self.clear_tail();
+    }
+
+    /// Force bars `0..n` to false (indicator warmup, cross look-back).
+    pub fn clear_below(&mut self, n: usize) {
+        let n = n.min(self.len);
+        let full = n / 64;
+        for w in &mut self.words[..full] {
+            *w = 0;
+        }
+        if n % 64 != 0 {
+            self.words[full] &= !0u64 << (n % 64);
+        }
+    }
+
+    /// True where this signal held on each of the last `count` bars.
+    pub fn consecutive(&self, count: usize) -> SignalBits {
+        let mut out = SignalBits::new(self.len);
+        if count == 0 {
+            return out;
+        }
+        let mut run = 0usize;
+        for i in 0..self.len {
+            run = if self.get(i) { run + 1 } else { 0 };
+            if run >= count {
+                out.set(i, true);
+            }
+        }
+        out
+    }
+
+    /// True where this signal held at least once in the last `count` bars.
+    pub fn any_of(&self, count: usize) -> SignalBits {
+        let mut out = SignalBits::new(self.len);
+        if count == 0 {
+            return out;
+        }
+        let mut last_true: Option<usize> = None;
+        for i in 0..self.len {
+            if self.get(i) {
+                last_true = Some(i);
+            }
+            if last_true.is_some_and(|t| i - t < count) {
+                out.set(i, true);
+            }
+        }
+        out
+    }
+
+    fn clear_tail(&mut self) {
+        if self.len % 64 != 0 {
+            if let Some(last) = self.words.last_mut() {
+                *last &= (1u64 << (self.len % 64)) - 1;
+            }
+        }
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    fn bits(pattern: &str) -> SignalBits {
+        let chars: Vec<char> = pattern.chars().collect();
+        SignalBits::from_fn(chars.len(), |i| chars[i] == '1')
+    }
+
+    fn pattern(bits: &SignalBits) -> String {
+        (0..bits.len())
+            .map(|i| if bits.get(i) { '1' } else { '0' })
+            .collect()
+    }
+
+    #[test]
+    fn from_fn_packs_across_words() {
+        let b = SignalBits::from_fn(130, |i| i % 3 == 0);
+        assert_eq!(b.count_ones(), 44);
+        assert!(b.get(129));
+        assert!(!b.get(128));
+        assert!(!b.get(130));
+    }
+
+    #[test]
+    fn not_keeps_tail_clear() {
+        let mut b = SignalBits::new(70);
+        b.not_assign();
+        assert_eq!(b.count_ones(), 70);
+    }
+
+    #[test]
+    fn and_or_combine_bitwise() {
+        let mut a = bits("1100");
+        a.and_assign(&bits("1010"));
+        assert_eq!(pattern(&a), "1000");
+        a.or_assign(&bits("0001"));
+        assert_eq!(pattern(&a), "1001");
+    }
+
+    #[test]
+    fn clear_below_crosses_word_boundary() {
+        let mut b = SignalBits::from_fn(100, |_| true);
+        b.clear_below(65);
+        assert!(!b.get(64));
+        assert!(b.get(65));
+        assert_eq!(b.count_ones(), 35);
+    }
+
+    #[test]
+    fn consecutive_counts_runs() {
+        assert_eq!(pattern(&bits("0111011110").consecutive(3)), "0001000110");
+        assert_eq!(pattern(&bits("111").consecutive(0)), "000");
+    }
+
+    #[test]
+    fn any_of_is_sliding_window() {
+        assert_eq!(pattern(&bits("1000010000").any_of(3)), "1110011100");
+        assert_eq!(pattern(&bits("111").any_of(0)), "000");
+    }
+}
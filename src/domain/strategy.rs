@@ -1,6 +1,7 @@
 //! Strategy configuration and composition (TRD Section 3.6).
 
-use crate::domain::rule::Rule;
+use crate::domain::indicator::IndicatorType;
+use crate::domain::rule::{Rule, extract_indicators};
 
 #[derive(Debug, Clone)]
 pub struct Strategy {
@@ -16,6 +17,18 @@ pub struct Strategy {
     pub max_positions: usize,
 }
 
+impl Strategy {
+    /// Every distinct indicator referenced by any of the strategy's rules.
+    pub fn indicator_types(&self) -> Vec<IndicatorType> {
+        let mut indicators = extract_indicators(&self.entry_long);
+        indicators.extend(extract_indicators(&self.exit_long));
+        for rule in [&self.entry_short, &self.exit_short].into_iter().flatten() {
+            indicators.extend(extract_indicators(rule));
+        }
+        indicators.into_iter().collect()
+    }
+}
+
 #[cfg(test)]
 mod tests {
     use super::*;
@@ -0,0 +1,633 @@
+//! Parameter sweeps over one loaded universe (TRD Section 8.3).
+//!
+//! A sweep is a strategy template plus a grid of named parameters. The
+//! `[sweep]` section lists the parameter names and, per name, either an
+//! inclusive numeric range (`start:end[:step]`) or a comma-separated list:
+//!
+//! ```ini
+//! [strategy]
+//! entry_long = CROSS_ABOVE(SMA(${fast}), SMA(${slow}))
+//! exit_long = CROSS_BELOW(SMA(${fast}), SMA(${slow}))
+//!
+//! [sweep]
+//! parameters = fast, slow
+//! fast = 10:50:5
+//! slow = 50, 100, 150, 200
+//! ```
+//!
+//! Every grid point substitutes its values for `${name}` in the strategy
+//! keys. `run_sweep` then runs one backtest per point over the same
+//! read-only `CodeData` and `Timeline`, on a worker pool, handing each
+//! point's `Metrics` back to the caller as soon as it finishes. Points draw
+//! their indicators from one shared `IndicatorStore`, so an indicator used
+//! by many points is computed once per code.
+
+use crate::domain::backtest::{BacktestConfig, run_backtest_with_indicators};
+use crate::domain::code_data::{CodeData, Timeline};
+use crate::domain::error::SamtraderError;
+use crate::domain::indicator_helpers::IndicatorCache;
+use crate::domain::indicator_store::IndicatorStore;
+use crate::domain::loader::resolve_workers;
+use crate::domain::metrics::Metrics;
+use crate::domain::strategy::Strategy;
+use crate::domain::symbol::SymbolId;
+use crate::ports::config_port::ConfigPort;
+use std::sync::atomic::{AtomicUsize, Ordering};
+use std::sync::mpsc;
+use std::thread;
+
+/// Upper bound on the number of values one range may expand to.
+const MAX_RANGE_VALUES: usize = 100_000;
+
+/// One named grid axis and the textual values substituted for it.
+#[derive(Debug, Clone, PartialEq)]
+pub struct SweepParam {
+    pub name: String,
+    pub values: Vec<String>,
+}
+
+/// Parameter values for one grid point, in `ParamGrid` order.
+pub type GridPoint = Vec<(String, String)>;
+
+/// The cartesian product of all sweep parameters.
+#[derive(Debug, Clone, PartialEq)]
+pub struct ParamGrid {
+    params: Vec<SweepParam>,
+}
+
+/// One grid point with the strategy built from it.
+#[derive(Debug, Clone)]
+pub struct SweepPoint {
+    pub params: GridPoint,
+    pub strategy: Strategy,
+}
+
+impl ParamGrid {
+    pub fn new(params: Vec<SweepParam>) -> Self {
+        ParamGrid { params }
+    }
+
+    /// Read `[sweep] parameters` and one value spec per listed name.
+    pub fn from_config(config: &dyn ConfigPort) -> Result<Self, SamtraderError> {
+        let names = config.get_string("sweep", "parameters").ok_or_else(|| {
+            SamtraderError::ConfigMissing {
+                section: "sweep".into(),
+                key: "parameters".into(),
+            }
+        })?;
+
+        let mut params = Vec::new();
+        for name in names.split(',').map(|s| s.trim().to_string()) {
+            if name.is_empty() {
+                continue;
+            }
+            if params.iter().any(|p: &SweepParam| p.name == name) {
+                return Err(SamtraderError::ConfigInvalid {
+                    section: "sweep".into(),
+                    key: "parameters".into(),
+                    reason: format!("duplicate parameter '{name}'"),
+                });
+            }
+            let spec =
+                config
+                    .get_string("sweep", &name)
+                    .ok_or_else(|| SamtraderError::ConfigMissing {
+                        section: "sweep".into(),
+                        key: name.clone(),
+                    })?;
+            let values = parse_values(&spec).map_err(|reason| SamtraderError::ConfigInvalid {
+                section: "sweep".into(),
+                key: name.clone(),
+                reason,
+            })?;
+            params.push(SweepParam { name, values });
+        }
+
+        if params.is_empty() {
+            return Err(SamtraderError::ConfigInvalid {
+                section: "sweep".into(),
+                key: "parameters".into(),
+                reason: "no parameters listed".into(),
+            });
+        }
+        Ok(ParamGrid { params })
+    }
+
+    pub fn params(&self) -> &[SweepParam] {
+        &self.params
+    }
+
+    /// Number of grid points.
+    pub fn len(&self) -> usize {
+        self.params.iter().map(|p| p.values.len()).product()
+    }
+
+    pub fn is_empty(&self) -> bool {
+        self.len() == 0
+    }
+
+    /// Every grid point; the last parameter varies fastest.
+    pub fn points(&self) -> Vec<GridPoint> {
+        let mut points: Vec<GridPoint> = vec![Vec::new()];
+        for param in &self.params {
+            points = points
+                .into_iter()
+                .flat_map(|point| {
+                    param.values.iter().map(move |value| {
+                        let mut next = point.clone();
+                        next.push((param.name.clone(), value.clone()));
+                        next
+                    })
+                })
+                .collect();
+        }
+        points
+    }
+}
+
+/// Parse `start:end[:step]` as an inclusive range, otherwise a comma list.
+fn parse_values(spec: &str) -> Result<Vec<String>, String> {
+    if spec.contains(':') {
+        return parse_range(spec);
+    }
+    let values: Vec<String> = spec
+        .split(',')
+        .map(|s| s.trim().to_string())
+        .filter(|s| !s.is_empty())
+        .collect();
+    if values.is_empty() {
+        return Err("no values".into());
+    }
+    Ok(values)
+}
+
+fn parse_range(spec: &str) -> Result<Vec<String>, String> {
+    let parts: Vec<f64> = spec
+        .split(':')
+        .map(|s| {
+            s.trim()
+                .parse::<f64>()
+                .map_err(|_| format!("'{}' is not a number", s.trim()))
+        })
+        .collect::<Result<_, _>>()?;
+    let (start, end, step) = match parts[..] {
+        [start, end] => (start, end, 1.0),
+        [start, end, step] => (start, end, step),
+        _ => return Err("expected start:end or start:end:step".into()),
+    };
+    if !(step > 0.0 && step.is_finite()) {
+        return Err("step must be positive".into());
+    }
+    if !(end >= start) {
+        return Err("end must not be less than start".into());
+    }
+    let count = ((end - start) / step + 1e-9).floor() as usize + 1;
+    if count > MAX_RANGE_VALUES {
+        return Err(format!(
+            "range expands to more than {MAX_RANGE_VALUES} values"
+        ));
+    }
+    Ok((0..count)
+        .map(|k| {
+            // Round away accumulated float error so 0.1 + 2 * 0.1 prints as 0.3.
+            let value = ((start + k as f64 * step) * 1e9).round() / 1e9;
+            value.to_string()
+        })
+        .collect())
+}
+
+/// Replace every `${name}` in `template` with the point's value.
+pub fn substitute(template: &str, point: &GridPoint) -> String {
+    let mut out = template.to_string();
+    for (name, value) in point {
+        out = out.replace(&format!("${{{name}}}"), value);
+    }
+    out
+}
+
+/// A `ConfigPort` view of `base` with one grid point substituted into
+/// every value, so the normal strategy validation and builder apply.
+pub struct PointConfig<'a> {
+    base: &'a dyn ConfigPort,
+    point: &'a GridPoint,
+}
+
+impl<'a> PointConfig<'a> {
+    pub fn new(base: &'a dyn ConfigPort, point: &'a GridPoint) -> Self {
+        PointConfig { base, point }
+    }
+
+    /// The substituted value, only when the raw value has a placeholder.
+    fn templated(&self, section: &str, key: &str) -> Option<String> {
+        self.base
+            .get_string(section, key)
+            .filter(|raw| raw.contains("${"))
+            .map(|raw| substitute(&raw, self.point))
+    }
+}
+
+impl ConfigPort for PointConfig<'_> {
+    fn get_string(&self, section: &str, key: &str) -> Option<String> {
+        self.base
+            .get_string(section, key)
+            .map(|raw| substitute(&raw, self.point))
+    }
+
+    fn get_int(&self, section: &str, key: &str, default: i64) -> i64 {
+        match self.templated(section, key) {
+            Some(value) => value.trim().parse().unwrap_or(default),
+            None => self.base.get_int(section, key, default),
+        }
+    }
+
+    fn get_double(&self, section: &str, key: &str, default: f64) -> f64 {
+        match self.templated(section, key) {
+            Some(value) => value.trim().parse().unwrap_or(default),
+            None => self.base.get_double(section, key, default),
+        }
+    }
+
+    fn get_bool(&self, section: &str, key: &str, default: bool) -> bool {
+        match self.templated(section, key) {
+            Some(value) => match value.trim().to_lowercase().as_str() {
+                "true" | "yes" | "1" => true,
+                "false" | "no" | "0" => false,
+                _ => default,
+            },
+            None => self.base.get_bool(section, key, default),
+        }
+    }
+}
+
+/// Backtest every point over the same universe on up to `workers` threads.
+///
+/// `on_result(index, metrics)` is called on the calling thread as each
+/// point finishes, so results arrive in completion order; `index` is the
+/// point's position in `points`.
+pub fn run_sweep(
+    code_data: &[CodeData],
+    timeline: &Timeline,
+    points: &[SweepPoint],
+    config: &BacktestConfig,
+    workers: usize,
+    mut on_result: impl FnMut(usize, Metrics),
+) {
+    let store = IndicatorStore::new(code_data);
+    let run_point = |point: &SweepPoint| {
+        let types = point.strategy.indicator_types();
+        let maps: Vec<IndicatorCache> = (0..code_data.len())
+            .map(|c| store.indicators_for(SymbolId::from_index(c), &types))
+            .collect();
+        let indicators: Vec<&IndicatorCache> = maps.iter().collect();
+        let result =
+            run_backtest_with_indicators(code_data, &indicators, timeline, &point.strategy, config);
+        Metrics::compute(&result.portfolio, config.risk_free_rate)
+    };
+
+    let workers = resolve_workers(workers).min(points.len());
+    if workers <= 1 {
+        for (i, point) in points.iter().enumerate() {
+            on_result(i, run_point(point));
+        }
+        return;
+    }
+
+    let next = AtomicUsize::new(0);
+    let (tx, rx) = mpsc::channel();
+    thread::scope(|scope| {
+        for _ in 0..workers {
+            let tx = tx.clone();
+            let (next, run_point) = (&next, &run_point);
+            scope.spawn(move || {
+                loop {
+                    let i = next.fetch_add(1, Ordering::Relaxed);
+                    if i >= points.len() {
+                        break;
+                    }
+                    if tx.send((i, run_point(&points[i]))).is_err() {
+                        break;
+                    }
+                }
+            });
+        }
+        drop(tx);
+        for (i, metrics) in rx {
+            on_result(i, metrics);
+        }
+    });
+}
+
+/// Metric columns written for every grid point.
+const METRIC_COLUMNS: [&str; 8] = [
+    "total_return",
+    "annualized_return",
+    "sharpe_ratio",
+    "sortino_ratio",
+    "max_drawdown",
+    "total_trades",
+    "win_rate",
+    "profit_factor",
+];
+
+fn metric_values(metrics: &Metrics) -> [f64; 8] {
+    [
+        metrics.total_return,
+        metrics.annualized_return,
+        metrics.sharpe_ratio,
+        metrics.sortino_ratio,
+        metrics.max_drawdown,
+        metrics.total_trades as f64,
+        metrics.win_rate,
+        metrics.profit_factor,
+    ]
+}
+
+/// CSV header: `point`, one column per parameter, then the metrics.
+pub fn csv_header(grid: &ParamGrid) -> String {
+    let mut columns = vec!["point".to_string()];
+    columns.extend(grid.params.iter().map(|p| p.name.clone()));
+    columns.extend(METRIC_COLUMNS.iter().map(|c| c.to_string()));
+    columns.join(",")
+}
+
+pub fn csv_row(index: usize, point: &GridPoint, metrics: &Metrics) -> String {
+    let mut fields = vec![index.to_string()];
+    fields.extend(point.iter().map(|(_, value)| csv_field(value)));
+    fields.extend(metric_values(metrics).iter().map(|v| v.to_string()));
+    fields.join(",")
+}
+
+/// One JSON object per line; non-finite metrics become `null`.
+pub fn json_row(index: usize, point: &GridPoint, metrics: &Metrics) -> String {
+    let params: Vec<String> = point
+        .iter()
+        .map(|(name, value)| format!("{}:{}", json_string(name), json_string(value)))
+        .collect();
+    let values: Vec<String> = METRIC_COLUMNS
+        .iter()
+        .zip(metric_values(metrics))
+        .map(|(name, v)| {
+            let v = if v.is_finite() {
+                v.to_string()
+            } else {
+                "null".to_string()
+            };
+            format!("\"{name}\":{v}")
+        })
+        .collect();
+    format!(
+        "{{\"point\":{index},\"params\":{{{}}},{}}}",
+        params.join(","),
+        values.join(",")
+    )
+}
+
+fn csv_field(value: &str) -> String {
+    if value.contains([',', '"', '\n']) {
+        format!("\"{}\"", value.replace('"', "\"\""))
+    } else {
+        value.to_string()
+    }
+}
+
+fn json_string(value: &str) -> String {
+    let mut out = String::with_capacity(value.len() + 2);
+    out.push('"');
+    for c in value.chars() {
+        match c {
+            '"' => out.push_str("\\\""),
+            '\\' => out.push_str("\\\\"),
+            c if (c as u32) < 0x20 => out.push_str(&format!("\\u{:04x}", c as u32)),
+            c => out.push(c),
+        }
+    }
+    out.push('"');
+    out
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+    use crate::domain::backtest::run_backtest;
+    use crate::domain::code_data::build_unified_timeline;
+    use crate::domain::indicator::IndicatorType;
+    use crate::domain::indicator_helpers::compute_indicators;
+    use crate::domain::ohlcv::OhlcvBar;
+    use crate::domain::rule_parser::parse;
+    use chrono::NaiveDate;
+    use std::collections::HashMap;
+
+    struct MapConfig(HashMap<(String, String), String>);
+
+    impl MapConfig {
+        fn new(entries: &[(&str, &str, &str)]) -> Self {
+            MapConfig(
+                entries
+                    .iter()
+                    .map(|(s, k, v)| ((s.to_string(), k.to_string()), v.to_string()))
+                    .collect(),
+            )
+        }
+    }
+
+    impl ConfigPort for MapConfig {
+        fn get_string(&self, section: &str, key: &str) -> Option<String> {
+            self.0.get(&(section.to_string(), key.to_string())).cloned()
+        }
+        fn get_int(&self, section: &str, key: &str, default: i64) -> i64 {
+            self.get_string(section, key)
+                .and_then(|v| v.parse().ok())
+                .unwrap_or(default)
+        }
+        fn get_double(&self, section: &str, key: &str, default: f64) -> f64 {
+            self.get_string(section, key)
+                .and_then(|v| v.parse().ok())
+                .unwrap_or(default)
+        }
+        fn get_bool(&self, _section: &str, _key: &str, default: bool) -> bool {
+            default
+        }
+    }
+
+    #[test]
+    fn ranges_and_lists_expand() {
+        assert_eq!(parse_values("10:20:5").unwrap(), ["10", "15", "20"]);
+        assert_eq!(parse_values("1:3").unwrap(), ["1", "2", "3"]);
+        assert_eq!(parse_values("0.1:0.3:0.1").unwrap(), ["0.1", "0.2", "0.3"]);
+        assert_eq!(parse_values("50, 100 ,200").unwrap(), ["50", "100", "200"]);
+        assert!(parse_values("5:1").is_err());
+        assert!(parse_values("1:5:0").is_err());
+        assert!(parse_values("a:5").is_err());
+    }
+
+    #[test]
+    fn grid_is_cartesian_product() {
+        let config = MapConfig::new(&[
+            ("sweep", "parameters", "fast, slow"),
+            ("sweep", "fast", "5:10:5"),
+            ("sweep", "slow", "20,30,40"),
+        ]);
+        let grid = ParamGrid::from_config(&config).unwrap();
+        let points = grid.points();
+
+        assert_eq!(grid.len(), 6);
+        assert_eq!(points.len(), 6);
+        assert_eq!(
+            points[1],
+            vec![
+                ("fast".to_string(), "5".to_string()),
+                ("slow".to_string(), "30".to_string())
+            ]
+        );
+        assert_eq!(
+            csv_header(&grid),
+            format!("point,fast,slow,{}", METRIC_COLUMNS.join(","))
+        );
+    }
+
+    #[test]
+    fn grid_requires_listed_values() {
+        let config = MapConfig::new(&[("sweep", "parameters", "fast")]);
+        assert!(matches!(
+            ParamGrid::from_config(&config),
+            Err(SamtraderError::ConfigMissing { key, .. }) if key == "fast"
+        ));
+        assert!(matches!(
+            ParamGrid::from_config(&MapConfig::new(&[])),
+            Err(SamtraderError::ConfigMissing { .. })
+        ));
+    }
+
+    #[test]
+    fn point_config_substitutes_placeholders() {
+        let config = MapConfig::new(&[
+            ("strategy", "entry_long", "ABOVE(close, SMA(${n}))"),
+            ("strategy", "stop_loss", "${sl}"),
+            ("strategy", "max_positions", "2"),
+        ]);
+        let point = vec![
+            ("n".to_string(), "15".to_string()),
+            ("sl".to_string(), "2.5".to_string()),
+        ];
+        let view = PointConfig::new(&config, &point);
+
+        assert_eq!(
+            view.get_string("strategy", "entry_long").unwrap(),
+            "ABOVE(close, SMA(15))"
+        );
+        assert_eq!(view.get_double("strategy", "stop_loss", 0.0), 2.5);
+        assert_eq!(view.get_int("strategy", "max_positions", 1), 2);
+    }
+
+    fn make_code_data(code: &str, n: usize) -> CodeData {
+        let start = NaiveDate::from_ymd_opt(2024, 1, 1).unwrap();
+        let bars: Vec<OhlcvBar> = (0..n)
+            .map(|i| {
+                let close = 100.0 + 10.0 * ((i as f64) * 0.2).sin();
+                OhlcvBar {
+                    code: code.to_string(),
+                    exchange: "ASX".to_string(),
+                    date: start + chrono::Duration::days(i as i64),
+                    open: close,
+                    high: close + 1.0,
+                    low: close - 1.0,
+                    close,
+                    volume: 1000,
+                }
+            })
+            .collect();
+        CodeData::new(code.to_string(), "ASX".to_string(), bars)
+    }
+
+    fn sweep_points(periods: &[usize]) -> Vec<SweepPoint> {
+        periods
+            .iter()
+            .map(|n| SweepPoint {
+                params: vec![("n".to_string(), n.to_string())],
+                strategy: Strategy {
+                    name: format!("SMA {n}"),
+                    description: String::new(),
+                    entry_long: parse(&format!("CROSS_ABOVE(close, SMA({n}))")).unwrap(),
+                    exit_long: parse(&format!("CROSS_BELOW(close, SMA({n}))")).unwrap(),
+                    entry_short: None,
+                    exit_short: None,
+                    position_size: 0.5,
+                    stop_loss_pct: 0.0,
+                    take_profit_pct: 0.0,
+                    max_positions: 2,
+                },
+            })
+            .collect()
+    }
+
+    fn config() -> BacktestConfig {
+        BacktestConfig {
+            start_date: NaiveDate::from_ymd_opt(2024, 1, 1).unwrap(),
+            end_date: NaiveDate::from_ymd_opt(2024, 12, 31).unwrap(),
+            initial_capital: 100_000.0,
+            commission_per_trade: 0.0,
+            commission_pct: 0.0,
+            slippage_pct: 0.0,
+            allow_shorting: false,
+            risk_free_rate: 0.05,
+            workers: 0,
+        }
+    }
+
+    #[test]
+    fn parallel_sweep_matches_sequential() {
+        let code_data = vec![make_code_data("BHP", 120), make_code_data("CBA", 100)];
+        let timeline = build_unified_timeline(&code_data);
+        let points = sweep_points(&[5, 10, 5, 10, 5]);
+
+        let collect = |workers| {
+            let mut rows: Vec<Option<Metrics>> = vec![None; points.len()];
+            run_sweep(
+                &code_data,
+                &timeline,
+                &points,
+                &config(),
+                workers,
+                |i, m| rows[i] = Some(m),
+            );
+            rows.into_iter().map(Option::unwrap).collect::<Vec<_>>()
+        };
+        let sequential = collect(1);
+        let parallel = collect(3);
+
+        assert_eq!(sequential, parallel);
+        assert!(sequential[0].total_trades > 0);
+        assert_eq!(sequential[0], sequential[2]);
+
+        // Same result as a plain backtest over eagerly computed indicators.
+        let mut eager = code_data.clone();
+        for cd in &mut eager {
+            cd.indicators = compute_indicators(&cd.ohlcv, &[IndicatorType::Sma(10)]);
+        }
+        let result = run_backtest(&eager, &timeline, &points[1].strategy, &config());
+        assert_eq!(
+            sequential[1],
+            Metrics::compute(&result.portfolio, config().risk_free_rate)
+        );
+    }
+
+    #[test]
+    fn rows_format_params_and_metrics() {
+        let code_data = vec![make_code_data("BHP", 60)];
+        let timeline = build_unified_timeline(&code_data);
+        let points = sweep_points(&[5]);
+        let mut rows = Vec::new();
+        run_sweep(&code_data, &timeline, &points, &config(), 1, |i, m| {
+            rows.push((i, m))
+        });
+        let (i, metrics) = &rows[0];
+
+        let csv = csv_row(*i, &points[0].params, metrics);
+        assert!(csv.starts_with("0,5,"));
+        assert_eq!(csv.split(',').count(), 2 + METRIC_COLUMNS.len());
+
+        let json = json_row(*i, &points[0].params, metrics);
+        assert!(json.starts_with("{\"point\":0,\"params\":{\"n\":\"5\"},\"total_return\":"));
+        assert!(!json.contains("inf"));
+    }
+}
@@ -0,0 +1,34 @@
+//! Integer symbol handles for the backtest event loop (TRD Section 8.3).
+//!
+//! Inside a run every code is identified by its position in the `CodeData`
+//! slice handed to `run_backtest`. Portfolio, position and execution state
+//! are keyed by that integer rather than by the ticker string, so the
+//! per-bar work never hashes or clones a code name. Names stay on
+//! `CodeData`, `Position` and `ClosedTrade` for reporting.
+
+/// Dense handle for one code within a backtest run.
+#[derive(Debug, Clone, Copy, PartialEq, Eq, Hash, PartialOrd, Ord)]
+pub struct SymbolId(pub u32);
+
+impl SymbolId {
+    pub fn from_index(index: usize) -> Self {
+        SymbolId(index as u32)
+    }
+
+    /// Index into per-code buffers (prices, commissions) for this run.
+    pub fn index(self) -> usize {
+        self.0 as usize
+    }
+}
+
+#[cfg(test)]
+mod tests {
+    use super::*;
+
+    #[test]
+    fn symbol_id_round_trips_index() {
+        let id = SymbolId::from_index(42);
+        assert_eq!(id, SymbolId(42));
+        assert_eq!(id.index(), 42);
+    }
+}
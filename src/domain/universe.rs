@@ -1,9 +1,12 @@
 //! Universe module for multi-code backtesting (TRD Section 7).
 //!
 //! Parses code lists from configuration and validates that each code has
-//! sufficient data for backtesting.
+//! sufficient data for backtesting. Validation keeps the bars it fetched, so
+//! the pipeline reads each code from the data source exactly once.
 
+use crate::domain::code_data::CodeData;
 use crate::domain::error::SamtraderError;
+use crate::domain::loader::fetch_code_data;
 use crate::ports::data_port::DataPort;
 use chrono::NaiveDate;
 use std::collections::HashSet;
@@ -54,6 +57,9 @@ pub fn parse_codes(input: &str) -> Result<Vec<String>, UniverseError> {
 #[derive(Debug)]
 pub struct UniverseValidationResult {
     pub universe: Universe,
+    /// Loaded bars for each valid code, in `universe.codes` order. Indicators
+    /// are not yet computed.
+    pub code_data: Vec<CodeData>,
     pub skipped: Vec<SkippedCode>,
 }
 
@@ -75,14 +81,26 @@ pub fn validate_universe(
     exchange: &str,
     start_date: NaiveDate,
     end_date: NaiveDate,
+) -> Result<UniverseValidationResult, SamtraderError> {
+    let fetched = fetch_code_data(data_port, &codes, exchange, start_date, end_date, 1)?;
+    validate_fetched(codes, fetched, exchange)
+}
+
+/// Validate codes whose bars were already fetched (one result per code, in
+/// `codes` order), keeping the loaded data of every code that passes.
+pub fn validate_fetched(
+    codes: Vec<String>,
+    fetched: Vec<Result<CodeData, SamtraderError>>,
+    exchange: &str,
 ) -> Result<UniverseValidationResult, SamtraderError> {
     let mut valid_codes = Vec::new();
+    let mut code_data = Vec::new();
     let mut skipped = Vec::new();
     let mut fetch_errors: usize = 0;
 
-    for code in codes {
-        let ohlcv = match data_port.fetch_ohlcv(&code, exchange, start_date, end_date) {
-            Ok(data) => data,
+    for (code, result) in codes.into_iter().zip(fetched) {
+        let cd = match result {
+            Ok(cd) => cd,
             Err(e) => {
                 eprintln!("Warning: skipping {}.{} ({})", code, exchange, e);
                 fetch_errors += 1;
@@ -93,8 +111,9 @@ pub fn validate_universe(
                 continue;
             }
         };
+        let bars = cd.bar_count();
 
-        if ohlcv.is_empty() {
+        if bars == 0 {
             eprintln!("Warning: skipping {}.{} (no data found)", code, exchange);
             skipped.push(SkippedCode {
                 code: code.clone(),
@@ -103,23 +122,21 @@ pub fn validate_universe(
             continue;
         }
 
-        if ohlcv.len() < MIN_OHLCV_BARS {
+        if bars < MIN_OHLCV_BARS {
             eprintln!(
                 "Warning: skipping {}.{} (only {} bars, minimum {} required)",
-                code,
-                exchange,
-                ohlcv.len(),
-                MIN_OHLCV_BARS
+                code, exchange, bars, MIN_OHLCV_BARS
             );
             skipped.push(SkippedCode {
                 code: code.clone(),
-                reason: SkipReason::InsufficientBars { bars: ohlcv.len() },
+                reason: SkipReason::InsufficientBars { bars },
             });
             continue;
         }
 
-        eprintln!("  {}: {} bars [OK]", code, ohlcv.len());
+        eprintln!("  {}: {} bars [OK]", code, bars);
         valid_codes.push(code);
+        code_data.push(cd);
     }
 
     if valid_codes.is_empty() {
@@ -152,6 +169,7 @@ pub fn validate_universe(
             codes: valid_codes,
             exchange: exchange.to_string(),
         },
+        code_data,
         skipped,
     })
 }
@@ -161,6 +179,7 @@ mod tests {
     use super::*;
     use crate::domain::ohlcv::OhlcvBar;
     use std::collections::HashMap;
+    use std::sync::atomic::{AtomicUsize, Ordering};
 
     // --- parse_codes tests ---
 
@@ -214,6 +233,7 @@ mod tests {
     struct MockDataPort {
         data: HashMap<String, Vec<OhlcvBar>>,
         errors: HashMap<String, String>,
+        fetches: AtomicUsize,
     }
 
     impl MockDataPort {
@@ -221,6 +241,7 @@ mod tests {
             Self {
                 data: HashMap::new(),
                 errors: HashMap::new(),
+                fetches: AtomicUsize::new(0),
             }
         }
 
@@ -256,6 +277,7 @@ mod tests {
             _start_date: NaiveDate,
             _end_date: NaiveDate,
         ) -> Result<Vec<OhlcvBar>, SamtraderError> {
+            self.fetches.fetch_add(1, Ordering::Relaxed);
             if let Some(reason) = self.errors.get(code) {
                 return Err(SamtraderError::Database {
                     reason: reason.clone(),
@@ -404,4 +426,24 @@ mod tests {
 
         assert!(matches!(err, SamtraderError::InsufficientData { .. }));
     }
+
+    #[test]
+    fn test_validate_keeps_loaded_bars() {
+        let port = MockDataPort::new()
+            .with_bars("CBA", 50)
+            .with_bars("XYZ", 10)
+            .with_bars("BHP", 40);
+        let codes = vec!["CBA".to_string(), "XYZ".to_string(), "BHP".to_string()];
+
+        let result =
+            validate_universe(&port, codes, "ASX", date(2024, 1, 1), date(2024, 12, 31)).unwrap();
+
+        assert_eq!(port.fetches.load(Ordering::Relaxed), 3);
+        let loaded: Vec<(&str, usize)> = result
+            .code_data
+            .iter()
+            .map(|cd| (cd.code.as_str(), cd.bar_count()))
+            .collect();
+        assert_eq!(loaded, vec![("CBA", 50), ("BHP", 40)]);
+    }
 }
@@ -1,10 +1,12 @@
 //! Data access port trait (TRD Section 11.1).
 
 use crate::domain::error::SamtraderError;
-use crate::domain::ohlcv::OhlcvBar;
+use crate::domain::ohlcv::{OhlcvBar, OhlcvSeries};
 use chrono::NaiveDate;
 
-pub trait DataPort {
+/// Data source for OHLCV bars. Implementations are shared across loader
+/// worker threads, hence `Send + Sync`.
+pub trait DataPort: Send + Sync {
     fn fetch_ohlcv(
         &self,
         code: &str,
@@ -13,8 +15,59 @@ pub trait DataPort {
         end_date: NaiveDate,
     ) -> Result<Vec<OhlcvBar>, SamtraderError>;
 
+    /// Fetch bars straight into the columnar store used by the backtest engine.
+    ///
+    /// Default implementation: converts the rows returned by `fetch_ohlcv`.
+    /// Adapters override this to fill the columns directly and skip the
+    /// per-row `code`/`exchange` strings.
+    fn fetch_ohlcv_series(
+        &self,
+        code: &str,
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<OhlcvSeries, SamtraderError> {
+        self.fetch_ohlcv(code, exchange, start_date, end_date)
+            .map(OhlcvSeries::from)
+    }
+
+    /// Fetch several codes in one go, returning one series per code in
+    /// `codes` order (empty when a code has no bars in range).
+    ///
+    /// Default implementation: one `fetch_ohlcv_series` call per code.
+    /// Database adapters override this with a single multi-code query so a
+    /// large universe costs one round-trip instead of one per code.
+    fn fetch_ohlcv_batch(
+        &self,
+        codes: &[String],
+        exchange: &str,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
+    ) -> Result<Vec<OhlcvSeries>, SamtraderError> {
+        codes
+            .iter()
+            .map(|code| self.fetch_ohlcv_series(code, exchange, start_date, end_date))
+            .collect()
+    }
+
+    /// Whether `fetch_ohlcv_batch` answers a whole batch with one query, so
+    /// that a `Database` (connection or pool) error from it says nothing
+    /// about any single code and would only repeat on a per-code retry.
+    ///
+    /// Default implementation: `false`, since the default batch fetches each
+    /// code on its own and any error it returns belongs to one code.
+    fn batch_is_one_query(&self) -> bool {
+        false
+    }
+
     fn list_symbols(&self, exchange: &str) -> Result<Vec<String>, SamtraderError>;
 
+    /// Forget anything cached for `code` on `exchange` (every code on the
+    /// exchange when `None`), after new bars have been ingested.
+    ///
+    /// Default implementation: nothing is cached, so nothing to do.
+    fn invalidate(&self, _exchange: &str, _code: Option<&str>) {}
+
     fn get_data_range(
         &self,
         code: &str,
@@ -5,7 +5,8 @@
 //! - Code resolution logic (resolve_codes)
 //! - Indicator extraction (collect_all_indicators)
 //! - Dry-run mode with real INI files on disk
-//! - Full pipeline with MockDataPort (stages 6-11)
+//! - Full pipeline with MockDataPort (stages 6-11), including --resume
+//! - Parameter sweep pipeline with MockDataPort
 //! - End-to-end with real database (#[ignore])
 
 mod common;
@@ -431,6 +432,7 @@ max_positions = 1
 
 mod pipeline_mock {
     use super::*;
+    use std::sync::atomic::Ordering;
 
     #[test]
     fn pipeline_single_code_generates_report() {
@@ -452,6 +454,7 @@ mod pipeline_mock {
             "ASX",
             Some(&output),
             None,
+            false,
         );
 
         let report = format!("{exit_code:?}");
@@ -489,6 +492,7 @@ mod pipeline_mock {
             "ASX",
             Some(&output),
             None,
+            false,
         );
 
         let report = format!("{exit_code:?}");
@@ -517,6 +521,7 @@ mod pipeline_mock {
             "ASX",
             Some(&output),
             None,
+            false,
         );
 
         let report = format!("{exit_code:?}");
@@ -545,6 +550,7 @@ mod pipeline_mock {
             "ASX",
             Some(&output),
             None,
+            false,
         );
 
         let content = std::fs::read_to_string(&output).unwrap();
@@ -576,12 +582,201 @@ mod pipeline_mock {
             "ASX",
             Some(&output),
             None,
+            false,
         );
 
         let report = format!("{exit_code:?}");
         assert!(report.contains("0"), "should succeed with partial universe");
         assert!(output.exists(), "report should be written");
     }
+
+    #[test]
+    fn pipeline_resume_matches_full_run() {
+        let strategy = make_simple_strategy();
+        let bt_config = sample_config();
+        let codes = vec!["BHP".to_string(), "CBA".to_string()];
+        let universe = |n| {
+            MockDataPort::new()
+                .with_bars("BHP", generate_bars("BHP", "2020-01-01", n, 90.0))
+                .with_bars("CBA", generate_bars("CBA", "2020-01-01", n, 98.0))
+        };
+
+        let temp_dir = tempfile::TempDir::new().unwrap();
+        let resumed = temp_dir.path().join("resumed.typ");
+        let full = temp_dir.path().join("full.typ");
+
+        // Yesterday's run leaves a checkpoint; today's resumes over 20 new
+        // bars, fetching only those and each code's last checkpointed bar.
+        cli::run_backtest_pipeline(
+            &universe(80), &strategy, &bt_config, &codes, "ASX", Some(&resumed), None, true,
+        );
+        assert!(temp_dir.path().join("resumed.typ.ckpt").exists());
+        let today = universe(100);
+        let exit_code = cli::run_backtest_pipeline(
+            &today, &strategy, &bt_config, &codes, "ASX", Some(&resumed), None, true,
+        );
+        assert!(format!("{exit_code:?}").contains("0"));
+        assert_eq!(today.bars_served.load(Ordering::Relaxed), 2 * 21);
+
+        cli::run_backtest_pipeline(
+            &universe(100), &strategy, &bt_config, &codes, "ASX", Some(&full), None, false,
+        );
+        assert!(!temp_dir.path().join("full.typ.ckpt").exists());
+        assert_eq!(
+            std::fs::read_to_string(&resumed).unwrap(),
+            std::fs::read_to_string(&full).unwrap()
+        );
+    }
+
+    #[test]
+    fn pipeline_resume_fetches_each_code_from_its_own_last_bar() {
+        let strategy = make_simple_strategy();
+        let bt_config = sample_config();
+        let codes = vec!["BHP".to_string(), "OLD".to_string()];
+        // OLD was delisted after 40 days; BHP keeps trading.
+        let universe = |n| {
+            MockDataPort::new()
+                .with_bars("BHP", generate_bars("BHP", "2020-01-01", n, 90.0))
+                .with_bars("OLD", generate_bars("OLD", "2020-01-01", 40, 98.0))
+        };
+
+        let temp_dir = tempfile::TempDir::new().unwrap();
+        let resumed = temp_dir.path().join("resumed.typ");
+        let full = temp_dir.path().join("full.typ");
+
+        cli::run_backtest_pipeline(
+            &universe(80), &strategy, &bt_config, &codes, "ASX", Some(&resumed), None, true,
+        );
+        let today = universe(100);
+        cli::run_backtest_pipeline(
+            &today, &strategy, &bt_config, &codes, "ASX", Some(&resumed), None, true,
+        );
+        // BHP's 20 new bars and last bar, and OLD's last bar only.
+        assert_eq!(today.bars_served.load(Ordering::Relaxed), 21 + 1);
+
+        cli::run_backtest_pipeline(
+            &universe(100), &strategy, &bt_config, &codes, "ASX", Some(&full), None, false,
+        );
+        assert_eq!(
+            std::fs::read_to_string(&resumed).unwrap(),
+            std::fs::read_to_string(&full).unwrap()
+        );
+    }
+
+    #[test]
+    fn pipeline_resume_replays_when_a_skipped_code_qualifies() {
+        let strategy = make_simple_strategy();
+        let bt_config = sample_config();
+        let codes = vec!["BHP".to_string(), "NEW".to_string()];
+        // NEW lists on day 60: 20 bars (skipped) after 80 days, 40 after 100.
+        // It falls through the entry level while BHP stays below it, so the
+        // only trade is NEW's.
+        let universe = |n| {
+            let mut new = generate_bars("NEW", "2020-03-01", n - 60, 0.0);
+            for (i, bar) in new.iter_mut().enumerate() {
+                bar.close = 110.0 - i as f64;
+            }
+            MockDataPort::new()
+                .with_bars("BHP", generate_bars("BHP", "2020-01-01", n, 1.0))
+                .with_bars("NEW", new)
+        };
+
+        let temp_dir = tempfile::TempDir::new().unwrap();
+        let resumed = temp_dir.path().join("resumed.typ");
+        let full = temp_dir.path().join("full.typ");
+
+        cli::run_backtest_pipeline(
+            &universe(80), &strategy, &bt_config, &codes, "ASX", Some(&resumed), None, true,
+        );
+        cli::run_backtest_pipeline(
+            &universe(100), &strategy, &bt_config, &codes, "ASX", Some(&resumed), None, true,
+        );
+        cli::run_backtest_pipeline(
+            &universe(100), &strategy, &bt_config, &codes, "ASX", Some(&full), None, false,
+        );
+        let report = std::fs::read_to_string(&resumed).unwrap();
+        assert!(report.contains("NEW"));
+        assert_eq!(report, std::fs::read_to_string(&full).unwrap());
+    }
+}
+
+mod sweep_mock {
+    use super::*;
+    use samtrader::domain::sweep::ParamGrid;
+
+    const SWEEP_INI: &str = r#"
+[strategy]
+name = SMA ${fast}/${slow}
+entry_long = CROSS_ABOVE(SMA(${fast}), SMA(${slow}))
+exit_long = CROSS_BELOW(SMA(${fast}), SMA(${slow}))
+position_size = 0.25
+max_positions = 2
+
+[sweep]
+parameters = fast, slow
+fast = 5:15:5
+slow = 20, 30
+"#;
+
+    #[test]
+    fn sweep_points_substitute_parameters() {
+        let adapter = FileConfigAdapter::from_string(SWEEP_INI).unwrap();
+        let grid = ParamGrid::from_config(&adapter).unwrap();
+        let points = cli::build_sweep_points(&adapter, &grid).unwrap();
+
+        assert_eq!(points.len(), 6);
+        assert_eq!(points[3].strategy.name, "SMA 10/30");
+        let indicators = cli::collect_all_indicators(&points[3].strategy);
+        assert!(indicators.contains(&IndicatorType::Sma(10)));
+        assert!(indicators.contains(&IndicatorType::Sma(30)));
+    }
+
+    #[test]
+    fn sweep_pipeline_writes_one_row_per_point() {
+        let mock = MockDataPort::new()
+            .with_bars("BHP", generate_bars("BHP", "2020-01-01", 100, 100.0))
+            .with_bars("CBA", generate_bars("CBA", "2020-01-01", 100, 50.0));
+        let adapter = FileConfigAdapter::from_string(SWEEP_INI).unwrap();
+        let grid = ParamGrid::from_config(&adapter).unwrap();
+        let points = cli::build_sweep_points(&adapter, &grid).unwrap();
+        let codes = vec!["BHP".to_string(), "CBA".to_string()];
+
+        let temp_dir = tempfile::TempDir::new().unwrap();
+        let output = temp_dir.path().join("sweep.csv");
+
+        let exit_code = cli::run_sweep_pipeline(
+            &mock,
+            &grid,
+            &points,
+            &sample_config(),
+            &codes,
+            "ASX",
+            Some(&output),
+            cli::SweepFormat::Csv,
+        );
+
+        let report = format!("{exit_code:?}");
+        assert!(report.contains("0"), "expected success, got: {report}");
+        let content = std::fs::read_to_string(&output).unwrap();
+        let lines: Vec<&str> = content.lines().collect();
+        assert_eq!(lines.len(), 1 + points.len());
+        assert!(lines[0].starts_with("point,fast,slow,total_return"));
+        let mut seen: Vec<usize> = lines[1..]
+            .iter()
+            .map(|l| l.split(',').next().unwrap().parse().unwrap())
+            .collect();
+        seen.sort();
+        assert_eq!(seen, (0..points.len()).collect::<Vec<_>>());
+    }
+
+    #[test]
+    fn sweep_without_grid_is_config_error() {
+        let adapter = FileConfigAdapter::from_string(VALID_INI).unwrap();
+        assert!(matches!(
+            ParamGrid::from_config(&adapter),
+            Err(SamtraderError::ConfigMissing { .. })
+        ));
+    }
 }
 
 mod end_to_end {
@@ -9,10 +9,13 @@ use samtrader::domain::rule::{Operand, Rule};
 use samtrader::domain::strategy::Strategy;
 use samtrader::ports::data_port::DataPort;
 use std::collections::HashMap;
+use std::sync::atomic::{AtomicUsize, Ordering};
 
 pub struct MockDataPort {
     pub data: HashMap<String, Vec<OhlcvBar>>,
     pub errors: HashMap<String, String>,
+    /// Bars returned by `fetch_ohlcv` so far.
+    pub bars_served: AtomicUsize,
 }
 
 impl MockDataPort {
@@ -20,6 +23,7 @@ impl MockDataPort {
         Self {
             data: HashMap::new(),
             errors: HashMap::new(),
+            bars_served: AtomicUsize::new(0),
         }
     }
 
@@ -39,15 +43,24 @@ impl DataPort for MockDataPort {
         &self,
         code: &str,
         _exchange: &str,
-        _start_date: NaiveDate,
-        _end_date: NaiveDate,
+        start_date: NaiveDate,
+        end_date: NaiveDate,
     ) -> Result<Vec<OhlcvBar>, SamtraderError> {
         if let Some(reason) = self.errors.get(code) {
             return Err(SamtraderError::Database {
                 reason: reason.clone(),
             });
         }
-        Ok(self.data.get(code).cloned().unwrap_or_default())
+        let bars: Vec<OhlcvBar> = self
+            .data
+            .get(code)
+            .into_iter()
+            .flatten()
+            .filter(|b| b.date >= start_date && b.date <= end_date)
+            .cloned()
+            .collect();
+        self.bars_served.fetch_add(bars.len(), Ordering::Relaxed);
+        Ok(bars)
     }
 
     fn list_symbols(&self, _exchange: &str) -> Result<Vec<String>, SamtraderError> {
@@ -123,6 +136,7 @@ pub fn sample_config() -> BacktestConfig {
         slippage_pct: 0.0,
         allow_shorting: false,
         risk_free_rate: 0.05,
+        workers: 1,
     }
 }
 
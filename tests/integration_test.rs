@@ -543,8 +543,7 @@ mod equity_curve_and_metrics {
 
         assert_eq!(result.portfolio.position_count(), 1);
 
-        let mut price_map = HashMap::new();
-        price_map.insert("BHP".to_string(), 130.0);
+        let prices = [Some(130.0)];
 
         let position_value = result
             .portfolio
@@ -553,7 +552,7 @@ mod equity_curve_and_metrics {
             .map(|p| p.market_value(130.0))
             .sum::<f64>();
         let expected_equity = result.portfolio.cash + position_value;
-        let actual_equity = result.portfolio.total_equity(&price_map);
+        let actual_equity = result.portfolio.total_equity(&prices);
 
         assert!((actual_equity - expected_equity).abs() < f64::EPSILON);
     }
@@ -15,7 +15,7 @@ use axum::{
     Router,
 };
 use http_body_util::BodyExt;
-use samtrader::adapters::web::{build_router, AppState, new_backtest_cache};
+use samtrader::adapters::web::{build_router, AppState, JobPool, new_backtest_cache};
 use samtrader::ports::config_port::ConfigPort;
 use std::sync::{Arc, LazyLock};
 use tower::ServiceExt;
@@ -77,6 +77,7 @@ async fn create_auth_app() -> Router {
         data_port: Arc::new(data_port),
         config: Arc::new(AuthMockConfigPort),
         backtest_cache: new_backtest_cache(),
+        jobs: JobPool::new(1, 4),
     };
     build_router(state).await
 }
@@ -4,7 +4,7 @@
 //! Tests cover:
 //! - Dashboard renders with expected content
 //! - Backtest form renders with form fields
-//! - Backtest submission returns report with expected sections
+//! - Backtest submission queues a job that redirects to its report
 //! - Report page contains equity chart, metrics table, trade log
 //! - HTMX fragment vs full page responses
 
@@ -16,10 +16,11 @@ use axum::{
     Router,
 };
 use http_body_util::BodyExt;
-use samtrader::adapters::web::{build_test_router, AppState};
+use samtrader::adapters::web::{build_test_router, AppState, JobPool};
 use samtrader::ports::config_port::ConfigPort;
 use samtrader::domain::ohlcv::OhlcvBar;
 use std::sync::Arc;
+use std::time::Duration;
 use tower::ServiceExt;
 
 use common::*;
@@ -61,6 +62,7 @@ fn create_test_app() -> Router {
         data_port: Arc::new(data_port),
         config: Arc::new(MockConfigPort),
         backtest_cache: samtrader::adapters::web::new_backtest_cache(),
+        jobs: JobPool::new(1, 4),
     };
 
     build_test_router(state)
@@ -76,11 +78,70 @@ fn create_test_app_with_data(codes: &[(&str, Vec<OhlcvBar>)]) -> Router {
         data_port: Arc::new(port),
         config: Arc::new(MockConfigPort),
         backtest_cache: samtrader::adapters::web::new_backtest_cache(),
+        jobs: JobPool::new(1, 4),
     };
 
     build_test_router(state)
 }
 
+/// Extract the status URL from hx-get="/backtest/job/XXX".
+fn extract_job_url(html: &str) -> String {
+    let start = html.find("/backtest/job/").expect("no job URL in html");
+    let end = start + html[start..].find('"').unwrap();
+    html[start..end].to_string()
+}
+
+/// Poll the job behind a `/backtest/run` response until it leaves the
+/// queued/running states, returning the final status response. A cached
+/// result is already a redirect and is returned as is.
+async fn follow_job(app: &Router, submitted: axum::http::Response<Body>) -> axum::http::Response<Body> {
+    if submitted.status() == StatusCode::SEE_OTHER {
+        return submitted;
+    }
+    assert_eq!(submitted.status(), StatusCode::ACCEPTED);
+    let body = submitted.into_body().collect().await.unwrap().to_bytes();
+    let job_url = extract_job_url(&String::from_utf8_lossy(&body));
+
+    for _ in 0..500 {
+        let response = app
+            .clone()
+            .oneshot(
+                Request::builder()
+                    .uri(&job_url)
+                    .body(Body::empty())
+                    .unwrap(),
+            )
+            .await
+            .unwrap();
+        if response.status() != StatusCode::OK {
+            return response;
+        }
+        tokio::time::sleep(Duration::from_millis(10)).await;
+    }
+    panic!("backtest job {job_url} did not finish");
+}
+
+/// Submit a backtest, wait for its job and fetch the report it redirects to.
+async fn submit_and_open_report(app: &Router, request: Request<Body>, htmx: bool) -> (StatusCode, String) {
+    let submitted = app.clone().oneshot(request).await.unwrap();
+    let done = follow_job(app, submitted).await;
+    assert_eq!(done.status(), StatusCode::SEE_OTHER);
+    let location = done.headers()[header::LOCATION].to_str().unwrap().to_string();
+
+    let mut report = Request::builder().uri(location);
+    if htmx {
+        report = report.header("HX-Request", "true");
+    }
+    let response = app
+        .clone()
+        .oneshot(report.body(Body::empty()).unwrap())
+        .await
+        .unwrap();
+    let status = response.status();
+    let body = response.into_body().collect().await.unwrap().to_bytes();
+    (status, String::from_utf8_lossy(&body).into_owned())
+}
+
 mod dashboard_tests {
     use super::*;
 
@@ -187,27 +248,37 @@ mod backtest_form_tests {
 mod backtest_submission_tests {
     use super::*;
 
+    const FORM_DATA: &str = "codes=BHP&start_date=2024-01-01&end_date=2024-01-31&initial_capital=100000&entry_rule=ABOVE(close%2C%20100)&exit_rule=BELOW(close%2C%20100)&position_size=0.25&max_positions=1";
+
     fn create_backtest_request() -> Request<Body> {
-        let form_data = "codes=BHP&start_date=2024-01-01&end_date=2024-01-31&initial_capital=100000&entry_rule=ABOVE(close%2C%20100)&exit_rule=BELOW(close%2C%20100)&position_size=0.25&max_positions=1";
-        
         Request::builder()
             .method("POST")
             .uri("/backtest/run")
             .header(header::CONTENT_TYPE, "application/x-www-form-urlencoded")
-            .body(Body::from(form_data))
+            .body(Body::from(FORM_DATA))
             .unwrap()
     }
 
     #[tokio::test]
-    async fn backtest_submission_returns_ok_status() {
-        let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
-        let app = create_test_app_with_data(&[("BHP", bars)]);
-        
+    async fn backtest_submission_returns_polling_job_status() {
+        let app = create_test_app();
+
         let response = app.oneshot(create_backtest_request()).await.unwrap();
-        let status = response.status();
+
+        assert_eq!(response.status(), StatusCode::ACCEPTED);
         let body = response.into_body().collect().await.unwrap().to_bytes();
         let html = String::from_utf8_lossy(&body);
-        
+        assert!(html.contains("hx-get=\"/backtest/job/"));
+        assert!(html.contains("hx-trigger=\"load delay:1s\""));
+    }
+
+    #[tokio::test]
+    async fn backtest_submission_returns_ok_status() {
+        let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
+        let app = create_test_app_with_data(&[("BHP", bars)]);
+
+        let (status, html) = submit_and_open_report(&app, create_backtest_request(), false).await;
+
         assert_eq!(status, StatusCode::OK, "Response body: {}", html);
     }
 
@@ -215,12 +286,9 @@ mod backtest_submission_tests {
     async fn backtest_submission_returns_report_content() {
         let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
         let app = create_test_app_with_data(&[("BHP", bars)]);
-        
-        let response = app.oneshot(create_backtest_request()).await.unwrap();
-        
-        let body = response.into_body().collect().await.unwrap().to_bytes();
-        let html = String::from_utf8_lossy(&body);
-        
+
+        let (_, html) = submit_and_open_report(&app, create_backtest_request(), false).await;
+
         assert!(html.contains("Backtest Report"));
     }
 
@@ -228,12 +296,9 @@ mod backtest_submission_tests {
     async fn backtest_submission_returns_metrics_table() {
         let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
         let app = create_test_app_with_data(&[("BHP", bars)]);
-        
-        let response = app.oneshot(create_backtest_request()).await.unwrap();
-        
-        let body = response.into_body().collect().await.unwrap().to_bytes();
-        let html = String::from_utf8_lossy(&body);
-        
+
+        let (_, html) = submit_and_open_report(&app, create_backtest_request(), false).await;
+
         assert!(html.contains("Total Return"));
         assert!(html.contains("Sharpe Ratio"));
         assert!(html.contains("Max Drawdown"));
@@ -244,12 +309,9 @@ mod backtest_submission_tests {
     async fn backtest_submission_returns_equity_chart() {
         let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
         let app = create_test_app_with_data(&[("BHP", bars)]);
-        
-        let response = app.oneshot(create_backtest_request()).await.unwrap();
-        
-        let body = response.into_body().collect().await.unwrap().to_bytes();
-        let html = String::from_utf8_lossy(&body);
-        
+
+        let (_, html) = submit_and_open_report(&app, create_backtest_request(), false).await;
+
         assert!(html.contains("Equity Chart"));
         assert!(html.contains("hx-get"));
         assert!(html.contains("/equity-chart"));
@@ -260,12 +322,9 @@ mod backtest_submission_tests {
     async fn backtest_submission_returns_drawdown_chart() {
         let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
         let app = create_test_app_with_data(&[("BHP", bars)]);
-        
-        let response = app.oneshot(create_backtest_request()).await.unwrap();
-        
-        let body = response.into_body().collect().await.unwrap().to_bytes();
-        let html = String::from_utf8_lossy(&body);
-        
+
+        let (_, html) = submit_and_open_report(&app, create_backtest_request(), false).await;
+
         assert!(html.contains("Drawdown Chart"));
         assert!(html.contains("hx-get"));
         assert!(html.contains("/drawdown-chart"));
@@ -276,52 +335,249 @@ mod backtest_submission_tests {
     async fn backtest_submission_shows_strategy_section() {
         let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
         let app = create_test_app_with_data(&[("BHP", bars)]);
-        
-        let form_data = "codes=BHP&start_date=2024-01-01&end_date=2024-01-31&initial_capital=100000&entry_rule=ABOVE(close%2C%20100)&exit_rule=BELOW(close%2C%20100)&position_size=0.25&max_positions=1";
-        
+
+        let (_, html) = submit_and_open_report(&app, create_backtest_request(), false).await;
+
+        assert!(html.contains("Strategy"));
+        assert!(html.contains("Position Size"));
+    }
+
+    #[tokio::test]
+    async fn backtest_submission_htmx_fragment() {
+        let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
+        let app = create_test_app_with_data(&[("BHP", bars)]);
+
+        let request = Request::builder()
+            .method("POST")
+            .uri("/backtest/run")
+            .header(header::CONTENT_TYPE, "application/x-www-form-urlencoded")
+            .header("HX-Request", "true")
+            .body(Body::from(FORM_DATA))
+            .unwrap();
+        let (_, html) = submit_and_open_report(&app, request, true).await;
+
+        assert!(html.contains("<div id=\"report-content\">"));
+    }
+
+    #[tokio::test]
+    async fn finished_job_htmx_poll_redirects_to_report() {
+        let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
+        let app = create_test_app_with_data(&[("BHP", bars)]);
+
+        let submitted = app.clone().oneshot(create_backtest_request()).await.unwrap();
+        let body = submitted.into_body().collect().await.unwrap().to_bytes();
+        let job_url = extract_job_url(&String::from_utf8_lossy(&body));
+
+        for _ in 0..500 {
+            let response = app
+                .clone()
+                .oneshot(
+                    Request::builder()
+                        .uri(&job_url)
+                        .header("HX-Request", "true")
+                        .body(Body::empty())
+                        .unwrap(),
+                )
+                .await
+                .unwrap();
+            assert_eq!(response.status(), StatusCode::OK);
+            if let Some(redirect) = response.headers().get("HX-Redirect") {
+                assert!(redirect.to_str().unwrap().starts_with("/report/"));
+                return;
+            }
+            tokio::time::sleep(Duration::from_millis(10)).await;
+        }
+        panic!("backtest job {job_url} never redirected");
+    }
+
+    #[tokio::test]
+    async fn backtest_without_data_fails_its_job() {
+        let app = create_test_app_with_data(&[]);
+
+        let submitted = app.clone().oneshot(create_backtest_request()).await.unwrap();
+        let done = follow_job(&app, submitted).await;
+
+        assert_eq!(done.status(), StatusCode::BAD_REQUEST);
+        let body = done.into_body().collect().await.unwrap().to_bytes();
+        assert!(String::from_utf8_lossy(&body).contains("class=\"error\""));
+    }
+
+    #[tokio::test]
+    async fn unknown_job_returns_404() {
+        let app = create_test_app();
+
         let response = app
             .oneshot(
                 Request::builder()
-                    .method("POST")
-                    .uri("/backtest/run")
-                    .header(header::CONTENT_TYPE, "application/x-www-form-urlencoded")
-                    .body(Body::from(form_data))
+                    .uri("/backtest/job/nonexistent")
+                    .body(Body::empty())
                     .unwrap(),
             )
             .await
             .unwrap();
-        
-        let body = response.into_body().collect().await.unwrap().to_bytes();
-        let html = String::from_utf8_lossy(&body);
-        
-        assert!(html.contains("Strategy"));
-        assert!(html.contains("Position Size"));
+
+        assert_eq!(response.status(), StatusCode::NOT_FOUND);
+    }
+}
+
+mod result_cache_tests {
+    use super::*;
+    use chrono::NaiveDate;
+    use samtrader::adapters::web::backtest_key;
+    use samtrader::domain::backtest::BacktestConfig;
+    use samtrader::domain::strategy::Strategy;
+
+    const FORM_DATA: &str = "codes=BHP&start_date=2024-01-01&end_date=2024-01-31&initial_capital=100000&entry_rule=ABOVE(close%2C%20100)&exit_rule=BELOW(close%2C%20100)&position_size=0.25&max_positions=1";
+
+    fn submit(htmx: bool) -> Request<Body> {
+        let mut request = Request::builder()
+            .method("POST")
+            .uri("/backtest/run")
+            .header(header::CONTENT_TYPE, "application/x-www-form-urlencoded");
+        if htmx {
+            request = request.header("HX-Request", "true");
+        }
+        request.body(Body::from(FORM_DATA)).unwrap()
+    }
+
+    fn location(response: &axum::http::Response<Body>) -> String {
+        response.headers()[header::LOCATION].to_str().unwrap().to_string()
     }
 
     #[tokio::test]
-    async fn backtest_submission_htmx_fragment() {
+    async fn identical_submission_is_served_from_cache() {
         let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
         let app = create_test_app_with_data(&[("BHP", bars)]);
-        
-        let form_data = "codes=BHP&start_date=2024-01-01&end_date=2024-01-31&initial_capital=100000&entry_rule=ABOVE(close%2C%20100)&exit_rule=BELOW(close%2C%20100)&position_size=0.25&max_positions=1";
-        
-        let response = app
+
+        let first = app.clone().oneshot(submit(false)).await.unwrap();
+        let report = location(&follow_job(&app, first).await);
+
+        let again = app.clone().oneshot(submit(false)).await.unwrap();
+        assert_eq!(again.status(), StatusCode::SEE_OTHER);
+        assert_eq!(location(&again), report);
+
+        let htmx = app.clone().oneshot(submit(true)).await.unwrap();
+        assert_eq!(htmx.status(), StatusCode::OK);
+        assert_eq!(htmx.headers()["HX-Redirect"].to_str().unwrap(), report);
+    }
+
+    #[tokio::test]
+    async fn concurrent_identical_submissions_share_a_job() {
+        let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
+        let app = create_test_app_with_data(&[("BHP", bars)]);
+
+        let first = app.clone().oneshot(submit(false)).await.unwrap();
+        let second = app.clone().oneshot(submit(false)).await.unwrap();
+
+        let first = location(&follow_job(&app, first).await);
+        let second = location(&follow_job(&app, second).await);
+        assert_eq!(first, second);
+    }
+
+    #[tokio::test]
+    async fn invalidating_data_recomputes() {
+        let bars = generate_bars("BHP", "2024-01-01", 50, 100.0);
+        let app = create_test_app_with_data(&[("BHP", bars)]);
+
+        let first = app.clone().oneshot(submit(false)).await.unwrap();
+        let before = location(&follow_job(&app, first).await);
+
+        let invalidate = app
+            .clone()
             .oneshot(
                 Request::builder()
                     .method("POST")
-                    .uri("/backtest/run")
+                    .uri("/data/invalidate")
                     .header(header::CONTENT_TYPE, "application/x-www-form-urlencoded")
-                    .header("HX-Request", "true")
-                    .body(Body::from(form_data))
+                    .body(Body::from("exchange=ASX&code=BHP"))
                     .unwrap(),
             )
             .await
             .unwrap();
-        
-        let body = response.into_body().collect().await.unwrap().to_bytes();
-        let html = String::from_utf8_lossy(&body);
-        
-        assert!(html.contains("<div id=\"report-content\">"));
+        assert_eq!(invalidate.status(), StatusCode::NO_CONTENT);
+
+        let rerun = app.clone().oneshot(submit(false)).await.unwrap();
+        assert_eq!(rerun.status(), StatusCode::ACCEPTED);
+        let after = location(&follow_job(&app, rerun).await);
+        assert_ne!(before, after);
+    }
+
+    #[tokio::test]
+    async fn appended_bars_recompute_without_invalidation() {
+        // Two servers over one report cache, the second after a new bar was
+        // written straight to the database.
+        let cache = samtrader::adapters::web::new_backtest_cache();
+        let app = |bars: usize| {
+            let port = MockDataPort::new()
+                .with_bars("BHP", generate_bars("BHP", "2024-01-01", bars, 100.0));
+            build_test_router(AppState {
+                data_port: Arc::new(port),
+                config: Arc::new(MockConfigPort),
+                backtest_cache: Arc::clone(&cache),
+                jobs: JobPool::new(1, 4),
+            })
+        };
+        let (before, after) = (app(30), app(31));
+
+        let first = before.clone().oneshot(submit(false)).await.unwrap();
+        let first = location(&follow_job(&before, first).await);
+
+        let rerun = after.clone().oneshot(submit(false)).await.unwrap();
+        assert_eq!(rerun.status(), StatusCode::ACCEPTED);
+        assert_ne!(location(&follow_job(&after, rerun).await), first);
+    }
+
+    fn key_inputs() -> (Vec<String>, Strategy, BacktestConfig) {
+        let strategy = make_simple_strategy();
+        let config = sample_config();
+        (vec!["BHP".to_string(), "CBA".to_string()], strategy, config)
+    }
+
+    fn ranges() -> Vec<Option<(NaiveDate, NaiveDate, usize)>> {
+        vec![Some((date(2024, 1, 1), date(2024, 2, 19), 50)), None]
+    }
+
+    #[test]
+    fn key_ignores_names_and_workers() {
+        let (codes, strategy, config) = key_inputs();
+        let renamed = Strategy {
+            name: "Renamed".to_string(),
+            description: "Other".to_string(),
+            ..strategy.clone()
+        };
+        let more_workers = BacktestConfig { workers: 8, ..config.clone() };
+
+        let key = backtest_key(&codes, &strategy, &config, &ranges(), 0);
+        assert_eq!(key.len(), 32);
+        assert_eq!(backtest_key(&codes, &renamed, &more_workers, &ranges(), 0), key);
+    }
+
+    #[test]
+    fn key_covers_inputs_that_change_results() {
+        let (codes, strategy, config) = key_inputs();
+        let key = backtest_key(&codes, &strategy, &config, &ranges(), 0);
+
+        let reordered = vec!["CBA".to_string(), "BHP".to_string()];
+        let later = BacktestConfig {
+            end_date: date(2025, 1, 1),
+            ..config.clone()
+        };
+        let sized = Strategy {
+            position_size: 0.5,
+            ..strategy.clone()
+        };
+        assert_ne!(backtest_key(&reordered, &strategy, &config, &ranges(), 0), key);
+        assert_ne!(backtest_key(&codes, &strategy, &later, &ranges(), 0), key);
+        assert_ne!(backtest_key(&codes, &sized, &config, &ranges(), 0), key);
+        assert_ne!(backtest_key(&codes, &strategy, &config, &ranges(), 1), key);
+
+        let mut appended = ranges();
+        appended[0] = Some((date(2024, 1, 1), date(2024, 2, 20), 51));
+        appended[1] = None;
+        assert_ne!(backtest_key(&codes, &strategy, &config, &appended, 0), key);
+        let mut listed = ranges();
+        listed[1] = Some((date(2024, 2, 1), date(2024, 2, 19), 19));
+        assert_ne!(backtest_key(&codes, &strategy, &config, &listed, 0), key);
     }
 }
 
@@ -503,28 +759,17 @@ mod view_report_tests {
             data_port: Arc::new(data_port),
             config: Arc::new(MockConfigPort),
             backtest_cache: samtrader::adapters::web::new_backtest_cache(),
+            jobs: JobPool::new(1, 4),
         }
     }
 
-    /// Extract the report ID from HTML containing hx-get="/report/XXX/equity-chart".
-    fn extract_report_id(html: &str) -> String {
-        let prefix = "/report/";
-        let suffix = "/equity-chart";
-        let start = html.find(prefix).expect("no /report/ in html") + prefix.len();
-        let rest = &html[start..];
-        let end = rest.find(suffix).expect("no /equity-chart in html");
-        rest[..end].to_string()
-    }
-
-    /// Run a backtest and return the report ID from the response.
+    /// Run a backtest, wait for its job and return the report ID it
+    /// redirects to.
     async fn run_backtest_and_get_id(state: &AppState) -> String {
-        let app = build_test_router(AppState {
-            data_port: state.data_port.clone(),
-            config: state.config.clone(),
-            backtest_cache: state.backtest_cache.clone(),
-        });
+        let app = build_app_from(state);
 
         let response = app
+            .clone()
             .oneshot(
                 Request::builder()
                     .method("POST")
@@ -536,9 +781,9 @@ mod view_report_tests {
             .await
             .unwrap();
 
-        let body = response.into_body().collect().await.unwrap().to_bytes();
-        let html = String::from_utf8_lossy(&body);
-        extract_report_id(&html)
+        let done = follow_job(&app, response).await;
+        let location = done.headers()[header::LOCATION].to_str().unwrap();
+        location.strip_prefix("/report/").expect("not a report redirect").to_string()
     }
 
     fn build_app_from(state: &AppState) -> Router {
@@ -546,6 +791,7 @@ mod view_report_tests {
             data_port: state.data_port.clone(),
             config: state.config.clone(),
             backtest_cache: state.backtest_cache.clone(),
+            jobs: state.jobs.clone(),
         })
     }
 
@@ -661,6 +907,38 @@ mod view_report_tests {
         assert!(html.contains(&equity_url), "missing equity chart URL");
         assert!(html.contains(&drawdown_url), "missing drawdown chart URL");
     }
+
+    #[tokio::test]
+    async fn chart_is_served_with_etag_and_gzip() {
+        let state = create_shared_state();
+        let report_id = run_backtest_and_get_id(&state).await;
+        let app = build_app_from(&state);
+        let chart = |extra: Option<(header::HeaderName, String)>| {
+            let mut request = Request::builder().uri(format!("/report/{report_id}/equity-chart"));
+            if let Some((name, value)) = extra {
+                request = request.header(name, value);
+            }
+            app.clone().oneshot(request.body(Body::empty()).unwrap())
+        };
+
+        let plain = chart(None).await.unwrap();
+        assert_eq!(plain.status(), StatusCode::OK);
+        assert!(plain.headers().get(header::CONTENT_ENCODING).is_none());
+        let etag = plain.headers()[header::ETAG].to_str().unwrap().to_string();
+        let body = plain.into_body().collect().await.unwrap().to_bytes();
+        assert!(String::from_utf8_lossy(&body).starts_with("<svg"));
+
+        let gzipped = chart(Some((header::ACCEPT_ENCODING, "gzip".into()))).await.unwrap();
+        assert_eq!(gzipped.headers()[header::CONTENT_ENCODING], "gzip");
+        assert_eq!(gzipped.headers()[header::ETAG].to_str().unwrap(), etag);
+        let body = gzipped.into_body().collect().await.unwrap().to_bytes();
+        assert_eq!(&body[..2], &[0x1f, 0x8b]);
+
+        let revalidated = chart(Some((header::IF_NONE_MATCH, etag))).await.unwrap();
+        assert_eq!(revalidated.status(), StatusCode::NOT_MODIFIED);
+        let body = revalidated.into_body().collect().await.unwrap().to_bytes();
+        assert!(body.is_empty());
+    }
 }
 
 mod multi_code_backtest_tests {
@@ -674,21 +952,13 @@ mod multi_code_backtest_tests {
         
         let form_data = "codes=BHP,CBA&start_date=2024-01-01&end_date=2024-01-31&initial_capital=100000&entry_rule=ABOVE(close%2C%2050)&exit_rule=BELOW(close%2C%2050)&position_size=0.25&max_positions=2";
         
-        let response = app
-            .oneshot(
-                Request::builder()
-                    .method("POST")
-                    .uri("/backtest/run")
-                    .header(header::CONTENT_TYPE, "application/x-www-form-urlencoded")
-                    .body(Body::from(form_data))
-                    .unwrap(),
-            )
-            .await
+        let request = Request::builder()
+            .method("POST")
+            .uri("/backtest/run")
+            .header(header::CONTENT_TYPE, "application/x-www-form-urlencoded")
+            .body(Body::from(form_data))
             .unwrap();
-        
-        let status = response.status();
-        let body = response.into_body().collect().await.unwrap().to_bytes();
-        let html = String::from_utf8_lossy(&body);
+        let (status, html) = submit_and_open_report(&app, request, false).await;
         
         assert_eq!(status, StatusCode::OK, "HTML: {}", html);
         assert!(html.contains("Backtest Report"));